@@ -21,6 +21,9 @@ OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
 #include <string.h>
 #include <stdlib.h>
 
+// must match PAK_SORTED_MARKER in Quake/common.c
+#define SORTED_MARKER "pak.sorted"
+
 static FILE *out;
 
 typedef struct
@@ -29,6 +32,15 @@ typedef struct
 	int  filepos, filelen;
 } dpackfile_t;
 
+typedef struct
+{
+	const char *name;
+	int32_t     size;
+	int32_t     filepos;
+	int         arg_index;
+	int         order; // position of the payload in the file
+} input_t;
+
 void write_byte (uint8_t value)
 {
 	fwrite (&value, 1, 1, out);
@@ -55,36 +67,154 @@ void write_header (int32_t directory_offset, int32_t directory_size)
 	write_int32 (directory_size);
 }
 
+void write_entry (const char *name, int32_t filepos, int32_t filelen)
+{
+	dpackfile_t pack_entry;
+	memset (&pack_entry, 0, sizeof (pack_entry));
+	strncpy (pack_entry.name, name, sizeof (pack_entry.name) - 1);
+	pack_entry.filepos = filepos;
+	pack_entry.filelen = filelen;
+	fwrite (&pack_entry, sizeof (pack_entry), 1, out);
+}
+
+int compare_names (const void *a, const void *b)
+{
+	return strcmp (((const input_t *)a)->name, ((const input_t *)b)->name);
+}
+
+int compare_order (const void *a, const void *b)
+{
+	return (*(const input_t **)a)->order - (*(const input_t **)b)->order;
+}
+
+// Gives the files in the trace, one name per line as written by the engine's
+// fstrace command, the first payload slots in the order they were first used
+int apply_trace (const char *path, input_t *inputs, int num_inputs, int sorted)
+{
+	FILE *trace = fopen (path, "r");
+	if (trace == NULL)
+	{
+		fprintf (stderr, "Could not open trace file '%s'\n", path);
+		return -1;
+	}
+
+	int  num_traced = 0;
+	char line[1024];
+	while (fgets (line, sizeof (line), trace))
+	{
+		line[strcspn (line, "\r\n")] = 0;
+		input_t *input = NULL;
+		if (sorted)
+		{
+			input_t key = {.name = line};
+			input = bsearch (&key, inputs, num_inputs, sizeof (input_t), compare_names);
+		}
+		else
+		{
+			for (int i = 0; i < num_inputs && !input; ++i)
+				if (!strcmp (inputs[i].name, line))
+					input = &inputs[i];
+		}
+		if (input && input->order < 0)
+			input->order = num_traced++;
+	}
+	fclose (trace);
+	return num_traced;
+}
+
 int main (int argc, char *argv[])
 {
-	if (argc < 3)
+	int         sorted = 0;
+	int32_t     alignment = 1;
+	const char *trace_path = NULL;
+	int         arg = 1;
+
+	for (; arg < argc && argv[arg][0] == '-'; ++arg)
+	{
+		if (!strcmp (argv[arg], "-s"))
+			sorted = 1;
+		else if (!strcmp (argv[arg], "-a") && arg + 1 < argc)
+			alignment = atoi (argv[++arg]);
+		else if (!strcmp (argv[arg], "-t") && arg + 1 < argc)
+			trace_path = argv[++arg];
+		else
+			break;
+	}
+
+	if (argc - arg < 2 || alignment < 1 || (alignment & (alignment - 1)))
 	{
-		fprintf (stderr, "Usage: mkpak [output.pak] [files...]\n");
+		fprintf (stderr, "Usage: mkpak [-s] [-a alignment] [-t trace] [output.pak] [files...]\n");
+		fprintf (stderr, "  -s            sort the directory so the engine can binary search it\n");
+		fprintf (stderr, "  -a alignment  align file contents, e.g. 4096 for memory mapping\n");
+		fprintf (stderr, "  -t trace      store the files in the order of an fstrace log first\n");
 		return 1;
 	}
 
-	out = fopen (argv[1], "wb+");
+	const char *out_name = argv[arg++];
+	int32_t     num_in_files = argc - arg;
+	input_t    *inputs = calloc (num_in_files, sizeof (input_t));
+	for (int i = 0; i < num_in_files; ++i)
+	{
+		inputs[i].name = argv[arg + i];
+		inputs[i].arg_index = i;
+		inputs[i].order = -1;
+		if (strlen (inputs[i].name) >= sizeof (((dpackfile_t *)0)->name))
+		{
+			fprintf (stderr, "Input file name '%s' is too long\n", inputs[i].name);
+			return 1;
+		}
+	}
+
+	if (sorted)
+	{
+		qsort (inputs, num_in_files, sizeof (input_t), compare_names);
+		for (int i = 1; i < num_in_files; ++i)
+			if (!strcmp (inputs[i - 1].name, inputs[i].name))
+			{
+				fprintf (stderr, "Input file '%s' given twice\n", inputs[i].name);
+				return 1;
+			}
+	}
+
+	// files not in the trace keep their argument order behind the traced ones
+	int num_traced = 0;
+	if (trace_path)
+	{
+		num_traced = apply_trace (trace_path, inputs, num_in_files, sorted);
+		if (num_traced < 0)
+			return 1;
+	}
+	input_t **payloads = calloc (num_in_files, sizeof (input_t *));
+	for (int i = 0; i < num_in_files; ++i)
+	{
+		if (inputs[i].order < 0)
+			inputs[i].order = num_traced + inputs[i].arg_index;
+		payloads[i] = &inputs[i];
+	}
+	qsort (payloads, num_in_files, sizeof (input_t *), compare_order);
+
+	out = fopen (out_name, "wb+");
 	if (out == NULL)
 	{
-		fprintf (stderr, "Could not open output file '%s'", argv[1]);
+		fprintf (stderr, "Could not open output file '%s'", out_name);
 		return 1;
 	}
 
 	int32_t directory_offset = 12;
-	int32_t num_in_files = argc - 2;
-	int32_t directory_size = num_in_files * sizeof (dpackfile_t);
+	int32_t directory_size = (num_in_files + (sorted ? 1 : 0)) * sizeof (dpackfile_t);
 	int32_t file_offset = directory_offset + directory_size;
 
 	write_header (directory_offset, directory_size);
 
 	uint8_t *in_buffer = NULL;
-	for (int i = 2; i < argc; ++i)
+	fseek (out, file_offset, SEEK_SET);
+	for (int i = 0; i < num_in_files; ++i)
 	{
-		int   file_index = i - 2;
-		FILE *in = fopen (argv[i], "rb");
+		input_t *input = payloads[i];
+		FILE    *in = fopen (input->name, "rb");
 		if (in == NULL)
 		{
-			fprintf (stderr, "Could not open input file '%s'", argv[i]);
+			fprintf (stderr, "Could not open input file '%s'", input->name);
 			return 1;
 		}
 
@@ -94,16 +224,12 @@ int main (int argc, char *argv[])
 		in_buffer = realloc (in_buffer, in_size);
 		fread (in_buffer, in_size, 1, in);
 
-		dpackfile_t pack_entry;
-		memset (&pack_entry, 0, sizeof (pack_entry));
-		strncpy (pack_entry.name, argv[i], sizeof (pack_entry.name) - 1);
-		pack_entry.filelen = in_size;
-		pack_entry.filepos = file_offset;
-
-		fseek (out, directory_offset + (file_index * sizeof (dpackfile_t)), SEEK_SET);
-		fwrite (&pack_entry, sizeof (pack_entry), 1, out);
+		int32_t padding = (alignment - (file_offset % alignment)) % alignment;
+		write_zero_padding (padding);
+		file_offset += padding;
 
-		fseek (out, file_offset, SEEK_SET);
+		input->size = in_size;
+		input->filepos = file_offset;
 		fwrite (in_buffer, in_size, 1, out);
 
 		file_offset += in_size;
@@ -111,5 +237,15 @@ int main (int argc, char *argv[])
 	}
 	free (in_buffer);
 
+	fseek (out, directory_offset, SEEK_SET);
+	if (sorted)
+		write_entry (SORTED_MARKER, 0, 0);
+	for (int i = 0; i < num_in_files; ++i)
+		write_entry (inputs[i].name, inputs[i].filepos, inputs[i].size);
+
+	free (payloads);
+	free (inputs);
+	fclose (out);
+
 	return 0;
 }
@@ -140,6 +140,12 @@ static inline uint64_t Atomic_SubUInt64 (volatile atomic_uint64_t *atomic, uint6
 {
 	return InterlockedAdd64 ((volatile LONG64 *)&atomic->value, (~value) + 1) + value;
 }
+
+// full sequentially consistent fence, orders a store before a later load
+static inline void Atomic_ThreadFence (void)
+{
+	MemoryBarrier ();
+}
 #else
 typedef _Atomic uint8_t atomic_uint8_t;
 
@@ -221,6 +227,12 @@ static inline uint64_t Atomic_SubUInt64 (atomic_uint64_t *atomic, const uint64_t
 {
 	return atomic_fetch_sub (atomic, value);
 }
+
+// full sequentially consistent fence, orders a store before a later load
+static inline void Atomic_ThreadFence (void)
+{
+	atomic_thread_fence (memory_order_seq_cst);
+}
 #endif
 
 #endif
@@ -1993,6 +1993,7 @@ void CL_ParseServerMessage (void)
 			cl.completed_time = cl.time;
 			vid.recalc_refdef = true; // go to full screen
 			V_RestoreAngles ();
+			SV_PrefetchNextMap ();
 			break;
 
 		case svc_finale:
@@ -44,6 +44,39 @@ qboolean fitzmode;
 qboolean multiuser;
 
 static void COM_Path_f (void);
+static void COM_FileSystemStats_f (void);
+
+#if defined(_WIN32) || defined(PLATFORM_OSX)
+#define DIR_CACHE_CASE_INSENSITIVE
+#endif
+
+static SDL_mutex *com_dir_cache_mutex;
+
+// files that weren't found anywhere in the search path: name -> loose directories probed for it
+static hash_map_t *com_missing_files;
+#define MAX_MISSING_FILES 8192
+
+// lookup counters for fsstats
+static atomic_uint32_t com_num_lookups;
+static atomic_uint32_t com_num_pack_probes;
+static atomic_uint32_t com_num_pack_compares_saved; // strcmp calls the linear directory scan would have done
+static atomic_uint32_t com_num_dir_probes;
+static atomic_uint32_t com_num_dir_listings;
+static atomic_uint32_t com_num_file_type_calls;
+static atomic_uint32_t com_num_missing_hits;
+static atomic_uint32_t com_num_missing_dir_lookups_saved; // COM_DirCacheFileType lookups a full search would have done
+static atomic_uint64_t com_lookup_ticks;
+static atomic_uint32_t com_num_mapped_files;
+static atomic_uint64_t com_num_mapped_bytes;
+static atomic_uint32_t com_num_zip_inflates;
+static atomic_uint64_t com_num_zip_inflated_bytes;
+static atomic_uint32_t com_num_zip_cache_hits;
+
+static cvar_t fs_pk3cache = {"fs_pk3cache", "32", CVAR_ARCHIVE}; // megabytes of inflated pk3 entries to keep around
+
+// fstrace: names of the files found, one per line, for ordering paks with mkpak -t
+static FILE		 *com_trace_file;
+static SDL_mutex *com_trace_mutex;
 
 // if a packfile directory differs from this, it is assumed to be hacked
 #define PAK0_COUNT		339	  /* id1/pak0.pak - v1.0x */
@@ -1588,6 +1621,9 @@ typedef struct
 
 #define MAX_FILES_IN_PACK 2048
 
+// mkpak -s writes this empty entry first, the rest of the directory is in strcmp order
+#define PAK_SORTED_MARKER "pak.sorted"
+
 char			 com_gamenames[1024]; // eg: "hipnotic;quoth;warp" ... no id1
 char			 com_gamedir[MAX_OSPATH];
 char			 com_basedir[MAX_OSPATH];
@@ -1605,6 +1641,9 @@ static void COM_Path_f (void)
 {
 	searchpath_t *s;
 
+	// files added outside the engine show up after this
+	COM_FlushDirectoryCache ();
+
 	Con_Printf ("Current search path:\n");
 	for (s = com_searchpaths; s; s = s->next)
 	{
@@ -1643,6 +1682,7 @@ void COM_WriteFile (const char *filename, const void *data, int len)
 	Sys_Printf ("COM_WriteFile: %s\n", name);
 	Sys_FileWrite (handle, data, len);
 	Sys_FileClose (handle);
+	COM_FlushDirectoryCache ();
 }
 
 /*
@@ -1677,20 +1717,513 @@ qfileofs_t COM_filelength (FILE *f)
 
 /*
 ===========
-COM_FindFile
+COM_ComparePackFileName
+
+bsearch callback for sorted paks
+===========
+*/
+static int COM_ComparePackFileName (const void *name, const void *file)
+{
+	return strcmp ((const char *)name, ((const packfile_t *)file)->name);
+}
+
+/*
+===========
+COM_FindPackFile
+
+Returns the index of the first file with that name in the pack or -1
+===========
+*/
+static int COM_FindPackFile (pack_t *pak, const char *filename)
+{
+	const packfile_t *file;
+	const int		 *index;
+	int				  i;
+
+	if (pak->sorted)
+	{
+		file = (const packfile_t *)bsearch (filename, pak->files, pak->numfiles, sizeof (packfile_t), COM_ComparePackFileName);
+		i = file ? (int)(file - pak->files) : -1;
+		index = file ? &i : NULL;
+	}
+	else
+		index = HashMap_Lookup (const int, pak->file_map, &filename);
+	Atomic_IncrementUInt32 (&com_num_pack_probes);
+	Atomic_AddUInt32 (&com_num_pack_compares_saved, index ? (*index + 1) : pak->numfiles);
+	return index ? *index : -1;
+}
+
+/*
+===========
+COM_AddDirCacheEntry
+===========
+*/
+static void COM_AddDirCacheEntry (const char *name, int type, void *userdata)
+{
+	hash_map_t *files = (hash_map_t *)userdata;
+	char	   *key = q_strdup (name);
+#ifdef DIR_CACHE_CASE_INSENSITIVE
+	q_strlwr (key);
+#endif
+	if (HashMap_Insert (files, &key, &type))
+		Mem_Free (key);
+}
+
+/*
+===========
+COM_FreeDirCache
+===========
+*/
+static void COM_FreeDirCache (searchpath_t *search)
+{
+	if (!search->dir_cache)
+		return;
+
+	for (uint32_t i = 0; i < HashMap_Size (search->dir_cache); ++i)
+	{
+		hash_map_t *files = *HashMap_GetValue (hash_map_t *, search->dir_cache, i);
+		if (files)
+		{
+			for (uint32_t j = 0; j < HashMap_Size (files); ++j)
+				Mem_Free (*HashMap_GetKey (char *, files, j));
+			HashMap_Destroy (files);
+		}
+		Mem_Free (*HashMap_GetKey (char *, search->dir_cache, i));
+	}
+	HashMap_Destroy (search->dir_cache);
+	search->dir_cache = NULL;
+}
+
+/*
+===========
+COM_FreeMissingFiles
+
+Called with the dir cache mutex held
+===========
+*/
+static void COM_FreeMissingFiles (void)
+{
+	if (!com_missing_files)
+		return;
+
+	for (uint32_t i = 0; i < HashMap_Size (com_missing_files); ++i)
+		Mem_Free (*HashMap_GetKey (char *, com_missing_files, i));
+	HashMap_Destroy (com_missing_files);
+	com_missing_files = NULL;
+}
+
+/*
+===========
+COM_IsKnownMissing
+===========
+*/
+static qboolean COM_IsKnownMissing (const char *filename)
+{
+	const int *num_dirs = NULL;
+	qboolean   missing = false;
+
+	SDL_LockMutex (com_dir_cache_mutex);
+	if (com_missing_files)
+		num_dirs = HashMap_Lookup (const int, com_missing_files, &filename);
+	if (num_dirs)
+	{
+		missing = true;
+		Atomic_IncrementUInt32 (&com_num_missing_hits);
+		Atomic_AddUInt32 (&com_num_missing_dir_lookups_saved, *num_dirs);
+	}
+	SDL_UnlockMutex (com_dir_cache_mutex);
+
+	return missing;
+}
+
+/*
+===========
+COM_AddMissingFile
+
+Remembers that the file isn't in any search path until the
+game directories change or COM_FlushDirectoryCache is called
+===========
+*/
+static void COM_AddMissingFile (const char *filename, int num_dirs)
+{
+	char *key;
+
+	SDL_LockMutex (com_dir_cache_mutex);
+	if (com_missing_files && HashMap_Size (com_missing_files) >= MAX_MISSING_FILES)
+		COM_FreeMissingFiles (); // e.g. QC probing lots of generated names, just start over
+	if (!com_missing_files)
+		com_missing_files = HashMap_Create (const char *, int, &HashStr, &HashStrCmp);
+	key = q_strdup (filename);
+	if (HashMap_Insert (com_missing_files, &key, &num_dirs))
+		Mem_Free (key);
+	SDL_UnlockMutex (com_dir_cache_mutex);
+}
+
+/*
+===========
+COM_FlushDirectoryCache
+
+Loose directories are only listed once and missing files are
+remembered, so this has to be called whenever files get created
+in the game directories during a session. The engine does it after
+its own writes, "flush" and "path" do it for files added from outside
+===========
+*/
+void COM_FlushDirectoryCache (void)
+{
+	searchpath_t *search;
+
+	SDL_LockMutex (com_dir_cache_mutex);
+	for (search = com_searchpaths; search; search = search->next)
+		COM_FreeDirCache (search);
+	COM_FreeMissingFiles ();
+	SDL_UnlockMutex (com_dir_cache_mutex);
+}
+
+/*
+===========
+COM_DirCacheFileType
+
+Same as Sys_FileType on search->filename/filename, but answered from a
+listing of the containing directory that is read on first use
+===========
+*/
+static int COM_DirCacheFileType (searchpath_t *search, const char *filename)
+{
+	char		path[MAX_OSPATH];
+	char		dirpath[MAX_OSPATH];
+	const char *dir = "";
+	const char *name = path;
+	int			type = FS_ENT_NONE;
+
+	if (strchr (filename, '\\') || q_strlcpy (path, filename, sizeof (path)) >= sizeof (path))
+	{
+		q_snprintf (dirpath, sizeof (dirpath), "%s/%s", search->filename, filename);
+		Atomic_IncrementUInt32 (&com_num_file_type_calls);
+		return Sys_FileType (dirpath);
+	}
+#ifdef DIR_CACHE_CASE_INSENSITIVE
+	q_strlwr (path);
+#endif
+	char *slash = strrchr (path, '/');
+	if (slash)
+	{
+		*slash = 0;
+		dir = path;
+		name = slash + 1;
+	}
+
+	Atomic_IncrementUInt32 (&com_num_dir_probes);
+	SDL_LockMutex (com_dir_cache_mutex);
+	if (!search->dir_cache)
+		search->dir_cache = HashMap_Create (const char *, hash_map_t *, &HashStr, &HashStrCmp);
+
+	hash_map_t **cached_files = HashMap_Lookup (hash_map_t *, search->dir_cache, &dir);
+	hash_map_t	*files;
+	if (cached_files)
+		files = *cached_files;
+	else
+	{
+		files = HashMap_Create (const char *, int, &HashStr, &HashStrCmp);
+		q_snprintf (dirpath, sizeof (dirpath), "%s/%s", search->filename, dir);
+		Atomic_IncrementUInt32 (&com_num_dir_listings);
+		if (!Sys_ListDirectory (dirpath, COM_AddDirCacheEntry, files))
+		{
+			// remember missing directories as well
+			HashMap_Destroy (files);
+			files = NULL;
+		}
+		char *key = q_strdup (dir);
+		HashMap_Insert (search->dir_cache, &key, &files);
+	}
+
+	if (files)
+	{
+		const int *file_type = HashMap_Lookup (const int, files, &name);
+		if (file_type)
+			type = *file_type;
+	}
+	SDL_UnlockMutex (com_dir_cache_mutex);
+
+	return type;
+}
+
+/*
+==============================================================================
+
+PK3 ENTRY CACHE
+
+Compressed pk3 entries are inflated on first use and kept in a LRU list,
+so files that get loaded repeatedly (e.g. on every map change) aren't
+decompressed again. Entries are pinned while files are open on them and
+unpinned ones are evicted once fs_pk3cache megabytes are exceeded.
+
+==============================================================================
+*/
+
+typedef struct zipcache_entry_s
+{
+	struct zippack_s		*zip;
+	int						 index; // into pack->files
+	byte					*data;
+	size_t					 size;
+	int						 refcount;
+	struct zipcache_entry_s *prev, *next;
+} zipcache_entry_t;
+
+typedef struct zippack_s
+{
+	mz_zip_archive	   archive;
+	pack_t			  *pack;
+	zipcache_entry_t **cache; // indexed like pack->files
+} zippack_t;
+
+static SDL_mutex		*com_zip_cache_mutex;
+static zipcache_entry_t *com_zip_cache_head; // most recently used
+static zipcache_entry_t *com_zip_cache_tail;
+static size_t			 com_zip_cache_bytes;
+static hash_map_t		*com_zip_handles; // memory handle -> inflated copy, see COM_OpenZipEntry
+
+/*
+===========
+COM_ZipRead
+
+Positional reads for miniz, they don't touch the
+shared handle so entries can be inflated on any thread
+===========
+*/
+static size_t COM_ZipRead (void *opaque, mz_uint64 ofs, void *buf, size_t n)
+{
+	const pack_t *pak = ((zippack_t *)opaque)->pack;
+
+	if (pak->data)
+	{
+		if (ofs >= (mz_uint64)pak->data_size)
+			return 0;
+		n = q_min (n, (size_t)(pak->data_size - ofs));
+		memcpy (buf, pak->data + ofs, n);
+		return n;
+	}
+	return Sys_FileReadAt (pak->handle, ofs, buf, (int)n);
+}
+
+static void COM_ZipCacheUnlink (zipcache_entry_t *entry)
+{
+	if (entry->prev)
+		entry->prev->next = entry->next;
+	else
+		com_zip_cache_head = entry->next;
+	if (entry->next)
+		entry->next->prev = entry->prev;
+	else
+		com_zip_cache_tail = entry->prev;
+	entry->prev = entry->next = NULL;
+}
+
+static void COM_ZipCacheLinkFront (zipcache_entry_t *entry)
+{
+	entry->prev = NULL;
+	entry->next = com_zip_cache_head;
+	if (com_zip_cache_head)
+		com_zip_cache_head->prev = entry;
+	else
+		com_zip_cache_tail = entry;
+	com_zip_cache_head = entry;
+}
+
+static void COM_ZipCacheFree (zipcache_entry_t *entry)
+{
+	COM_ZipCacheUnlink (entry);
+	entry->zip->cache[entry->index] = NULL;
+	com_zip_cache_bytes -= entry->size;
+	Mem_Free (entry->data);
+	Mem_Free (entry);
+}
+
+/*
+===========
+COM_ZipCacheTrim
+
+Evicts unpinned entries, least recently used first,
+until the cache fits. Called with the mutex held.
+===========
+*/
+static void COM_ZipCacheTrim (void)
+{
+	const size_t	  limit = (size_t)(q_max (fs_pk3cache.value, 0.0f) * 1024.0 * 1024.0);
+	zipcache_entry_t *entry, *prev;
+
+	for (entry = com_zip_cache_tail; entry && com_zip_cache_bytes > limit; entry = prev)
+	{
+		prev = entry->prev;
+		if (!entry->refcount)
+			COM_ZipCacheFree (entry);
+	}
+}
+
+/*
+===========
+COM_ZipCacheAcquire
+
+Returns the inflated entry pinned or NULL if it couldn't be
+inflated. Has to be released with COM_ZipCacheRelease.
+===========
+*/
+static zipcache_entry_t *COM_ZipCacheAcquire (pack_t *pak, int i)
+{
+	zippack_t		 *zip = (zippack_t *)pak->zip;
+	zipcache_entry_t *entry;
+	byte			 *data;
+	size_t			  size = 0;
+
+	SDL_LockMutex (com_zip_cache_mutex);
+	entry = zip->cache[i];
+	if (entry)
+	{
+		entry->refcount++;
+		COM_ZipCacheUnlink (entry);
+		COM_ZipCacheLinkFront (entry);
+	}
+	SDL_UnlockMutex (com_zip_cache_mutex);
+	if (entry)
+	{
+		Atomic_IncrementUInt32 (&com_num_zip_cache_hits);
+		return entry;
+	}
+
+	// inflate without holding the lock, so task workers can decompress different entries at once
+	data = (byte *)mz_zip_reader_extract_to_heap (&zip->archive, pak->files[i].filepos, &size, 0);
+	if (!data || size != (size_t)pak->files[i].filelen)
+	{
+		Con_Printf ("Couldn't inflate %s from %s\n", pak->files[i].name, pak->filename);
+		Mem_Free (data);
+		return NULL;
+	}
+	Atomic_IncrementUInt32 (&com_num_zip_inflates);
+	Atomic_AddUInt64 (&com_num_zip_inflated_bytes, size);
+
+	SDL_LockMutex (com_zip_cache_mutex);
+	entry = zip->cache[i];
+	if (entry)
+	{
+		// another thread got there first
+		Mem_Free (data);
+		COM_ZipCacheUnlink (entry);
+	}
+	else
+	{
+		entry = (zipcache_entry_t *)Mem_AllocTagged (sizeof (zipcache_entry_t), MEMTAG_FILESYSTEM);
+		entry->zip = zip;
+		entry->index = i;
+		entry->data = data;
+		entry->size = size;
+		zip->cache[i] = entry;
+		com_zip_cache_bytes += size;
+	}
+	entry->refcount++;
+	COM_ZipCacheLinkFront (entry);
+	COM_ZipCacheTrim ();
+	SDL_UnlockMutex (com_zip_cache_mutex);
+
+	return entry;
+}
+
+/*
+===========
+COM_ZipCacheRelease
+===========
+*/
+static void COM_ZipCacheRelease (zipcache_entry_t *entry)
+{
+	SDL_LockMutex (com_zip_cache_mutex);
+	if (!--entry->refcount && !entry->zip)
+	{
+		// orphaned by COM_FreePackFile while it was pinned
+		Mem_Free (entry->data);
+		Mem_Free (entry);
+	}
+	COM_ZipCacheTrim ();
+	SDL_UnlockMutex (com_zip_cache_mutex);
+}
+
+/*
+===========
+COM_OpenZipEntry
+
+COM_SearchFile for compressed pk3 entries
+===========
+*/
+static int COM_OpenZipEntry (pack_t *pak, int i, int *handle, FILE **file, com_file_t *cf)
+{
+	zipcache_entry_t *entry;
+	byte			 *copy;
+
+	if (!handle && !file && !cf)
+		return com_filesize; /* for COM_FileExists() */
+
+	entry = COM_ZipCacheAcquire (pak, i);
+	if (!entry)
+	{
+		if (handle)
+			*handle = -1;
+		if (file)
+			*file = NULL;
+		com_filesize = -1;
+		return com_filesize;
+	}
+
+	if (cf)
+	{
+		cf->data = entry->data;
+		cf->zip_entry = entry;
+		return com_filesize;
+	}
+
+	if (handle)
+	{
+		// the handle reads from a private copy, COM_CloseFile frees it
+		copy = (byte *)Mem_AllocNonZeroTagged (entry->size + 1, MEMTAG_FILESYSTEM);
+		memcpy (copy, entry->data, entry->size);
+		Sys_MemFileOpenRead (copy, entry->size, handle);
+		SDL_LockMutex (com_zip_cache_mutex);
+		HashMap_Insert (com_zip_handles, handle, &copy);
+		SDL_UnlockMutex (com_zip_cache_mutex);
+	}
+	else
+	{
+		// callers want a real FILE, so they get a temporary file with the inflated contents
+		*file = tmpfile ();
+		if (*file && fwrite (entry->data, 1, entry->size, *file) == entry->size)
+			rewind (*file);
+		else if (*file)
+		{
+			fclose (*file);
+			*file = NULL;
+		}
+	}
+	COM_ZipCacheRelease (entry);
+
+	return com_filesize;
+}
+
+/*
+===========
+COM_SearchFile
 
 Finds the file in the search path.
 Sets com_filesize and one of handle or file
 If neither of file or handle is set, this
 can be used for detecting a file's presence.
+If cf is set, it gets what's needed for
+reentrant reads and nothing is opened for paks.
 ===========
 */
-static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigned int *path_id)
+static int COM_SearchFile (const char *filename, int *handle, FILE **file, com_file_t *cf, unsigned int *path_id)
 {
 	searchpath_t *search;
 	char		  netpath[MAX_OSPATH];
 	pack_t		 *pak;
-	int			  i;
+	int			  i, num_dirs = 0;
 	qboolean	  is_config = !q_strcasecmp (filename, "config.cfg"), found = false;
 
 	if (file && handle)
@@ -1698,6 +2231,16 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 
 	file_from_pak = 0;
 
+	if (COM_IsKnownMissing (filename))
+	{
+		if (handle)
+			*handle = -1;
+		if (file)
+			*file = NULL;
+		com_filesize = -1;
+		return com_filesize;
+	}
+
 	//
 	// search through the path, one element at a time
 	//
@@ -1706,15 +2249,23 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 		if (search->pack) /* look through all the pak file elements */
 		{
 			pak = search->pack;
-			for (i = 0; i < pak->numfiles; i++)
+			i = COM_FindPackFile (pak, filename);
+			if (i >= 0)
 			{
-				if (strcmp (pak->files[i].name, filename) != 0)
-					continue;
 				// found it!
 				com_filesize = pak->files[i].filelen;
 				file_from_pak = 1;
 				if (path_id)
 					*path_id = search->path_id;
+				if (pak->files[i].compressed)
+					return COM_OpenZipEntry (pak, i, handle, file, cf);
+				if (cf)
+				{
+					cf->data = pak->data ? pak->data + pak->files[i].filepos : NULL;
+					cf->handle = pak->handle;
+					cf->start = pak->files[i].filepos;
+					return com_filesize;
+				}
 				if (handle)
 				{
 					*handle = pak->handle;
@@ -1745,15 +2296,17 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 			if (is_config)
 			{
 				q_snprintf (netpath, sizeof (netpath), "%s/" CONFIG_NAME, search->filename);
+				Atomic_IncrementUInt32 (&com_num_file_type_calls);
 				if (Sys_FileType (netpath) & FS_ENT_FILE)
 					found = true;
 			}
 
 			if (!found)
 			{
-				q_snprintf (netpath, sizeof (netpath), "%s/%s", search->filename, filename);
-				if (!(Sys_FileType (netpath) & FS_ENT_FILE))
+				num_dirs++;
+				if (!(COM_DirCacheFileType (search, filename) & FS_ENT_FILE))
 					continue;
+				q_snprintf (netpath, sizeof (netpath), "%s/%s", search->filename, filename);
 			}
 
 			if (path_id)
@@ -1764,10 +2317,11 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 				*handle = i;
 				return com_filesize;
 			}
-			else if (file)
+			else if (file || cf)
 			{
-				*file = fopen (netpath, "rb");
-				com_filesize = (*file == NULL) ? -1 : COM_filelength (*file);
+				FILE **f = file ? file : &cf->file;
+				*f = fopen (netpath, "rb");
+				com_filesize = (*f == NULL) ? -1 : COM_filelength (*f);
 				return com_filesize;
 			}
 			else
@@ -1784,6 +2338,10 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 	else
 		Con_DPrintf2 ("FindFile: can't find %s\n", filename);
 
+	// shareware only searches the base directories, so don't remember anything until registered
+	if (registered.value && !is_config)
+		COM_AddMissingFile (filename, num_dirs);
+
 	if (handle)
 		*handle = -1;
 	if (file)
@@ -1792,6 +2350,116 @@ static int COM_FindFile (const char *filename, int *handle, FILE **file, unsigne
 	return com_filesize;
 }
 
+/*
+===========
+COM_FindFile
+===========
+*/
+static int COM_FindFile (const char *filename, int *handle, FILE **file, com_file_t *cf, unsigned int *path_id)
+{
+	const uint64_t start = SDL_GetPerformanceCounter ();
+	const int	   filesize = COM_SearchFile (filename, handle, file, cf, path_id);
+	Atomic_IncrementUInt32 (&com_num_lookups);
+	Atomic_AddUInt64 (&com_lookup_ticks, SDL_GetPerformanceCounter () - start);
+	if (com_trace_file && filesize != -1)
+	{
+		SDL_LockMutex (com_trace_mutex);
+		if (com_trace_file)
+			fprintf (com_trace_file, "%s\n", filename);
+		SDL_UnlockMutex (com_trace_mutex);
+	}
+	return filesize;
+}
+
+/*
+===========
+COM_Trace_f
+
+"fstrace <file>" logs every file found until "fstrace", e.g. around a map
+load, for laying out paks with "mkpak -t <file>"
+===========
+*/
+static void COM_Trace_f (void)
+{
+	char  path[MAX_OSPATH];
+	FILE *f = NULL;
+
+	if (Cmd_Argc () > 1)
+	{
+		q_snprintf (path, sizeof (path), "%s/%s", com_gamedir, Cmd_Argv (1));
+		f = fopen (path, "w");
+		if (!f)
+		{
+			Con_Printf ("Couldn't open %s\n", path);
+			return;
+		}
+		COM_FlushDirectoryCache ();
+		Con_Printf ("Tracing file lookups to %s\n", path);
+	}
+	else if (!com_trace_file)
+	{
+		Con_Printf ("fstrace <file> : log the files found to <file> until \"fstrace\"\n");
+		return;
+	}
+
+	SDL_LockMutex (com_trace_mutex);
+	if (com_trace_file)
+		fclose (com_trace_file);
+	com_trace_file = f;
+	SDL_UnlockMutex (com_trace_mutex);
+}
+
+/*
+===========
+COM_FileSystemStats_f
+
+Lookup counters, e.g. "fsstats reset; map e1m1; fsstats"
+===========
+*/
+static void COM_FileSystemStats_f (void)
+{
+	if ((Cmd_Argc () > 1) && !strcmp (Cmd_Argv (1), "reset"))
+	{
+		Atomic_StoreUInt32 (&com_num_lookups, 0);
+		Atomic_StoreUInt32 (&com_num_pack_probes, 0);
+		Atomic_StoreUInt32 (&com_num_pack_compares_saved, 0);
+		Atomic_StoreUInt32 (&com_num_dir_probes, 0);
+		Atomic_StoreUInt32 (&com_num_dir_listings, 0);
+		Atomic_StoreUInt32 (&com_num_file_type_calls, 0);
+		Atomic_StoreUInt32 (&com_num_missing_hits, 0);
+		Atomic_StoreUInt32 (&com_num_missing_dir_lookups_saved, 0);
+		Atomic_StoreUInt64 (&com_lookup_ticks, 0);
+		Atomic_StoreUInt32 (&com_num_mapped_files, 0);
+		Atomic_StoreUInt64 (&com_num_mapped_bytes, 0);
+		Atomic_StoreUInt32 (&com_num_zip_inflates, 0);
+		Atomic_StoreUInt64 (&com_num_zip_inflated_bytes, 0);
+		Atomic_StoreUInt32 (&com_num_zip_cache_hits, 0);
+		return;
+	}
+
+	const double lookup_ms = (double)Atomic_LoadUInt64 (&com_lookup_ticks) * 1000.0 / (double)SDL_GetPerformanceFrequency ();
+	Con_Printf ("File lookups: %" SDL_PRIu32 " (%.2f ms)\n", Atomic_LoadUInt32 (&com_num_lookups), lookup_ms);
+	Con_Printf (
+		" pak probes: %" SDL_PRIu32 " (%" SDL_PRIu32 " directory compares avoided)\n", Atomic_LoadUInt32 (&com_num_pack_probes),
+		Atomic_LoadUInt32 (&com_num_pack_compares_saved));
+	Con_Printf (
+		" loose directory probes: %" SDL_PRIu32 " (%" SDL_PRIu32 " directories listed)\n", Atomic_LoadUInt32 (&com_num_dir_probes),
+		Atomic_LoadUInt32 (&com_num_dir_listings));
+	Con_Printf (" file type calls: %" SDL_PRIu32 "\n", Atomic_LoadUInt32 (&com_num_file_type_calls));
+	Con_Printf (
+		" known missing files: %" SDL_PRIu32 " (%" SDL_PRIu32 " directory cache lookups avoided)\n", Atomic_LoadUInt32 (&com_num_missing_hits),
+		Atomic_LoadUInt32 (&com_num_missing_dir_lookups_saved));
+	Con_Printf (
+		"Mapped pak reads: %" SDL_PRIu32 " (%.1f KB not copied)\n", Atomic_LoadUInt32 (&com_num_mapped_files),
+		(double)Atomic_LoadUInt64 (&com_num_mapped_bytes) / 1024.0);
+	SDL_LockMutex (com_zip_cache_mutex);
+	const size_t zip_cache_bytes = com_zip_cache_bytes;
+	SDL_UnlockMutex (com_zip_cache_mutex);
+	Con_Printf (
+		"Pk3 entries inflated: %" SDL_PRIu32 " (%.1f KB), cache hits: %" SDL_PRIu32 ", cached: %.1f KB\n", Atomic_LoadUInt32 (&com_num_zip_inflates),
+		(double)Atomic_LoadUInt64 (&com_num_zip_inflated_bytes) / 1024.0, Atomic_LoadUInt32 (&com_num_zip_cache_hits), (double)zip_cache_bytes / 1024.0);
+}
+
 /*
 ===========
 COM_FileExists
@@ -1801,7 +2469,7 @@ Returns whether the file is found in the quake filesystem.
 */
 qboolean COM_FileExists (const char *filename, unsigned int *path_id)
 {
-	int ret = COM_FindFile (filename, NULL, NULL, path_id);
+	int ret = COM_FindFile (filename, NULL, NULL, NULL, path_id);
 	return (ret == -1) ? false : true;
 }
 
@@ -1816,7 +2484,7 @@ it may actually be inside a pak file
 */
 int COM_OpenFile (const char *filename, int *handle, unsigned int *path_id)
 {
-	return COM_FindFile (filename, handle, NULL, path_id);
+	return COM_FindFile (filename, handle, NULL, NULL, path_id);
 }
 
 /*
@@ -1829,7 +2497,7 @@ into the file.
 */
 int COM_FOpenFile (const char *filename, FILE **file, unsigned int *path_id)
 {
-	return COM_FindFile (filename, NULL, file, path_id);
+	return COM_FindFile (filename, NULL, file, NULL, path_id);
 }
 
 /*
@@ -1842,12 +2510,109 @@ If it is a pak file handle, don't really close it
 void COM_CloseFile (int h)
 {
 	searchpath_t *s;
+	byte		**copy;
+	byte		 *data = NULL;
 
 	for (s = com_searchpaths; s; s = s->next)
 		if (s->pack && s->pack->handle == h)
 			return;
 
+	// forget the copy before the handle can be reused by another thread
+	SDL_LockMutex (com_zip_cache_mutex);
+	copy = HashMap_Lookup (byte *, com_zip_handles, &h);
+	if (copy)
+	{
+		data = *copy;
+		HashMap_Erase (com_zip_handles, &h);
+	}
+	SDL_UnlockMutex (com_zip_cache_mutex);
+
 	Sys_FileClose (h);
+	Mem_Free (data);
+}
+
+/*
+============
+COM_FileOpenRead
+
+Reentrant version of COM_OpenFile, file has to
+be closed with COM_FileClose.
+============
+*/
+qboolean COM_FileOpenRead (const char *filename, com_file_t *file)
+{
+	memset (file, 0, sizeof (*file));
+	file->handle = -1;
+
+	file->size = COM_FindFile (filename, NULL, NULL, file, &file->path_id);
+	if (file->size < 0 || (!file->data && !file->file && file->handle == -1))
+	{
+		COM_FileClose (file);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+============
+COM_FileReadAt
+
+Doesn't use or move the position of the file.
+Returns the number of bytes read.
+============
+*/
+int COM_FileReadAt (com_file_t *file, qfileofs_t ofs, void *dest, int count)
+{
+	if (ofs < 0 || ofs >= file->size || count <= 0)
+		return 0;
+	count = (int)q_min ((qfileofs_t)count, file->size - ofs);
+
+	if (file->data)
+	{
+		memcpy (dest, file->data + ofs, count);
+		return count;
+	}
+	if (file->file)
+		return Sys_pread (file->file, dest, count, ofs);
+	return Sys_FileReadAt (file->handle, file->start + ofs, dest, count);
+}
+
+/*
+============
+COM_FileRead
+============
+*/
+int COM_FileRead (com_file_t *file, void *dest, int count)
+{
+	const int num_read = COM_FileReadAt (file, file->pos, dest, count);
+	file->pos += num_read;
+	return num_read;
+}
+
+/*
+============
+COM_FileSeek
+============
+*/
+void COM_FileSeek (com_file_t *file, qfileofs_t pos)
+{
+	file->pos = CLAMP (0, pos, file->size);
+}
+
+/*
+============
+COM_FileClose
+============
+*/
+void COM_FileClose (com_file_t *file)
+{
+	if (file->file)
+		fclose (file->file);
+	if (file->zip_entry)
+		COM_ZipCacheRelease ((zipcache_entry_t *)file->zip_entry);
+	memset (file, 0, sizeof (*file));
+	file->handle = -1;
 }
 
 /*
@@ -1860,34 +2625,103 @@ Allways appends a 0 byte.
 */
 byte *COM_LoadFile (const char *path, unsigned int *path_id)
 {
-	int	  h;
-	byte *buf;
-	char  base[32];
-	int	  len;
+	com_file_t file;
+	byte	  *buf;
+	char	   base[32];
+	int		   len;
 
 	buf = NULL; // quiet compiler warning
 
 	// look for it in the filesystem or pack files
-	len = COM_OpenFile (path, &h, path_id);
-	if (h == -1)
+	if (!COM_FileOpenRead (path, &file))
 		return NULL;
+	if (path_id)
+		*path_id = file.path_id;
+	len = file.size;
 
 	// extract the filename base name for hunk tag
 	COM_FileBase (path, base, sizeof (base));
 
-	buf = (byte *)Mem_AllocNonZero (len + 1);
+	buf = (byte *)Mem_AllocNonZeroTagged (len + 1, MEMTAG_FILESYSTEM);
 
 	if (!buf)
 		Sys_Error ("COM_LoadFile: not enough space for %s", path);
 
 	((byte *)buf)[len] = 0;
 
-	Sys_FileRead (h, buf, len);
-	COM_CloseFile (h);
+	COM_FileRead (&file, buf, len);
+	COM_FileClose (&file);
 
 	return buf;
 }
 
+/*
+============
+COM_MapFile
+
+Like COM_LoadFile, but files in mapped paks
+are returned in place instead of being copied.
+The data is read-only and not 0 terminated.
+Inflated pk3 entries are copied out of the cache,
+so they can be evicted while the data is in use.
+============
+*/
+const byte *COM_MapFile (const char *path, int *len, unsigned int *path_id)
+{
+	com_file_t	file;
+	byte	   *buf;
+	const byte *data;
+
+	if (!COM_FileOpenRead (path, &file))
+		return NULL;
+
+	if (file.data && !file.zip_entry)
+	{
+		data = file.data;
+		Atomic_IncrementUInt32 (&com_num_mapped_files);
+		Atomic_AddUInt64 (&com_num_mapped_bytes, file.size);
+	}
+	else
+	{
+		buf = (byte *)Mem_AllocNonZeroTagged (file.size + 1, MEMTAG_FILESYSTEM);
+		if (!buf)
+			Sys_Error ("COM_MapFile: not enough space for %s", path);
+		buf[file.size] = 0;
+
+		COM_FileRead (&file, buf, file.size);
+		data = buf;
+	}
+
+	if (len)
+		*len = file.size;
+	if (path_id)
+		*path_id = file.path_id;
+	COM_FileClose (&file);
+	return data;
+}
+
+/*
+============
+COM_UnmapFile
+============
+*/
+void COM_UnmapFile (const byte *data)
+{
+	searchpath_t *search;
+
+	if (!data)
+		return;
+
+	for (search = com_searchpaths; search; search = search->next)
+	{
+		const pack_t *pak = search->pack;
+		if (pak && pak->data && data >= pak->data && data < pak->data + pak->data_size)
+			return;
+	}
+
+	Mem_Free ((void *)data);
+}
+
 byte *COM_LoadMallocFile_TextMode_OSPath (const char *path, long *len_out)
 {
 	FILE *f;
@@ -1909,7 +2743,7 @@ byte *COM_LoadMallocFile_TextMode_OSPath (const char *path, long *len_out)
 		return NULL;
 	}
 
-	data = (byte *)Mem_AllocNonZero (len + 1);
+	data = (byte *)Mem_AllocNonZeroTagged (len + 1, MEMTAG_FILESYSTEM);
 	if (data == NULL)
 	{
 		fclose (f);
@@ -1954,6 +2788,25 @@ const char *COM_ParseStringNewline (const char *buffer)
 	return buffer + consumed;
 }
 
+/*
+=================
+COM_BuildPackFileMap
+=================
+*/
+static void COM_BuildPackFileMap (pack_t *pack)
+{
+	int i;
+
+	// insert backwards so the first entry wins if a name appears more than once
+	pack->file_map = HashMap_Create (const char *, int, &HashStr, &HashStrCmp);
+	HashMap_Reserve (pack->file_map, pack->numfiles);
+	for (i = pack->numfiles - 1; i >= 0; i--)
+	{
+		const char *name = pack->files[i].name;
+		HashMap_Insert (pack->file_map, &name, &i);
+	}
+}
+
 /*
 =================
 COM_LoadPackFile -- johnfitz -- modified based on topaz's tutorial
@@ -1973,6 +2826,7 @@ static pack_t *COM_LoadPackFile (const char *packfile, int packhandle)
 	pack_t		  *pack;
 	dpackfile_t	   info[MAX_FILES_IN_PACK];
 	unsigned short crc;
+	qboolean	   sorted;
 
 	Sys_FileRead (packhandle, (void *)&header, sizeof (header));
 	if (header.id[0] != 'P' || header.id[1] != 'A' || header.id[2] != 'C' || header.id[3] != 'K')
@@ -1999,7 +2853,7 @@ static pack_t *COM_LoadPackFile (const char *packfile, int packhandle)
 	if (numpackfiles != PAK0_COUNT)
 		com_modified = true; // not the original file
 
-	newfiles = (packfile_t *)Mem_Alloc (numpackfiles * sizeof (packfile_t));
+	newfiles = (packfile_t *)Mem_AllocTagged (numpackfiles * sizeof (packfile_t), MEMTAG_FILESYSTEM);
 
 	Sys_FileSeek (packhandle, header.dirofs);
 	Sys_FileRead (packhandle, (void *)info, header.dirlen);
@@ -2019,11 +2873,26 @@ static pack_t *COM_LoadPackFile (const char *packfile, int packhandle)
 		newfiles[i].filelen = LittleLong (info[i].filelen);
 	}
 
-	pack = (pack_t *)Mem_Alloc (sizeof (pack_t));
+	// a sorted directory is searched in place, the marker itself is dropped
+	sorted = numpackfiles > 1 && !strcmp (newfiles[0].name, PAK_SORTED_MARKER);
+	for (i = 2; sorted && i < numpackfiles; i++)
+		sorted = strcmp (newfiles[i - 1].name, newfiles[i].name) < 0;
+	if (sorted)
+	{
+		memmove (newfiles, newfiles + 1, (numpackfiles - 1) * sizeof (packfile_t));
+		numpackfiles--;
+	}
+	else if (!strcmp (newfiles[0].name, PAK_SORTED_MARKER))
+		Sys_Printf ("WARNING: %s claims to be sorted but isn't\n", packfile);
+
+	pack = (pack_t *)Mem_AllocTagged (sizeof (pack_t), MEMTAG_FILESYSTEM);
 	q_strlcpy (pack->filename, packfile, sizeof (pack->filename));
 	pack->handle = packhandle;
 	pack->numfiles = numpackfiles;
 	pack->files = newfiles;
+	pack->sorted = sorted;
+	if (!sorted)
+		COM_BuildPackFileMap (pack);
 
 	// Sys_Printf ("Added packfile %s (%i files)\n", packfile, numpackfiles);
 	return pack;
@@ -2081,6 +2950,222 @@ qboolean COM_GameDirMatches (const char *tdirs)
 	return false;
 }
 
+/*
+=================
+COM_MapPackFile
+
+Maps the whole pak so files can be read without
+seeking the shared handle. Stays unmapped if any
+directory entry points past the end of the file.
+=================
+*/
+static void COM_MapPackFile (pack_t *pak)
+{
+	int i;
+
+	pak->data = Sys_MapFile (pak->filename, &pak->data_size);
+	if (!pak->data)
+		return;
+
+	for (i = 0; i < pak->numfiles; i++)
+	{
+		if (pak->files[i].filepos < 0 || pak->files[i].filelen < 0 || (qfileofs_t)pak->files[i].filepos + pak->files[i].filelen > pak->data_size)
+		{
+			Sys_UnmapFile (pak->data, pak->data_size);
+			pak->data = NULL;
+			pak->data_size = 0;
+			return;
+		}
+	}
+	pak->data_mapped = true;
+}
+
+/*
+=================
+COM_FreePackFile
+=================
+*/
+static void COM_FreePackFile (pack_t *pak)
+{
+	zippack_t *zip = (zippack_t *)pak->zip;
+	int		   i;
+
+	if (zip)
+	{
+		SDL_LockMutex (com_zip_cache_mutex);
+		for (i = 0; zip->cache && i < pak->numfiles; i++)
+		{
+			zipcache_entry_t *entry = zip->cache[i];
+			if (!entry)
+				continue;
+			if (!entry->refcount)
+			{
+				COM_ZipCacheFree (entry);
+				continue;
+			}
+			// still pinned by a com_file_t, COM_ZipCacheRelease frees it
+			COM_ZipCacheUnlink (entry);
+			com_zip_cache_bytes -= entry->size;
+			entry->zip = NULL;
+		}
+		SDL_UnlockMutex (com_zip_cache_mutex);
+		mz_zip_reader_end (&zip->archive);
+		Mem_Free (zip->cache);
+		Mem_Free (zip);
+	}
+	Sys_FileClose (pak->handle);
+	if (pak->data_mapped)
+		Sys_UnmapFile (pak->data, pak->data_size);
+	if (pak->file_map)
+		HashMap_Destroy (pak->file_map);
+	Mem_Free (pak->files);
+	Mem_Free (pak);
+}
+
+/*
+=================
+COM_LoadZipFile
+
+Mounts a pk3 like a pak. The names in the central directory go into the
+same file map, stored entries are read in place like pak entries and
+compressed ones are inflated through the pk3 entry cache.
+=================
+*/
+static pack_t *COM_LoadZipFile (const char *zipfile)
+{
+	mz_zip_archive_file_stat stat;
+	byte					 local_header[30];
+	zippack_t				*zip;
+	pack_t					*pack;
+	packfile_t				*file;
+	qfileofs_t				 filesize, ofs;
+	int						 packhandle, numzipfiles, i;
+
+	filesize = Sys_FileOpenRead (zipfile, &packhandle);
+	if (packhandle == -1)
+		return NULL;
+
+	pack = (pack_t *)Mem_AllocTagged (sizeof (pack_t), MEMTAG_FILESYSTEM);
+	q_strlcpy (pack->filename, zipfile, sizeof (pack->filename));
+	pack->handle = packhandle;
+	pack->data = Sys_MapFile (zipfile, &pack->data_size);
+	pack->data_mapped = (pack->data != NULL);
+
+	zip = (zippack_t *)Mem_AllocTagged (sizeof (zippack_t), MEMTAG_FILESYSTEM);
+	zip->pack = pack;
+	zip->archive.m_pRead = COM_ZipRead;
+	zip->archive.m_pIO_opaque = zip;
+	pack->zip = zip;
+	if (!mz_zip_reader_init (&zip->archive, filesize, 0))
+	{
+		Sys_Printf ("WARNING: %s is not a valid pk3, ignored\n", zipfile);
+		COM_FreePackFile (pack);
+		return NULL;
+	}
+
+	numzipfiles = (int)q_min (zip->archive.m_total_files, (mz_uint32)INT_MAX);
+	pack->files = (packfile_t *)Mem_AllocTagged (q_max (numzipfiles, 1) * sizeof (packfile_t), MEMTAG_FILESYSTEM);
+	for (i = 0; i < numzipfiles; i++)
+	{
+		if (!mz_zip_reader_file_stat (&zip->archive, i, &stat) || stat.m_is_directory || stat.m_is_encrypted || !stat.m_is_supported)
+			continue;
+		if (stat.m_uncomp_size > INT_MAX || strlen (stat.m_filename) >= MAX_QPATH)
+			continue;
+
+		file = &pack->files[pack->numfiles++];
+		q_strlcpy (file->name, stat.m_filename, sizeof (file->name));
+		file->filepos = i;
+		file->filelen = (int)stat.m_uncomp_size;
+		file->compressed = true;
+
+		// stored entries start after the local header, which has its own name and extra field lengths
+		if (stat.m_method == 0 && COM_ZipRead (zip, stat.m_local_header_ofs, local_header, sizeof (local_header)) == sizeof (local_header) &&
+			local_header[0] == 'P' && local_header[1] == 'K' && local_header[2] == 3 && local_header[3] == 4)
+		{
+			ofs = stat.m_local_header_ofs + sizeof (local_header) + (local_header[26] | (local_header[27] << 8)) + (local_header[28] | (local_header[29] << 8));
+			if (ofs + file->filelen <= filesize && ofs <= INT_MAX)
+			{
+				file->filepos = (int)ofs;
+				file->compressed = false;
+			}
+		}
+	}
+
+	if (!pack->numfiles)
+	{
+		Sys_Printf ("WARNING: %s has no files, ignored\n", zipfile);
+		COM_FreePackFile (pack);
+		return NULL;
+	}
+
+	com_modified = true; // not an id file
+	zip->cache = (zipcache_entry_t **)Mem_AllocTagged (pack->numfiles * sizeof (zipcache_entry_t *), MEMTAG_FILESYSTEM);
+	COM_BuildPackFileMap (pack);
+
+	return pack;
+}
+
+/*
+=================
+COM_AddZipFileName
+=================
+*/
+static void COM_AddZipFileName (const char *name, int type, void *userdata)
+{
+	char ***names = (char ***)userdata;
+	char   *copy;
+
+	if ((type & FS_ENT_FILE) && !q_strcasecmp (COM_FileGetExtension (name), "pk3"))
+	{
+		copy = q_strdup (name);
+		VEC_PUSH (*names, copy);
+	}
+}
+
+static int COM_CompareZipFileNames (const void *a, const void *b)
+{
+	return q_strcasecmp (*(char *const *)a, *(char *const *)b);
+}
+
+/*
+=================
+COM_AddZipFiles
+
+Adds every pk3 in com_gamedir, in alphabetical order so
+later ones override earlier ones like numbered paks
+=================
+*/
+static void COM_AddZipFiles (const char *dir, unsigned int path_id)
+{
+	char		**names = NULL;
+	char		  zipfile[MAX_OSPATH];
+	searchpath_t *search;
+	pack_t		 *pak;
+	size_t		  i;
+
+	Sys_ListDirectory (com_gamedir, COM_AddZipFileName, &names);
+	if (!names)
+		return;
+	qsort (names, VEC_SIZE (names), sizeof (char *), COM_CompareZipFileNames);
+
+	for (i = 0; i < VEC_SIZE (names); i++)
+	{
+		q_snprintf (zipfile, sizeof (zipfile), "%s/%s", com_gamedir, names[i]);
+		pak = COM_LoadZipFile (zipfile);
+		if (pak)
+		{
+			search = (searchpath_t *)Mem_AllocTagged (sizeof (searchpath_t), MEMTAG_FILESYSTEM);
+			search->path_id = path_id;
+			search->pack = pak;
+			q_strlcpy (search->dir, dir, sizeof (search->dir));
+			search->next = com_searchpaths;
+			com_searchpaths = search;
+		}
+		Mem_Free (names[i]);
+	}
+	VEC_FREE (names);
+}
+
 /*
 =================
 COM_AddGameDirectory -- johnfitz -- modified based on topaz's tutorial
@@ -2124,7 +3209,7 @@ static void COM_AddGameDirectory (const char *dir)
 
 _add_path:
 	// add the directory to the search path
-	search = (searchpath_t *)Mem_Alloc (sizeof (searchpath_t));
+	search = (searchpath_t *)Mem_AllocTagged (sizeof (searchpath_t), MEMTAG_FILESYSTEM);
 	search->path_id = path_id;
 	q_strlcpy (search->filename, com_gamedir, sizeof (search->filename));
 	q_strlcpy (search->dir, dir, sizeof (search->dir));
@@ -2140,7 +3225,8 @@ _add_path:
 		pak = COM_LoadPackFile (pakfile, packhandle);
 		if (pak)
 		{
-			search = (searchpath_t *)Mem_Alloc (sizeof (searchpath_t));
+			COM_MapPackFile (pak);
+			search = (searchpath_t *)Mem_AllocTagged (sizeof (searchpath_t), MEMTAG_FILESYSTEM);
 			search->path_id = path_id;
 			search->pack = pak;
 			q_strlcpy (search->dir, dir, sizeof (search->dir));
@@ -2155,7 +3241,7 @@ _add_path:
 			{
 				tinfl_decompressor inflator;
 				tinfl_init (&inflator);
-				vkquake_pak_extracted = Mem_Alloc (vkquake_pak_size_extracted);
+				vkquake_pak_extracted = Mem_AllocTagged (vkquake_pak_size_extracted, MEMTAG_FILESYSTEM);
 				if (TINFL_STATUS_DONE != tinfl_decompress (
 											 &inflator, vkquake_pak, &vkquake_pak_size_compressed, vkquake_pak_extracted, vkquake_pak_extracted,
 											 &vkquake_pak_size_extracted, TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF))
@@ -2164,7 +3250,9 @@ _add_path:
 			qboolean pak0_modified = com_modified;
 			Sys_MemFileOpenRead (vkquake_pak_extracted, vkquake_pak_size_extracted, &packhandle);
 			pak = COM_LoadPackFile ("vkquake.pak", packhandle);
-			search = (searchpath_t *)Mem_Alloc (sizeof (searchpath_t));
+			pak->data = vkquake_pak_extracted;
+			pak->data_size = vkquake_pak_size_extracted;
+			search = (searchpath_t *)Mem_AllocTagged (sizeof (searchpath_t), MEMTAG_FILESYSTEM);
 			search->path_id = path_id;
 			search->pack = pak;
 			q_strlcpy (search->dir, dir, sizeof (search->dir));
@@ -2177,6 +3265,9 @@ _add_path:
 			break;
 	}
 
+	// pk3s override the numbered paks
+	COM_AddZipFiles (dir, path_id);
+
 	if (!been_here && host_parms->userdir != host_parms->basedir)
 	{
 		been_here = true;
@@ -2195,15 +3286,18 @@ void COM_ResetGameDirectories (const char *newdirs)
 	while (com_searchpaths != com_base_searchpaths)
 	{
 		if (com_searchpaths->pack)
-		{
-			Sys_FileClose (com_searchpaths->pack->handle);
-			Mem_Free (com_searchpaths->pack->files);
-			Mem_Free (com_searchpaths->pack);
-		}
+			COM_FreePackFile (com_searchpaths->pack);
+		SDL_LockMutex (com_dir_cache_mutex);
+		COM_FreeDirCache (com_searchpaths);
+		SDL_UnlockMutex (com_dir_cache_mutex);
 		search = com_searchpaths->next;
 		Mem_Free (com_searchpaths);
 		com_searchpaths = search;
 	}
+	// the negative cache is only valid for the current game directories
+	SDL_LockMutex (com_dir_cache_mutex);
+	COM_FreeMissingFiles ();
+	SDL_UnlockMutex (com_dir_cache_mutex);
 	hipnotic = false;
 	rogue = false;
 	standard_quake = true;
@@ -2308,6 +3402,7 @@ static void COM_Game_f (void)
 		// Write config file
 		Host_WriteConfiguration ();
 
+		SV_CancelPrefetch ();
 		COM_ResetGameDirectories (paths);
 
 		// clear out and reload appropriate data
@@ -2348,8 +3443,17 @@ void COM_InitFilesystem (void) // johnfitz -- modified based on topaz's tutorial
 
 	Cvar_RegisterVariable (&registered);
 	Cvar_RegisterVariable (&cmdline);
+	Cvar_RegisterVariable (&fs_pk3cache);
 	Cmd_AddCommand ("path", COM_Path_f);
+	Cmd_AddCommand ("flush", COM_FlushDirectoryCache);
 	Cmd_AddCommand ("game", COM_Game_f); // johnfitz
+	Cmd_AddCommand ("fsstats", COM_FileSystemStats_f);
+	Cmd_AddCommand ("fstrace", COM_Trace_f);
+
+	com_dir_cache_mutex = SDL_CreateMutex ();
+	com_zip_cache_mutex = SDL_CreateMutex ();
+	com_trace_mutex = SDL_CreateMutex ();
+	com_zip_handles = HashMap_Create (int, byte *, &HashInt32, NULL);
 
 	i = COM_CheckParm ("-basedir");
 	if (i && i < com_argc - 1)
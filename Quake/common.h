@@ -316,10 +316,13 @@ size_t		LOC_Format (const char *format, const char *(*getarg_fn) (int idx, void
 //============================================================================
 
 // QUAKEFS
+typedef struct hash_map_s hash_map_t;
+
 typedef struct
 {
-	char name[MAX_QPATH];
-	int	 filepos, filelen;
+	char	 name[MAX_QPATH];
+	int		 filepos, filelen;
+	qboolean compressed; // pk3 entry that has to be inflated, filepos is its index in the zip directory
 } packfile_t;
 
 typedef struct pack_s
@@ -328,6 +331,12 @@ typedef struct pack_s
 	int			handle;
 	int			numfiles;
 	packfile_t *files;
+	hash_map_t *file_map; // name -> index into files, NULL if sorted
+	qboolean	sorted;	  // files are in strcmp order and searched with bsearch
+	const byte *data;	  // the whole pak, read-only, NULL if it couldn't be mapped
+	qfileofs_t	data_size;
+	qboolean	data_mapped; // false for the embedded pak, which lives in memory
+	void	   *zip;		 // zip directory and inflated entry cache of a pk3, NULL for paks
 } pack_t;
 
 typedef struct searchpath_s
@@ -339,6 +348,8 @@ typedef struct searchpath_s
 	pack_t				*pack;			 // only one of filename / pack will be used
 	char				 dir[MAX_QPATH]; // directory name: "id1", "rogue", etc.
 	struct searchpath_s *next;
+	// lazily built listings of loose directories: relative dir -> (file name -> FS_ENT_*)
+	hash_map_t			*dir_cache;
 } searchpath_t;
 
 extern searchpath_t *com_searchpaths;
@@ -360,9 +371,37 @@ int		 COM_OpenFile (const char *filename, int *handle, unsigned int *path_id);
 int		 COM_FOpenFile (const char *filename, FILE **file, unsigned int *path_id);
 qboolean COM_FileExists (const char *filename, unsigned int *path_id);
 void	 COM_CloseFile (int h);
+void	 COM_FlushDirectoryCache (void); // call after creating files in the game directories
 
 byte *COM_LoadFile (const char *path, unsigned int *path_id);
 
+// Reentrant access to files in the search path. Each open file has its own
+// position and pak reads don't touch the shared pak handle, so task workers
+// can load files concurrently.
+typedef struct com_file_s
+{
+	const byte	*data;	 // file contents inside a mapped pak or the pk3 cache
+	FILE		*file;	 // loose file, owned
+	int			 handle; // pak handle for positional reads, or -1
+	qfileofs_t	 start;	 // offset of the file inside the pak
+	qfileofs_t	 size;
+	qfileofs_t	 pos;
+	unsigned int path_id;
+	void		*zip_entry; // inflated pk3 entry, pinned in the cache until closed
+} com_file_t;
+
+qboolean COM_FileOpenRead (const char *filename, com_file_t *file);
+int		 COM_FileRead (com_file_t *file, void *dest, int count);
+int		 COM_FileReadAt (com_file_t *file, qfileofs_t ofs, void *dest, int count);
+void	 COM_FileSeek (com_file_t *file, qfileofs_t pos);
+void	 COM_FileClose (com_file_t *file);
+
+// Returns a read-only view of the file and sets len if it isn't NULL. Files in
+// mapped paks are returned in place, anything else is loaded into memory.
+// Release with COM_UnmapFile before the game directories change.
+const byte *COM_MapFile (const char *path, int *len, unsigned int *path_id);
+void		COM_UnmapFile (const byte *data);
+
 // Opens the given path directly, ignoring search paths.
 // Returns NULL on failure, or else a '\0'-terminated malloc'ed buffer.
 // Loads in "t" mode so CRLF to LF translation is performed on Windows.
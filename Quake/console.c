@@ -201,6 +201,7 @@ static void Con_Dump_f (void)
 	}
 
 	fclose (f);
+	COM_FlushDirectoryCache ();
 	Con_Printf ("Dumped console text to %s.\n", name);
 }
 
@@ -30,8 +30,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 ================================================================================
 */
 
-#define NUM_SMALL_ALLOC_SIZES  6 // 64 bit mask
-#define NUM_BLOCK_SIZE_CLASSES 8
+#define NUM_SMALL_ALLOC_SIZES  GL_HEAP_NUM_SMALL_ALLOC_SIZES // 64 bit mask
+#define NUM_BLOCK_SIZE_CLASSES GL_HEAP_NUM_BLOCK_SIZE_CLASSES
 #define MAX_PAGES			   (UINT16_MAX - 1)
 #define INVALID_PAGE_INDEX	   UINT16_MAX
 
@@ -77,6 +77,10 @@ typedef struct glheapsegment_s
 	uint64_t				*free_blocks_skip_bitfields[NUM_BLOCK_SIZE_CLASSES];
 	page_index_t			 small_alloc_free_list_heads[NUM_SMALL_ALLOC_SIZES];
 	page_index_t			 num_pages_allocated;
+	page_index_t			 num_small_alloc_pages[NUM_SMALL_ALLOC_SIZES];
+	uint32_t				 num_small_alloc_slots_used[NUM_SMALL_ALLOC_SIZES];
+	glheapallocation_t		*allocations;
+	qboolean				 evacuating; // GL_HeapCompact is moving allocations out of this segment
 } glheapsegment_t;
 
 typedef struct glheap_s
@@ -94,6 +98,7 @@ typedef struct glheap_s
 	page_index_t		 num_masks_per_segment;
 	glheapsegment_t	   **segments;
 	uint64_t			 dedicated_alloc_bytes;
+	glheaprelocatefunc_t relocate;
 	glheapstats_t		 stats;
 } glheap_t;
 
@@ -128,9 +133,13 @@ typedef struct glheapallocation_s
 		glheapsegment_t *segment;
 		vulkan_memory_t *memory;
 	};
-	VkDeviceSize size;
-	VkDeviceSize offset;
-	alloc_type_t alloc_type;
+	VkDeviceSize		size;
+	VkDeviceSize		offset;
+	VkDeviceSize		alignment;
+	alloc_type_t		alloc_type;
+	void			   *owner;
+	glheapallocation_t *prev_in_segment;
+	glheapallocation_t *next_in_segment;
 #ifndef NDEBUG
 	uint32_t small_alloc_slot;
 	uint32_t small_alloc_size;
@@ -227,6 +236,59 @@ static glheapsegment_t *GL_CreateHeapSegment (glheap_t *heap, atomic_uint32_t *n
 	return segment;
 }
 
+/*
+===============
+GL_DestroyHeapSegment
+===============
+*/
+static void GL_DestroyHeapSegment (glheapsegment_t *segment, atomic_uint32_t *num_allocations)
+{
+	R_FreeVulkanMemory (&segment->memory, num_allocations);
+	Mem_Free (segment->page_hdrs);
+	Mem_Free (segment->small_alloc_links);
+	Mem_Free (segment->small_alloc_masks);
+	for (int i = 0; i < NUM_BLOCK_SIZE_CLASSES; ++i)
+	{
+		Mem_Free (segment->free_blocks_bitfields[i]);
+		Mem_Free (segment->free_blocks_skip_bitfields[i]);
+	}
+	Mem_Free (segment);
+}
+
+/*
+===============
+GL_HeapLinkAllocation
+===============
+*/
+static void GL_HeapLinkAllocation (glheapsegment_t *segment, glheapallocation_t *allocation)
+{
+	allocation->prev_in_segment = NULL;
+	allocation->next_in_segment = segment->allocations;
+	if (segment->allocations)
+		segment->allocations->prev_in_segment = allocation;
+	segment->allocations = allocation;
+}
+
+/*
+===============
+GL_HeapUnlinkAllocation
+===============
+*/
+static void GL_HeapUnlinkAllocation (glheapsegment_t *segment, glheapallocation_t *allocation)
+{
+	if (allocation->prev_in_segment)
+		allocation->prev_in_segment->next_in_segment = allocation->next_in_segment;
+	else
+	{
+		assert (segment->allocations == allocation);
+		segment->allocations = allocation->next_in_segment;
+	}
+	if (allocation->next_in_segment)
+		allocation->next_in_segment->prev_in_segment = allocation->prev_in_segment;
+	allocation->prev_in_segment = NULL;
+	allocation->next_in_segment = NULL;
+}
+
 /*
 ===============
 GL_HeapAllocateBlockFromSegment
@@ -399,7 +461,9 @@ static void GL_HeapSmallAllocateFromBlock (
 	{
 		// New page, add to free list
 		GL_HeapAddPageToSmallFreeList (segment, block_page_index, small_alloc_bucket);
+		++segment->num_small_alloc_pages[small_alloc_bucket];
 	}
+	++segment->num_small_alloc_slots_used[small_alloc_bucket];
 
 	const uint32_t slot_index = FindFirstBitNonZero (~(*small_alloc_mask));
 	TRACE_LOG (" Allocated slot %d from page %u\n", slot_index, block_page_index);
@@ -456,12 +520,14 @@ static qboolean GL_HeapSmallFreeFromBlock (glheap_t *heap, glheapsegment_t *segm
 
 	assert ((*small_alloc_mask & (1ull << slot_index)) != 0);
 	*small_alloc_mask &= ~(1ull << slot_index);
+	--segment->num_small_alloc_slots_used[small_alloc_bucket];
 
 	qboolean page_empty = *small_alloc_mask == 0ull;
 	if (page_empty)
 	{
 		// Page is now empty, remove from free list
 		GL_HeapRemovePageFromSmallFreeList (segment, block_page_index, small_alloc_bucket);
+		--segment->num_small_alloc_pages[small_alloc_bucket];
 	}
 
 	return page_empty;
@@ -578,6 +644,43 @@ static void GL_HeapFreeBlockFromSegment (glheap_t *heap, glheapsegment_t *segmen
 	GL_HeapMarkBlockFree (heap, segment, block_page_hdr->size_in_pages, block_page_index);
 }
 
+/*
+===============
+GL_HeapFreeFromSegment
+===============
+*/
+static void GL_HeapFreeFromSegment (glheap_t *heap, glheapallocation_t *allocation)
+{
+	glheapsegment_t *segment = allocation->segment;
+	GL_HeapUnlinkAllocation (segment, allocation);
+	if (allocation->alloc_type == ALLOC_TYPE_PAGES)
+		GL_HeapFreeBlockFromSegment (heap, segment, heap->page_size_shift, allocation->offset);
+	else if (GL_HeapSmallFreeFromBlock (heap, segment, allocation))
+		GL_HeapFreeBlockFromSegment (heap, segment, heap->page_size_shift, allocation->offset);
+}
+
+/*
+===============
+GL_HeapGetAllocInfo
+===============
+*/
+static void GL_HeapGetAllocInfo (glheap_t *heap, VkDeviceSize size, VkDeviceSize alignment, allocinfo_t *alloc_info)
+{
+	const VkDeviceSize size_alignment_max = q_max (size, alignment);
+	alloc_info->is_small_alloc = size_alignment_max <= heap->page_size / 2;
+	if (alloc_info->is_small_alloc)
+	{
+		alloc_info->small_alloc_size = q_max (Q_nextPow2 (size_alignment_max), heap->min_small_alloc_size);
+		alloc_info->small_alloc_bucket = Q_log2 (alloc_info->small_alloc_size >> heap->small_alloc_shift);
+	}
+	else
+	{
+		alloc_info->alloc_size_in_pages = (size + heap->page_size - 1) >> heap->page_size_shift;
+		alloc_info->alignment_in_pages = (alignment + heap->page_size - 1) >> heap->page_size_shift;
+		alloc_info->size_class = q_min (Q_log2 (alloc_info->alloc_size_in_pages), NUM_BLOCK_SIZE_CLASSES - 1);
+	}
+}
+
 /*
 ===============
 GL_HeapCreate
@@ -612,18 +715,7 @@ GL_HeapDestroy
 void GL_HeapDestroy (glheap_t *heap, atomic_uint32_t *num_allocations)
 {
 	for (uint32_t mask_page_offset = 0; mask_page_offset < heap->num_segments; ++mask_page_offset)
-	{
-		glheapsegment_t *segment = heap->segments[mask_page_offset];
-		R_FreeVulkanMemory (&segment->memory, num_allocations);
-		Mem_Free (segment->page_hdrs);
-		Mem_Free (segment->small_alloc_links);
-		Mem_Free (segment->small_alloc_masks);
-		for (int mask_page_index = 0; mask_page_index < NUM_BLOCK_SIZE_CLASSES; ++mask_page_index)
-		{
-			Mem_Free (segment->free_blocks_bitfields[mask_page_index]);
-			Mem_Free (segment->free_blocks_skip_bitfields[mask_page_index]);
-		}
-	}
+		GL_DestroyHeapSegment (heap->segments[mask_page_offset], num_allocations);
 	Mem_Free (heap->segments);
 }
 
@@ -639,6 +731,7 @@ glheapallocation_t *GL_HeapAllocate (glheap_t *heap, VkDeviceSize size, VkDevice
 
 	glheapallocation_t *allocation = Mem_Alloc (sizeof (glheapallocation_t));
 	allocation->size = size;
+	allocation->alignment = alignment;
 
 	++heap->stats.num_allocations;
 	heap->stats.num_bytes_allocated += size;
@@ -646,21 +739,11 @@ glheapallocation_t *GL_HeapAllocate (glheap_t *heap, VkDeviceSize size, VkDevice
 	if (size < heap->segment_size)
 	{
 		ZEROED_STRUCT (allocinfo_t, alloc_info);
-		const VkDeviceSize size_alignment_max = q_max (size, alignment);
-		alloc_info.is_small_alloc = size_alignment_max <= heap->page_size / 2;
+		GL_HeapGetAllocInfo (heap, size, alignment, &alloc_info);
 		if (alloc_info.is_small_alloc)
-		{
 			++heap->stats.num_small_allocations;
-			alloc_info.small_alloc_size = q_max (Q_nextPow2 (size_alignment_max), heap->min_small_alloc_size);
-			alloc_info.small_alloc_bucket = Q_log2 (alloc_info.small_alloc_size >> heap->small_alloc_shift);
-		}
 		else
-		{
 			++heap->stats.num_block_allocations;
-			alloc_info.alloc_size_in_pages = (size + heap->page_size - 1) >> heap->page_size_shift;
-			alloc_info.alignment_in_pages = (alignment + heap->page_size - 1) >> heap->page_size_shift;
-			alloc_info.size_class = q_min (Q_log2 (alloc_info.alloc_size_in_pages), NUM_BLOCK_SIZE_CLASSES - 1);
-		}
 
 		const uint32_t num_segments = heap->num_segments;
 		for (uint32_t mask_page_offset = 0; mask_page_offset < (num_segments + 1); ++mask_page_offset)
@@ -673,9 +756,16 @@ glheapallocation_t *GL_HeapAllocate (glheap_t *heap, VkDeviceSize size, VkDevice
 				++heap->num_segments;
 			}
 
-			const qboolean success = GL_HeapAllocateFromSegment (allocation, heap, heap->segments[mask_page_offset], &alloc_info);
+			glheapsegment_t *segment = heap->segments[mask_page_offset];
+			if (segment->evacuating)
+				continue;
+
+			const qboolean success = GL_HeapAllocateFromSegment (allocation, heap, segment, &alloc_info);
 			if (success)
+			{
+				GL_HeapLinkAllocation (segment, allocation);
 				return allocation;
+			}
 		}
 
 		Sys_Error ("GL_HeapAllocate failed to allocate");
@@ -713,7 +803,7 @@ void GL_HeapFree (glheap_t *heap, glheapallocation_t *allocation, atomic_uint32_
 	if (allocation->alloc_type == ALLOC_TYPE_PAGES)
 	{
 		--heap->stats.num_block_allocations;
-		GL_HeapFreeBlockFromSegment (heap, allocation->segment, heap->page_size_shift, allocation->offset);
+		GL_HeapFreeFromSegment (heap, allocation);
 	}
 	else if (allocation->alloc_type == ALLOC_TYPE_DEDICATED)
 	{
@@ -725,8 +815,7 @@ void GL_HeapFree (glheap_t *heap, glheapallocation_t *allocation, atomic_uint32_
 	else if (allocation->alloc_type >= ALLOC_TYPE_SMALL_ALLOC)
 	{
 		--heap->stats.num_small_allocations;
-		if (GL_HeapSmallFreeFromBlock (heap, allocation->segment, allocation))
-			GL_HeapFreeBlockFromSegment (heap, allocation->segment, heap->page_size_shift, allocation->offset);
+		GL_HeapFreeFromSegment (heap, allocation);
 	}
 	Mem_Free (allocation);
 }
@@ -759,6 +848,11 @@ GL_HeapGetStats
 glheapstats_t *GL_HeapGetStats (glheap_t *heap)
 {
 	heap->stats.num_pages_allocated = 0;
+	heap->stats.largest_free_block_pages = 0;
+	memset (heap->stats.num_small_alloc_slots_used, 0, sizeof (heap->stats.num_small_alloc_slots_used));
+	memset (heap->stats.num_small_alloc_slots_total, 0, sizeof (heap->stats.num_small_alloc_slots_total));
+	memset (heap->stats.num_free_blocks_per_class, 0, sizeof (heap->stats.num_free_blocks_per_class));
+	memset (heap->stats.num_free_pages_per_class, 0, sizeof (heap->stats.num_free_pages_per_class));
 	uint32_t num_total_pages = 0;
 	uint64_t total_allocated_page_bytes = 0;
 	uint32_t small_alloc_pages_bytes = 0;
@@ -786,6 +880,23 @@ glheapstats_t *GL_HeapGetStats (glheap_t *heap)
 				}
 				small_alloc_page_index = links->next_small_alloc_page;
 			}
+			heap->stats.num_small_alloc_slots_used[i] += segment->num_small_alloc_slots_used[i];
+			heap->stats.num_small_alloc_slots_total[i] += segment->num_small_alloc_pages[i] * slots_per_page;
+		}
+
+		// Walk the block list to get the free space per size class
+		uint32_t block_page_index = 0;
+		while (block_page_index < heap->num_pages_per_segment)
+		{
+			const uint32_t size_in_pages = segment->page_hdrs[block_page_index].size_in_pages;
+			if (GL_HeapIsBlockFree (heap, segment, block_page_index))
+			{
+				const int size_class = q_min (Q_log2 (size_in_pages), NUM_BLOCK_SIZE_CLASSES - 1);
+				heap->stats.num_free_blocks_per_class[size_class] += 1;
+				heap->stats.num_free_pages_per_class[size_class] += size_in_pages;
+				heap->stats.largest_free_block_pages = q_max (heap->stats.largest_free_block_pages, size_in_pages);
+			}
+			block_page_index += size_in_pages;
 		}
 	}
 	heap->stats.num_segments = heap->num_segments;
@@ -796,6 +907,167 @@ glheapstats_t *GL_HeapGetStats (glheap_t *heap)
 	return &heap->stats;
 }
 
+/*
+===============
+GL_HeapSetRelocateCallback
+===============
+*/
+void GL_HeapSetRelocateCallback (glheap_t *heap, glheaprelocatefunc_t relocate)
+{
+	heap->relocate = relocate;
+}
+
+/*
+===============
+GL_HeapSetAllocationOwner
+
+Allocations without an owner are never moved by GL_HeapCompact
+===============
+*/
+void GL_HeapSetAllocationOwner (glheapallocation_t *allocation, void *owner)
+{
+	allocation->owner = owner;
+}
+
+/*
+===============
+GL_HeapIsSegmentMovable
+===============
+*/
+static qboolean GL_HeapIsSegmentMovable (glheapsegment_t *segment)
+{
+	for (glheapallocation_t *allocation = segment->allocations; allocation != NULL; allocation = allocation->next_in_segment)
+		if (!allocation->owner)
+			return false;
+	return true;
+}
+
+/*
+===============
+GL_HeapRelocateAllocation
+===============
+*/
+static qboolean GL_HeapRelocateAllocation (glheap_t *heap, glheapallocation_t *allocation)
+{
+	ZEROED_STRUCT (allocinfo_t, alloc_info);
+	GL_HeapGetAllocInfo (heap, allocation->size, allocation->alignment, &alloc_info);
+
+	// Place first, only release the old range once the allocation has somewhere to go
+	ZEROED_STRUCT (glheapallocation_t, placement);
+	for (uint32_t i = 0; i < heap->num_segments; ++i)
+	{
+		glheapsegment_t *segment = heap->segments[i];
+		if (segment->evacuating || !GL_HeapAllocateFromSegment (&placement, heap, segment, &alloc_info))
+			continue;
+
+		const VkDeviceMemory old_memory = allocation->segment->memory.handle;
+		const VkDeviceSize	 old_offset = allocation->offset;
+		GL_HeapFreeFromSegment (heap, allocation);
+
+		assert (placement.alloc_type == allocation->alloc_type);
+		allocation->segment = placement.segment;
+		allocation->offset = placement.offset;
+#ifndef NDEBUG
+		allocation->small_alloc_slot = placement.small_alloc_slot;
+		allocation->small_alloc_size = placement.small_alloc_size;
+#endif
+		GL_HeapLinkAllocation (segment, allocation);
+
+		++heap->stats.num_relocations;
+		heap->stats.num_bytes_relocated += allocation->size;
+		heap->relocate (allocation->owner, allocation, old_memory, old_offset);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+===============
+GL_HeapCompact
+
+Moves all allocations out of segments that are at most max_occupancy full so
+GL_HeapReleaseEmptySegments can give their memory back. Segments that hold
+allocations without an owner are left alone. The relocate callback is
+responsible for copying the contents, the caller has to make sure those
+copies have completed before releasing segments or allocating again.
+Returns the number of moved allocations.
+===============
+*/
+uint32_t GL_HeapCompact (glheap_t *heap, float max_occupancy)
+{
+	if (!heap->relocate || (heap->num_segments < 2))
+		return 0;
+
+	uint32_t num_evacuating = 0;
+	uint32_t densest_segment_index = 0;
+	for (uint32_t i = 0; i < heap->num_segments; ++i)
+	{
+		glheapsegment_t *segment = heap->segments[i];
+		const float		 occupancy = (float)segment->num_pages_allocated / (float)heap->num_pages_per_segment;
+		if (segment->num_pages_allocated > heap->segments[densest_segment_index]->num_pages_allocated)
+			densest_segment_index = i;
+		segment->evacuating = (segment->allocations != NULL) && (occupancy <= max_occupancy) && GL_HeapIsSegmentMovable (segment);
+		if (segment->evacuating)
+			++num_evacuating;
+	}
+
+	// Everything is sparse, fill up the densest segment instead of creating a new one
+	if (num_evacuating == heap->num_segments)
+		heap->segments[densest_segment_index]->evacuating = false;
+
+	uint32_t num_relocated = 0;
+	for (uint32_t i = 0; i < heap->num_segments; ++i)
+	{
+		glheapsegment_t *segment = heap->segments[i];
+		if (!segment->evacuating)
+			continue;
+		glheapallocation_t *allocation = segment->allocations;
+		while (allocation != NULL)
+		{
+			glheapallocation_t *next_allocation = allocation->next_in_segment;
+			if (GL_HeapRelocateAllocation (heap, allocation))
+				++num_relocated;
+			allocation = next_allocation;
+		}
+	}
+
+	for (uint32_t i = 0; i < heap->num_segments; ++i)
+		heap->segments[i]->evacuating = false;
+
+	return num_relocated;
+}
+
+/*
+===============
+GL_HeapReleaseEmptySegments
+
+Frees the device memory of segments without allocations, but always keeps one segment around
+===============
+*/
+uint32_t GL_HeapReleaseEmptySegments (glheap_t *heap, atomic_uint32_t *num_allocations)
+{
+	uint32_t num_kept = 0;
+	uint32_t num_released = 0;
+	for (uint32_t i = 0; i < heap->num_segments; ++i)
+	{
+		glheapsegment_t *segment = heap->segments[i];
+		const qboolean	 last_segment = (num_kept == 0) && (i == (heap->num_segments - 1));
+		if ((segment->num_pages_allocated == 0) && !last_segment)
+		{
+			assert (segment->allocations == NULL);
+			GL_DestroyHeapSegment (segment, num_allocations);
+			--heap->stats.num_blocks_free;
+			++num_released;
+		}
+		else
+			heap->segments[num_kept++] = segment;
+	}
+	heap->num_segments = num_kept;
+	heap->stats.num_segments_released += num_released;
+	return num_released;
+}
+
 #ifdef _DEBUG
 /*
 =================
@@ -841,7 +1113,12 @@ static void TestHeapCleanState (glheap_t *heap)
 			for (int k = 0; k < NUM_BLOCK_SIZE_CLASSES; ++k)
 				HEAP_TEST_ASSERT (segment->free_blocks_skip_bitfields[k][j] == 0, "skip bitfield is not 0");
 		for (page_index_t j = 0; j < NUM_SMALL_ALLOC_SIZES; ++j)
+		{
 			HEAP_TEST_ASSERT (segment->small_alloc_free_list_heads[j] == INVALID_PAGE_INDEX, "free list head is not empty");
+			HEAP_TEST_ASSERT (segment->num_small_alloc_pages[j] == 0, "small alloc page counter is not 0");
+			HEAP_TEST_ASSERT (segment->num_small_alloc_slots_used[j] == 0, "small alloc slot counter is not 0");
+		}
+		HEAP_TEST_ASSERT (segment->allocations == NULL, "segment allocation list is not empty");
 	}
 	HEAP_TEST_ASSERT (heap->num_segments == heap->stats.num_blocks_free, "Invalid number of free blocks");
 
@@ -860,6 +1137,7 @@ TestHeapConsistency
 */
 static void TestHeapConsistency (glheap_t *heap)
 {
+	uint32_t num_segment_allocations = 0;
 	for (uint32_t i = 0; i < heap->num_segments; ++i)
 	{
 		page_index_t	 current_block_index = 0;
@@ -888,11 +1166,82 @@ static void TestHeapConsistency (glheap_t *heap)
 		}
 		HEAP_TEST_ASSERT (current_block_index == heap->num_pages_per_segment, "Blocks need to add up to num pages");
 		HEAP_TEST_ASSERT (num_allocated_pages == segment->num_pages_allocated, "Invalid number of allocated pages found");
+		HEAP_TEST_ASSERT (!segment->evacuating, "Segment is still evacuating");
+		for (glheapallocation_t *allocation = segment->allocations; allocation != NULL; allocation = allocation->next_in_segment)
+		{
+			HEAP_TEST_ASSERT (allocation->segment == segment, "Allocation is linked to the wrong segment");
+			HEAP_TEST_ASSERT (!allocation->next_in_segment || (allocation->next_in_segment->prev_in_segment == allocation), "Invalid allocation links");
+			++num_segment_allocations;
+		}
 	}
 
 	glheapstats_t *stats = GL_HeapGetStats (heap);
 	HEAP_TEST_ASSERT (
 		stats->num_allocations == (stats->num_small_allocations + stats->num_block_allocations + stats->num_dedicated_allocations), "Invalid alloc counter");
+	HEAP_TEST_ASSERT (num_segment_allocations == (stats->num_small_allocations + stats->num_block_allocations), "Invalid segment allocation lists");
+	uint32_t num_free_blocks = 0;
+	for (int i = 0; i < NUM_BLOCK_SIZE_CLASSES; ++i)
+		num_free_blocks += stats->num_free_blocks_per_class[i];
+	HEAP_TEST_ASSERT (num_free_blocks == stats->num_blocks_free, "Invalid free blocks per size class");
+	uint32_t num_small_alloc_slots = 0;
+	for (int i = 0; i < NUM_SMALL_ALLOC_SIZES; ++i)
+	{
+		HEAP_TEST_ASSERT (stats->num_small_alloc_slots_used[i] <= stats->num_small_alloc_slots_total[i], "Invalid small alloc slot counters");
+		num_small_alloc_slots += stats->num_small_alloc_slots_used[i];
+	}
+	HEAP_TEST_ASSERT (num_small_alloc_slots == stats->num_small_allocations, "Invalid small alloc slots per size");
+}
+
+/*
+=================
+TestHeapNoOverlap
+=================
+*/
+static void TestHeapNoOverlap (glheap_t *heap)
+{
+	TEMP_ALLOC (byte, used_bytes, heap->segment_size);
+	for (uint32_t i = 0; i < heap->num_segments; ++i)
+	{
+		glheapsegment_t *segment = heap->segments[i];
+		memset (used_bytes, 0, heap->segment_size);
+		for (glheapallocation_t *allocation = segment->allocations; allocation != NULL; allocation = allocation->next_in_segment)
+		{
+			HEAP_TEST_ASSERT ((allocation->offset + allocation->size) <= heap->segment_size, "Allocation exceeds segment");
+			for (VkDeviceSize j = allocation->offset; j < (allocation->offset + allocation->size); ++j)
+			{
+				HEAP_TEST_ASSERT (!used_bytes[j], "Allocations overlap");
+				used_bytes[j] = 1;
+			}
+		}
+	}
+	TEMP_FREE (used_bytes);
+}
+
+typedef struct
+{
+	glheapallocation_t *allocation;
+	glheapsegment_t	   *segment;
+	VkDeviceSize		offset;
+	uint32_t			num_relocations;
+} testheapowner_t;
+
+/*
+=================
+TestHeapRelocate
+=================
+*/
+static void TestHeapRelocate (void *owner, glheapallocation_t *allocation, VkDeviceMemory old_memory, VkDeviceSize old_offset)
+{
+	testheapowner_t *test_owner = (testheapowner_t *)owner;
+	HEAP_TEST_ASSERT (test_owner->allocation == allocation, "Relocated allocation has the wrong owner");
+	HEAP_TEST_ASSERT (test_owner->segment->evacuating, "Allocation was moved out of a segment that isn't evacuating");
+	HEAP_TEST_ASSERT (test_owner->segment->memory.handle == old_memory, "Wrong old memory");
+	HEAP_TEST_ASSERT (test_owner->offset == old_offset, "Wrong old offset");
+	HEAP_TEST_ASSERT (!allocation->segment->evacuating, "Allocation was moved into an evacuating segment");
+	HEAP_TEST_ASSERT ((allocation->offset % allocation->alignment) == 0, "wrong alignment");
+	test_owner->segment = allocation->segment;
+	test_owner->offset = allocation->offset;
+	++test_owner->num_relocations;
 }
 
 /*
@@ -954,6 +1303,65 @@ void GL_HeapTest_f (void)
 		TestHeapCleanState (test_heap);
 	}
 	TEMP_FREE (allocations);
+	{
+		// Sparse segments need to be emptied out, except for ones holding pinned allocations
+		GL_HeapSetRelocateCallback (test_heap, TestHeapRelocate);
+		TEMP_ALLOC_ZEROED (testheapowner_t, owners, NUM_ALLOCS_PER_ITERATION);
+		for (int i = 0; i < NUM_ALLOCS_PER_ITERATION; ++i)
+		{
+			const VkDeviceSize size = (rand () % (MAX_ALLOC_SIZE - 1) + 1);
+			const VkDeviceSize alignment = ALIGNMENTS[rand () % NUM_ALIGNMENTS];
+			owners[i].allocation = GL_HeapAllocate (test_heap, size, alignment, &num_allocations);
+			owners[i].segment = owners[i].allocation->segment;
+			owners[i].offset = GL_HeapGetAllocationOffset (owners[i].allocation);
+			if ((i % 50) != 0)
+				GL_HeapSetAllocationOwner (owners[i].allocation, &owners[i]);
+		}
+		for (int i = 0; i < NUM_ALLOCS_PER_ITERATION; ++i)
+		{
+			if ((i % 5) != 0)
+			{
+				GL_HeapFree (test_heap, owners[i].allocation, &num_allocations);
+				owners[i].allocation = NULL;
+			}
+		}
+		TestHeapConsistency (test_heap);
+
+		const uint32_t num_segments = test_heap->num_segments;
+		const uint32_t num_relocated = GL_HeapCompact (test_heap, 0.5f);
+		TestHeapConsistency (test_heap);
+		TestHeapNoOverlap (test_heap);
+
+		uint32_t num_owner_relocations = 0;
+		for (int i = 0; i < NUM_ALLOCS_PER_ITERATION; ++i)
+		{
+			if (!owners[i].allocation)
+				continue;
+			HEAP_TEST_ASSERT (owners[i].segment == owners[i].allocation->segment, "Owner segment is out of date");
+			HEAP_TEST_ASSERT (owners[i].offset == GL_HeapGetAllocationOffset (owners[i].allocation), "Owner offset is out of date");
+			HEAP_TEST_ASSERT (((i % 50) != 0) || (owners[i].num_relocations == 0), "Pinned allocation was moved");
+			num_owner_relocations += owners[i].num_relocations;
+		}
+		HEAP_TEST_ASSERT (num_relocated > 0, "Nothing was relocated");
+		HEAP_TEST_ASSERT (num_owner_relocations == num_relocated, "Invalid number of relocations");
+
+		const uint32_t num_released = GL_HeapReleaseEmptySegments (test_heap, &num_allocations);
+		HEAP_TEST_ASSERT (num_released > 0, "No segments were released");
+		HEAP_TEST_ASSERT (test_heap->num_segments == (num_segments - num_released), "Invalid number of segments");
+		TestHeapConsistency (test_heap);
+		TestHeapNoOverlap (test_heap);
+
+		for (int i = 0; i < NUM_ALLOCS_PER_ITERATION; ++i)
+			if (owners[i].allocation)
+				GL_HeapFree (test_heap, owners[i].allocation, &num_allocations);
+		TEMP_FREE (owners);
+		TestHeapConsistency (test_heap);
+		TestHeapCleanState (test_heap);
+
+		GL_HeapReleaseEmptySegments (test_heap, &num_allocations);
+		HEAP_TEST_ASSERT (test_heap->num_segments == 1, "Only one empty segment should be left");
+		TestHeapCleanState (test_heap);
+	}
 	{
 		glheapallocation_t *large_alloc = GL_HeapAllocate (test_heap, TEST_HEAP_SIZE * 2, 1, &num_allocations);
 		TestHeapConsistency (test_heap);
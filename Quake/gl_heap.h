@@ -21,9 +21,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #ifndef __HEAP__
 #define __HEAP__
 
+#define GL_HEAP_NUM_SMALL_ALLOC_SIZES  6
+#define GL_HEAP_NUM_BLOCK_SIZE_CLASSES 8
+
 typedef struct glheap_s			  glheap_t;
 typedef struct glheapallocation_s glheapallocation_t;
 
+// Called after an allocation was moved by GL_HeapCompact. The old range is no longer
+// reserved in the heap, but nothing else is placed in it until compaction finished.
+typedef void (*glheaprelocatefunc_t) (void *owner, glheapallocation_t *allocation, VkDeviceMemory old_memory, VkDeviceSize old_offset);
+
 typedef struct glheapstats_s
 {
 	uint32_t num_segments;
@@ -38,6 +45,14 @@ typedef struct glheapstats_s
 	uint64_t num_bytes_allocated;
 	uint64_t num_bytes_free;
 	uint64_t num_bytes_wasted;
+	uint32_t num_small_alloc_slots_used[GL_HEAP_NUM_SMALL_ALLOC_SIZES];
+	uint32_t num_small_alloc_slots_total[GL_HEAP_NUM_SMALL_ALLOC_SIZES];
+	uint32_t num_free_blocks_per_class[GL_HEAP_NUM_BLOCK_SIZE_CLASSES];
+	uint32_t num_free_pages_per_class[GL_HEAP_NUM_BLOCK_SIZE_CLASSES];
+	uint32_t largest_free_block_pages;
+	uint32_t num_relocations;
+	uint64_t num_bytes_relocated;
+	uint32_t num_segments_released;
 } glheapstats_t;
 
 glheap_t *GL_HeapCreate (VkDeviceSize segment_size, uint32_t page_size, uint32_t memory_type_index, vulkan_memory_type_t memory_type, const char *heap_name);
@@ -47,6 +62,10 @@ void				GL_HeapFree (glheap_t *heap, glheapallocation_t *allocation, atomic_uint
 VkDeviceMemory		GL_HeapGetAllocationMemory (glheapallocation_t *allocation);
 VkDeviceSize		GL_HeapGetAllocationOffset (glheapallocation_t *allocation);
 glheapstats_t	   *GL_HeapGetStats (glheap_t *heap);
+void				GL_HeapSetRelocateCallback (glheap_t *heap, glheaprelocatefunc_t relocate);
+void				GL_HeapSetAllocationOwner (glheapallocation_t *allocation, void *owner);
+uint32_t			GL_HeapCompact (glheap_t *heap, float max_occupancy);
+uint32_t			GL_HeapReleaseEmptySegments (glheap_t *heap, atomic_uint32_t *num_allocations);
 
 #ifdef _DEBUG
 void GL_HeapTest_f (void);
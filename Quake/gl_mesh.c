@@ -38,8 +38,20 @@ ALIAS MODEL DISPLAY LIST GENERATION
 #define MESH_HEAP_PAGE_SIZE 4096
 #define MESH_HEAP_NAME		"Mesh heap"
 
+// Mesh buffers can be sources of copies so GL_HeapCompact can move them
+#define MESH_INDEX_BUFFER_USAGE	 (VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+#define MESH_VERTEX_BUFFER_USAGE (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+#define MESH_JOINTS_BUFFER_USAGE (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+
 static glheap_t *mesh_buffer_heap;
 
+// R_CompactMeshHeap records the relocation copies into its own command buffer and waits for it
+static VkCommandBuffer		  relocate_command_buffer;
+static VkBuffer				 *relocated_buffers; // old buffers, destroyed once the copies finished
+static VkBufferMemoryBarrier *relocate_barriers; // new buffers, made visible to the draws
+static int					  num_relocated_buffers;
+static int					  max_relocated_buffers;
+
 typedef struct
 {
 	VkBuffer				  buffer;
@@ -64,6 +76,9 @@ static void AddBufferGarbage (
 	int				  garbage_index;
 	buffer_garbage_t *garbage;
 
+	// The header no longer references the buffer, so it can't be relocated anymore
+	GL_HeapSetAllocationOwner (allocation, NULL);
+
 	garbage_index = num_garbage_buffers[current_garbage_index]++;
 	garbage = &buffer_garbage[garbage_index][current_garbage_index];
 	garbage->buffer = buffer;
@@ -73,6 +88,100 @@ static void AddBufferGarbage (
 	garbage->desc_set_layout = desc_set_layout;
 }
 
+/*
+================
+GLMesh_RelocateBuffer
+
+Recreates a buffer that GL_HeapCompact moved and copies the contents on the GPU
+================
+*/
+static void GLMesh_RelocateBuffer (void *owner, glheapallocation_t *allocation, VkDeviceMemory old_memory, VkDeviceSize old_offset)
+{
+	aliashdr_t		  *hdr = (aliashdr_t *)owner;
+	VkBuffer		  *buffer;
+	VkDeviceSize	   size;
+	VkBufferUsageFlags usage;
+	VkResult		   err;
+
+	if (allocation == hdr->index_allocation)
+	{
+		buffer = &hdr->index_buffer;
+		size = hdr->index_buffer_size;
+		usage = MESH_INDEX_BUFFER_USAGE;
+	}
+	else if (allocation == hdr->vertex_allocation)
+	{
+		buffer = &hdr->vertex_buffer;
+		size = hdr->vertex_buffer_size;
+		usage = MESH_VERTEX_BUFFER_USAGE;
+	}
+	else
+	{
+		assert (allocation == hdr->joints_allocation);
+		buffer = &hdr->joints_buffer;
+		size = hdr->joints_buffer_size;
+		usage = MESH_JOINTS_BUFFER_USAGE;
+	}
+
+	ZEROED_STRUCT (VkBufferCreateInfo, buffer_create_info);
+	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	buffer_create_info.size = size;
+	buffer_create_info.usage = usage;
+	VkBuffer new_buffer;
+	err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &new_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateBuffer failed");
+
+	GL_SetObjectName ((uint64_t)new_buffer, VK_OBJECT_TYPE_BUFFER, MESH_HEAP_NAME);
+
+	err = vkBindBufferMemory (vulkan_globals.device, new_buffer, GL_HeapGetAllocationMemory (allocation), GL_HeapGetAllocationOffset (allocation));
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkBindBufferMemory failed");
+
+	VkBufferCopy region;
+	region.srcOffset = 0;
+	region.dstOffset = 0;
+	region.size = size;
+	vkCmdCopyBuffer (relocate_command_buffer, *buffer, new_buffer, 1, &region);
+
+	if (num_relocated_buffers == max_relocated_buffers)
+	{
+		max_relocated_buffers = q_max (max_relocated_buffers * 2, 64);
+		relocated_buffers = Mem_Realloc (relocated_buffers, max_relocated_buffers * sizeof (VkBuffer));
+		relocate_barriers = Mem_Realloc (relocate_barriers, max_relocated_buffers * sizeof (VkBufferMemoryBarrier));
+	}
+	ZEROED_STRUCT (VkBufferMemoryBarrier, buffer_barrier);
+	buffer_barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	buffer_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	buffer_barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+	buffer_barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	buffer_barrier.buffer = new_buffer;
+	buffer_barrier.offset = 0;
+	buffer_barrier.size = VK_WHOLE_SIZE;
+	relocate_barriers[num_relocated_buffers] = buffer_barrier;
+	relocated_buffers[num_relocated_buffers++] = *buffer;
+	*buffer = new_buffer;
+
+	if (buffer == &hdr->joints_buffer)
+	{
+		ZEROED_STRUCT (VkDescriptorBufferInfo, buffer_info);
+		buffer_info.buffer = hdr->joints_buffer;
+		buffer_info.offset = 0;
+		buffer_info.range = VK_WHOLE_SIZE;
+
+		ZEROED_STRUCT (VkWriteDescriptorSet, joints_set_write);
+		joints_set_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		joints_set_write.dstSet = hdr->joints_set;
+		joints_set_write.dstBinding = 0;
+		joints_set_write.dstArrayElement = 0;
+		joints_set_write.descriptorCount = 1;
+		joints_set_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		joints_set_write.pBufferInfo = &buffer_info;
+		vkUpdateDescriptorSets (vulkan_globals.device, 1, &joints_set_write, 0, NULL);
+	}
+}
+
 /*
 ================
 R_InitMeshHeap
@@ -84,8 +193,7 @@ void R_InitMeshHeap (void)
 	ZEROED_STRUCT (VkBufferCreateInfo, buffer_create_info);
 	buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 	buffer_create_info.size = 16;
-	buffer_create_info.usage =
-		VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	buffer_create_info.usage = MESH_INDEX_BUFFER_USAGE | MESH_VERTEX_BUFFER_USAGE | MESH_JOINTS_BUFFER_USAGE;
 	VkBuffer dummy_buffer;
 	VkResult err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &dummy_buffer);
 	if (err != VK_SUCCESS)
@@ -97,10 +205,95 @@ void R_InitMeshHeap (void)
 	const uint32_t memory_type_index = GL_MemoryTypeFromProperties (memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
 	VkDeviceSize   heap_size = MESH_HEAP_SIZE_MB * (VkDeviceSize)1024 * (VkDeviceSize)1024;
 	mesh_buffer_heap = GL_HeapCreate (heap_size, MESH_HEAP_PAGE_SIZE, memory_type_index, VULKAN_MEMORY_TYPE_DEVICE, MESH_HEAP_NAME);
+	GL_HeapSetRelocateCallback (mesh_buffer_heap, GLMesh_RelocateBuffer);
 
 	vkDestroyBuffer (vulkan_globals.device, dummy_buffer, NULL);
 }
 
+/*
+================
+R_CompactMeshHeap
+
+Moves mesh buffers out of segments that are at most max_occupancy full and frees the emptied segments
+================
+*/
+void R_CompactMeshHeap (float max_occupancy)
+{
+	VkCommandPool command_pool;
+	VkResult	  err;
+
+	GL_WaitForDeviceIdle ();
+
+	ZEROED_STRUCT (VkCommandPoolCreateInfo, command_pool_create_info);
+	command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	command_pool_create_info.queueFamilyIndex = vulkan_globals.gfx_queue_family_index;
+	err = vkCreateCommandPool (vulkan_globals.device, &command_pool_create_info, NULL, &command_pool);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkCreateCommandPool failed");
+
+	ZEROED_STRUCT (VkCommandBufferAllocateInfo, command_buffer_allocate_info);
+	command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	command_buffer_allocate_info.commandPool = command_pool;
+	command_buffer_allocate_info.commandBufferCount = 1;
+	err = vkAllocateCommandBuffers (vulkan_globals.device, &command_buffer_allocate_info, &relocate_command_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkAllocateCommandBuffers failed");
+
+	ZEROED_STRUCT (VkCommandBufferBeginInfo, command_buffer_begin_info);
+	command_buffer_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	command_buffer_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	err = vkBeginCommandBuffer (relocate_command_buffer, &command_buffer_begin_info);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkBeginCommandBuffer failed");
+
+	const uint32_t num_relocated = GL_HeapCompact (mesh_buffer_heap, max_occupancy);
+	if (num_relocated > 0)
+	{
+		vkCmdPipelineBarrier (
+			relocate_command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, 0, 0, NULL,
+			num_relocated_buffers, relocate_barriers, 0, NULL);
+	}
+
+	err = vkEndCommandBuffer (relocate_command_buffer);
+	if (err != VK_SUCCESS)
+		Sys_Error ("vkEndCommandBuffer failed");
+
+	if (num_relocated > 0)
+	{
+		// The old buffers and their segments have to outlive the copies
+		VkFence fence;
+		ZEROED_STRUCT (VkFenceCreateInfo, fence_create_info);
+		fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		err = vkCreateFence (vulkan_globals.device, &fence_create_info, NULL, &fence);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkCreateFence failed");
+
+		ZEROED_STRUCT (VkSubmitInfo, submit_info);
+		submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submit_info.commandBufferCount = 1;
+		submit_info.pCommandBuffers = &relocate_command_buffer;
+		err = vkQueueSubmit (vulkan_globals.queue, 1, &submit_info, fence);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkQueueSubmit failed");
+
+		err = vkWaitForFences (vulkan_globals.device, 1, &fence, VK_TRUE, UINT64_MAX);
+		if (err != VK_SUCCESS)
+			Sys_Error ("vkWaitForFences failed");
+		vkDestroyFence (vulkan_globals.device, fence, NULL);
+
+		for (int i = 0; i < num_relocated_buffers; ++i)
+			vkDestroyBuffer (vulkan_globals.device, relocated_buffers[i], NULL);
+		num_relocated_buffers = 0;
+	}
+
+	vkDestroyCommandPool (vulkan_globals.device, command_pool, NULL);
+	relocate_command_buffer = VK_NULL_HANDLE;
+
+	const uint32_t num_released = GL_HeapReleaseEmptySegments (mesh_buffer_heap, &num_vulkan_mesh_allocations);
+	Con_DPrintf ("Mesh heap: relocated %" SDL_PRIu32 " buffers, released %" SDL_PRIu32 " segments\n", num_relocated, num_released);
+}
+
 /*
 ================
 R_GetMeshHeapStats
@@ -321,7 +514,7 @@ void GLMesh_UploadBuffers (qmodel_t *m, aliashdr_t *mainhdr, unsigned short *ind
 		ZEROED_STRUCT (VkBufferCreateInfo, buffer_create_info);
 		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		buffer_create_info.size = totalindexsize;
-		buffer_create_info.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_create_info.usage = MESH_INDEX_BUFFER_USAGE;
 		err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &mainhdr->index_buffer);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateBuffer failed");
@@ -332,6 +525,8 @@ void GLMesh_UploadBuffers (qmodel_t *m, aliashdr_t *mainhdr, unsigned short *ind
 		vkGetBufferMemoryRequirements (vulkan_globals.device, mainhdr->index_buffer, &memory_requirements);
 
 		mainhdr->index_allocation = GL_HeapAllocate (mesh_buffer_heap, memory_requirements.size, memory_requirements.alignment, &num_vulkan_mesh_allocations);
+		mainhdr->index_buffer_size = totalindexsize;
+		GL_HeapSetAllocationOwner (mainhdr->index_allocation, mainhdr);
 		err = vkBindBufferMemory (
 			vulkan_globals.device, mainhdr->index_buffer, GL_HeapGetAllocationMemory (mainhdr->index_allocation),
 			GL_HeapGetAllocationOffset (mainhdr->index_allocation));
@@ -399,7 +594,7 @@ void GLMesh_UploadBuffers (qmodel_t *m, aliashdr_t *mainhdr, unsigned short *ind
 		ZEROED_STRUCT (VkBufferCreateInfo, buffer_create_info);
 		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		buffer_create_info.size = totalvbosize;
-		buffer_create_info.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_create_info.usage = MESH_VERTEX_BUFFER_USAGE;
 		err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &mainhdr->vertex_buffer);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateBuffer failed");
@@ -410,6 +605,8 @@ void GLMesh_UploadBuffers (qmodel_t *m, aliashdr_t *mainhdr, unsigned short *ind
 		vkGetBufferMemoryRequirements (vulkan_globals.device, mainhdr->vertex_buffer, &memory_requirements);
 
 		mainhdr->vertex_allocation = GL_HeapAllocate (mesh_buffer_heap, memory_requirements.size, memory_requirements.alignment, &num_vulkan_mesh_allocations);
+		mainhdr->vertex_buffer_size = totalvbosize;
+		GL_HeapSetAllocationOwner (mainhdr->vertex_allocation, mainhdr);
 		err = vkBindBufferMemory (
 			vulkan_globals.device, mainhdr->vertex_buffer, GL_HeapGetAllocationMemory (mainhdr->vertex_allocation),
 			GL_HeapGetAllocationOffset (mainhdr->vertex_allocation));
@@ -425,7 +622,7 @@ void GLMesh_UploadBuffers (qmodel_t *m, aliashdr_t *mainhdr, unsigned short *ind
 		ZEROED_STRUCT (VkBufferCreateInfo, buffer_create_info);
 		buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
 		buffer_create_info.size = totaljointssize;
-		buffer_create_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		buffer_create_info.usage = MESH_JOINTS_BUFFER_USAGE;
 		err = vkCreateBuffer (vulkan_globals.device, &buffer_create_info, NULL, &mainhdr->joints_buffer);
 		if (err != VK_SUCCESS)
 			Sys_Error ("vkCreateBuffer failed");
@@ -436,6 +633,8 @@ void GLMesh_UploadBuffers (qmodel_t *m, aliashdr_t *mainhdr, unsigned short *ind
 		vkGetBufferMemoryRequirements (vulkan_globals.device, mainhdr->joints_buffer, &memory_requirements);
 
 		mainhdr->joints_allocation = GL_HeapAllocate (mesh_buffer_heap, memory_requirements.size, memory_requirements.alignment, &num_vulkan_mesh_allocations);
+		mainhdr->joints_buffer_size = totaljointssize;
+		GL_HeapSetAllocationOwner (mainhdr->joints_allocation, mainhdr);
 		err = vkBindBufferMemory (
 			vulkan_globals.device, mainhdr->joints_buffer, GL_HeapGetAllocationMemory (mainhdr->joints_allocation),
 			GL_HeapGetAllocationOffset (mainhdr->joints_allocation));
@@ -26,9 +26,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
-static void		 Mod_LoadSpriteModel (qmodel_t *mod, void *buffer);
-static void		 Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffer);
-static void		 Mod_LoadAliasModel (qmodel_t *mod, void *buffer);
+static void		 Mod_LoadSpriteModel (qmodel_t *mod, const void *buffer);
+static void		 Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, const void *buffer);
+static void		 Mod_LoadAliasModel (qmodel_t *mod, const void *buffer);
 static void		 Mod_LoadMD5MeshModel (qmodel_t *mod, const void *buffer);
 static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash);
 
@@ -55,7 +55,7 @@ texture_t *r_notexture_mip2; // johnfitz -- used for non-lightmapped surfs with
 ReadShortUnaligned
 ===============
 */
-static short ReadShortUnaligned (byte *ptr)
+static short ReadShortUnaligned (const byte *ptr)
 {
 	short temp;
 	memcpy (&temp, ptr, sizeof (short));
@@ -67,7 +67,7 @@ static short ReadShortUnaligned (byte *ptr)
 ReadLongUnaligned
 ===============
 */
-static int ReadLongUnaligned (byte *ptr)
+static int ReadLongUnaligned (const byte *ptr)
 {
 	int temp;
 	memcpy (&temp, ptr, sizeof (int));
@@ -79,7 +79,7 @@ static int ReadLongUnaligned (byte *ptr)
 ReadFloatUnaligned
 ===============
 */
-static float ReadFloatUnaligned (byte *ptr)
+static float ReadFloatUnaligned (const byte *ptr)
 {
 	float temp;
 	memcpy (&temp, ptr, sizeof (float));
@@ -111,11 +111,11 @@ void Mod_Init (void)
 	Cvar_SetCallback (&r_md5models, Mod_RefreshSkins_f);
 
 	// johnfitz -- create notexture miptex
-	r_notexture_mip = (texture_t *)Mem_Alloc (sizeof (texture_t));
+	r_notexture_mip = (texture_t *)Mem_AllocTagged (sizeof (texture_t), MEMTAG_MODEL);
 	strcpy (r_notexture_mip->name, "notexture");
 	r_notexture_mip->height = r_notexture_mip->width = 32;
 
-	r_notexture_mip2 = (texture_t *)Mem_Alloc (sizeof (texture_t));
+	r_notexture_mip2 = (texture_t *)Mem_AllocTagged (sizeof (texture_t), MEMTAG_MODEL);
 	strcpy (r_notexture_mip2->name, "notexture2");
 	r_notexture_mip2->height = r_notexture_mip2->width = 32;
 	// johnfitz
@@ -310,6 +310,15 @@ static void Mod_FreeSpriteMemory (msprite_t *psprite)
 	psprite->numframes = 0;
 }
 
+// level allocations are only forgotten, Mem_LevelFreeAll releases them without counting them as abandoned
+#define MOD_FREE(ptr)                \
+	do                               \
+	{                                \
+		if (!Mem_IsLevelAlloc (ptr)) \
+			Mem_Free (ptr);          \
+		ptr = NULL;                  \
+	} while (false)
+
 /*
 ===================
 Mod_FreeModelMemory
@@ -321,50 +330,45 @@ static void Mod_FreeModelMemory (qmodel_t *mod)
 	{
 		if ((mod->type == mod_sprite) && (mod->extradata[0]))
 			Mod_FreeSpriteMemory ((msprite_t *)mod->extradata[0]);
-		// Last two ones are dummy textures
-		for (int i = 0; i < mod->numtextures - 2; ++i)
-			SAFE_FREE (mod->textures[i]);
-		for (int i = 0; i < mod->numsurfaces; ++i)
-			SAFE_FREE (mod->surfaces[i].polys);
-		SAFE_FREE (mod->hulls[0].clipnodes);
-		SAFE_FREE (mod->submodels);
+		MOD_FREE (mod->hulls[0].clipnodes);
+		MOD_FREE (mod->submodels);
 		mod->numsubmodels = 0;
-		SAFE_FREE (mod->planes);
+		MOD_FREE (mod->planes);
 		mod->numplanes = 0;
-		SAFE_FREE (mod->leafs);
+		MOD_FREE (mod->leafs);
 		mod->numleafs = 0;
-		SAFE_FREE (mod->vertexes);
+		MOD_FREE (mod->vertexes);
 		mod->numvertexes = 0;
-		SAFE_FREE (mod->edges);
+		MOD_FREE (mod->edges);
 		mod->numedges = 0;
-		SAFE_FREE (mod->nodes);
+		MOD_FREE (mod->nodes);
 		mod->numnodes = 0;
-		SAFE_FREE (mod->texinfo);
+		MOD_FREE (mod->texinfo);
 		mod->numtexinfo = 0;
-		SAFE_FREE (mod->surfaces);
+		MOD_FREE (mod->surfaces);
 		mod->numsurfaces = 0;
-		SAFE_FREE (mod->surfedges);
+		MOD_FREE (mod->surfedges);
 		mod->numsurfedges = 0;
-		SAFE_FREE (mod->clipnodes);
+		MOD_FREE (mod->clipnodes);
 		mod->numclipnodes = 0;
-		SAFE_FREE (mod->marksurfaces);
+		MOD_FREE (mod->marksurfaces);
 		mod->nummarksurfaces = 0;
-		SAFE_FREE (mod->soa_leafbounds);
-		SAFE_FREE (mod->surfvis);
-		SAFE_FREE (mod->soa_surfplanes);
-		SAFE_FREE (mod->textures);
+		MOD_FREE (mod->soa_leafbounds);
+		MOD_FREE (mod->surfvis);
+		MOD_FREE (mod->soa_surfplanes);
+		MOD_FREE (mod->textures);
 		mod->numtextures = 0;
-		SAFE_FREE (mod->visdata);
-		SAFE_FREE (mod->lightdata);
-		SAFE_FREE (mod->entities);
+		MOD_FREE (mod->visdata);
+		MOD_FREE (mod->lightdata);
+		MOD_FREE (mod->entities);
 		for (int i = 0; i < 2; ++i)
-			SAFE_FREE (mod->extradata[i]);
-		SAFE_FREE (mod->water_surfs);
+			MOD_FREE (mod->extradata[i]);
+		MOD_FREE (mod->water_surfs);
 		mod->used_water_surfs = 0;
 		mod->water_surfs_specials = 0;
 	}
 	else
-		SAFE_FREE (mod->textures);
+		MOD_FREE (mod->textures);
 
 	if (!isDedicated)
 		TexMgr_FreeTexturesForOwner (mod);
@@ -416,6 +420,9 @@ void Mod_ResetAll (void)
 	}
 	mod_numknown = 0;
 
+	// nothing refers to the level region anymore
+	Mem_LevelFreeAll ();
+
 	InvalidateTraceLineCache ();
 }
 
@@ -473,8 +480,8 @@ Loads a model into the cache
 */
 static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash)
 {
-	byte *buf = NULL;
-	int	  mod_type;
+	const byte *buf = NULL;
+	int			mod_type;
 
 	if (!mod->needload)
 		return mod;
@@ -500,18 +507,19 @@ static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash)
 		if (strcmp (extension, "mdl") == 0)
 		{
 			q_strlcpy (extension, "md5mesh", sizeof (newname) - (extension - newname));
-			buf = COM_LoadFile (newname, &mod->path_id);
-			if (buf)
+			byte *md5_buf = COM_LoadFile (newname, &mod->path_id);
+			if (md5_buf)
 			{
-				Mod_LoadMD5MeshModel (mod, buf);
+				Mod_LoadMD5MeshModel (mod, md5_buf);
 				md5_loaded = true;
 				md5_path_id = mod->path_id;
 			}
-			Mem_Free (buf);
+			Mem_Free (md5_buf);
 		}
 	}
 
-	buf = COM_LoadFile (mod->name, &mod->path_id);
+	// parsed in place, models in mapped paks aren't copied
+	buf = COM_MapFile (mod->name, NULL, &mod->path_id);
 	if (!buf)
 	{
 		if (crash)
@@ -579,7 +587,7 @@ static qmodel_t *Mod_LoadModel (qmodel_t *mod, qboolean crash)
 		break;
 	}
 
-	Mem_Free (buf);
+	COM_UnmapFile (buf);
 	return mod;
 }
 
@@ -766,17 +774,17 @@ static void Mod_LoadTextureTask (int i, qmodel_t **ppmod)
 Mod_LoadTextures
 =================
 */
-static void Mod_LoadTextures (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadTextures (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	int		   i, j, pixels, num, maxanim, altmax;
-	miptex_t   mt;
-	texture_t *tx, *tx2;
-	texture_t *anims[10];
-	texture_t *altanims[10];
-	byte	  *m;
-	byte	  *pixels_p;
-	int		   nummiptex;
-	int		   dataofs;
+	int			i, j, pixels, num, maxanim, altmax;
+	miptex_t	mt;
+	texture_t  *tx, *tx2;
+	texture_t  *anims[10];
+	texture_t  *altanims[10];
+	const byte *m;
+	const byte *pixels_p;
+	int			nummiptex;
+	int			dataofs;
 
 	// johnfitz -- don't return early if no textures; still need to create dummy texture
 	if (!l->filelen)
@@ -793,7 +801,7 @@ static void Mod_LoadTextures (qmodel_t *mod, byte *mod_base, lump_t *l)
 	// johnfitz
 
 	mod->numtextures = nummiptex + 2; // johnfitz -- need 2 dummy texture chains for missing textures
-	mod->textures = (texture_t **)Mem_Alloc (mod->numtextures * sizeof (*mod->textures));
+	mod->textures = (texture_t **)Mem_LevelAlloc (mod->numtextures * sizeof (*mod->textures), MEMTAG_MODEL);
 
 	for (i = 0; i < nummiptex; i++)
 	{
@@ -813,7 +821,7 @@ static void Mod_LoadTextures (qmodel_t *mod, byte *mod_base, lump_t *l)
 		}
 
 		pixels = mt.width * mt.height / 64 * 85;
-		tx = (texture_t *)Mem_Alloc (sizeof (texture_t) + pixels);
+		tx = (texture_t *)Mem_LevelAlloc (sizeof (texture_t) + pixels, MEMTAG_MODEL);
 		mod->textures[i] = tx;
 
 		memcpy (tx->name, mt.name, sizeof (tx->name));
@@ -855,7 +863,9 @@ static void Mod_LoadTextures (qmodel_t *mod, byte *mod_base, lump_t *l)
 	{
 		if (!Tasks_IsWorker () && (nummiptex > 1))
 		{
-			task_handle_t task = Task_AllocateAssignIndexedFuncAndSubmit ((task_indexed_func_t)Mod_LoadTextureTask, nummiptex, &mod, sizeof (mod));
+			task_handle_t task = Task_AllocateAndAssignIndexedFunc ((task_indexed_func_t)Mod_LoadTextureTask, nummiptex, &mod, sizeof (mod));
+			Task_SetPriority (task, TASK_PRIORITY_BACKGROUND);
+			Task_Submit (task);
 			Task_Join (task, SDL_MUTEX_MAXWAIT);
 		}
 		else
@@ -971,7 +981,7 @@ static void Mod_LoadTextures (qmodel_t *mod, byte *mod_base, lump_t *l)
 Mod_LoadLighting -- johnfitz -- replaced with lit support code via lordhavoc
 =================
 */
-static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadLighting (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
 	int			 i;
 	byte		*in, *out, *data;
@@ -1001,7 +1011,7 @@ static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
 				if (8 + l->filelen * 3 == com_filesize)
 				{
 					Con_DPrintf2 ("%s loaded\n", litfilename);
-					mod->lightdata = (byte *)Mem_AllocNonZero (l->filelen * 3);
+					mod->lightdata = (byte *)Mem_LevelAlloc (l->filelen * 3, MEMTAG_MODEL);
 					memcpy (mod->lightdata, data + 8, l->filelen * 3);
 					Mem_Free (data);
 					return;
@@ -1030,14 +1040,14 @@ static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
 		// RGB lightmap samples are packed in 16bits.
 		// RRRRR GGGGG BBBBBB
 
-		mod->lightdata = (byte *)Mem_Alloc ((l->filelen / 2) * 3);
-		in = mod_base + l->fileofs;
+		mod->lightdata = (byte *)Mem_LevelAlloc ((l->filelen / 2) * 3, MEMTAG_MODEL);
+		const byte *q64_in = mod_base + l->fileofs;
 		out = mod->lightdata;
 
 		for (i = 0; i < (l->filelen / 2); i++)
 		{
-			q64_b0 = *in++;
-			q64_b1 = *in++;
+			q64_b0 = *q64_in++;
+			q64_b1 = *q64_in++;
 
 			*out++ = q64_b0 & 0xf8;									  /* 0b11111000 */
 			*out++ = ((q64_b0 & 0x07) << 5) + ((q64_b1 & 0xc0) >> 5); /* 0b00000111, 0b11000000 */
@@ -1046,7 +1056,7 @@ static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
 		return;
 	}
 
-	mod->lightdata = (byte *)Mem_Alloc (l->filelen * 3);
+	mod->lightdata = (byte *)Mem_LevelAlloc (l->filelen * 3, MEMTAG_MODEL);
 	in = mod->lightdata + l->filelen * 2; // place the file at the end, so it will not be overwritten until the very last write
 	out = mod->lightdata;
 	memcpy (in, mod_base + l->fileofs, l->filelen);
@@ -1064,7 +1074,7 @@ static void Mod_LoadLighting (qmodel_t *mod, byte *mod_base, lump_t *l)
 Mod_LoadVisibility
 =================
 */
-static void Mod_LoadVisibility (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadVisibility (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
 	mod->viswarn = false;
 	if (!l->filelen)
@@ -1072,7 +1082,7 @@ static void Mod_LoadVisibility (qmodel_t *mod, byte *mod_base, lump_t *l)
 		mod->visdata = NULL;
 		return;
 	}
-	mod->visdata = (byte *)Mem_Alloc (l->filelen);
+	mod->visdata = (byte *)Mem_LevelAlloc (l->filelen, MEMTAG_MODEL);
 	memcpy (mod->visdata, mod_base + l->fileofs, l->filelen);
 }
 
@@ -1081,7 +1091,7 @@ static void Mod_LoadVisibility (qmodel_t *mod, byte *mod_base, lump_t *l)
 Mod_LoadEntities
 =================
 */
-static void Mod_LoadEntities (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadEntities (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
 	char		 basemapname[MAX_QPATH];
 	char		 entfilename[MAX_QPATH];
@@ -1137,7 +1147,7 @@ _load_embedded:
 		mod->entities = NULL;
 		return;
 	}
-	mod->entities = (char *)Mem_Alloc (l->filelen);
+	mod->entities = (char *)Mem_LevelAlloc (l->filelen, MEMTAG_MODEL);
 	memcpy (mod->entities, mod_base + l->fileofs, l->filelen);
 	Mem_Free (ents);
 }
@@ -1147,17 +1157,17 @@ _load_embedded:
 Mod_LoadVertexes
 =================
 */
-static void Mod_LoadVertexes (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadVertexes (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	byte	  *in;
-	mvertex_t *out;
-	int		   i, count;
+	const byte *in;
+	mvertex_t  *out;
+	int			i, count;
 
 	in = mod_base + l->fileofs;
 	if (l->filelen % sizeof (dvertex_t))
 		Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 	count = l->filelen / sizeof (dvertex_t);
-	out = (mvertex_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mvertex_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	mod->vertexes = out;
 	mod->numvertexes = count;
@@ -1175,20 +1185,20 @@ static void Mod_LoadVertexes (qmodel_t *mod, byte *mod_base, lump_t *l)
 Mod_LoadEdges
 =================
 */
-static void Mod_LoadEdges (qmodel_t *mod, byte *mod_base, lump_t *l, int bsp2)
+static void Mod_LoadEdges (qmodel_t *mod, const byte *mod_base, lump_t *l, int bsp2)
 {
 	medge_t *out;
 	int		 i, count;
 
 	if (bsp2)
 	{
-		byte *in = mod_base + l->fileofs;
+		const byte *in = mod_base + l->fileofs;
 
 		if (l->filelen % sizeof (dledge_t))
 			Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 
 		count = l->filelen / sizeof (dledge_t);
-		out = (medge_t *)Mem_Alloc ((count + 1) * sizeof (*out));
+		out = (medge_t *)Mem_LevelAlloc ((count + 1) * sizeof (*out), MEMTAG_MODEL);
 
 		mod->edges = out;
 		mod->numedges = count;
@@ -1201,13 +1211,13 @@ static void Mod_LoadEdges (qmodel_t *mod, byte *mod_base, lump_t *l, int bsp2)
 	}
 	else
 	{
-		byte *in = mod_base + l->fileofs;
+		const byte *in = mod_base + l->fileofs;
 
 		if (l->filelen % sizeof (dsedge_t))
 			Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 
 		count = l->filelen / sizeof (dsedge_t);
-		out = (medge_t *)Mem_Alloc ((count + 1) * sizeof (*out));
+		out = (medge_t *)Mem_LevelAlloc ((count + 1) * sizeof (*out), MEMTAG_MODEL);
 
 		mod->edges = out;
 		mod->numedges = count;
@@ -1225,9 +1235,9 @@ static void Mod_LoadEdges (qmodel_t *mod, byte *mod_base, lump_t *l, int bsp2)
 Mod_LoadTexinfo
 =================
 */
-static void Mod_LoadTexinfo (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadTexinfo (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	byte	   *in;
+	const byte *in;
 	mtexinfo_t *out;
 	int			i, j, count, miptex;
 	int			missing = 0; // johnfitz
@@ -1236,7 +1246,7 @@ static void Mod_LoadTexinfo (qmodel_t *mod, byte *mod_base, lump_t *l)
 	if (l->filelen % sizeof (texinfo_t))
 		Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 	count = l->filelen / sizeof (texinfo_t);
-	out = (mtexinfo_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mtexinfo_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	mod->texinfo = out;
 	mod->numtexinfo = count;
@@ -1369,7 +1379,7 @@ static void Mod_PolyForUnlitSurface (qmodel_t *mod, msurface_t *fa)
 		texscale = (1.0 / 32.0); // to match r_notexture_mip
 
 	// create the poly
-	poly = (glpoly_t *)Mem_Alloc (sizeof (glpoly_t) + (numverts - 4) * VERTEXSIZE * sizeof (float));
+	poly = (glpoly_t *)Mem_LevelAlloc (sizeof (glpoly_t) + (numverts - 4) * VERTEXSIZE * sizeof (float), MEMTAG_MODEL);
 	poly->next = NULL;
 	fa->polys = poly;
 	poly->numverts = numverts;
@@ -1389,10 +1399,11 @@ static void Mod_PolyForUnlitSurface (qmodel_t *mod, msurface_t *fa)
 Mod_CalcSurfaceExtents
 ================
 */
-static void Mod_CalcSurfaceExtentsTask (int surfnum, qmodel_t **mod_ptr)
+static void Mod_CalcSurfaceExtentsTask (int first_surf, int end_surf, qmodel_t **mod_ptr)
 {
 	qmodel_t *mod = *mod_ptr;
-	CalcSurfaceExtents (mod, &mod->surfaces[surfnum]);
+	for (int surfnum = first_surf; surfnum < end_surf; ++surfnum)
+		CalcSurfaceExtents (mod, &mod->surfaces[surfnum]);
 }
 
 /*
@@ -1400,10 +1411,10 @@ static void Mod_CalcSurfaceExtentsTask (int surfnum, qmodel_t **mod_ptr)
 Mod_LoadFaces
 =================
 */
-static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bsp2)
+static void Mod_LoadFaces (qmodel_t *mod, const byte *mod_base, lump_t *l, qboolean bsp2)
 {
-	byte	   *ins;
-	byte	   *inl;
+	const byte *ins;
+	const byte *inl;
 	msurface_t *out;
 	int			i, count, surfnum, lofs;
 	int			planenum, side, texinfon;
@@ -1424,7 +1435,7 @@ static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bs
 			Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 		count = l->filelen / sizeof (dsface_t);
 	}
-	out = (msurface_t *)Mem_AllocNonZero (count * sizeof (*out));
+	out = (msurface_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	// johnfitz -- warn mappers about exceeding old limits
 	if (count > 32767 && !bsp2)
@@ -1560,14 +1571,11 @@ static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bs
 	{
 		if (!Tasks_IsWorker () && (count > 1))
 		{
-			task_handle_t task = Task_AllocateAssignIndexedFuncAndSubmit ((task_indexed_func_t)Mod_CalcSurfaceExtentsTask, count, &mod, sizeof (qmodel_t *));
+			task_handle_t task = Task_AllocateAssignRangeFuncAndSubmit ((task_range_func_t)Mod_CalcSurfaceExtentsTask, count, &mod, sizeof (qmodel_t *));
 			Task_Join (task, SDL_MUTEX_MAXWAIT);
 		}
 		else
-		{
-			for (i = 0; i < count; i++)
-				Mod_CalcSurfaceExtentsTask (i, &mod);
-		}
+			Mod_CalcSurfaceExtentsTask (0, count, &mod);
 	}
 }
 
@@ -1576,17 +1584,17 @@ static void Mod_LoadFaces (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bs
 Mod_LoadNodes
 =================
 */
-static void Mod_LoadNodes_S (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadNodes_S (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	int		 i, j, count, p;
-	byte	*in;
-	mnode_t *out;
+	int			i, j, count, p;
+	const byte *in;
+	mnode_t	   *out;
 
 	in = mod_base + l->fileofs;
 	if (l->filelen % sizeof (dsnode_t))
 		Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 	count = l->filelen / sizeof (dsnode_t);
-	out = (mnode_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mnode_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	// johnfitz -- warn mappers about exceeding old limits
 	if (count > 32767)
@@ -1632,18 +1640,18 @@ static void Mod_LoadNodes_S (qmodel_t *mod, byte *mod_base, lump_t *l)
 	}
 }
 
-static void Mod_LoadNodes_L1 (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadNodes_L1 (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	int		 i, j, count, p;
-	byte	*in;
-	mnode_t *out;
+	int			i, j, count, p;
+	const byte *in;
+	mnode_t	   *out;
 
 	in = mod_base + l->fileofs;
 	if (l->filelen % sizeof (dl1node_t))
 		Sys_Error ("Mod_LoadNodes: funny lump size in %s", mod->name);
 
 	count = l->filelen / sizeof (dl1node_t);
-	out = (mnode_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mnode_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	mod->nodes = out;
 	mod->numnodes = count;
@@ -1684,18 +1692,18 @@ static void Mod_LoadNodes_L1 (qmodel_t *mod, byte *mod_base, lump_t *l)
 	}
 }
 
-static void Mod_LoadNodes_L2 (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadNodes_L2 (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	int		 i, j, count, p;
-	byte	*in;
-	mnode_t *out;
+	int			i, j, count, p;
+	const byte *in;
+	mnode_t	   *out;
 
 	in = mod_base + l->fileofs;
 	if (l->filelen % sizeof (dl2node_t))
 		Sys_Error ("Mod_LoadNodes: funny lump size in %s", mod->name);
 
 	count = l->filelen / sizeof (dl2node_t);
-	out = (mnode_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mnode_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	mod->nodes = out;
 	mod->numnodes = count;
@@ -1736,7 +1744,7 @@ static void Mod_LoadNodes_L2 (qmodel_t *mod, byte *mod_base, lump_t *l)
 	}
 }
 
-static void Mod_LoadNodes (qmodel_t *mod, byte *mod_base, lump_t *l, int bsp2)
+static void Mod_LoadNodes (qmodel_t *mod, const byte *mod_base, lump_t *l, int bsp2)
 {
 	if (bsp2 == 2)
 		Mod_LoadNodes_L2 (mod, mod_base, l);
@@ -1746,7 +1754,7 @@ static void Mod_LoadNodes (qmodel_t *mod, byte *mod_base, lump_t *l, int bsp2)
 		Mod_LoadNodes_S (mod, mod_base, l);
 }
 
-static void Mod_ProcessLeafs_S (qmodel_t *mod, byte *in, int filelen)
+static void Mod_ProcessLeafs_S (qmodel_t *mod, const byte *in, int filelen)
 {
 	mleaf_t *out;
 	int		 i, j, count, p;
@@ -1754,7 +1762,7 @@ static void Mod_ProcessLeafs_S (qmodel_t *mod, byte *in, int filelen)
 	if (filelen % sizeof (dsleaf_t))
 		Sys_Error ("Mod_ProcessLeafs: funny lump size in %s", mod->name);
 	count = filelen / sizeof (dsleaf_t);
-	out = (mleaf_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mleaf_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	// johnfitz
 	if (count > 32767)
@@ -1793,7 +1801,7 @@ static void Mod_ProcessLeafs_S (qmodel_t *mod, byte *in, int filelen)
 	}
 }
 
-static void Mod_ProcessLeafs_L1 (qmodel_t *mod, byte *in, int filelen)
+static void Mod_ProcessLeafs_L1 (qmodel_t *mod, const byte *in, int filelen)
 {
 	mleaf_t *out;
 	int		 i, j, count, p;
@@ -1803,7 +1811,7 @@ static void Mod_ProcessLeafs_L1 (qmodel_t *mod, byte *in, int filelen)
 
 	count = filelen / sizeof (dl1leaf_t);
 
-	out = (mleaf_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mleaf_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	mod->leafs = out;
 	mod->numleafs = count;
@@ -1836,7 +1844,7 @@ static void Mod_ProcessLeafs_L1 (qmodel_t *mod, byte *in, int filelen)
 	}
 }
 
-static void Mod_ProcessLeafs_L2 (qmodel_t *mod, byte *in, int filelen)
+static void Mod_ProcessLeafs_L2 (qmodel_t *mod, const byte *in, int filelen)
 {
 	mleaf_t *out;
 	int		 i, j, count, p;
@@ -1846,7 +1854,7 @@ static void Mod_ProcessLeafs_L2 (qmodel_t *mod, byte *in, int filelen)
 
 	count = filelen / sizeof (dl2leaf_t);
 
-	out = (mleaf_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mleaf_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	mod->leafs = out;
 	mod->numleafs = count;
@@ -1884,9 +1892,9 @@ static void Mod_ProcessLeafs_L2 (qmodel_t *mod, byte *in, int filelen)
 Mod_LoadLeafs
 =================
 */
-static void Mod_LoadLeafs (qmodel_t *mod, byte *mod_base, lump_t *l, int bsp2)
+static void Mod_LoadLeafs (qmodel_t *mod, const byte *mod_base, lump_t *l, int bsp2)
 {
-	void *in = (void *)(mod_base + l->fileofs);
+	const byte *in = mod_base + l->fileofs;
 
 	if (bsp2 == 2)
 		Mod_ProcessLeafs_L2 (mod, in, l->filelen);
@@ -2007,10 +2015,10 @@ static void Mod_CheckWaterVis (qmodel_t *mod)
 Mod_LoadClipnodes
 =================
 */
-static void Mod_LoadClipnodes (qmodel_t *mod, byte *mod_base, lump_t *l, qboolean bsp2)
+static void Mod_LoadClipnodes (qmodel_t *mod, const byte *mod_base, lump_t *l, qboolean bsp2)
 {
-	byte *ins;
-	byte *inl;
+	const byte *ins;
+	const byte *inl;
 
 	mclipnode_t *out; // johnfitz -- was dclipnode_t
 	int			 i, count;
@@ -2034,7 +2042,7 @@ static void Mod_LoadClipnodes (qmodel_t *mod, byte *mod_base, lump_t *l, qboolea
 
 		count = l->filelen / sizeof (dsclipnode_t);
 	}
-	out = (mclipnode_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mclipnode_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	// johnfitz -- warn about exceeding old limits
 	if (count > 32767 && !bsp2)
@@ -2126,7 +2134,7 @@ static void Mod_MakeHull0 (qmodel_t *mod)
 
 	in = mod->nodes;
 	count = mod->numnodes;
-	out = (mclipnode_t *)Mem_Alloc (count * sizeof (*out));
+	out = (mclipnode_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	hull->clipnodes = out;
 	hull->firstclipnode = 0;
@@ -2152,19 +2160,19 @@ static void Mod_MakeHull0 (qmodel_t *mod)
 Mod_LoadMarksurfaces
 =================
 */
-static void Mod_LoadMarksurfaces (qmodel_t *mod, byte *mod_base, lump_t *l, int bsp2)
+static void Mod_LoadMarksurfaces (qmodel_t *mod, const byte *mod_base, lump_t *l, int bsp2)
 {
 	int	 i, j, count;
 	int *out;
 	if (bsp2)
 	{
-		byte *in = mod_base + l->fileofs;
+		const byte *in = mod_base + l->fileofs;
 
 		if (l->filelen % sizeof (unsigned int))
 			Host_Error ("Mod_LoadMarksurfaces: funny lump size in %s", mod->name);
 
 		count = l->filelen / sizeof (unsigned int);
-		out = (int *)Mem_Alloc (count * sizeof (*out));
+		out = (int *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 		mod->marksurfaces = out;
 		mod->nummarksurfaces = count;
@@ -2179,13 +2187,13 @@ static void Mod_LoadMarksurfaces (qmodel_t *mod, byte *mod_base, lump_t *l, int
 	}
 	else
 	{
-		byte *in = mod_base + l->fileofs;
+		const byte *in = mod_base + l->fileofs;
 
 		if (l->filelen % sizeof (short))
 			Host_Error ("Mod_LoadMarksurfaces: funny lump size in %s", mod->name);
 
 		count = l->filelen / sizeof (short);
-		out = (int *)Mem_Alloc (count * sizeof (*out));
+		out = (int *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 		mod->marksurfaces = out;
 		mod->nummarksurfaces = count;
@@ -2210,17 +2218,17 @@ static void Mod_LoadMarksurfaces (qmodel_t *mod, byte *mod_base, lump_t *l, int
 Mod_LoadSurfedges
 =================
 */
-static void Mod_LoadSurfedges (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadSurfedges (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	int	  i, count;
-	byte *in;
-	int	 *out;
+	int			i, count;
+	const byte *in;
+	int		   *out;
 
 	in = mod_base + l->fileofs;
 	if (l->filelen % sizeof (int))
 		Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 	count = l->filelen / sizeof (int);
-	out = (int *)Mem_Alloc (count * sizeof (int));
+	out = (int *)Mem_LevelAlloc (count * sizeof (int), MEMTAG_MODEL);
 
 	mod->surfedges = out;
 	mod->numsurfedges = count;
@@ -2236,19 +2244,19 @@ static void Mod_LoadSurfedges (qmodel_t *mod, byte *mod_base, lump_t *l)
 Mod_LoadPlanes
 =================
 */
-static void Mod_LoadPlanes (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadPlanes (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	int		  i, j;
-	mplane_t *out;
-	byte	 *in;
-	int		  count;
-	int		  bits;
+	int			i, j;
+	mplane_t   *out;
+	const byte *in;
+	int			count;
+	int			bits;
 
 	in = mod_base + l->fileofs;
 	if (l->filelen % sizeof (dplane_t))
 		Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 	count = l->filelen / sizeof (dplane_t);
-	out = (mplane_t *)Mem_Alloc (count * 2 * sizeof (*out));
+	out = (mplane_t *)Mem_LevelAlloc (count * 2 * sizeof (*out), MEMTAG_MODEL);
 
 	mod->planes = out;
 	mod->numplanes = count;
@@ -2292,17 +2300,17 @@ float RadiusFromBounds (vec3_t mins, vec3_t maxs)
 Mod_LoadSubmodels
 =================
 */
-static void Mod_LoadSubmodels (qmodel_t *mod, byte *mod_base, lump_t *l)
+static void Mod_LoadSubmodels (qmodel_t *mod, const byte *mod_base, lump_t *l)
 {
-	byte	 *in;
-	dmodel_t *out;
-	int		  i, j, count;
+	const byte *in;
+	dmodel_t   *out;
+	int			i, j, count;
 
 	in = mod_base + l->fileofs;
 	if (l->filelen % sizeof (dmodel_t))
 		Sys_Error ("MOD_LoadBmodel: funny lump size in %s", mod->name);
 	count = l->filelen / sizeof (dmodel_t);
-	out = (dmodel_t *)Mem_Alloc (count * sizeof (*out));
+	out = (dmodel_t *)Mem_LevelAlloc (count * sizeof (*out), MEMTAG_MODEL);
 
 	mod->submodels = out;
 	mod->numsubmodels = count;
@@ -2463,7 +2471,7 @@ static byte *Mod_LoadVisibilityExternal (FILE *f)
 	if (filelen <= 0)
 		return NULL;
 	Con_DPrintf ("...%d bytes visibility data\n", filelen);
-	visdata = (byte *)Mem_Alloc (filelen);
+	visdata = (byte *)Mem_LevelAlloc (filelen, MEMTAG_MODEL);
 	if (fread (visdata, filelen, 1, f) != 1)
 		return NULL;
 	return visdata;
@@ -2481,7 +2489,7 @@ static void Mod_LoadLeafsExternal (qmodel_t *mod, FILE *f)
 	if (filelen <= 0)
 		return;
 	Con_DPrintf ("...%d bytes leaf data\n", filelen);
-	in = Mem_Alloc (filelen);
+	in = Mem_AllocTagged (filelen, MEMTAG_MODEL);
 	if (fread (in, filelen, 1, f) != 1)
 		return;
 	Mod_ProcessLeafs_S (mod, (byte *)in, filelen);
@@ -2515,7 +2523,7 @@ static void Mod_CalcSpecialsAndTextures (qmodel_t *model)
 			++total;
 
 	texture_t **orig_textures = model->textures;
-	model->textures = (texture_t **)Mem_AllocNonZero (total * sizeof (*model->textures));
+	model->textures = (texture_t **)Mem_LevelAlloc (total * sizeof (*model->textures), MEMTAG_MODEL);
 	model->numtextures = total;
 
 	for (int i = 0; placed < total; i++)
@@ -2608,17 +2616,19 @@ static void Mod_SetupSubmodels (qmodel_t *mod)
 Mod_LoadBrushModel
 =================
 */
-static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffer)
+static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, const void *buffer)
 {
-	int		   i;
-	int		   bsp2;
-	dheader_t *header;
+	int			i;
+	int			bsp2;
+	dheader_t	header;
+	const byte *mod_base = (const byte *)buffer;
 
 	mod->type = mod_brush;
 
-	header = (dheader_t *)buffer;
+	// the file may be mapped read-only, so swap a copy of the header
+	memcpy (&header, mod_base, sizeof (header));
 
-	mod->bspversion = LittleLong (header->version);
+	mod->bspversion = LittleLong (header.version);
 
 	switch (mod->bspversion)
 	{
@@ -2640,22 +2650,20 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 	}
 
 	// swap all the lumps
-	byte *mod_base = (byte *)header;
-
 	for (i = 0; i < (int)sizeof (dheader_t) / 4; i++)
-		((int *)header)[i] = LittleLong (((int *)header)[i]);
+		((int *)&header)[i] = LittleLong (((int *)&header)[i]);
 
 	// load into heap
 
-	Mod_LoadVertexes (mod, mod_base, &header->lumps[LUMP_VERTEXES]);
-	Mod_LoadEdges (mod, mod_base, &header->lumps[LUMP_EDGES], bsp2);
-	Mod_LoadSurfedges (mod, mod_base, &header->lumps[LUMP_SURFEDGES]);
-	Mod_LoadTextures (mod, mod_base, &header->lumps[LUMP_TEXTURES]);
-	Mod_LoadLighting (mod, mod_base, &header->lumps[LUMP_LIGHTING]);
-	Mod_LoadPlanes (mod, mod_base, &header->lumps[LUMP_PLANES]);
-	Mod_LoadTexinfo (mod, mod_base, &header->lumps[LUMP_TEXINFO]);
-	Mod_LoadFaces (mod, mod_base, &header->lumps[LUMP_FACES], bsp2);
-	Mod_LoadMarksurfaces (mod, mod_base, &header->lumps[LUMP_MARKSURFACES], bsp2);
+	Mod_LoadVertexes (mod, mod_base, &header.lumps[LUMP_VERTEXES]);
+	Mod_LoadEdges (mod, mod_base, &header.lumps[LUMP_EDGES], bsp2);
+	Mod_LoadSurfedges (mod, mod_base, &header.lumps[LUMP_SURFEDGES]);
+	Mod_LoadTextures (mod, mod_base, &header.lumps[LUMP_TEXTURES]);
+	Mod_LoadLighting (mod, mod_base, &header.lumps[LUMP_LIGHTING]);
+	Mod_LoadPlanes (mod, mod_base, &header.lumps[LUMP_PLANES]);
+	Mod_LoadTexinfo (mod, mod_base, &header.lumps[LUMP_TEXINFO]);
+	Mod_LoadFaces (mod, mod_base, &header.lumps[LUMP_FACES], bsp2);
+	Mod_LoadMarksurfaces (mod, mod_base, &header.lumps[LUMP_MARKSURFACES], bsp2);
 
 	if (mod->bspversion == BSPVERSION && external_vis.value && sv.modelname[0] && !q_strcasecmp (loadname, sv.name))
 	{
@@ -2681,13 +2689,13 @@ static void Mod_LoadBrushModel (qmodel_t *mod, const char *loadname, void *buffe
 		}
 	}
 
-	Mod_LoadVisibility (mod, mod_base, &header->lumps[LUMP_VISIBILITY]);
-	Mod_LoadLeafs (mod, mod_base, &header->lumps[LUMP_LEAFS], bsp2);
+	Mod_LoadVisibility (mod, mod_base, &header.lumps[LUMP_VISIBILITY]);
+	Mod_LoadLeafs (mod, mod_base, &header.lumps[LUMP_LEAFS], bsp2);
 visdone:
-	Mod_LoadNodes (mod, mod_base, &header->lumps[LUMP_NODES], bsp2);
-	Mod_LoadClipnodes (mod, mod_base, &header->lumps[LUMP_CLIPNODES], bsp2);
-	Mod_LoadEntities (mod, mod_base, &header->lumps[LUMP_ENTITIES]);
-	Mod_LoadSubmodels (mod, mod_base, &header->lumps[LUMP_MODELS]);
+	Mod_LoadNodes (mod, mod_base, &header.lumps[LUMP_NODES], bsp2);
+	Mod_LoadClipnodes (mod, mod_base, &header.lumps[LUMP_CLIPNODES], bsp2);
+	Mod_LoadEntities (mod, mod_base, &header.lumps[LUMP_ENTITIES]);
+	Mod_LoadSubmodels (mod, mod_base, &header.lumps[LUMP_MODELS]);
 
 	Mod_MakeHull0 (mod);
 
@@ -2710,25 +2718,25 @@ mtriangle_t triangles[MAXALIASTRIS];
 
 // a pose is a single set of vertexes.  a frame may be
 // an animating sequence of poses
-trivertx_t *poseverts[MAXALIASFRAMES];
-int			posenum;
+const trivertx_t *poseverts[MAXALIASFRAMES];
+int				  posenum;
 
 /*
 =================
 Mod_LoadAliasFrame
 =================
 */
-void *Mod_LoadAliasFrame (void *pin, aliashdr_t *pheader, const int index)
+const void *Mod_LoadAliasFrame (const void *pin, aliashdr_t *pheader, const int index)
 {
-	maliasframedesc_t *frame = &pheader->frames[index];
-	trivertx_t		  *pinframe;
-	int				   i;
-	daliasframe_t	  *pdaliasframe;
+	maliasframedesc_t	*frame = &pheader->frames[index];
+	const trivertx_t	*pinframe;
+	int					 i;
+	const daliasframe_t *pdaliasframe;
 
 	if (posenum >= MAXALIASFRAMES)
 		Sys_Error ("posenum >= MAXALIASFRAMES");
 
-	pdaliasframe = (daliasframe_t *)pin;
+	pdaliasframe = (const daliasframe_t *)pin;
 
 	q_strlcpy (frame->name, pdaliasframe->name, sizeof (frame->name));
 	frame->firstpose = posenum;
@@ -2742,14 +2750,14 @@ void *Mod_LoadAliasFrame (void *pin, aliashdr_t *pheader, const int index)
 		frame->bboxmax.v[i] = pdaliasframe->bboxmax.v[i];
 	}
 
-	pinframe = (trivertx_t *)(pdaliasframe + 1);
+	pinframe = (const trivertx_t *)(pdaliasframe + 1);
 
 	poseverts[posenum] = pinframe;
 	posenum++;
 
 	pinframe += pheader->numverts;
 
-	return (void *)pinframe;
+	return (const void *)pinframe;
 }
 
 /*
@@ -2757,15 +2765,15 @@ void *Mod_LoadAliasFrame (void *pin, aliashdr_t *pheader, const int index)
 Mod_LoadAliasGroup
 =================
 */
-void *Mod_LoadAliasGroup (void *pin, aliashdr_t *pheader, const int index)
+const void *Mod_LoadAliasGroup (const void *pin, aliashdr_t *pheader, const int index)
 {
-	maliasframedesc_t *frame = &pheader->frames[index];
-	daliasgroup_t	  *pingroup;
-	int				   i, numframes;
-	daliasinterval_t  *pin_intervals;
-	void			  *ptemp;
+	maliasframedesc_t	   *frame = &pheader->frames[index];
+	const daliasgroup_t	   *pingroup;
+	int						i, numframes;
+	const daliasinterval_t *pin_intervals;
+	const void			   *ptemp;
 
-	pingroup = (daliasgroup_t *)pin;
+	pingroup = (const daliasgroup_t *)pin;
 
 	numframes = LittleLong (pingroup->numframes);
 
@@ -2779,23 +2787,23 @@ void *Mod_LoadAliasGroup (void *pin, aliashdr_t *pheader, const int index)
 		frame->bboxmax.v[i] = pingroup->bboxmax.v[i];
 	}
 
-	pin_intervals = (daliasinterval_t *)(pingroup + 1);
+	pin_intervals = (const daliasinterval_t *)(pingroup + 1);
 
 	frame->interval = LittleFloat (pin_intervals->interval);
 
 	pin_intervals += numframes;
 
-	ptemp = (void *)pin_intervals;
+	ptemp = (const void *)pin_intervals;
 
 	for (i = 0; i < numframes; i++)
 	{
 		if (posenum >= MAXALIASFRAMES)
 			Sys_Error ("posenum >= MAXALIASFRAMES");
 
-		poseverts[posenum] = (trivertx_t *)((daliasframe_t *)ptemp + 1);
+		poseverts[posenum] = (const trivertx_t *)((const daliasframe_t *)ptemp + 1);
 		posenum++;
 
-		ptemp = (trivertx_t *)((daliasframe_t *)ptemp + 1) + pheader->numverts;
+		ptemp = (const trivertx_t *)((const daliasframe_t *)ptemp + 1) + pheader->numverts;
 	}
 
 	return ptemp;
@@ -2890,25 +2898,26 @@ Mod_LoadSkinTask
 */
 typedef struct load_skin_task_args_s
 {
-	aliashdr_t *pheader;
-	qmodel_t   *mod;
-	byte	   *mod_base;
-	byte	  **ppskintypes;
+	aliashdr_t	*pheader;
+	qmodel_t	*mod;
+	const byte	*mod_base;
+	const byte **ppskintypes;
 } load_skin_task_args_t;
 
 static void Mod_LoadSkinTask (int i, load_skin_task_args_t *args)
 {
 	int			 j, k, size, groupskins;
 	char		 name[MAX_QPATH];
-	byte		*skin, *texels;
-	byte		*pskintype = args->ppskintypes[i];
-	byte		*pinskingroup;
-	byte		*pinskinintervals;
+	const byte	*skin;
+	byte		*texels;
+	const byte	*pskintype = args->ppskintypes[i];
+	const byte	*pinskingroup;
+	const byte	*pinskinintervals;
 	char		 fbr_mask_name[MAX_QPATH]; // johnfitz -- added for fullbright support
 	src_offset_t offset;				   // johnfitz
 	unsigned int texflags = TEXPREF_PAD;
 	qmodel_t	*mod = args->mod;
-	byte		*mod_base = args->mod_base;
+	const byte	*mod_base = args->mod_base;
 	aliashdr_t	*pheader = args->pheader;
 
 	size = pheader->skinwidth * pheader->skinheight;
@@ -2919,29 +2928,30 @@ static void Mod_LoadSkinTask (int i, load_skin_task_args_t *args)
 	if (ReadLongUnaligned (pskintype + offsetof (daliasskintype_t, type)) == ALIAS_SKIN_SINGLE)
 	{
 		skin = pskintype + sizeof (daliasskintype_t);
-		Mod_FloodFillSkin (skin, pheader->skinwidth, pheader->skinheight);
 
 		// save 8 bit texels for the player model to remap
-		texels = (byte *)Mem_Alloc (size);
+		// the file may be mapped read-only, so fill the copy
+		texels = (byte *)Mem_AllocTagged (size, MEMTAG_MODEL);
 		pheader->texels[i] = texels;
 		memcpy (texels, skin, size);
+		Mod_FloodFillSkin (texels, pheader->skinwidth, pheader->skinheight);
 
 		// johnfitz -- rewritten
 		q_snprintf (name, sizeof (name), "%s:frame%i", mod->name, i);
 		offset = (src_offset_t)(skin) - (src_offset_t)mod_base;
-		if (Mod_CheckFullbrights (skin, size))
+		if (Mod_CheckFullbrights (texels, size))
 		{
 			pheader->gltextures[i][0] = TexMgr_LoadImage (
-				mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP | TEXPREF_NOBRIGHT);
+				mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, texels, mod->name, offset, texflags | TEXPREF_MIPMAP | TEXPREF_NOBRIGHT);
 			q_snprintf (fbr_mask_name, sizeof (fbr_mask_name), "%s:frame%i_glow", mod->name, i);
 			pheader->fbtextures[i][0] = TexMgr_LoadImage (
-				mod, fbr_mask_name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset,
+				mod, fbr_mask_name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, texels, mod->name, offset,
 				texflags | TEXPREF_MIPMAP | TEXPREF_FULLBRIGHT);
 		}
 		else
 		{
 			pheader->gltextures[i][0] =
-				TexMgr_LoadImage (mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP);
+				TexMgr_LoadImage (mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, texels, mod->name, offset, texflags | TEXPREF_MIPMAP);
 			pheader->fbtextures[i][0] = NULL;
 		}
 
@@ -2957,38 +2967,41 @@ static void Mod_LoadSkinTask (int i, load_skin_task_args_t *args)
 		pinskinintervals = pinskingroup + sizeof (daliasskingroup_t);
 		skin = pinskinintervals + (groupskins * sizeof (daliasskininterval_t));
 
+		TEMP_ALLOC (byte, pixels, size);
 		for (j = 0; j < groupskins; j++)
 		{
-			Mod_FloodFillSkin (skin, pheader->skinwidth, pheader->skinheight);
+			memcpy (pixels, skin, size);
+			Mod_FloodFillSkin (pixels, pheader->skinwidth, pheader->skinheight);
 			if (j == 0)
 			{
-				texels = (byte *)Mem_Alloc (size);
+				texels = (byte *)Mem_AllocTagged (size, MEMTAG_MODEL);
 				pheader->texels[i] = texels;
-				memcpy (texels, skin, size);
+				memcpy (texels, pixels, size);
 			}
 
 			// johnfitz -- rewritten
 			q_snprintf (name, sizeof (name), "%s:frame%i_%i", mod->name, i, j);
 			offset = (src_offset_t)(skin) - (src_offset_t)mod_base; // johnfitz
-			if (Mod_CheckFullbrights (skin, size))
+			if (Mod_CheckFullbrights (pixels, size))
 			{
 				pheader->gltextures[i][j & 3] = TexMgr_LoadImage (
-					mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP | TEXPREF_NOBRIGHT);
+					mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, pixels, mod->name, offset, texflags | TEXPREF_MIPMAP | TEXPREF_NOBRIGHT);
 				q_snprintf (fbr_mask_name, sizeof (fbr_mask_name), "%s:frame%i_%i_glow", mod->name, i, j);
 				pheader->fbtextures[i][j & 3] = TexMgr_LoadImage (
-					mod, fbr_mask_name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset,
+					mod, fbr_mask_name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, pixels, mod->name, offset,
 					texflags | TEXPREF_MIPMAP | TEXPREF_FULLBRIGHT);
 			}
 			else
 			{
 				pheader->gltextures[i][j & 3] =
-					TexMgr_LoadImage (mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, skin, mod->name, offset, texflags | TEXPREF_MIPMAP);
+					TexMgr_LoadImage (mod, name, pheader->skinwidth, pheader->skinheight, SRC_INDEXED, pixels, mod->name, offset, texflags | TEXPREF_MIPMAP);
 				pheader->fbtextures[i][j & 3] = NULL;
 			}
 			// johnfitz
 
 			skin += size;
 		}
+		TEMP_FREE (pixels);
 		k = j;
 		for (/**/; j < 4; j++)
 			pheader->gltextures[i][j & 3] = pheader->gltextures[i][j - k];
@@ -3000,12 +3013,12 @@ static void Mod_LoadSkinTask (int i, load_skin_task_args_t *args)
 Mod_LoadAllSkins
 ===============
 */
-void *Mod_LoadAllSkins (aliashdr_t *pheader, qmodel_t *mod, byte *mod_base, int numskins, byte *pskintype)
+const void *Mod_LoadAllSkins (aliashdr_t *pheader, qmodel_t *mod, const byte *mod_base, int numskins, const byte *pskintype)
 {
 	if (numskins < 1 || numskins > MAX_SKINS)
 		Sys_Error ("Mod_LoadAliasModel: Invalid # of skins: %d", numskins);
 
-	TEMP_ALLOC (byte *, ppskintypes, numskins);
+	TEMP_ALLOC (const byte *, ppskintypes, numskins);
 	int size = pheader->skinwidth * pheader->skinheight;
 	for (int i = 0; i < numskins; i++)
 	{
@@ -3017,10 +3030,10 @@ void *Mod_LoadAllSkins (aliashdr_t *pheader, qmodel_t *mod, byte *mod_base, int
 		else
 		{
 			// animating skin group.  yuck.
-			byte *pinskingroup = pskintype + sizeof (daliasskintype_t);
-			int	  groupskins = ReadLongUnaligned (pinskingroup + offsetof (daliasskingroup_t, numskins));
-			byte *pinskinintervals = pinskingroup + sizeof (daliasskingroup_t);
-			byte *skin = pinskinintervals + (groupskins * sizeof (daliasskininterval_t));
+			const byte *pinskingroup = pskintype + sizeof (daliasskintype_t);
+			int			groupskins = ReadLongUnaligned (pinskingroup + offsetof (daliasskingroup_t, numskins));
+			const byte *pinskinintervals = pinskingroup + sizeof (daliasskingroup_t);
+			const byte *skin = pinskinintervals + (groupskins * sizeof (daliasskininterval_t));
 			pskintype = skin + (groupskins * size);
 		}
 	}
@@ -3033,7 +3046,9 @@ void *Mod_LoadAllSkins (aliashdr_t *pheader, qmodel_t *mod, byte *mod_base, int
 	};
 	if (!Tasks_IsWorker () && (numskins > 1))
 	{
-		task_handle_t task = Task_AllocateAssignIndexedFuncAndSubmit ((task_indexed_func_t)Mod_LoadSkinTask, numskins, &args, sizeof (args));
+		task_handle_t task = Task_AllocateAndAssignIndexedFunc ((task_indexed_func_t)Mod_LoadSkinTask, numskins, &args, sizeof (args));
+		Task_SetPriority (task, TASK_PRIORITY_BACKGROUND);
+		Task_Submit (task);
 		Task_Join (task, SDL_MUTEX_MAXWAIT);
 	}
 	else
@@ -3045,7 +3060,7 @@ void *Mod_LoadAllSkins (aliashdr_t *pheader, qmodel_t *mod, byte *mod_base, int
 	}
 
 	TEMP_FREE (ppskintypes);
-	return (void *)pskintype;
+	return (const void *)pskintype;
 }
 
 //=========================================================================
@@ -3198,16 +3213,16 @@ void Mod_SetExtraFlags (qmodel_t *mod)
 Mod_LoadAliasModel
 =================
 */
-static void Mod_LoadAliasModel (qmodel_t *mod, void *buffer)
+static void Mod_LoadAliasModel (qmodel_t *mod, const void *buffer)
 {
-	int	  i, j;
-	byte *pinstverts;
-	byte *pintriangles;
-	int	  version, numframes;
-	int	  size;
-	byte *pframetype;
-	byte *pskintype;
-	byte *mod_base = (byte *)buffer; // johnfitz
+	int			i, j;
+	const byte *pinstverts;
+	const byte *pintriangles;
+	int			version, numframes;
+	int			size;
+	const byte *pframetype;
+	const byte *pskintype;
+	const byte *mod_base = (const byte *)buffer; // johnfitz
 
 	version = ReadLongUnaligned (mod_base + offsetof (mdl_t, version));
 	if (version != ALIAS_VERSION)
@@ -3218,7 +3233,7 @@ static void Mod_LoadAliasModel (qmodel_t *mod, void *buffer)
 	// skin and group info
 	//
 	size = sizeof (aliashdr_t) + (ReadLongUnaligned (mod_base + offsetof (mdl_t, numframes)) - 1) * sizeof (maliasframedesc_t);
-	aliashdr_t *pheader = (aliashdr_t *)Mem_Alloc (size);
+	aliashdr_t *pheader = (aliashdr_t *)Mem_AllocTagged (size, MEMTAG_MODEL);
 	pheader->poseverttype = PV_QUAKE1;
 
 	mod->flags = ReadLongUnaligned (mod_base + offsetof (mdl_t, flags));
@@ -3341,29 +3356,29 @@ static void Mod_LoadAliasModel (qmodel_t *mod, void *buffer)
 /*
 =================
 Mod_LoadSpriteFrame
+
+pin may sit at any offset inside a read-only mapped pak, so the header is read field by field
 =================
 */
-static void *Mod_LoadSpriteFrame (qmodel_t *mod, byte *mod_base, void *pin, mspriteframe_t **ppframe, int framenum)
+static const byte *Mod_LoadSpriteFrame (qmodel_t *mod, const byte *mod_base, const byte *pin, mspriteframe_t **ppframe, int framenum)
 {
-	dspriteframe_t *pinframe;
 	mspriteframe_t *pspriteframe;
+	const byte	   *pixels;
 	int				width, height, size, origin[2];
 	char			name[64];
 	src_offset_t	offset; // johnfitz
 
-	pinframe = (dspriteframe_t *)pin;
-
-	width = LittleLong (pinframe->width);
-	height = LittleLong (pinframe->height);
+	width = ReadLongUnaligned (pin + offsetof (dspriteframe_t, width));
+	height = ReadLongUnaligned (pin + offsetof (dspriteframe_t, height));
 	size = width * height;
 
-	pspriteframe = (mspriteframe_t *)Mem_Alloc (sizeof (mspriteframe_t));
+	pspriteframe = (mspriteframe_t *)Mem_AllocTagged (sizeof (mspriteframe_t), MEMTAG_MODEL);
 	*ppframe = pspriteframe;
 
 	pspriteframe->width = width;
 	pspriteframe->height = height;
-	origin[0] = LittleLong (pinframe->origin[0]);
-	origin[1] = LittleLong (pinframe->origin[1]);
+	origin[0] = ReadLongUnaligned (pin + offsetof (dspriteframe_t, origin[0]));
+	origin[1] = ReadLongUnaligned (pin + offsetof (dspriteframe_t, origin[1]));
 
 	pspriteframe->up = origin[1];
 	pspriteframe->down = origin[1] - height;
@@ -3373,13 +3388,15 @@ static void *Mod_LoadSpriteFrame (qmodel_t *mod, byte *mod_base, void *pin, mspr
 	pspriteframe->smax = 1;
 	pspriteframe->tmax = 1;
 
+	pixels = pin + sizeof (dspriteframe_t);
 	q_snprintf (name, sizeof (name), "%s:frame%i", mod->name, framenum);
-	offset = (src_offset_t)(pinframe + 1) - (src_offset_t)mod_base; // johnfitz
+	offset = (src_offset_t)(pixels - mod_base); // johnfitz
+	// TexMgr only reads the indexed pixels; it keeps the source offset for reloads
 	pspriteframe->gltexture = TexMgr_LoadImage (
-		mod, name, width, height, SRC_INDEXED, (byte *)(pinframe + 1), mod->name, offset,
+		mod, name, width, height, SRC_INDEXED, (byte *)pixels, mod->name, offset,
 		TEXPREF_PAD | TEXPREF_ALPHA | TEXPREF_NOPICMIP); // johnfitz -- TexMgr
 
-	return (void *)((byte *)pinframe + sizeof (dspriteframe_t) + size);
+	return pixels + size;
 }
 
 /*
@@ -3387,45 +3404,39 @@ static void *Mod_LoadSpriteFrame (qmodel_t *mod, byte *mod_base, void *pin, mspr
 Mod_LoadSpriteGroup
 =================
 */
-static void *Mod_LoadSpriteGroup (qmodel_t *mod, byte *mod_base, void *pin, mspriteframe_t **ppframe, int framenum, spriteframetype_t type)
+static const byte *Mod_LoadSpriteGroup (qmodel_t *mod, const byte *mod_base, const byte *pin, mspriteframe_t **ppframe, int framenum, spriteframetype_t type)
 {
-	dspritegroup_t	  *pingroup;
-	mspritegroup_t	  *pspritegroup;
-	int				   i, numframes;
-	dspriteinterval_t *pin_intervals;
-	float			  *poutintervals;
-	void			  *ptemp;
+	mspritegroup_t *pspritegroup;
+	int				i, numframes;
+	float		   *poutintervals;
+	const byte	   *ptemp;
 
-	pingroup = (dspritegroup_t *)pin;
-
-	numframes = LittleLong (pingroup->numframes);
+	numframes = ReadLongUnaligned (pin + offsetof (dspritegroup_t, numframes));
 	if (type == SPR_ANGLED && numframes != 8)
 		Sys_Error ("Mod_LoadSpriteGroup: Bad # of frames: %d", numframes);
 
-	pspritegroup = (mspritegroup_t *)Mem_Alloc (sizeof (mspritegroup_t) + (numframes - 1) * sizeof (pspritegroup->frames[0]));
+	pspritegroup = (mspritegroup_t *)Mem_AllocTagged (sizeof (mspritegroup_t) + (numframes - 1) * sizeof (pspritegroup->frames[0]), MEMTAG_MODEL);
 
 	pspritegroup->numframes = numframes;
 
 	*ppframe = (mspriteframe_t *)pspritegroup;
 
-	pin_intervals = (dspriteinterval_t *)(pingroup + 1);
+	ptemp = pin + sizeof (dspritegroup_t);
 
-	poutintervals = (float *)Mem_Alloc (numframes * sizeof (float));
+	poutintervals = (float *)Mem_AllocTagged (numframes * sizeof (float), MEMTAG_MODEL);
 
 	pspritegroup->intervals = poutintervals;
 
 	for (i = 0; i < numframes; i++)
 	{
-		*poutintervals = LittleFloat (pin_intervals->interval);
+		*poutintervals = ReadFloatUnaligned (ptemp + offsetof (dspriteinterval_t, interval));
 		if (*poutintervals <= 0.0)
 			Sys_Error ("Mod_LoadSpriteGroup: interval<=0");
 
 		poutintervals++;
-		pin_intervals++;
+		ptemp += sizeof (dspriteinterval_t);
 	}
 
-	ptemp = (void *)pin_intervals;
-
 	for (i = 0; i < numframes; i++)
 	{
 		ptemp = Mod_LoadSpriteFrame (mod, mod_base, ptemp, &pspritegroup->frames[i], framenum * 100 + i);
@@ -3439,41 +3450,41 @@ static void *Mod_LoadSpriteGroup (qmodel_t *mod, byte *mod_base, void *pin, mspr
 Mod_LoadSpriteModel
 =================
 */
-static void Mod_LoadSpriteModel (qmodel_t *mod, void *buffer)
+static void Mod_LoadSpriteModel (qmodel_t *mod, const void *buffer)
 {
-	int					i;
-	int					version;
-	dsprite_t		   *pin;
-	msprite_t		   *psprite;
-	int					numframes;
-	int					size;
-	dspriteframetype_t *pframetype;
-
-	pin = (dsprite_t *)buffer;
-	byte *mod_base = (byte *)buffer; // johnfitz
-
-	version = LittleLong (pin->version);
+	int			i;
+	int			version;
+	const byte *pin;
+	msprite_t  *psprite;
+	int			numframes;
+	int			size;
+	const byte *pframetype;
+
+	pin = (const byte *)buffer;
+	const byte *mod_base = pin; // johnfitz
+
+	version = ReadLongUnaligned (pin + offsetof (dsprite_t, version));
 	if (version != SPRITE_VERSION)
 		Sys_Error (
 			"%s has wrong version number "
 			"(%i should be %i)",
 			mod->name, version, SPRITE_VERSION);
 
-	numframes = LittleLong (pin->numframes);
+	numframes = ReadLongUnaligned (pin + offsetof (dsprite_t, numframes));
 	if (numframes < 1)
 		Sys_Error ("Mod_LoadSpriteModel: Invalid # of frames: %d", numframes);
 
 	size = sizeof (msprite_t) + (numframes - 1) * sizeof (psprite->frames);
 
-	psprite = (msprite_t *)Mem_Alloc (size);
+	psprite = (msprite_t *)Mem_AllocTagged (size, MEMTAG_MODEL);
 
 	mod->extradata[0] = (byte *)psprite;
 
-	psprite->type = LittleLong (pin->type);
-	psprite->maxwidth = LittleLong (pin->width);
-	psprite->maxheight = LittleLong (pin->height);
-	psprite->beamlength = LittleFloat (pin->beamlength);
-	mod->synctype = (synctype_t)LittleLong (pin->synctype);
+	psprite->type = ReadLongUnaligned (pin + offsetof (dsprite_t, type));
+	psprite->maxwidth = ReadLongUnaligned (pin + offsetof (dsprite_t, width));
+	psprite->maxheight = ReadLongUnaligned (pin + offsetof (dsprite_t, height));
+	psprite->beamlength = ReadFloatUnaligned (pin + offsetof (dsprite_t, beamlength));
+	mod->synctype = (synctype_t)ReadLongUnaligned (pin + offsetof (dsprite_t, synctype));
 	psprite->numframes = numframes;
 
 	mod->mins[0] = mod->mins[1] = -psprite->maxwidth / 2;
@@ -3486,22 +3497,22 @@ static void Mod_LoadSpriteModel (qmodel_t *mod, void *buffer)
 	//
 	mod->numframes = numframes;
 
-	pframetype = (dspriteframetype_t *)(pin + 1);
+	pframetype = pin + sizeof (dsprite_t);
 
 	for (i = 0; i < numframes; i++)
 	{
 		spriteframetype_t frametype;
 
-		frametype = (spriteframetype_t)LittleLong (pframetype->type);
+		frametype = (spriteframetype_t)ReadLongUnaligned (pframetype + offsetof (dspriteframetype_t, type));
 		psprite->frames[i].type = frametype;
 
 		if (frametype == SPR_SINGLE)
 		{
-			pframetype = (dspriteframetype_t *)Mod_LoadSpriteFrame (mod, mod_base, pframetype + 1, &psprite->frames[i].frameptr, i);
+			pframetype = Mod_LoadSpriteFrame (mod, mod_base, pframetype + sizeof (dspriteframetype_t), &psprite->frames[i].frameptr, i);
 		}
 		else
 		{
-			pframetype = (dspriteframetype_t *)Mod_LoadSpriteGroup (mod, mod_base, pframetype + 1, &psprite->frames[i].frameptr, i, frametype);
+			pframetype = Mod_LoadSpriteGroup (mod, mod_base, pframetype + sizeof (dspriteframetype_t), &psprite->frames[i].frameptr, i, frametype);
 		}
 	}
 
@@ -3979,10 +3990,10 @@ static void MD5Anim_Load (md5animctx_t *ctx, jointinfo_t *joints, size_t numjoin
 	if (ctx->numjoints != numjoints)
 		Sys_Error ("%s has incorrect joint count", fname);
 
-	raw = Mem_Alloc (sizeof (*raw) * (rawcount + 6));
-	ab = Mem_Alloc (sizeof (*ab) * ctx->numjoints);
+	raw = Mem_AllocTagged (sizeof (*raw) * (rawcount + 6), MEMTAG_MODEL);
+	ab = Mem_AllocTagged (sizeof (*ab) * ctx->numjoints, MEMTAG_MODEL);
 
-	ctx->posedata = outposes = Mem_Alloc (sizeof (*outposes) * ctx->numjoints * ctx->numposes);
+	ctx->posedata = outposes = Mem_AllocTagged (sizeof (*outposes) * ctx->numjoints * ctx->numposes, MEMTAG_MODEL);
 
 	MD5EXPECT ("hierarchy");
 	MD5EXPECT ("{");
@@ -4125,7 +4136,7 @@ static void Mod_LoadMD5MeshModel (qmodel_t *mod, const void *buffer)
 
 	hdrsize = sizeof (*outhdr) - sizeof (outhdr->frames);
 	hdrsize += sizeof (outhdr->frames) * anim.numposes;
-	outhdr = Mem_Alloc (hdrsize * numjoints);
+	outhdr = Mem_AllocTagged (hdrsize * numjoints, MEMTAG_MODEL);
 	TEMP_ALLOC_ZEROED (jointinfo_t, joint_infos, numjoints);
 	TEMP_ALLOC_ZEROED (jointpose_t, joint_poses, numjoints);
 
@@ -4220,7 +4231,7 @@ static void Mod_LoadMD5MeshModel (qmodel_t *mod, const void *buffer)
 						if (f == 0)
 						{
 							size_t size = fwidth * fheight;
-							byte  *texels = (byte *)Mem_Alloc (size);
+							byte  *texels = (byte *)Mem_AllocTagged (size, MEMTAG_MODEL);
 							surf->texels[surf->numskins] = texels;
 							memcpy (texels, data, size);
 						}
@@ -4287,7 +4298,7 @@ static void Mod_LoadMD5MeshModel (qmodel_t *mod, const void *buffer)
 		MD5EXPECT ("numverts");
 		surf->numverts_vbo = surf->numverts = MD5UINT ();
 
-		vinfo = Mem_Alloc (sizeof (*vinfo) * surf->numverts);
+		vinfo = Mem_AllocTagged (sizeof (*vinfo) * surf->numverts, MEMTAG_MODEL);
 		poutvertexes = Mem_Realloc (poutvertexes, sizeof (*poutvertexes) * (vertex_offset + surf->numverts));
 		while (MD5CHECK ("vert"))
 		{
@@ -4326,7 +4337,7 @@ static void Mod_LoadMD5MeshModel (qmodel_t *mod, const void *buffer)
 		// md5 is a gpu-unfriendly interchange format. :(
 		MD5EXPECT ("numweights");
 		numweights = MD5UINT ();
-		weight = Mem_Alloc (sizeof (*weight) * numweights);
+		weight = Mem_AllocTagged (sizeof (*weight) * numweights, MEMTAG_MODEL);
 		while (MD5CHECK ("weight"))
 		{
 			size_t idx = MD5UINT ();
@@ -378,11 +378,14 @@ typedef struct aliashdr_s
 	struct gltexture_s *fbtextures[MAX_SKINS][4]; // johnfitz
 	byte			   *texels[MAX_SKINS];		  // only for player skins
 	VkBuffer			vertex_buffer;
+	VkDeviceSize		vertex_buffer_size;
 	glheapallocation_t *vertex_allocation;
 	VkBuffer			index_buffer;
+	VkDeviceSize		index_buffer_size;
 	glheapallocation_t *index_allocation;
 	int					vbostofs; // offset in vbo of hdr->numverts_vbo meshst_t
 	VkBuffer			joints_buffer;
+	VkDeviceSize		joints_buffer_size;
 	glheapallocation_t *joints_allocation;
 	VkDescriptorSet		joints_set;
 	maliasframedesc_t	frames[1]; // variable sized
@@ -408,9 +411,9 @@ typedef struct jointpose_s
 #define MAXALIASVERTS  (3 * MAXALIASTRIS) // johnfitz -- was 1024
 #define MAXALIASFRAMES 2048				  // spike -- was 256
 
-extern mtriangle_t triangles[MAXALIASTRIS];
-extern stvert_t	   stverts[MAXALIASVERTS];
-extern trivertx_t *poseverts[MAXALIASFRAMES];
+extern mtriangle_t		 triangles[MAXALIASTRIS];
+extern stvert_t			 stverts[MAXALIASVERTS];
+extern const trivertx_t *poseverts[MAXALIASFRAMES];
 
 //===================================================================
 
@@ -867,7 +867,7 @@ static void R_SortAlphaEntitiesTask (void *unused)
 		unsigned sortkey;
 	} transp_sort;
 	cl_numvisedicts_alpha_overwater = cl_numvisedicts_alpha_underwater = 0;
-	TEMP_ALLOC_COND (transp_sort, edicts, cl_numvisedicts * 2, r_alphasort.value);
+	transp_sort *edicts = r_alphasort.value ? (transp_sort *)Arena_FrameAlloc (sizeof (transp_sort) * cl_numvisedicts * 2) : NULL;
 	int sort_bins[3][128];
 	if (r_alphasort.value)
 		memset (sort_bins, 0, sizeof (sort_bins));
@@ -946,8 +946,6 @@ static void R_SortAlphaEntitiesTask (void *unused)
 				cl_visedicts_alpha[highest - sort_bins[pass][key]] = cl_visedicts[from[i].visedict];
 		}
 	}
-
-	TEMP_FREE (edicts);
 }
 
 /*
@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 cvar_t r_lodbias = {"r_lodbias", "1", CVAR_ARCHIVE};
 cvar_t gl_lodbias = {"gl_lodbias", "0", CVAR_ARCHIVE};
+cvar_t r_heap_compact = {"r_heap_compact", "0", CVAR_ARCHIVE}; // max occupancy of heap segments that get evacuated on map load, 0 = off
 
 // johnfitz -- new cvars
 extern cvar_t r_clearcolor;
@@ -3634,6 +3635,7 @@ void R_Init (void)
 	Cvar_RegisterVariable (&r_tasks);
 	Cvar_RegisterVariable (&r_parallelmark);
 	Cvar_RegisterVariable (&r_usesops);
+	Cvar_RegisterVariable (&r_heap_compact);
 
 	R_InitParticles ();
 	SetClearColor (); // johnfitz
@@ -3857,6 +3859,12 @@ void R_NewMap (void)
 #endif
 	GL_DeleteBModelVertexBuffer ();
 
+	if (r_heap_compact.value > 0.0f)
+	{
+		R_CompactMeshHeap (q_min (r_heap_compact.value, 1.0f));
+		TexMgr_ReleaseEmptyHeapSegments ();
+	}
+
 	GL_BuildLightmaps ();
 	GL_BuildBModelVertexBuffer ();
 	GL_BuildBModelAccelerationStructures ();
@@ -4190,6 +4198,21 @@ static void R_PrintHeapStats (const char *name, glheapstats_t *stats)
 		name, stats->num_segments, stats->num_allocations, stats->num_small_allocations, stats->num_block_allocations, stats->num_dedicated_allocations,
 		stats->num_blocks_used, stats->num_blocks_free, stats->num_pages_allocated, stats->num_pages_free, stats->num_bytes_allocated, stats->num_bytes_free,
 		stats->num_bytes_wasted, ((double)stats->num_bytes_wasted / (double)stats->num_bytes_allocated) * 100.0f);
+
+	Con_Printf ("  small slots used/total:");
+	for (int i = 0; i < GL_HEAP_NUM_SMALL_ALLOC_SIZES; ++i)
+		Con_Printf (" %" SDL_PRIu32 "/%" SDL_PRIu32, stats->num_small_alloc_slots_used[i], stats->num_small_alloc_slots_total[i]);
+	Con_Printf ("\n  free blocks/pages by size:");
+	for (int i = 0; i < GL_HEAP_NUM_BLOCK_SIZE_CLASSES; ++i)
+		Con_Printf (
+			" %u%s:%" SDL_PRIu32 "/%" SDL_PRIu32, 1u << i, (i == (GL_HEAP_NUM_BLOCK_SIZE_CLASSES - 1)) ? "+" : "", stats->num_free_blocks_per_class[i],
+			stats->num_free_pages_per_class[i]);
+	Con_Printf (
+		"\n"
+		"  largest free block: %" SDL_PRIu32 " pages\n"
+		"  relocations: %" SDL_PRIu32 " (%" SDL_PRIu64 " bytes)\n"
+		"  segments released: %" SDL_PRIu32 "\n",
+		stats->largest_free_block_pages, stats->num_relocations, stats->num_bytes_relocated, stats->num_segments_released);
 }
 
 /*
@@ -629,7 +629,7 @@ void TexMgr_Init (void)
 	texmgr_mutex = SDL_CreateMutex ();
 
 	// init texture list
-	free_gltextures = (gltexture_t *)Mem_Alloc (MAX_GLTEXTURES * sizeof (gltexture_t));
+	free_gltextures = (gltexture_t *)Mem_AllocTagged (MAX_GLTEXTURES * sizeof (gltexture_t), MEMTAG_TEXTURE);
 	active_gltextures = NULL;
 	for (i = 0; i < MAX_GLTEXTURES - 1; i++)
 		free_gltextures[i].next = &free_gltextures[i + 1];
@@ -1377,7 +1377,7 @@ void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants)
 		{
 			size *= LIGHTMAP_BYTES;
 		}
-		allocated = data = (byte *)Mem_Alloc (size);
+		allocated = data = (byte *)Mem_AllocTagged (size, MEMTAG_TEXTURE);
 		if (fread (data, 1, size, f) != size)
 			goto invalid;
 		fclose (f);
@@ -1446,7 +1446,7 @@ void TexMgr_ReloadImage (gltexture_t *glt, int shirt, int pants)
 
 		// translate texture
 		size = glt->width * glt->height;
-		dst = translated = (byte *)Mem_Alloc (size);
+		dst = translated = (byte *)Mem_AllocTagged (size, MEMTAG_TEXTURE);
 		src = data;
 
 		for (i = 0; i < size; i++)
@@ -1606,3 +1606,18 @@ glheapstats_t *TexMgr_GetHeapStats (void)
 {
 	return GL_HeapGetStats (texmgr_heap);
 }
+
+/*
+================
+TexMgr_ReleaseEmptyHeapSegments
+
+Images are never relocated, but segments emptied by freeing textures can be given back
+================
+*/
+void TexMgr_ReleaseEmptyHeapSegments (void)
+{
+	SDL_LockMutex (texmgr_mutex);
+	const uint32_t num_released = GL_HeapReleaseEmptySegments (texmgr_heap, &num_vulkan_tex_allocations);
+	SDL_UnlockMutex (texmgr_mutex);
+	Con_DPrintf ("Texture heap: released %" SDL_PRIu32 " segments\n", num_released);
+}
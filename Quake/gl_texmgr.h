@@ -119,5 +119,6 @@ void TexMgr_UpdateTextureDescriptorSets (void);
 
 typedef struct glheapstats_s glheapstats_t;
 glheapstats_t				*TexMgr_GetHeapStats (void);
+void						 TexMgr_ReleaseEmptyHeapSegments (void);
 
 #endif /* _GL_TEXMAN_H */
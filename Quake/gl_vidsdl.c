@@ -2484,6 +2484,7 @@ qboolean GL_BeginRendering (qboolean use_tasks, task_handle_t *begin_rendering_t
 	*width = vid.width;
 	*height = vid.height;
 
+	Arena_BeginFrame ();
 	if (use_tasks)
 		*begin_rendering_task = Task_AllocateAndAssignFunc (GL_BeginRenderingTask, NULL, 0);
 	else
@@ -2599,6 +2600,7 @@ typedef struct end_rendering_parms_s
 	vec3_t	 forward;
 	vec3_t	 right;
 	vec3_t	 down;
+	uint32_t arena_frame;
 } end_rendering_parms_t;
 
 #define SCREEN_EFFECT_FLAG_SCALE_MASK 0x3
@@ -2779,6 +2781,8 @@ GL_EndRenderingTask
 */
 static void GL_EndRenderingTask (end_rendering_parms_t *parms)
 {
+	// All tasks of this frame have finished, scratch memory can be reused two frames from now
+	Arena_EndFrame (parms->arena_frame);
 	R_SubmitStagingBuffers ();
 	R_FlushDynamicBuffers ();
 
@@ -2973,6 +2977,7 @@ task_handle_t GL_EndRendering (qboolean use_tasks, qboolean swapchain)
 				-vulkan_globals.view_matrix[5],
 				-vulkan_globals.view_matrix[9],
 			},
+		.arena_frame = Arena_CurrentFrame (),
 	};
 	task_handle_t end_rendering_task = INVALID_TASK_HANDLE;
 	if (use_tasks)
@@ -4089,7 +4094,10 @@ void SCR_ScreenShot_f (void)
 		ok = false;
 
 	if (ok)
+	{
 		Con_Printf ("Wrote %s\n", imagename);
+		COM_FlushDirectoryCache ();
+	}
 	else
 		Con_Printf ("SCR_ScreenShot_f: Couldn't create %s\n", imagename);
 
@@ -708,6 +708,7 @@ void  R_StagingUploadBuffer (const VkBuffer buffer, const size_t size, const byt
 void		   R_InitGPUBuffers (void);
 void		   R_InitMeshHeap (void);
 glheapstats_t *R_GetMeshHeapStats (void);
+void		   R_CompactMeshHeap (float max_occupancy);
 void		   R_SwapDynamicBuffers (void);
 void		   R_FlushDynamicBuffers (void);
 void		   R_CollectDynamicBufferGarbage (void);
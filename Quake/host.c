@@ -291,6 +291,7 @@ void Host_InitLocal (void)
 	Cmd_AddCommand ("version", Host_Version_f);
 
 	Host_InitCommands ();
+	Tasks_InitCommands ();
 
 	Cvar_RegisterVariable (&pr_engine);
 	Cvar_RegisterVariable (&host_framerate);
@@ -377,6 +378,7 @@ void Host_WriteConfiguration (void)
 		// johnfitz
 
 		fclose (f);
+		COM_FlushDirectoryCache ();
 	}
 }
 
@@ -683,6 +685,10 @@ void Host_ClearMemory (void)
 	memset (&sv, 0, sizeof (sv));
 
 	CL_FreeState ();
+	// Everything that opted into the level region was already dropped by Mod_ClearAll
+	Mem_LevelFreeAll ();
+	// pick up files that were added to loose game directories since the last map
+	COM_FlushDirectoryCache ();
 }
 
 //==============================================================================
@@ -906,6 +912,8 @@ void _Host_Frame (double time)
 	if (!Host_FilterTime (time))
 		return; // don't run too fast, or packets will flood out
 
+	Tasks_TraceFrame ();
+
 	if (host_speeds.value)
 		time3 = Sys_DoubleTime ();
 
@@ -971,6 +979,8 @@ void _Host_Frame (double time)
 			break;
 	}
 
+	SV_PrefetchFrame ();
+
 	if (cl.qcvm.progs)
 	{
 		PR_SwitchQCVM (&cl.qcvm);
@@ -1065,6 +1075,8 @@ static void Tests_Init ()
 	Cmd_AddCommand ("test_hash_map", TestHashMap_f);
 	Cmd_AddCommand ("test_gl_heap", GL_HeapTest_f);
 	Cmd_AddCommand ("test_tasks", TestTasks_f);
+	Cmd_AddCommand ("test_engine_strings", TestEngineStrings_f);
+	Cmd_AddCommand ("test_edict_mirror", TestEdictMirror_f);
 #endif
 }
 
@@ -1281,6 +1293,9 @@ void Host_Shutdown (void)
 
 	Host_WriteConfiguration ();
 
+	// workers may still be decoding sounds for the next map
+	SV_CancelPrefetch ();
+
 	NET_Shutdown ();
 
 	if (cls.state != ca_dedicated)
@@ -1198,6 +1198,7 @@ void Host_Savegame_f ()
 	fprintf (f, "*/\n");
 
 	fclose (f);
+	COM_FlushDirectoryCache ();
 	Con_Printf ("done.\n");
 	PR_SwitchQCVM (NULL);
 	SaveList_Rebuild ();
@@ -1537,6 +1538,7 @@ void Host_Loadgame_f (const char *savename)
 		Con_Warning ("Save game had less entities than map (%d < %d)\n", entnum, qcvm->num_edicts); // should be Host_Error, but try to recover
 
 	qcvm->num_edicts = q_max (qcvm->num_edicts, entnum);
+	ED_ResetIndex (); // the edicts were rewritten in place
 
 	Mem_Free (start);
 	start = NULL;
@@ -1987,6 +1989,7 @@ static void Host_Spawn_f (void)
 		ent->v.colormap = NUM_FOR_EDICT (ent);
 		ent->v.team = (host_client->colors & 15) + 1;
 		ent->v.netname = PR_SetEngineString (host_client->name);
+		ED_UpdateIndex (ent);
 
 		// copy spawn parms out of the client_t
 		for (i = 0; i < NUM_BASIC_SPAWN_PARMS; i++)
@@ -2449,6 +2452,7 @@ static void Host_Viewmodel_f (void)
 	e->v.modelindex = m ? SV_Precache_Model (m->name) : 0;
 	e->v.model = PR_SetEngineString (sv.model_precache[(int)e->v.modelindex]);
 	e->v.frame = 0;
+	ED_UpdateIndex (e);
 	PR_SwitchQCVM (NULL);
 }
 
@@ -2655,6 +2659,7 @@ void Host_Send_Ap_Item (const char *classname, int spawnflags)
 	ent = ED_Alloc ();
 	ent->v.classname = PR_SetEngineString (classname);
 	ent->v.spawnflags = spawnflags;
+	ED_UpdateIndex (ent);
 
 	func = ED_FindFunction (va ("spawnfunc_%s", PR_GetString (ent->v.classname)));
 	if (!func)
@@ -2732,4 +2737,5 @@ void Host_InitCommands (void)
 	Cmd_AddCommand ("viewprev", Host_Viewprev_f);
 
 	Cmd_AddCommand ("mcache", Mod_Print);
+	Cmd_AddCommand ("memstats", Mem_Stats_f);
 }
@@ -58,6 +58,66 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define THREAD_STACK_RESERVATION (128ll * 1024ll)
 #define MAX_STACK_ALLOC_SIZE	 (512ll * 1024ll)
+// Keeps the 16 byte alignment of the underlying allocator
+#define MEM_HEADER_SIZE			16
+#define LEVEL_CHUNK_HEADER_SIZE 32
+#define LEVEL_CHUNK_SIZE		(4 * 1024 * 1024)
+// Allocations bigger than this get a chunk of their own
+#define LEVEL_MAX_SHARED_SIZE (LEVEL_CHUNK_SIZE / 4)
+
+#define MEM_FLAG_LEVEL 1
+
+typedef struct
+{
+	size_t	 size;
+	memtag_t tag;
+	uint32_t flags;
+} mem_header_t;
+
+COMPILE_TIME_ASSERT (mem_header, sizeof (mem_header_t) <= MEM_HEADER_SIZE);
+
+typedef struct level_chunk_s
+{
+	struct level_chunk_s *next;
+	size_t				  size;
+	size_t				  used;
+} level_chunk_t;
+
+COMPILE_TIME_ASSERT (level_chunk, sizeof (level_chunk_t) <= LEVEL_CHUNK_HEADER_SIZE);
+
+// Everything except abandoned_bytes is protected by mutex
+typedef struct
+{
+	SDL_mutex	   *mutex;
+	level_chunk_t  *chunks; // Chunk that is currently being filled comes first
+	size_t			committed;
+	size_t			used;
+	uint64_t		num_allocations;
+	uint64_t		tag_bytes[NUM_MEMTAGS];
+	uint64_t		tag_allocations[NUM_MEMTAGS];
+	atomic_uint64_t abandoned_bytes; // Freed or reallocated before the level ended
+	uint32_t		num_releases;
+	size_t			peak_committed;
+	size_t			last_release_committed;
+	uint64_t		last_release_allocations;
+	double			last_release_ms;
+} level_region_t;
+
+typedef struct
+{
+	atomic_uint64_t current;
+	atomic_uint64_t peak;
+	atomic_uint64_t num_allocations;
+	atomic_uint64_t num_live;
+	uint64_t		padding[4]; // Pad to 64 byte cache line size
+} mem_tag_stats_t;
+
+static const char *const mem_tag_names[NUM_MEMTAGS] = {
+	"default", "temp", "filesystem", "model", "texture", "sound", "progs", "particles", "tasks",
+};
+
+static mem_tag_stats_t mem_tag_stats[NUM_MEMTAGS];
+static level_region_t  level_region;
 
 size_t THREAD_LOCAL thread_stack_alloc_size = 0;
 size_t				max_thread_stack_alloc_size = 0;
@@ -69,6 +129,7 @@ Mem_Init
 */
 void Mem_Init ()
 {
+	level_region.mutex = SDL_CreateMutex ();
 #ifdef _WIN32
 	max_thread_stack_alloc_size = MAX_STACK_ALLOC_SIZE;
 #else /* unix: */
@@ -85,52 +146,137 @@ void Mem_Init ()
 
 /*
 ====================
-Mem_Alloc
+Mem_RawAlloc
 ====================
 */
-void *Mem_Alloc (const size_t size)
+static inline void *Mem_RawAlloc (const size_t size, const qboolean zeroed)
 {
 #if defined(USE_MI_MALLOC)
-	return mi_calloc (1, size);
+	return zeroed ? mi_calloc (1, size) : mi_malloc (size);
 #elif defined(USE_SDL_MALLOC)
-	return SDL_calloc (1, size);
+	return zeroed ? SDL_calloc (1, size) : SDL_malloc (size);
 #elif defined(USE_CRT_MALLOC)
-	return calloc (1, size);
+	return zeroed ? calloc (1, size) : malloc (size);
 #endif
 }
 
 /*
 ====================
-Mem_AllocNonZero
+Mem_RawRealloc
 ====================
 */
-void *Mem_AllocNonZero (const size_t size)
+static inline void *Mem_RawRealloc (void *ptr, const size_t size)
 {
 #if defined(USE_MI_MALLOC)
-	return mi_malloc (size);
+	return mi_realloc (ptr, size);
 #elif defined(USE_SDL_MALLOC)
-	return SDL_malloc (size);
+	return SDL_realloc (ptr, size);
 #elif defined(USE_CRT_MALLOC)
-	return malloc (size);
+	return realloc (ptr, size);
 #endif
 }
 
 /*
 ====================
-Mem_Realloc
+Mem_RawFree
 ====================
 */
-void *Mem_Realloc (void *ptr, const size_t size)
+static inline void Mem_RawFree (void *ptr)
 {
 #if defined(USE_MI_MALLOC)
-	return mi_realloc (ptr, size);
+	mi_free (ptr);
 #elif defined(USE_SDL_MALLOC)
-	return SDL_realloc (ptr, size);
+	SDL_free (ptr);
 #elif defined(USE_CRT_MALLOC)
-	return realloc (ptr, size);
+	free (ptr);
 #endif
 }
 
+/*
+====================
+Mem_AddUsage
+====================
+*/
+static void Mem_AddUsage (const memtag_t tag, const size_t size)
+{
+	mem_tag_stats_t *stats = &mem_tag_stats[tag];
+	const uint64_t	 current = Atomic_AddUInt64 (&stats->current, size) + size;
+	uint64_t		 peak = Atomic_LoadUInt64 (&stats->peak);
+	while ((current > peak) && !Atomic_CompareExchangeUInt64 (&stats->peak, &peak, current))
+		;
+}
+
+/*
+====================
+Mem_AllocHeader
+====================
+*/
+static void *Mem_AllocHeader (const size_t size, const memtag_t tag, const qboolean zeroed)
+{
+	assert (tag < NUM_MEMTAGS);
+	mem_header_t *header = (mem_header_t *)Mem_RawAlloc (MEM_HEADER_SIZE + size, zeroed);
+	if (!header)
+		return NULL;
+	header->size = size;
+	header->tag = tag;
+	header->flags = 0;
+	Mem_AddUsage (tag, size);
+	Atomic_IncrementUInt64 (&mem_tag_stats[tag].num_allocations);
+	Atomic_IncrementUInt64 (&mem_tag_stats[tag].num_live);
+	return (byte *)header + MEM_HEADER_SIZE;
+}
+
+/*
+====================
+Mem_AllocTagged
+====================
+*/
+void *Mem_AllocTagged (const size_t size, const memtag_t tag)
+{
+	return Mem_AllocHeader (size, tag, true);
+}
+
+/*
+====================
+Mem_AllocNonZeroTagged
+====================
+*/
+void *Mem_AllocNonZeroTagged (const size_t size, const memtag_t tag)
+{
+	return Mem_AllocHeader (size, tag, false);
+}
+
+/*
+====================
+Mem_Realloc
+====================
+*/
+void *Mem_Realloc (void *ptr, const size_t size)
+{
+	if (!ptr)
+		return Mem_AllocHeader (size, MEMTAG_DEFAULT, false);
+
+	mem_header_t  *header = (mem_header_t *)((byte *)ptr - MEM_HEADER_SIZE);
+	const size_t   old_size = header->size;
+	const memtag_t tag = header->tag;
+	if (header->flags & MEM_FLAG_LEVEL)
+	{
+		void *new_ptr = Mem_LevelAlloc (size, tag);
+		memcpy (new_ptr, ptr, q_min (size, old_size));
+		Atomic_AddUInt64 (&level_region.abandoned_bytes, old_size);
+		return new_ptr;
+	}
+	header = (mem_header_t *)Mem_RawRealloc (header, MEM_HEADER_SIZE + size);
+	if (!header)
+		return NULL;
+	header->size = size;
+	if (size > old_size)
+		Mem_AddUsage (tag, size - old_size);
+	else
+		Atomic_SubUInt64 (&mem_tag_stats[tag].current, old_size - size);
+	return (byte *)header + MEM_HEADER_SIZE;
+}
+
 /*
 ====================
 Mem_Free
@@ -138,11 +284,177 @@ Mem_Free
 */
 void Mem_Free (const void *ptr)
 {
-#if defined(USE_MI_MALLOC)
-	mi_free ((void *)ptr);
-#elif defined(USE_SDL_MALLOC)
-	SDL_free ((void *)ptr);
-#elif defined(USE_CRT_MALLOC)
-	free ((void *)ptr);
-#endif
+	if (!ptr)
+		return;
+	mem_header_t *header = (mem_header_t *)((byte *)ptr - MEM_HEADER_SIZE);
+	if (header->flags & MEM_FLAG_LEVEL)
+	{
+		// Released with the rest of the level in Mem_LevelFreeAll
+		Atomic_AddUInt64 (&level_region.abandoned_bytes, header->size);
+		return;
+	}
+	Atomic_SubUInt64 (&mem_tag_stats[header->tag].current, header->size);
+	Atomic_SubUInt64 (&mem_tag_stats[header->tag].num_live, 1);
+	Mem_RawFree (header);
+}
+
+/*
+====================
+Mem_IsLevelAlloc
+====================
+*/
+qboolean Mem_IsLevelAlloc (const void *ptr)
+{
+	return ptr && (((const mem_header_t *)((const byte *)ptr - MEM_HEADER_SIZE))->flags & MEM_FLAG_LEVEL);
+}
+
+/*
+====================
+Mem_LevelAlloc
+
+Zero initialized memory that lives until the next Mem_LevelFreeAll.
+Mem_Free on it is a no-op, Mem_Realloc moves it to a new level allocation.
+====================
+*/
+void *Mem_LevelAlloc (const size_t size, const memtag_t tag)
+{
+	assert (tag < NUM_MEMTAGS);
+	const size_t aligned_size = (MEM_HEADER_SIZE + size + MEM_HEADER_SIZE - 1) & ~(size_t)(MEM_HEADER_SIZE - 1);
+
+	SDL_LockMutex (level_region.mutex);
+	level_chunk_t *chunk = level_region.chunks;
+	if (!chunk || (aligned_size > (chunk->size - chunk->used)))
+	{
+		const size_t chunk_size = (aligned_size > LEVEL_MAX_SHARED_SIZE) ? aligned_size : LEVEL_CHUNK_SIZE;
+		level_chunk_t *new_chunk = (level_chunk_t *)Mem_RawAlloc (LEVEL_CHUNK_HEADER_SIZE + chunk_size, true);
+		if (!new_chunk)
+			Sys_Error ("Mem_LevelAlloc: failed to allocate %" SDL_PRIu64 " bytes", (uint64_t)chunk_size);
+		new_chunk->size = chunk_size;
+		new_chunk->used = 0;
+		// Keep filling the current chunk if this one is exclusive to a big allocation
+		if (chunk && (chunk_size != LEVEL_CHUNK_SIZE))
+		{
+			new_chunk->next = chunk->next;
+			chunk->next = new_chunk;
+		}
+		else
+		{
+			new_chunk->next = chunk;
+			level_region.chunks = new_chunk;
+		}
+		level_region.committed += LEVEL_CHUNK_HEADER_SIZE + chunk_size;
+		level_region.peak_committed = q_max (level_region.peak_committed, level_region.committed);
+		chunk = new_chunk;
+	}
+
+	mem_header_t *header = (mem_header_t *)((byte *)chunk + LEVEL_CHUNK_HEADER_SIZE + chunk->used);
+	chunk->used += aligned_size;
+	level_region.used += aligned_size;
+	level_region.num_allocations += 1;
+	level_region.tag_bytes[tag] += size;
+	level_region.tag_allocations[tag] += 1;
+	SDL_UnlockMutex (level_region.mutex);
+
+	header->size = size;
+	header->tag = tag;
+	header->flags = MEM_FLAG_LEVEL;
+	Mem_AddUsage (tag, size);
+	Atomic_IncrementUInt64 (&mem_tag_stats[tag].num_allocations);
+	Atomic_IncrementUInt64 (&mem_tag_stats[tag].num_live);
+	return (byte *)header + MEM_HEADER_SIZE;
+}
+
+/*
+====================
+Mem_LevelFreeAll
+
+Releases every level allocation at once, cost only depends on the number of chunks
+====================
+*/
+void Mem_LevelFreeAll (void)
+{
+	const uint64_t start = SDL_GetPerformanceCounter ();
+
+	SDL_LockMutex (level_region.mutex);
+	level_chunk_t *chunk = level_region.chunks;
+	while (chunk)
+	{
+		level_chunk_t *next = chunk->next;
+		Mem_RawFree (chunk);
+		chunk = next;
+	}
+	for (int i = 0; i < NUM_MEMTAGS; ++i)
+	{
+		Atomic_SubUInt64 (&mem_tag_stats[i].current, level_region.tag_bytes[i]);
+		Atomic_SubUInt64 (&mem_tag_stats[i].num_live, level_region.tag_allocations[i]);
+		level_region.tag_bytes[i] = 0;
+		level_region.tag_allocations[i] = 0;
+	}
+	level_region.num_releases += 1;
+	level_region.last_release_committed = level_region.committed;
+	level_region.last_release_allocations = level_region.num_allocations;
+	level_region.chunks = NULL;
+	level_region.committed = 0;
+	level_region.used = 0;
+	level_region.num_allocations = 0;
+	Atomic_StoreUInt64 (&level_region.abandoned_bytes, 0);
+	level_region.last_release_ms = (SDL_GetPerformanceCounter () - start) * 1000.0 / (double)SDL_GetPerformanceFrequency ();
+	SDL_UnlockMutex (level_region.mutex);
+
+	Con_DPrintf (
+		"Released %" SDL_PRIu64 " level allocations (%.1f KB) in %.3f ms\n", level_region.last_release_allocations,
+		level_region.last_release_committed / 1024.0, level_region.last_release_ms);
+}
+
+/*
+====================
+Mem_Stats_f
+====================
+*/
+void Mem_Stats_f (void)
+{
+	if ((Cmd_Argc () >= 2) && !strcmp (Cmd_Argv (1), "reset"))
+	{
+		// Peaks restart from the current usage
+		for (int i = 0; i < NUM_MEMTAGS; ++i)
+		{
+			Atomic_StoreUInt64 (&mem_tag_stats[i].peak, Atomic_LoadUInt64 (&mem_tag_stats[i].current));
+			Atomic_StoreUInt64 (&mem_tag_stats[i].num_allocations, 0);
+		}
+		return;
+	}
+
+	uint64_t total_current = 0;
+	uint64_t total_live = 0;
+	Con_Printf ("%-10s %12s %12s %10s %12s\n", "tag", "current KB", "peak KB", "live", "allocations");
+	for (int i = 0; i < NUM_MEMTAGS; ++i)
+	{
+		const uint64_t current = Atomic_LoadUInt64 (&mem_tag_stats[i].current);
+		const uint64_t num_live = Atomic_LoadUInt64 (&mem_tag_stats[i].num_live);
+		Con_Printf (
+			"%-10s %12.1f %12.1f %10" SDL_PRIu64 " %12" SDL_PRIu64 "\n", mem_tag_names[i], current / 1024.0,
+			Atomic_LoadUInt64 (&mem_tag_stats[i].peak) / 1024.0, num_live, Atomic_LoadUInt64 (&mem_tag_stats[i].num_allocations));
+		total_current += current;
+		total_live += num_live;
+	}
+	Con_Printf ("%-10s %12.1f %12s %10" SDL_PRIu64 "\n", "total", total_current / 1024.0, "", total_live);
+
+	SDL_LockMutex (level_region.mutex);
+	const size_t   committed = level_region.committed;
+	const size_t   used = level_region.used;
+	const uint64_t abandoned = Atomic_LoadUInt64 (&level_region.abandoned_bytes);
+	int			   num_chunks = 0;
+	for (level_chunk_t *chunk = level_region.chunks; chunk; chunk = chunk->next)
+		++num_chunks;
+	Con_Printf (
+		"level region: %.1f KB in %" SDL_PRIu64 " allocations, %d chunks, %.1f KB committed (peak %.1f KB)\n", used / 1024.0,
+		level_region.num_allocations, num_chunks, committed / 1024.0, level_region.peak_committed / 1024.0);
+	// Unused chunk space plus allocations that were freed or moved before the end of the level
+	Con_Printf (
+		"level fragmentation: %.1f KB unused, %.1f KB abandoned (%.1f%%)\n", (committed - used) / 1024.0, abandoned / 1024.0,
+		(committed > 0) ? (100.0 * ((committed - used) + abandoned) / committed) : 0.0);
+	Con_Printf (
+		"level releases: %u, last one freed %" SDL_PRIu64 " allocations (%.1f KB) in %.3f ms\n", level_region.num_releases,
+		level_region.last_release_allocations, level_region.last_release_committed / 1024.0, level_region.last_release_ms);
+	SDL_UnlockMutex (level_region.mutex);
 }
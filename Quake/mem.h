@@ -26,11 +26,36 @@
 // Mem_Alloc will always return zero initialized memory
 // A lot of old code was assuming this and overhead is negligible
 
-void  Mem_Init ();
-void *Mem_Alloc (const size_t size);
-void *Mem_AllocNonZero (const size_t size);
-void *Mem_Realloc (void *ptr, const size_t size);
-void  Mem_Free (const void *ptr);
+// Allocations are accounted per tag, see memstats. Mem_Alloc uses MEMTAG_DEFAULT
+// and Mem_Realloc keeps the tag of the original allocation
+// Mem_LevelAlloc is for data that is only needed until the next map change,
+// all of it is released at once by Mem_LevelFreeAll in Host_ClearMemory
+typedef enum
+{
+	MEMTAG_DEFAULT,
+	MEMTAG_TEMP,
+	MEMTAG_FILESYSTEM,
+	MEMTAG_MODEL,
+	MEMTAG_TEXTURE,
+	MEMTAG_SOUND,
+	MEMTAG_PROGS,
+	MEMTAG_PARTICLES,
+	MEMTAG_TASKS,
+	NUM_MEMTAGS,
+} memtag_t;
+
+void	 Mem_Init ();
+void	*Mem_AllocTagged (const size_t size, const memtag_t tag);
+void	*Mem_AllocNonZeroTagged (const size_t size, const memtag_t tag);
+void	*Mem_Realloc (void *ptr, const size_t size);
+void	 Mem_Free (const void *ptr);
+void	*Mem_LevelAlloc (const size_t size, const memtag_t tag);
+void	 Mem_LevelFreeAll (void);
+qboolean Mem_IsLevelAlloc (const void *ptr);
+void	 Mem_Stats_f (void);
+
+#define Mem_Alloc(size)		   Mem_AllocTagged (size, MEMTAG_DEFAULT)
+#define Mem_AllocNonZero(size) Mem_AllocNonZeroTagged (size, MEMTAG_DEFAULT)
 
 #define SAFE_FREE(ptr)  \
 	do                  \
@@ -51,9 +76,9 @@ extern size_t			   max_thread_stack_alloc_size;
 		if ((thread_stack_alloc_size + temp_alloc_##var##_size) > max_thread_stack_alloc_size) \
 		{                                                                                      \
 			if (zeroed)                                                                        \
-				var = (type *)Mem_Alloc (temp_alloc_##var##_size);                             \
+				var = (type *)Mem_AllocTagged (temp_alloc_##var##_size, MEMTAG_TEMP);          \
 			else                                                                               \
-				var = (type *)Mem_AllocNonZero (temp_alloc_##var##_size);                      \
+				var = (type *)Mem_AllocNonZeroTagged (temp_alloc_##var##_size, MEMTAG_TEMP);   \
 			temp_alloc_##var##_on_heap = true;                                                 \
 		}                                                                                      \
 		else                                                                                   \
@@ -907,6 +907,15 @@ static void M_SelectLevel (const char *level)
 //=============================================================================
 /* [AP] LEVEL SELECT MENUS */
 
+// start reading the highlighted level if it can be played, called when the cursor moves but never from drawing
+static void M_PrefetchLevel (int ep, int cursor)
+{
+	ap_level_state_t *level_state = ap_get_level_state (ap_make_level_index (ep, cursor + 1));
+
+	if (level_state->unlocked)
+		SV_PrefetchMap (levels[episodes[ep].firstLevel + cursor].name);
+}
+
 static int m_ep1_select_cursor = 0;
 
 static void M_Menu_Ep1_Select_f (void)
@@ -917,6 +926,7 @@ static void M_Menu_Ep1_Select_f (void)
 	key_dest = key_menu;
 	m_state = m_ep1_select;
 	m_entersound = true;
+	M_PrefetchLevel (1, m_ep1_select_cursor);
 }
 
 static void M_Ep1_Select_Draw (cb_context_t *cbx)
@@ -952,12 +962,14 @@ static void M_Ep1_Select_Key (int key)
 		S_LocalSound ("misc/menu1.wav");
 		if (++m_ep1_select_cursor >= episodes[1].levels)
 			m_ep1_select_cursor = 0;
+		M_PrefetchLevel (1, m_ep1_select_cursor);
 		break;
 
 	case K_UPARROW:
 		S_LocalSound ("misc/menu1.wav");
 		if (--m_ep1_select_cursor < 0)
 			m_ep1_select_cursor = episodes[1].levels - 1;
+		M_PrefetchLevel (1, m_ep1_select_cursor);
 		break;
 
 	case K_MOUSE1:
@@ -980,6 +992,7 @@ static void M_Menu_Ep2_Select_f (void)
 	key_dest = key_menu;
 	m_state = m_ep2_select;
 	m_entersound = true;
+	M_PrefetchLevel (2, m_ep2_select_cursor);
 }
 
 static void M_Ep2_Select_Draw (cb_context_t *cbx)
@@ -1015,12 +1028,14 @@ static void M_Ep2_Select_Key (int key)
 		S_LocalSound ("misc/menu1.wav");
 		if (++m_ep2_select_cursor >= episodes[2].levels)
 			m_ep2_select_cursor = 0;
+		M_PrefetchLevel (2, m_ep2_select_cursor);
 		break;
 
 	case K_UPARROW:
 		S_LocalSound ("misc/menu1.wav");
 		if (--m_ep2_select_cursor < 0)
 			m_ep2_select_cursor = episodes[2].levels - 1;
+		M_PrefetchLevel (2, m_ep2_select_cursor);
 		break;
 
 	case K_MOUSE1:
@@ -1043,6 +1058,7 @@ static void M_Menu_Ep3_Select_f (void)
 	key_dest = key_menu;
 	m_state = m_ep3_select;
 	m_entersound = true;
+	M_PrefetchLevel (3, m_ep3_select_cursor);
 }
 
 static void M_Ep3_Select_Draw (cb_context_t *cbx)
@@ -1078,12 +1094,14 @@ static void M_Ep3_Select_Key (int key)
 		S_LocalSound ("misc/menu1.wav");
 		if (++m_ep3_select_cursor >= episodes[3].levels)
 			m_ep3_select_cursor = 0;
+		M_PrefetchLevel (3, m_ep3_select_cursor);
 		break;
 
 	case K_UPARROW:
 		S_LocalSound ("misc/menu1.wav");
 		if (--m_ep3_select_cursor < 0)
 			m_ep3_select_cursor = episodes[3].levels - 1;
+		M_PrefetchLevel (3, m_ep3_select_cursor);
 		break;
 
 	case K_MOUSE1:
@@ -1106,6 +1124,7 @@ static void M_Menu_Ep4_Select_f (void)
 	key_dest = key_menu;
 	m_state = m_ep4_select;
 	m_entersound = true;
+	M_PrefetchLevel (4, m_ep4_select_cursor);
 }
 
 static void M_Ep4_Select_Draw (cb_context_t *cbx)
@@ -1141,12 +1160,14 @@ static void M_Ep4_Select_Key (int key)
 		S_LocalSound ("misc/menu1.wav");
 		if (++m_ep4_select_cursor >= episodes[4].levels)
 			m_ep4_select_cursor = 0;
+		M_PrefetchLevel (4, m_ep4_select_cursor);
 		break;
 
 	case K_UPARROW:
 		S_LocalSound ("misc/menu1.wav");
 		if (--m_ep4_select_cursor < 0)
 			m_ep4_select_cursor = episodes[4].levels - 1;
+		M_PrefetchLevel (4, m_ep4_select_cursor);
 		break;
 
 	case K_MOUSE1:
@@ -2457,6 +2478,26 @@ void M_UpdateMouse (void)
 	}
 
 	scrollbar_size = 0;
+
+	// the level select cursors follow the mouse while drawing, so pick up where they are now.
+	// SV_PrefetchMap returns right away if that level is already being read
+	switch (m_state)
+	{
+	case m_ep1_select:
+		M_PrefetchLevel (1, m_ep1_select_cursor);
+		break;
+	case m_ep2_select:
+		M_PrefetchLevel (2, m_ep2_select_cursor);
+		break;
+	case m_ep3_select:
+		M_PrefetchLevel (3, m_ep3_select_cursor);
+		break;
+	case m_ep4_select:
+		M_PrefetchLevel (4, m_ep4_select_cursor);
+		break;
+	default:
+		break;
+	}
 }
 
 void M_Draw (cb_context_t *cbx)
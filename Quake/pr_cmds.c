@@ -984,6 +984,31 @@ static void PF_cvar_set (void)
 	Cvar_Set (var, val);
 }
 
+static qboolean PF_InRadius (edict_t *ent, const float *org, float rad)
+{
+	float d, lensq;
+
+	if (ent->free)
+		return false;
+	if (ent->v.solid == SOLID_NOT)
+		return false;
+
+	d = org[0] - (ent->v.origin[0] + (ent->v.mins[0] + ent->v.maxs[0]) * 0.5);
+	lensq = d * d;
+	if (lensq > rad)
+		return false;
+	d = org[1] - (ent->v.origin[1] + (ent->v.mins[1] + ent->v.maxs[1]) * 0.5);
+	lensq += d * d;
+	if (lensq > rad)
+		return false;
+	d = org[2] - (ent->v.origin[2] + (ent->v.mins[2] + ent->v.maxs[2]) * 0.5);
+	lensq += d * d;
+	if (lensq > rad)
+		return false;
+
+	return true;
+}
+
 /*
 =================
 PF_findradius
@@ -998,7 +1023,7 @@ static void PF_findradius (void)
 	edict_t *ent, *chain;
 	float	 rad;
 	float	*org;
-	int		 i;
+	int		 i, count, *candidates;
 
 	chain = (edict_t *)qcvm->edicts;
 
@@ -1006,30 +1031,29 @@ static void PF_findradius (void)
 	rad = G_FLOAT (OFS_PARM1);
 	rad *= rad;
 
-	ent = NEXT_EDICT (qcvm->edicts);
-	for (i = 1; i < qcvm->num_edicts; i++, ent = NEXT_EDICT (ent))
+	// the index hands out candidates in edict order, so the chain comes out the same
+	count = ED_FindRadius (org, rad, &candidates);
+	if (count < 0)
 	{
-		float d, lensq;
-		if (ent->free)
-			continue;
-		if (ent->v.solid == SOLID_NOT)
-			continue;
-
-		d = org[0] - (ent->v.origin[0] + (ent->v.mins[0] + ent->v.maxs[0]) * 0.5);
-		lensq = d * d;
-		if (lensq > rad)
-			continue;
-		d = org[1] - (ent->v.origin[1] + (ent->v.mins[1] + ent->v.maxs[1]) * 0.5);
-		lensq += d * d;
-		if (lensq > rad)
-			continue;
-		d = org[2] - (ent->v.origin[2] + (ent->v.mins[2] + ent->v.maxs[2]) * 0.5);
-		lensq += d * d;
-		if (lensq > rad)
-			continue;
-
-		ent->v.chain = EDICT_TO_PROG (chain);
-		chain = ent;
+		ent = NEXT_EDICT (qcvm->edicts);
+		for (i = 1; i < qcvm->num_edicts; i++, ent = NEXT_EDICT (ent))
+		{
+			if (!PF_InRadius (ent, org, rad))
+				continue;
+			ent->v.chain = EDICT_TO_PROG (chain);
+			chain = ent;
+		}
+	}
+	else
+	{
+		for (i = 0; i < count; i++)
+		{
+			ent = EDICT_NUM (candidates[i]);
+			if (!PF_InRadius (ent, org, rad))
+				continue;
+			ent->v.chain = EDICT_TO_PROG (chain);
+			chain = ent;
+		}
 	}
 
 	RETURN_EDICT (chain);
@@ -1097,8 +1121,7 @@ static void PF_Find (void)
 {
 	int			e;
 	int			f;
-	const char *s, *t;
-	edict_t	   *ed;
+	const char *s;
 
 	e = G_EDICTNUM (OFS_PARM0);
 	f = G_INT (OFS_PARM1);
@@ -1106,22 +1129,8 @@ static void PF_Find (void)
 	if (!s)
 		PR_RunError ("PF_Find: bad search string");
 
-	for (e++; e < qcvm->num_edicts; e++)
-	{
-		ed = EDICT_NUM (e);
-		if (ed->free)
-			continue;
-		t = E_STRING (ed, f);
-		if (!t)
-			continue;
-		if (!strcmp (t, s))
-		{
-			RETURN_EDICT (ed);
-			return;
-		}
-	}
-
-	RETURN_EDICT (qcvm->edicts);
+	// world if nothing matches
+	RETURN_EDICT (EDICT_NUM (ED_FindString (e, f, s)));
 }
 
 static void PR_CheckEmptyString (const char *s)
@@ -1327,6 +1336,7 @@ static void PF_droptofloor (void)
 		SV_LinkEdict (ent, false);
 		ent->v.flags = (int)ent->v.flags | FL_ONGROUND;
 		ent->v.groundentity = EDICT_TO_PROG (trace.ent);
+		ED_UpdateIndex (ent);
 		G_FLOAT (OFS_RETURN) = 1;
 	}
 }
@@ -1893,7 +1903,7 @@ static void PF_cl_makestatic (void)
 	{
 		int		   ec = 64;
 		entity_t **newstatics = Mem_Realloc (cl.static_entities, sizeof (*newstatics) * (cl.max_static_entities + ec));
-		entity_t  *newents = Mem_Alloc (sizeof (*newents) * ec);
+		entity_t  *newents = Mem_AllocTagged (sizeof (*newents) * ec, MEMTAG_PROGS);
 		if (!newstatics || !newents)
 			Host_Error ("Too many static entities");
 		cl.static_entities = newstatics;
@@ -2168,3 +2178,24 @@ const builtin_t pr_csqcbuiltins[] = {
 };
 // clang-format on
 const int pr_csqcnumbuiltins = countof (pr_csqcbuiltins);
+
+/*
+=================
+PR_IsPureBuiltin
+
+sv_parallelthinks only lets its sandboxed vms call builtins from this list, or PR_IsPureExtBuiltin's.
+Nothing here may touch edicts, links, strings, messages or the random state.
+=================
+*/
+qboolean PR_IsPureBuiltin (builtin_t func)
+{
+	static const builtin_t pure[] = {
+		PF_makevectors, PF_normalize, PF_vlen, PF_vectoyaw, PF_vectoangles, PF_fabs, PF_rint, PF_floor, PF_ceil, PF_pointcontents,
+	};
+	size_t i;
+
+	for (i = 0; i < countof (pure); i++)
+		if (func == pure[i])
+			return true;
+	return PR_IsPureExtBuiltin (func);
+}
@@ -79,6 +79,7 @@ edict_t *ED_Alloc (void)
 		if (e->next_free)
 			e->next_free->prev_free = NULL;
 		e->next_free = NULL;
+		ED_UpdateIndex (e);
 		return e;
 	}
 
@@ -87,6 +88,7 @@ edict_t *ED_Alloc (void)
 
 	e = EDICT_NUM (qcvm->num_edicts++);
 	e->baseline = nullentitystate;
+	ED_UpdateIndex (e);
 	return e;
 }
 
@@ -138,6 +140,609 @@ void ED_Free (edict_t *ed)
 		qcvm->free_edicts_tail->next_free = ed;
 		qcvm->free_edicts_tail = ed;
 	}
+
+	ED_UpdateIndex (ed);
+}
+
+/*
+===============================================================================
+
+ENTITY SEARCH INDEX
+
+find, findchain and findradius used to test every edict. The server qcvm keeps
+classname and targetname hashed by content and the findradius centers of the
+edicts bucketed in a grid of 256 unit columns. Every list is sorted by edict
+number, so searches visit their candidates in the order the full scan would
+and return the same edicts.
+
+The engine updates an edict's slots wherever it changes these fields, most
+moves go through SV_LinkEdict. QC writes go through OP_ADDRESS, which doesn't
+see the value, so the edict leaves the index and sits on a pending list that
+every search tests until the outermost PR_ExecuteProgram settles it. Strings
+other than progs strings and live zoned strings can change under the index,
+they and centers that aren't finite go on lists every search tests as well.
+
+===============================================================================
+*/
+
+#define ED_NOTINDEXED	 -1
+#define ED_ALWAYS		 -2 // on the list every search tests
+#define ED_STRINGBUCKETS 1024
+#define ED_GRIDBUCKETS	 4096
+#define ED_GRIDSIZE		 256.0
+#define ED_GRIDMAXCELLS	 1024 // findradius scans every edict beyond that
+#define ED_GRIDLIMIT	 1e9  // centers further out are always tested
+
+cvar_t pr_findindex = {"pr_findindex", "1", CVAR_NONE};
+
+typedef struct
+{
+	int		 strings[2]; // bucket, ED_ALWAYS or ED_NOTINDEXED, one per ed_stringfields entry
+	int		 cell;		 // grid bucket, ED_ALWAYS or ED_NOTINDEXED
+	int		 cellx, celly;
+	qboolean pending;
+} edindexent_t;
+
+struct edindex_s
+{
+	int			  max_edicts;
+	edindexent_t *ents;
+	int			 *strings[2][ED_STRINGBUCKETS]; // VECs of edict numbers, ascending
+	int			 *stringsalways[2];
+	int			 *grid[ED_GRIDBUCKETS];
+	int			 *gridalways;
+	int			 *pending; // in the order they were addressed
+	int			 *candidates;
+	unsigned int  gridstamp[ED_GRIDBUCKETS];
+	unsigned int  stamp;
+};
+
+static const int		  ed_stringfields[2] = {ED_FIELD (classname), ED_FIELD (targetname)};
+static const edindexent_t ed_notindexed = {{ED_NOTINDEXED, ED_NOTINDEXED}, ED_NOTINDEXED, 0, 0, false};
+
+static int ED_LowerBound (const int *list, int e)
+{
+	int lo = 0, hi = VEC_SIZE (list), mid;
+
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (list[mid] < e)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+static void ED_ListInsert (int **list, int e)
+{
+	int i = ED_LowerBound (*list, e);
+	int count = VEC_SIZE (*list);
+
+	VEC_PUSH (*list, e);
+	memmove (*list + i + 1, *list + i, (count - i) * sizeof (int));
+	(*list)[i] = e;
+}
+
+static void ED_ListRemove (int **list, int e)
+{
+	int i = ED_LowerBound (*list, e);
+	int count = VEC_SIZE (*list);
+
+	if (i == count || (*list)[i] != e)
+		return;
+	memmove (*list + i, *list + i + 1, (count - i - 1) * sizeof (int));
+	VEC_HEADER (*list).size--;
+}
+
+static int **ED_StringList (struct edindex_s *index, int field, int bucket)
+{
+	return (bucket == ED_ALWAYS) ? &index->stringsalways[field] : &index->strings[field][bucket];
+}
+
+static int **ED_GridList (struct edindex_s *index, int bucket)
+{
+	return (bucket == ED_ALWAYS) ? &index->gridalways : &index->grid[bucket];
+}
+
+static int ED_GridBucket (int x, int y)
+{
+	return HashCombine ((uint32_t)x, (uint32_t)y) & (ED_GRIDBUCKETS - 1);
+}
+
+static int ED_StringBucket (const char *s)
+{
+	return HashStr (&s) & (ED_STRINGBUCKETS - 1);
+}
+
+/*
+=============
+ED_StableString
+
+Progs strings and live zoned strings keep their text for as long as their number is in use
+=============
+*/
+static qboolean ED_StableString (int num)
+{
+	if (num >= 0 && num < qcvm->stringssize)
+		return true;
+	num = -1 - num;
+	return num >= 0 && num < qcvm->numknownstrings && qcvm->knownstrings[num] && qcvm->knownstringsowned[num];
+}
+
+/*
+=============
+ED_IndexTarget
+
+The slots edict e belongs in, the center is computed exactly like PF_findradius does
+=============
+*/
+static void ED_IndexTarget (int e, edindexent_t *target)
+{
+	edict_t *ed = EDICT_NUM (e);
+	double	 center[3];
+	int		 i, num;
+
+	*target = ed_notindexed;
+	if (e <= 0 || e >= qcvm->num_edicts || ed->free)
+		return;
+
+	for (i = 0; i < 2; i++)
+	{
+		num = ((int *)&ed->v)[ed_stringfields[i]];
+		target->strings[i] = ED_StableString (num) ? ED_StringBucket (PR_GetString (num)) : ED_ALWAYS;
+	}
+
+	for (i = 0; i < 3; i++)
+		center[i] = ed->v.origin[i] + (ed->v.mins[i] + ed->v.maxs[i]) * 0.5;
+	if (!(fabs (center[0]) < ED_GRIDLIMIT && fabs (center[1]) < ED_GRIDLIMIT && fabs (center[2]) < ED_GRIDLIMIT))
+	{
+		target->cell = ED_ALWAYS;
+		return;
+	}
+	target->cellx = (int)floor (center[0] / ED_GRIDSIZE);
+	target->celly = (int)floor (center[1] / ED_GRIDSIZE);
+	target->cell = ED_GridBucket (target->cellx, target->celly);
+}
+
+/*
+=============
+ED_IndexPlace
+
+Moves edict e to the target slots, lists are only touched where a slot changes
+=============
+*/
+static void ED_IndexPlace (struct edindex_s *index, int e, const edindexent_t *target)
+{
+	edindexent_t *ent = &index->ents[e];
+	int			  i;
+
+	for (i = 0; i < 2; i++)
+	{
+		if (ent->strings[i] == target->strings[i])
+			continue;
+		if (ent->strings[i] != ED_NOTINDEXED)
+			ED_ListRemove (ED_StringList (index, i, ent->strings[i]), e);
+		if (target->strings[i] != ED_NOTINDEXED)
+			ED_ListInsert (ED_StringList (index, i, target->strings[i]), e);
+		ent->strings[i] = target->strings[i];
+	}
+
+	if (ent->cell != target->cell)
+	{
+		if (ent->cell != ED_NOTINDEXED)
+			ED_ListRemove (ED_GridList (index, ent->cell), e);
+		if (target->cell != ED_NOTINDEXED)
+			ED_ListInsert (ED_GridList (index, target->cell), e);
+		ent->cell = target->cell;
+	}
+	ent->cellx = target->cellx;
+	ent->celly = target->celly;
+}
+
+static int ED_IndexNum (struct edindex_s *index, edict_t *ed)
+{
+	ptrdiff_t ofs = (byte *)ed - (byte *)qcvm->edicts;
+
+	if (ofs <= 0 || ofs % qcvm->edict_size || ofs / qcvm->edict_size >= index->max_edicts)
+		return -1;
+	return (int)(ofs / qcvm->edict_size);
+}
+
+/*
+=============
+ED_CheckIndex
+
+pr_findindex 2 runs this before every search
+=============
+*/
+static void ED_CheckIndex (struct edindex_s *index)
+{
+	edindexent_t  target;
+	edindexent_t *ent;
+	int			  e, i;
+
+	for (e = 1; e < index->max_edicts; e++)
+	{
+		ent = &index->ents[e];
+		if (ent->pending)
+			continue;
+		ED_IndexTarget (e, &target);
+		// ED_StringReleased leaves edicts on the always lists, that's stale but safe
+		for (i = 0; i < 2; i++)
+			if (ent->strings[i] == ED_ALWAYS && target.strings[i] != ED_NOTINDEXED)
+				target.strings[i] = ED_ALWAYS;
+		if (memcmp (&target.strings, &ent->strings, sizeof (target.strings)) || target.cell != ent->cell ||
+			(target.cell >= 0 && (target.cellx != ent->cellx || target.celly != ent->celly)))
+		{
+			Con_Warning ("ED_CheckIndex: edict %i is stale\n", e);
+			ED_IndexPlace (index, e, &target);
+		}
+	}
+}
+
+void ED_ResetIndex (void)
+{
+	struct edindex_s *index = qcvm->findindex;
+	int				  i, j;
+
+	ED_ResetHot ();
+	if (!index)
+		return;
+	for (i = 0; i < 2; i++)
+	{
+		for (j = 0; j < ED_STRINGBUCKETS; j++)
+			VEC_FREE (index->strings[i][j]);
+		VEC_FREE (index->stringsalways[i]);
+	}
+	for (j = 0; j < ED_GRIDBUCKETS; j++)
+		VEC_FREE (index->grid[j]);
+	VEC_FREE (index->gridalways);
+	VEC_FREE (index->pending);
+	VEC_FREE (index->candidates);
+	Mem_Free (index->ents);
+	Mem_Free (index);
+	qcvm->findindex = NULL;
+}
+
+static struct edindex_s *ED_GetIndex (void)
+{
+	if (!qcvm->findindex)
+		return NULL;
+	if (!pr_findindex.value || qcvm->findindex->max_edicts != qcvm->max_edicts)
+	{
+		ED_ResetIndex ();
+		return NULL;
+	}
+	if (pr_findindex.value >= 2)
+		ED_CheckIndex (qcvm->findindex);
+	return qcvm->findindex;
+}
+
+/*
+=============
+ED_SettleIndex
+
+Called by the outermost PR_ExecuteProgram, builds the server's index and places the pending edicts
+=============
+*/
+void ED_SettleIndex (void)
+{
+	struct edindex_s *index = ED_GetIndex ();
+	edindexent_t	  target;
+	int				  i, e;
+
+	if (!index)
+	{
+		if (qcvm != &sv.qcvm || !pr_findindex.value || !qcvm->edicts)
+			return;
+		index = (struct edindex_s *)Mem_AllocTagged (sizeof (*index), MEMTAG_PROGS);
+		index->max_edicts = qcvm->max_edicts;
+		index->ents = (edindexent_t *)Mem_AllocTagged (index->max_edicts * sizeof (edindexent_t), MEMTAG_PROGS);
+		for (e = 0; e < index->max_edicts; e++)
+			index->ents[e] = ed_notindexed;
+		for (e = 1; e < qcvm->num_edicts; e++)
+		{
+			ED_IndexTarget (e, &target);
+			ED_IndexPlace (index, e, &target);
+		}
+		qcvm->findindex = index;
+		return;
+	}
+
+	for (i = 0; i < VEC_SIZE (index->pending); i++)
+	{
+		e = index->pending[i];
+		index->ents[e].pending = false;
+		ED_IndexTarget (e, &target);
+		ED_IndexPlace (index, e, &target);
+	}
+	VEC_CLEAR (index->pending);
+}
+
+/*
+=============
+ED_UpdateIndex
+
+The engine calls this after it changes an indexed or mirrored field or frees or allocates the edict
+=============
+*/
+void ED_UpdateIndex (edict_t *ed)
+{
+	struct edindex_s *index = qcvm->findindex;
+	edindexent_t	  target;
+	int				  e;
+
+	ED_HotStale (ed);
+	if (!index || (e = ED_IndexNum (index, ed)) < 0 || index->ents[e].pending)
+		return;
+	ED_IndexTarget (e, &target);
+	ED_IndexPlace (index, e, &target);
+}
+
+/*
+=============
+ED_FieldAddressed
+
+OP_ADDRESS took a pointer to an indexed or mirrored field, searches test the edict until the
+index is settled and the sweeps don't trust its row until SV_Physics copies it again
+=============
+*/
+void ED_FieldAddressed (edict_t *ed, int field)
+{
+	struct edindex_s *index = qcvm->findindex;
+	int				  e;
+
+	if (ED_HotField (field))
+		ED_HotStale (ed);
+	if (!index || !ED_IndexedField (field) || (e = ED_IndexNum (index, ed)) < 0 || index->ents[e].pending)
+		return;
+	ED_IndexPlace (index, e, &ed_notindexed);
+	index->ents[e].pending = true;
+	VEC_PUSH (index->pending, e);
+}
+
+/*
+=============
+ED_StringReleased
+
+String num is about to be freed or reused, edicts still pointing at it can't stay in its bucket
+=============
+*/
+void ED_StringReleased (int num)
+{
+	struct edindex_s *index = qcvm->findindex;
+	edindexent_t	  target;
+	int				  i, j, e, bucket;
+
+	if (!index || !ED_StableString (num))
+		return;
+	bucket = ED_StringBucket (PR_GetString (num));
+	for (i = 0; i < 2; i++)
+	{
+		// backwards, so removals don't shift the entries still to be visited
+		for (j = VEC_SIZE (index->strings[i][bucket]) - 1; j >= 0; j--)
+		{
+			e = index->strings[i][bucket][j];
+			if (((int *)&EDICT_NUM (e)->v)[ed_stringfields[i]] != num)
+				continue;
+			target = index->ents[e];
+			target.strings[i] = ED_ALWAYS;
+			ED_IndexPlace (index, e, &target);
+		}
+	}
+}
+
+static qboolean ED_StringMatches (int e, int field, const char *s)
+{
+	edict_t *ed = EDICT_NUM (e);
+	return !ed->free && !strcmp (E_STRING (ed, field), s);
+}
+
+/*
+=============
+ED_FindString
+
+The first edict after start whose string field matches s, 0 if there is none
+=============
+*/
+int ED_FindString (int start, int field, const char *s)
+{
+	struct edindex_s *index = NULL;
+	int				  i, j, e, best, *list;
+
+	for (i = 0; i < 2; i++)
+		if (ed_stringfields[i] == field)
+		{
+			index = ED_GetIndex ();
+			break;
+		}
+
+	if (!index)
+	{
+		for (e = start + 1; e < qcvm->num_edicts; e++)
+			if (ED_StringMatches (e, field, s))
+				return e;
+		return 0;
+	}
+
+	best = qcvm->num_edicts;
+	list = index->strings[i][ED_StringBucket (s)];
+	for (j = ED_LowerBound (list, start + 1); j < VEC_SIZE (list); j++)
+		if (ED_StringMatches (list[j], field, s))
+		{
+			best = list[j];
+			break;
+		}
+	// in order, so strings that error out do so at the same edict as the scan would
+	list = index->stringsalways[i];
+	for (j = ED_LowerBound (list, start + 1); j < VEC_SIZE (list) && list[j] < best; j++)
+		if (ED_StringMatches (list[j], field, s))
+		{
+			best = list[j];
+			break;
+		}
+	for (j = 0; j < VEC_SIZE (index->pending); j++)
+	{
+		e = index->pending[j];
+		if (e > start && e < best && ED_StringMatches (e, field, s))
+			best = e;
+	}
+
+	return (best < qcvm->num_edicts) ? best : 0;
+}
+
+static int ED_CompareNums (const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+=============
+ED_FindRadius
+
+Collects the edicts whose findradius center may lie within sqrt (rad) of org, in ascending order.
+Returns -1 if every edict has to be tested.
+=============
+*/
+int ED_FindRadius (const float *org, float rad, int **candidates)
+{
+	struct edindex_s *index = ED_GetIndex ();
+	double			  r, x0, x1, y0, y1;
+	int				  x, y, i, e, bucket, *list;
+	edindexent_t	 *ent;
+
+	if (!index || !(rad >= 0.f) || !(fabs (org[0]) < ED_GRIDLIMIT && fabs (org[1]) < ED_GRIDLIMIT))
+		return -1;
+
+	// generous margin for the float rounding of the distance test
+	r = sqrt (rad) * (1.0 + 1e-6) + 1.0;
+	x0 = floor ((org[0] - r) / ED_GRIDSIZE);
+	x1 = floor ((org[0] + r) / ED_GRIDSIZE);
+	y0 = floor ((org[1] - r) / ED_GRIDSIZE);
+	y1 = floor ((org[1] + r) / ED_GRIDSIZE);
+	if (!((x1 - x0 + 1) * (y1 - y0 + 1) <= ED_GRIDMAXCELLS))
+		return -1;
+
+	if (!++index->stamp)
+	{
+		memset (index->gridstamp, 0, sizeof (index->gridstamp));
+		index->stamp = 1;
+	}
+	VEC_CLEAR (index->candidates);
+	for (x = (int)x0; x <= (int)x1; x++)
+		for (y = (int)y0; y <= (int)y1; y++)
+		{
+			// cells sharing a bucket are filtered by their coordinates
+			bucket = ED_GridBucket (x, y);
+			if (index->gridstamp[bucket] == index->stamp)
+				continue;
+			index->gridstamp[bucket] = index->stamp;
+			list = index->grid[bucket];
+			for (i = 0; i < VEC_SIZE (list); i++)
+			{
+				ent = &index->ents[list[i]];
+				if (ent->cellx >= x0 && ent->cellx <= x1 && ent->celly >= y0 && ent->celly <= y1)
+					VEC_PUSH (index->candidates, list[i]);
+			}
+		}
+	for (i = 0; i < VEC_SIZE (index->gridalways); i++)
+		VEC_PUSH (index->candidates, index->gridalways[i]);
+	for (i = 0; i < VEC_SIZE (index->pending); i++)
+	{
+		e = index->pending[i];
+		if (e < qcvm->num_edicts)
+			VEC_PUSH (index->candidates, e);
+	}
+
+	if (VEC_SIZE (index->candidates) > 1)
+		qsort (index->candidates, VEC_SIZE (index->candidates), sizeof (int), ED_CompareNums);
+	*candidates = index->candidates;
+	return VEC_SIZE (index->candidates);
+}
+
+/*
+===============================================================================
+
+HOT FIELD MIRROR
+
+SV_Physics and the entity sweeps load every edict to find the few that have
+something to do or send. With pr_edictmirror the server qcvm keeps the fields
+those skips are decided on in one array per field, so a sweep reads a few
+bytes per edict and only loads the edicts it doesn't skip. A row is copied by
+SV_Physics after it has processed the edict. Every engine change reported
+through ED_UpdateIndex and every QC write through OP_ADDRESS or OP_STATE marks
+the row stale, and stale rows are never trusted.
+
+===============================================================================
+*/
+
+cvar_t pr_edictmirror = {"pr_edictmirror", "0", CVAR_NONE};
+
+/*
+=============
+ED_HotStale
+
+The edict's row can't be trusted until SV_Physics copies it again
+=============
+*/
+void ED_HotStale (edict_t *ed)
+{
+	edhot_t	 *hot = qcvm->hot;
+	ptrdiff_t ofs;
+
+	if (!hot)
+		return;
+	ofs = (byte *)ed - (byte *)qcvm->edicts;
+	if (ofs >= 0 && ofs % qcvm->edict_size == 0 && ofs / qcvm->edict_size < hot->max_edicts)
+		hot->stale[ofs / qcvm->edict_size] = true;
+}
+
+void ED_ResetHot (void)
+{
+	edhot_t *hot = qcvm->hot;
+
+	if (!hot)
+		return;
+	Mem_Free (hot->nextthink);
+	Mem_Free (hot->modelindex);
+	Mem_Free (hot->still);
+	Mem_Free (hot->stale);
+	Mem_Free (hot->idle);
+	Mem_Free (hot);
+	qcvm->hot = NULL;
+}
+
+/*
+=============
+ED_GetHot
+
+The server's mirror, built with every row stale, or NULL if pr_edictmirror is 0
+=============
+*/
+edhot_t *ED_GetHot (void)
+{
+	edhot_t *hot = qcvm->hot;
+
+	if (hot && (!pr_edictmirror.value || hot->max_edicts != qcvm->max_edicts))
+	{
+		ED_ResetHot ();
+		hot = NULL;
+	}
+	if (hot || qcvm != &sv.qcvm || !pr_edictmirror.value || !qcvm->edicts)
+		return hot;
+
+	hot = (edhot_t *)Mem_AllocTagged (sizeof (*hot), MEMTAG_PROGS);
+	hot->max_edicts = qcvm->max_edicts;
+	hot->nextthink = (float *)Mem_AllocTagged (hot->max_edicts * sizeof (float), MEMTAG_PROGS);
+	hot->modelindex = (float *)Mem_AllocTagged (hot->max_edicts * sizeof (float), MEMTAG_PROGS);
+	hot->still = (byte *)Mem_AllocTagged (hot->max_edicts, MEMTAG_PROGS);
+	hot->stale = (byte *)Mem_AllocTagged (hot->max_edicts, MEMTAG_PROGS);
+	hot->idle = (byte *)Mem_AllocTagged (hot->max_edicts, MEMTAG_PROGS);
+	memset (hot->stale, true, hot->max_edicts);
+	qcvm->hot = hot;
+	return hot;
 }
 
 //===========================================================================
@@ -601,7 +1206,10 @@ static void ED_PrintEdict_f (void)
 					"Edict %u.%s==%s\n", i, PR_GetString (def->s_name),
 					PR_UglyValueString (def->type & ~DEF_SAVEGLOBAL, (eval_t *)((char *)&EDICT_NUM (i)->v + def->ofs * 4)));
 			else
+			{
 				ED_ParseEpair ((void *)&EDICT_NUM (i)->v, def, Cmd_Argv (3), false);
+				ED_UpdateIndex (EDICT_NUM (i));
+			}
 		}
 	}
 	PR_SwitchQCVM (NULL);
@@ -782,7 +1390,7 @@ static void ED_RezoneString (string_t *ref, const char *str)
 		// initialised with
 	}
 
-	buf = Mem_Alloc (len);
+	buf = Mem_AllocTagged (len, MEMTAG_PROGS);
 	memcpy (buf, str, len);
 	id = -1 - (*ref = PR_SetEngineString (buf));
 	// make sure its flagged as zoned so we can clean up properly after.
@@ -1030,6 +1638,7 @@ const char *ED_ParseEdict (const char *data, edict_t *ent)
 
 	if (!init)
 		ED_Free (ent);
+	ED_UpdateIndex (ent);
 
 	return data;
 }
@@ -1149,9 +1758,9 @@ void ED_LoadFromFile (const char *data)
 }
 
 #ifndef PR_SwitchQCVM
-qcvm_t		 *qcvm;
-globalvars_t *pr_global_struct;
-void		  PR_SwitchQCVM (qcvm_t *nvm)
+THREAD_LOCAL qcvm_t		  *qcvm;
+THREAD_LOCAL globalvars_t *pr_global_struct;
+void					   PR_SwitchQCVM (qcvm_t *nvm)
 {
 	if (qcvm && nvm)
 		Sys_Error ("PR_SwitchQCVM: A qcvm was already active");
@@ -1180,6 +1789,9 @@ void PR_ClearProgs (qcvm_t *vm)
 		Mem_Free ((void *)qcvm->knownstrings);
 		Mem_Free (qcvm->knownstringsowned);
 	}
+	if (qcvm->knownstrings_map)
+		HashMap_Destroy (qcvm->knownstrings_map);
+	ED_ResetIndex ();
 	Mem_Free (qcvm->edicts); // ericw -- sv.edicts switched to use malloc()
 	if (qcvm->fielddefs != (ddef_t *)((byte *)qcvm->progs + qcvm->progs->ofs_fielddefs))
 		Mem_Free (qcvm->fielddefs);
@@ -1187,6 +1799,7 @@ void PR_ClearProgs (qcvm_t *vm)
 	HashMap_Destroy (qcvm->function_map);
 	HashMap_Destroy (qcvm->fielddefs_map);
 	HashMap_Destroy (qcvm->globaldefs_map);
+	PR_FreeTranslation ();
 	memset (qcvm, 0, sizeof (*qcvm));
 
 	qcvm = NULL;
@@ -1245,7 +1858,7 @@ static void PR_MergeEngineFieldDefs (void)
 	if (maxdefs != qcvm->progs->numfielddefs)
 	{ // we now know how many entries we need to add...
 		ddef_t *olddefs = qcvm->fielddefs;
-		qcvm->fielddefs = Mem_Alloc (maxdefs * sizeof (*qcvm->fielddefs));
+		qcvm->fielddefs = Mem_AllocTagged (maxdefs * sizeof (*qcvm->fielddefs), MEMTAG_PROGS);
 		memcpy (qcvm->fielddefs, olddefs, qcvm->progs->numfielddefs * sizeof (*qcvm->fielddefs));
 		if (olddefs != (ddef_t *)((byte *)qcvm->progs + qcvm->progs->ofs_fielddefs))
 			Mem_Free (olddefs);
@@ -1519,6 +2132,8 @@ qboolean PR_LoadProgs (const char *filename, qboolean fatal, unsigned int needcr
 	PR_FindSupportedEffects ();
 
 	qcvm->progsstrings = qcvm->numknownstrings;
+
+	PR_TranslateProgs ();
 	return true;
 }
 
@@ -1533,7 +2148,13 @@ void PR_Init (void)
 	Cmd_AddCommand ("edicts", ED_PrintEdicts);
 	Cmd_AddCommand ("edictcount", ED_Count);
 	Cmd_AddCommand ("profile", PR_Profile_f);
+	Cmd_AddCommand ("prof_start", PR_ProfStart_f);
+	Cmd_AddCommand ("prof_stop", PR_ProfStop_f);
 	Cmd_AddCommand ("pr_dumpplatform", PR_DumpPlatform_f);
+	Cvar_RegisterVariable (&pr_threaded);
+	Cvar_RegisterVariable (&pr_native_check);
+	Cvar_RegisterVariable (&pr_findindex);
+	Cvar_RegisterVariable (&pr_edictmirror);
 	Cvar_RegisterVariable (&nomonsters);
 	Cvar_RegisterVariable (&gamecfg);
 	Cvar_RegisterVariable (&scratch1);
@@ -1580,6 +2201,29 @@ static void PR_AllocStringSlots (void)
 	qcvm->knownstringsowned = (qboolean *)Mem_Realloc ((void *)qcvm->knownstringsowned, qcvm->maxknownstrings * sizeof (qboolean));
 }
 
+/*
+============
+PR_MapKnownString
+
+Makes slot i the one PR_SetEngineString finds for its pointer, unless an earlier slot already has it
+============
+*/
+static void PR_MapKnownString (int i)
+{
+	if (!qcvm->knownstrings_map)
+		qcvm->knownstrings_map = HashMap_Create (const char *, int, &HashPtr, NULL);
+	if (!HashMap_Lookup (int, qcvm->knownstrings_map, &qcvm->knownstrings[i]))
+		HashMap_Insert (qcvm->knownstrings_map, &qcvm->knownstrings[i], &i);
+}
+
+static void PR_UnmapKnownString (int i)
+{
+	int *mapped = HashMap_Lookup (int, qcvm->knownstrings_map, &qcvm->knownstrings[i]);
+
+	if (mapped && *mapped == i)
+		HashMap_Erase (qcvm->knownstrings_map, &qcvm->knownstrings[i]);
+}
+
 const char *PR_GetString (int num)
 {
 	if (num >= 0 && num < qcvm->stringssize)
@@ -1605,7 +2249,10 @@ void PR_ClearEngineString (int num)
 {
 	if (num < 0 && num >= -qcvm->numknownstrings)
 	{
+		ED_StringReleased (num);
 		num = -1 - num;
+		if (qcvm->knownstrings[num])
+			PR_UnmapKnownString (num);
 		if (qcvm->knownstringsowned[num])
 		{
 			SAFE_FREE (qcvm->knownstrings[num]);
@@ -1631,10 +2278,11 @@ int PR_SetEngineString (const char *s)
 	if (s >= qcvm->strings && s <= qcvm->strings + qcvm->stringssize - 2)
 		return (int)(s - qcvm->strings);
 #endif
-	for (i = 0; i < qcvm->numknownstrings; i++)
+	if (qcvm->knownstrings_map)
 	{
-		if (qcvm->knownstrings[i] == s)
-			return -1 - i;
+		int *known = HashMap_Lookup (int, qcvm->knownstrings_map, &s);
+		if (known)
+			return -1 - *known;
 	}
 	// new unknown engine string
 	// Con_DPrintf ("PR_SetEngineString: new engine string %p\n", s);
@@ -1656,6 +2304,7 @@ int PR_SetEngineString (const char *s)
 	qcvm->freeknownstrings = i + 1;
 	qcvm->knownstrings[i] = s;
 	qcvm->knownstringsowned[i] = false;
+	PR_MapKnownString (i);
 	return -1 - i;
 }
 
@@ -1682,8 +2331,9 @@ int PR_AllocString (int size, char **ptr)
 		break;
 	}
 	qcvm->freeknownstrings = i + 1;
-	qcvm->knownstrings[i] = (char *)Mem_Alloc (size);
+	qcvm->knownstrings[i] = (char *)Mem_AllocTagged (size, MEMTAG_PROGS);
 	qcvm->knownstringsowned[i] = true;
+	PR_MapKnownString (i);
 	if (ptr)
 		*ptr = (char *)qcvm->knownstrings[i];
 	return -1 - i;
@@ -1691,9 +2341,11 @@ int PR_AllocString (int size, char **ptr)
 
 void PR_ClearEdictStrings ()
 {
+	ED_ResetIndex ();
 	for (int i = qcvm->progsstrings; i < qcvm->numknownstrings; ++i)
 		if (qcvm->knownstringsowned[i])
 		{
+			PR_UnmapKnownString (i);
 			SAFE_FREE (qcvm->knownstrings[i]);
 			qcvm->knownstringsowned[i] = false;
 		}
@@ -1703,3 +2355,85 @@ void PR_ClearEdictStrings ()
 	qcvm->freeknownstrings = qcvm->progsstrings;
 #endif
 }
+
+#ifdef _DEBUG
+/*
+=================
+PR_TEST_ASSERT
+=================
+*/
+#define PR_TEST_ASSERT(cond, what) \
+	if (!(cond))                   \
+	{                              \
+		Con_Printf ("%s\n", what); \
+		abort ();                  \
+	}
+
+/*
+=================
+TestEngineStrings_f
+
+Registers, looks up and frees 100k engine strings in a scratch qcvm
+=================
+*/
+void TestEngineStrings_f (void)
+{
+	static const int NUM_STRINGS = 100000;
+	static char		 progsstrings[] = "\0progs";
+	qcvm_t			*oldvm = qcvm;
+	qcvm_t			*vm = (qcvm_t *)Mem_Alloc (sizeof (qcvm_t));
+	char			*engine = (char *)Mem_Alloc (NUM_STRINGS); // every byte is a distinct engine string
+	char			*owned;
+	TEMP_ALLOC (int, nums, NUM_STRINGS);
+
+	vm->strings = progsstrings;
+	vm->stringssize = sizeof (progsstrings);
+	qcvm = NULL;
+	PR_SwitchQCVM (vm);
+
+	double start_time = Sys_DoubleTime ();
+	for (int i = 0; i < NUM_STRINGS; ++i)
+		nums[i] = PR_SetEngineString (&engine[i]);
+	const double register_time = Sys_DoubleTime () - start_time;
+	start_time = Sys_DoubleTime ();
+	for (int i = 0; i < NUM_STRINGS; ++i)
+		PR_TEST_ASSERT (PR_SetEngineString (&engine[i]) == nums[i], va ("Engine string %d registered twice", i));
+	const double lookup_time = Sys_DoubleTime () - start_time;
+	for (int i = 0; i < NUM_STRINGS; ++i)
+		PR_TEST_ASSERT (nums[i] == -1 - i && PR_GetString (nums[i]) == &engine[i], va ("Wrong slot for engine string %d", i));
+
+	// freed slots get reused without disturbing the strings around them
+	for (int i = 0; i < NUM_STRINGS; i += 2)
+		PR_ClearEngineString (nums[i]);
+	for (int i = 1; i < NUM_STRINGS; i += 2)
+		PR_TEST_ASSERT (PR_SetEngineString (&engine[i]) == nums[i], va ("Engine string %d lost", i));
+	for (int i = 0; i < NUM_STRINGS; i += 2)
+	{
+		nums[i] = PR_SetEngineString (&engine[i]);
+		PR_TEST_ASSERT (PR_GetString (nums[i]) == &engine[i], va ("Wrong slot for engine string %d", i));
+	}
+	PR_TEST_ASSERT (qcvm->numknownstrings == NUM_STRINGS, "Freed slots not reused");
+
+	// PR_AllocString memory can be passed back in as an engine string too
+	for (int i = 0; i < 1000; ++i)
+	{
+		const int num = PR_AllocString (16, &owned);
+		PR_TEST_ASSERT (PR_SetEngineString (owned) == num, va ("Owned string %d not found", i));
+		PR_ClearEngineString (num);
+	}
+
+	for (int i = 0; i < NUM_STRINGS; ++i)
+		PR_ClearEngineString (nums[i]);
+	PR_TEST_ASSERT (HashMap_Size (qcvm->knownstrings_map) == 0, "Known string map is not empty");
+	Con_Printf ("%d engine strings: %.1f ms to register, %.1f ms to look up\n", NUM_STRINGS, register_time * 1000.0, lookup_time * 1000.0);
+
+	Mem_Free ((void *)vm->knownstrings);
+	Mem_Free (vm->knownstringsowned);
+	HashMap_Destroy (vm->knownstrings_map);
+	Mem_Free (vm);
+	Mem_Free (engine);
+	TEMP_FREE (nums);
+	qcvm = NULL;
+	PR_SwitchQCVM (oldvm);
+}
+#endif
@@ -145,9 +145,10 @@ PR_Profile_f
 */
 void PR_Profile_f (void)
 {
-	int			 i, num;
-	int			 pmax;
-	dfunction_t *f, *best;
+	static const char *engines[2] = {"switch", "threaded"};
+	int				   i, num;
+	int				   pmax;
+	dfunction_t		  *f, *best;
 
 	if (!sv.active)
 		return;
@@ -177,9 +178,324 @@ void PR_Profile_f (void)
 		}
 	} while (best);
 
+	// statement throughput since the last profile, set pr_threaded and profile again to compare
+	for (i = 0; i < 2; i++)
+	{
+		if (!qcvm->profilestatements[i])
+			continue;
+		Con_Printf (
+			"%s interpreter: %" SDL_PRIu64 " statements in %.1f ms, %.1f M/s\n", engines[i], qcvm->profilestatements[i], qcvm->profiletime[i] * 1000.0,
+			qcvm->profiletime[i] > 0.0 ? qcvm->profilestatements[i] / qcvm->profiletime[i] / 1000000.0 : 0.0);
+		qcvm->profilestatements[i] = 0;
+		qcvm->profiletime[i] = 0.0;
+	}
+
 	PR_SwitchQCVM (NULL);
 }
 
+/*
+===============================================================================
+
+QC PROFILER
+
+prof_start and prof_stop bracket a stretch of play and record the call tree of
+the server progs, builtins included. Each node keeps its call count, its self
+time and the statements run in the function itself. prof_stop writes the tree
+in collapsed-stack format, one "outer;inner;innermost value" line per node, for
+flamegraph.pl and compatible viewers.
+
+===============================================================================
+*/
+
+typedef struct
+{
+	int		 parent; // node index, -1 for calls made by the engine
+	int		 firstchild;
+	int		 sibling;
+	int		 func; // index into the progs functions
+	char	*name;
+	uint64_t calls;
+	uint64_t ticks;		 // self time in performance counter ticks
+	uint64_t statements; // statements run in this function itself
+} prprofnode_t;
+
+typedef struct
+{
+	int		 node;
+	uint64_t start; // counter when this frame last became the innermost one
+	int		 mark;	// profile count of its function at that point
+} prprofframe_t;
+
+static qcvm_t		 *pr_profvm; // &sv.qcvm while recording
+static unsigned int	  pr_profhash;
+static double		  pr_proftime;
+static prprofnode_t	 *pr_profnodes;
+static int			  pr_proffirst = -1; // first node called by the engine
+static prprofframe_t  pr_profstack[MAX_STACK_DEPTH * 2];
+static int			  pr_profdepth;
+static int			  pr_profoverflow; // frames that didn't fit on pr_profstack
+
+static void PR_ProfileSuspend (prprofframe_t *frame, uint64_t now)
+{
+	prprofnode_t *node = &pr_profnodes[frame->node];
+
+	node->ticks += now - frame->start;
+	node->statements += qcvm->functions[node->func].profile - frame->mark;
+}
+
+static void PR_ProfileResume (prprofframe_t *frame, uint64_t now)
+{
+	frame->start = now;
+	frame->mark = qcvm->functions[pr_profnodes[frame->node].func].profile;
+}
+
+static int PR_ProfileChild (int parent, int func)
+{
+	prprofnode_t node;
+	dfunction_t *f = &qcvm->functions[func];
+	int			 i;
+
+	for (i = (parent >= 0) ? pr_profnodes[parent].firstchild : pr_proffirst; i >= 0; i = pr_profnodes[i].sibling)
+		if (pr_profnodes[i].func == func)
+			return i;
+
+	memset (&node, 0, sizeof (node));
+	node.parent = parent;
+	node.firstchild = -1;
+	node.func = func;
+	node.name = q_strdup (va ("%s%s", (f->first_statement < 0) ? "PF_" : "", PR_GetString (f->s_name)));
+	i = VEC_SIZE (pr_profnodes);
+	if (parent >= 0)
+	{
+		node.sibling = pr_profnodes[parent].firstchild;
+		pr_profnodes[parent].firstchild = i;
+	}
+	else
+	{
+		node.sibling = pr_proffirst;
+		pr_proffirst = i;
+	}
+	VEC_PUSH (pr_profnodes, node);
+	return i;
+}
+
+/*
+====================
+PR_ProfileEnter
+
+Called for every QC function and builtin entered while pr_profvm is running
+====================
+*/
+static void PR_ProfileEnter (dfunction_t *f)
+{
+	uint64_t	   now = SDL_GetPerformanceCounter ();
+	prprofframe_t *frame;
+	int			   parent = -1;
+
+	if (pr_profdepth == countof (pr_profstack))
+	{
+		pr_profoverflow++;
+		return;
+	}
+	if (pr_profdepth)
+	{
+		PR_ProfileSuspend (&pr_profstack[pr_profdepth - 1], now);
+		parent = pr_profstack[pr_profdepth - 1].node;
+	}
+	frame = &pr_profstack[pr_profdepth++];
+	frame->node = PR_ProfileChild (parent, f - qcvm->functions);
+	pr_profnodes[frame->node].calls++;
+	PR_ProfileResume (frame, now);
+}
+
+static void PR_ProfileLeave (void)
+{
+	uint64_t now = SDL_GetPerformanceCounter ();
+
+	if (pr_profoverflow)
+	{
+		pr_profoverflow--;
+		return;
+	}
+	if (!pr_profdepth)
+		return;
+	PR_ProfileSuspend (&pr_profstack[--pr_profdepth], now);
+	if (pr_profdepth)
+		PR_ProfileResume (&pr_profstack[pr_profdepth - 1], now);
+}
+
+static inline void PR_CallBuiltin (dfunction_t *f, int i)
+{
+	if (pr_profvm == qcvm)
+	{
+		PR_ProfileEnter (f);
+		qcvm->builtins[i]();
+		PR_ProfileLeave ();
+	}
+	else
+		qcvm->builtins[i]();
+}
+
+static void PR_ProfileFree (void)
+{
+	int i;
+
+	for (i = 0; i < (int)VEC_SIZE (pr_profnodes); i++)
+		Mem_Free (pr_profnodes[i].name);
+	VEC_FREE (pr_profnodes);
+	pr_proffirst = -1;
+	pr_profdepth = 0;
+	pr_profoverflow = 0;
+}
+
+/*
+====================
+PR_ProfileWrite
+
+Writes one collapsed stack line per node, weighted by self time in nanoseconds or by statements
+====================
+*/
+static qboolean PR_ProfileWrite (const char *path, qboolean statements)
+{
+	FILE		 *f;
+	int			 *chain;
+	int			  i, j, n, depth;
+	uint64_t	  value;
+	const double  tons = 1000000000.0 / (double)SDL_GetPerformanceFrequency ();
+	prprofnode_t *node;
+
+	f = fopen (path, "w");
+	if (!f)
+		return false;
+
+	n = VEC_SIZE (pr_profnodes);
+	chain = (int *)Mem_Alloc (q_max (n, 1) * sizeof (int));
+	for (i = 0; i < n; i++)
+	{
+		node = &pr_profnodes[i];
+		value = statements ? node->statements : (uint64_t)(node->ticks * tons);
+		if (!value)
+			continue;
+		depth = 0;
+		for (j = i; j >= 0; j = pr_profnodes[j].parent)
+			chain[depth++] = j;
+		while (depth-- > 0)
+			fprintf (f, "%s%c", pr_profnodes[chain[depth]].name, depth ? ';' : ' ');
+		fprintf (f, "%" SDL_PRIu64 "\n", value);
+	}
+	Mem_Free (chain);
+	return fclose (f) == 0;
+}
+
+/*
+====================
+PR_ProfileSummary
+
+Prints the functions with the most self time, summed over every place they were called from
+====================
+*/
+static void PR_ProfileSummary (void)
+{
+	int			 numfunctions = qcvm->progs->numfunctions;
+	uint64_t	*ticks, *calls, *statements, total, best;
+	const double toms = 1000.0 / (double)SDL_GetPerformanceFrequency ();
+	int			 i, num, bestfunc;
+
+	ticks = (uint64_t *)Mem_Alloc (numfunctions * sizeof (uint64_t));
+	calls = (uint64_t *)Mem_Alloc (numfunctions * sizeof (uint64_t));
+	statements = (uint64_t *)Mem_Alloc (numfunctions * sizeof (uint64_t));
+	total = 0;
+	for (i = 0; i < (int)VEC_SIZE (pr_profnodes); i++)
+	{
+		ticks[pr_profnodes[i].func] += pr_profnodes[i].ticks;
+		calls[pr_profnodes[i].func] += pr_profnodes[i].calls;
+		statements[pr_profnodes[i].func] += pr_profnodes[i].statements;
+		total += pr_profnodes[i].ticks;
+	}
+
+	Con_Printf ("%.1f ms in QC over %.1f s\n", total * toms, Sys_DoubleTime () - pr_proftime);
+	Con_Printf ("   self ms     calls  statements function\n");
+	for (num = 0; num < 15; num++)
+	{
+		best = 0;
+		bestfunc = -1;
+		for (i = 0; i < numfunctions; i++)
+			if (ticks[i] > best)
+			{
+				best = ticks[i];
+				bestfunc = i;
+			}
+		if (bestfunc < 0)
+			break;
+		Con_Printf (
+			"%10.2f %9" SDL_PRIu64 " %11" SDL_PRIu64 " %s%s\n", ticks[bestfunc] * toms, calls[bestfunc], statements[bestfunc],
+			(qcvm->functions[bestfunc].first_statement < 0) ? "PF_" : "", PR_GetString (qcvm->functions[bestfunc].s_name));
+		ticks[bestfunc] = 0;
+	}
+
+	Mem_Free (statements);
+	Mem_Free (calls);
+	Mem_Free (ticks);
+}
+
+/*
+====================
+PR_ProfStart_f
+====================
+*/
+void PR_ProfStart_f (void)
+{
+	if (!sv.active)
+	{
+		Con_Printf ("prof_start: no server running\n");
+		return;
+	}
+
+	PR_ProfileFree ();
+	pr_profvm = &sv.qcvm;
+	pr_profhash = sv.qcvm.progshash;
+	pr_proftime = Sys_DoubleTime ();
+	Con_Printf ("QC profiling started\n");
+}
+
+/*
+====================
+PR_ProfStop_f
+
+prof_stop [file] [statements]
+====================
+*/
+void PR_ProfStop_f (void)
+{
+	char	 path[MAX_OSPATH];
+	qboolean statements = Cmd_Argc () >= 3 && !q_strcasecmp (Cmd_Argv (2), "statements");
+
+	if (!pr_profvm)
+	{
+		Con_Printf ("prof_stop: not profiling\n");
+		return;
+	}
+	pr_profvm = NULL;
+
+	q_snprintf (path, sizeof (path), "%s/%s", com_gamedir, Cmd_Argc () >= 2 ? Cmd_Argv (1) : "qcprof.txt");
+	COM_CreatePath (path);
+	if (PR_ProfileWrite (path, statements))
+	{
+		COM_FlushDirectoryCache ();
+		Con_Printf ("Wrote %s\n", path);
+	}
+	else
+		Con_Printf ("ERROR: couldn't open file %s.\n", path);
+
+	if (sv.active && sv.qcvm.progshash == pr_profhash)
+	{
+		PR_SwitchQCVM (&sv.qcvm);
+		PR_ProfileSummary ();
+		PR_SwitchQCVM (NULL);
+	}
+	PR_ProfileFree ();
+}
+
 /*
 ============
 PR_RunError
@@ -192,6 +508,9 @@ void PR_RunError (const char *error, ...)
 	va_list argptr;
 	char	string[1024];
 
+	if (qcvm->sandbox)
+		PR_SandboxAbort (); // the serial rerun reports it
+
 	va_start (argptr, error);
 	q_vsnprintf (string, sizeof (string), error, argptr);
 	va_end (argptr);
@@ -211,6 +530,9 @@ void PR_RunWarning (const char *error, ...)
 	va_list argptr;
 	char	string[1024];
 
+	if (qcvm->sandbox)
+		PR_SandboxAbort ();
+
 	va_start (argptr, error);
 	q_vsnprintf (string, sizeof (string), error, argptr);
 	va_end (argptr);
@@ -221,6 +543,35 @@ void PR_RunWarning (const char *error, ...)
 	Con_Warning ("%s\n", string);
 }
 
+/*
+============
+PR_SandboxAbort
+
+Builtin for everything a sandboxed vm may not call, and its way out of run errors and
+warnings. Unwinds to the setjmp of whoever set qcvm->sandbox, the work is redone serially.
+============
+*/
+void PR_SandboxAbort (void)
+{
+	qcvm->depth = 0;
+	qcvm->localstack_used = 0;
+	longjmp (*qcvm->sandbox, 1);
+}
+
+/*
+============
+PR_MarkWritten
+
+OP_ADDRESS and OP_STATE on a sandboxed vm, records which edicts its owner has to diff
+============
+*/
+static inline void PR_MarkWritten (int edict)
+{
+	if ((unsigned int)edict >= (unsigned int)(qcvm->num_edicts * qcvm->edict_size))
+		PR_SandboxAbort ();
+	qcvm->written[edict / qcvm->edict_size] = true;
+}
+
 /*
 ====================
 PR_EnterFunction
@@ -259,6 +610,8 @@ static int PR_EnterFunction (dfunction_t *f)
 	}
 
 	qcvm->xfunction = f;
+	if (pr_profvm == qcvm)
+		PR_ProfileEnter (f);
 	return f->first_statement - 1; // offset the s++
 }
 
@@ -274,6 +627,9 @@ static int PR_LeaveFunction (void)
 	if (qcvm->depth <= 0)
 		Host_Error ("prog stack underflow");
 
+	if (pr_profvm == qcvm)
+		PR_ProfileLeave ();
+
 	// Restore locals from the stack
 	c = qcvm->xfunction->locals;
 	qcvm->localstack_used -= c;
@@ -291,48 +647,39 @@ static int PR_LeaveFunction (void)
 
 /*
 ====================
-PR_ExecuteProgram
+PR_ExecuteSwitch
 
-The interpretation main loop
+The classic interpretation main loop, also used while tracing.
+Starts after statement s and returns the number of statements run.
 ====================
 */
 #define OPA ((eval_t *)&qcvm->globals[(unsigned short)st->a])
 #define OPB ((eval_t *)&qcvm->globals[(unsigned short)st->b])
 #define OPC ((eval_t *)&qcvm->globals[(unsigned short)st->c])
 
-void PR_ExecuteProgram (func_t fnum)
+#define PR_RUNAWAY_LIMIT 0x1000000 // spike -- was decimal 100000, 0x10000000 in QSS
+
+static qboolean pr_nonative; // set while pr_native_check reruns a call in the interpreter
+#define PR_NATIVE(fnum) ((qcvm->natives && !pr_nonative) ? qcvm->natives[fnum] : NULL)
+static void PR_ExecuteNative (dfunction_t *f);
+static void PR_LoadNative (void);
+
+static int PR_ExecuteSwitch (int s, int exitdepth)
 {
 	eval_t		 *ptr;
 	dstatement_t *st;
-	dfunction_t	 *f, *newf;
+	dfunction_t	 *newf;
 	int			  profile, startprofile;
 	edict_t		 *ed;
-	int			  exitdepth;
-
-	if (!fnum || fnum >= (func_t)qcvm->progs->numfunctions)
-	{
-		if (pr_global_struct->self)
-			ED_Print (PROG_TO_EDICT (pr_global_struct->self));
-		Host_Error ("PR_ExecuteProgram: NULL function");
-	}
-
-	f = &qcvm->functions[fnum];
-
-	// FIXME: if this is a builtin, then we're going to crash.
-
-	qcvm->trace = false;
-
-	// make a stack frame
-	exitdepth = qcvm->depth;
 
-	st = &qcvm->statements[PR_EnterFunction (f)];
+	st = &qcvm->statements[s];
 	startprofile = profile = 0;
 
 	while (1)
 	{
 		st++; /* next statement */
 
-		if (++profile > 0x1000000) // spike -- was decimal 100000, 0x10000000 in QSS
+		if (++profile > PR_RUNAWAY_LIMIT)
 		{
 			qcvm->xstatement = st - qcvm->statements;
 			PR_RunError ("runaway loop error");
@@ -495,6 +842,10 @@ void PR_ExecuteProgram (func_t fnum)
 				qcvm->xstatement = st - qcvm->statements;
 				PR_RunError ("assignment to world entity");
 			}
+			if ((qcvm->findindex && ED_IndexedField (OPB->_int)) || (qcvm->hot && ED_HotField (OPB->_int)))
+				ED_FieldAddressed (ed, OPB->_int);
+			if (qcvm->written) // sandboxes only run here, never threaded or native
+				PR_MarkWritten (OPA->edict);
 			OPC->_int = (byte *)((int *)&ed->v + OPB->_int) - (byte *)qcvm->edicts;
 			break;
 
@@ -556,7 +907,12 @@ void PR_ExecuteProgram (func_t fnum)
 				int i = -newf->first_statement;
 				if (i >= qcvm->numbuiltins)
 					i = 0; // just invoke the fixme builtin.
-				qcvm->builtins[i]();
+				PR_CallBuiltin (newf, i);
+				break;
+			}
+			if (PR_NATIVE (OPA->function))
+			{
+				PR_ExecuteNative (newf);
 				break;
 			}
 			// Normal function
@@ -574,15 +930,19 @@ void PR_ExecuteProgram (func_t fnum)
 			st = &qcvm->statements[PR_LeaveFunction ()];
 			if (qcvm->depth == exitdepth)
 			{ // Done
-				return;
+				return profile;
 			}
 			break;
 
 		case OP_STATE:
+			if (qcvm->written)
+				PR_MarkWritten (pr_global_struct->self);
 			ed = PROG_TO_EDICT (pr_global_struct->self);
 			ed->v.nextthink = pr_global_struct->time + 0.1;
 			ed->v.frame = OPA->_float;
 			ed->v.think = OPB->function;
+			if (qcvm->hot)
+				ED_HotStale (ed);
 			break;
 
 		default:
@@ -594,3 +954,1426 @@ void PR_ExecuteProgram (func_t fnum)
 #undef OPA
 #undef OPB
 #undef OPC
+
+/*
+===============================================================================
+
+THREADED INTERPRETER
+
+At load time every statement is translated into a prtstatement_t with its
+operands resolved to global pointers, so the dispatch loop no longer decodes
+offsets. Handlers jump straight to the next one through a computed goto where
+the compiler supports it, and fall back to a switch otherwise. A few common
+pairs are fused into one handler; the second statement of a pair is kept in
+place, so statement indices and error reports are the same as the bytecode.
+
+===============================================================================
+*/
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PR_COMPUTED_GOTO
+#endif
+
+// X-macro of the translated opcodes, order defines the dispatch table
+#define PR_THREADED_OPS     \
+	PR_TOP (BAD)            \
+	PR_TOP (BADJUMP)        \
+	PR_TOP (ADD_F)          \
+	PR_TOP (ADD_V)          \
+	PR_TOP (SUB_F)          \
+	PR_TOP (SUB_V)          \
+	PR_TOP (MUL_F)          \
+	PR_TOP (MUL_V)          \
+	PR_TOP (MUL_FV)         \
+	PR_TOP (MUL_VF)         \
+	PR_TOP (DIV_F)          \
+	PR_TOP (BITAND)         \
+	PR_TOP (BITOR)          \
+	PR_TOP (GE)             \
+	PR_TOP (LE)             \
+	PR_TOP (GT)             \
+	PR_TOP (LT)             \
+	PR_TOP (AND)            \
+	PR_TOP (OR)             \
+	PR_TOP (NOT_F)          \
+	PR_TOP (NOT_V)          \
+	PR_TOP (NOT_S)          \
+	PR_TOP (NOT_FNC)        \
+	PR_TOP (NOT_ENT)        \
+	PR_TOP (EQ_F)           \
+	PR_TOP (EQ_V)           \
+	PR_TOP (EQ_S)           \
+	PR_TOP (EQ_E)           \
+	PR_TOP (EQ_FNC)         \
+	PR_TOP (NE_F)           \
+	PR_TOP (NE_V)           \
+	PR_TOP (NE_S)           \
+	PR_TOP (NE_E)           \
+	PR_TOP (NE_FNC)         \
+	PR_TOP (STORE)          \
+	PR_TOP (STORE_V)        \
+	PR_TOP (STOREP)         \
+	PR_TOP (STOREP_V)       \
+	PR_TOP (ADDRESS)        \
+	PR_TOP (LOAD)           \
+	PR_TOP (LOAD_V)         \
+	PR_TOP (IFNOT)          \
+	PR_TOP (IF)             \
+	PR_TOP (GOTO)           \
+	PR_TOP (CALL)           \
+	PR_TOP (DONE)           \
+	PR_TOP (STATE)          \
+	/* fused pairs */       \
+	PR_TOP (LOAD_IFNOT)     \
+	PR_TOP (LOAD_IF)        \
+	PR_TOP (ADDRESS_STOREP) \
+	PR_TOP (ADDRESS_STOREP_V)
+
+typedef enum
+{
+#define PR_TOP(n) TOP_##n,
+	PR_THREADED_OPS
+#undef PR_TOP
+	NUM_TOPS
+} prtop_t;
+
+typedef struct prtstatement_s
+{
+	int		op;	  // prtop_t
+	int		jump; // branch offset relative to this statement, argc for calls
+	eval_t *a, *b, *c;
+	eval_t *d; // value stored by the second half of ADDRESS_STOREP
+} prtstatement_t;
+
+cvar_t pr_threaded = {"pr_threaded", "1", CVAR_NONE};
+
+/*
+====================
+PR_BranchTarget
+
+Returns the statement a branch at index i jumps to, or -1
+====================
+*/
+static int PR_BranchTarget (const dstatement_t *st, int i)
+{
+	switch (st->op)
+	{
+	case OP_IF:
+	case OP_IFNOT:
+		return i + st->b;
+	case OP_GOTO:
+		return i + st->a;
+	default:
+		return -1;
+	}
+}
+
+/*
+====================
+PR_TranslateProgs
+
+Called at the end of PR_LoadProgs, once the globals are in place
+====================
+*/
+void PR_TranslateProgs (void)
+{
+	int					numstatements = qcvm->progs->numstatements;
+	const dstatement_t *st;
+	prtstatement_t	   *ts;
+	qboolean		   *targets;
+	int					i, target, numfused;
+
+	PR_FreeTranslation ();
+	qcvm->tstatements = (prtstatement_t *)Mem_Alloc (numstatements * sizeof (prtstatement_t));
+
+	// statements that are entered from anywhere but the previous one can't be fused into it
+	targets = (qboolean *)Mem_Alloc (numstatements * sizeof (qboolean));
+	for (i = 0; i < qcvm->progs->numfunctions; i++)
+	{
+		target = qcvm->functions[i].first_statement;
+		if (target >= 0 && target < numstatements)
+			targets[target] = true;
+	}
+	for (i = 0; i < numstatements; i++)
+	{
+		target = PR_BranchTarget (&qcvm->statements[i], i);
+		if (target >= 0 && target < numstatements)
+			targets[target] = true;
+	}
+
+	for (i = 0; i < numstatements; i++)
+	{
+		st = &qcvm->statements[i];
+		ts = &qcvm->tstatements[i];
+		ts->a = (eval_t *)&qcvm->globals[(unsigned short)st->a];
+		ts->b = (eval_t *)&qcvm->globals[(unsigned short)st->b];
+		ts->c = (eval_t *)&qcvm->globals[(unsigned short)st->c];
+
+		switch (st->op)
+		{
+		case OP_ADD_F:
+			ts->op = TOP_ADD_F;
+			break;
+		case OP_ADD_V:
+			ts->op = TOP_ADD_V;
+			break;
+		case OP_SUB_F:
+			ts->op = TOP_SUB_F;
+			break;
+		case OP_SUB_V:
+			ts->op = TOP_SUB_V;
+			break;
+		case OP_MUL_F:
+			ts->op = TOP_MUL_F;
+			break;
+		case OP_MUL_V:
+			ts->op = TOP_MUL_V;
+			break;
+		case OP_MUL_FV:
+			ts->op = TOP_MUL_FV;
+			break;
+		case OP_MUL_VF:
+			ts->op = TOP_MUL_VF;
+			break;
+		case OP_DIV_F:
+			ts->op = TOP_DIV_F;
+			break;
+		case OP_BITAND:
+			ts->op = TOP_BITAND;
+			break;
+		case OP_BITOR:
+			ts->op = TOP_BITOR;
+			break;
+		case OP_GE:
+			ts->op = TOP_GE;
+			break;
+		case OP_LE:
+			ts->op = TOP_LE;
+			break;
+		case OP_GT:
+			ts->op = TOP_GT;
+			break;
+		case OP_LT:
+			ts->op = TOP_LT;
+			break;
+		case OP_AND:
+			ts->op = TOP_AND;
+			break;
+		case OP_OR:
+			ts->op = TOP_OR;
+			break;
+		case OP_NOT_F:
+			ts->op = TOP_NOT_F;
+			break;
+		case OP_NOT_V:
+			ts->op = TOP_NOT_V;
+			break;
+		case OP_NOT_S:
+			ts->op = TOP_NOT_S;
+			break;
+		case OP_NOT_FNC:
+			ts->op = TOP_NOT_FNC;
+			break;
+		case OP_NOT_ENT:
+			ts->op = TOP_NOT_ENT;
+			break;
+		case OP_EQ_F:
+			ts->op = TOP_EQ_F;
+			break;
+		case OP_EQ_V:
+			ts->op = TOP_EQ_V;
+			break;
+		case OP_EQ_S:
+			ts->op = TOP_EQ_S;
+			break;
+		case OP_EQ_E:
+			ts->op = TOP_EQ_E;
+			break;
+		case OP_EQ_FNC:
+			ts->op = TOP_EQ_FNC;
+			break;
+		case OP_NE_F:
+			ts->op = TOP_NE_F;
+			break;
+		case OP_NE_V:
+			ts->op = TOP_NE_V;
+			break;
+		case OP_NE_S:
+			ts->op = TOP_NE_S;
+			break;
+		case OP_NE_E:
+			ts->op = TOP_NE_E;
+			break;
+		case OP_NE_FNC:
+			ts->op = TOP_NE_FNC;
+			break;
+		case OP_STORE_F:
+		case OP_STORE_ENT:
+		case OP_STORE_FLD:
+		case OP_STORE_S:
+		case OP_STORE_FNC:
+			ts->op = TOP_STORE;
+			break;
+		case OP_STORE_V:
+			ts->op = TOP_STORE_V;
+			break;
+		case OP_STOREP_F:
+		case OP_STOREP_ENT:
+		case OP_STOREP_FLD:
+		case OP_STOREP_S:
+		case OP_STOREP_FNC:
+			ts->op = TOP_STOREP;
+			break;
+		case OP_STOREP_V:
+			ts->op = TOP_STOREP_V;
+			break;
+		case OP_ADDRESS:
+			ts->op = TOP_ADDRESS;
+			break;
+		case OP_LOAD_F:
+		case OP_LOAD_FLD:
+		case OP_LOAD_ENT:
+		case OP_LOAD_S:
+		case OP_LOAD_FNC:
+			ts->op = TOP_LOAD;
+			break;
+		case OP_LOAD_V:
+			ts->op = TOP_LOAD_V;
+			break;
+		case OP_IFNOT:
+		case OP_IF:
+		case OP_GOTO:
+			target = PR_BranchTarget (st, i);
+			if (target < 0 || target >= numstatements)
+				ts->op = TOP_BADJUMP;
+			else if (st->op == OP_GOTO)
+				ts->op = TOP_GOTO;
+			else
+				ts->op = (st->op == OP_IF) ? TOP_IF : TOP_IFNOT;
+			ts->jump = target - i;
+			break;
+		case OP_CALL0:
+		case OP_CALL1:
+		case OP_CALL2:
+		case OP_CALL3:
+		case OP_CALL4:
+		case OP_CALL5:
+		case OP_CALL6:
+		case OP_CALL7:
+		case OP_CALL8:
+			ts->op = TOP_CALL;
+			ts->jump = st->op - OP_CALL0;
+			break;
+		case OP_DONE:
+		case OP_RETURN:
+			ts->op = TOP_DONE;
+			break;
+		case OP_STATE:
+			ts->op = TOP_STATE;
+			break;
+		default:
+			ts->op = TOP_BAD;
+			break;
+		}
+	}
+
+	numfused = 0;
+	for (i = 0; i < numstatements - 1; i++)
+	{
+		const dstatement_t *next = &qcvm->statements[i + 1];
+
+		st = &qcvm->statements[i];
+		ts = &qcvm->tstatements[i];
+		if (targets[i + 1])
+			continue;
+
+		// load a field and branch on it
+		if (ts->op == TOP_LOAD && (ts[1].op == TOP_IF || ts[1].op == TOP_IFNOT) && next->a == st->c)
+		{
+			ts->op = (ts[1].op == TOP_IF) ? TOP_LOAD_IF : TOP_LOAD_IFNOT;
+			ts->jump = ts[1].jump + 1;
+			numfused++;
+		}
+		// take a field address and store through it
+		else if (ts->op == TOP_ADDRESS && (ts[1].op == TOP_STOREP || ts[1].op == TOP_STOREP_V) && next->b == st->c)
+		{
+			ts->op = (ts[1].op == TOP_STOREP) ? TOP_ADDRESS_STOREP : TOP_ADDRESS_STOREP_V;
+			ts->d = ts[1].a;
+			numfused++;
+		}
+	}
+
+	Mem_Free (targets);
+	Con_DPrintf ("PR_TranslateProgs: %i statements, %i pairs fused\n", numstatements, numfused);
+
+	if (qcvm == &sv.qcvm && COM_CheckParm ("-qcnative"))
+		PR_LoadNative ();
+}
+
+/*
+====================
+PR_FreeTranslation
+====================
+*/
+void PR_FreeTranslation (void)
+{
+	Mem_Free (qcvm->tstatements);
+	qcvm->tstatements = NULL;
+	Mem_Free (qcvm->natives);
+	qcvm->natives = NULL;
+	if (qcvm->nativelib)
+		SDL_UnloadObject (qcvm->nativelib);
+	qcvm->nativelib = NULL;
+}
+
+#ifdef PR_COMPUTED_GOTO
+#define PR_CASE(n)	  TOP_LABEL_##n:
+#define PR_DISPATCH()           \
+	do                          \
+	{                           \
+		++profile;              \
+		goto *dispatch[ts->op]; \
+	} while (0)
+#else
+#define PR_CASE(n)	  case TOP_##n:
+#define PR_DISPATCH() continue
+#endif
+
+// runaway loops can only come from branches and calls, so only they check the counter
+#define PR_JUMP(n)                  \
+	ts += (n);                      \
+	if (profile > PR_RUNAWAY_LIMIT) \
+		goto runaway;               \
+	PR_DISPATCH ()
+
+#define PR_NEXT() \
+	ts++;         \
+	PR_DISPATCH ()
+
+/*
+====================
+PR_ExecuteThreaded
+
+The threaded interpretation main loop.
+Starts after statement s and returns the number of statements run.
+====================
+*/
+static int PR_ExecuteThreaded (int s, int exitdepth)
+{
+	prtstatement_t *ts;
+	eval_t		   *ptr;
+	dfunction_t	   *newf;
+	edict_t		   *ed;
+	int				profile, startprofile;
+	int				i;
+#ifdef PR_COMPUTED_GOTO
+	static const void *const dispatch[NUM_TOPS] = {
+#define PR_TOP(n) &&TOP_LABEL_##n,
+		PR_THREADED_OPS
+#undef PR_TOP
+	};
+#endif
+
+	ts = &qcvm->tstatements[s + 1];
+	startprofile = profile = 0;
+
+	for (;;)
+	{
+#ifdef PR_COMPUTED_GOTO
+		PR_DISPATCH ();
+#else
+		++profile;
+		switch (ts->op)
+#endif
+		{
+			PR_CASE (ADD_F)
+			ts->c->_float = ts->a->_float + ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (ADD_V)
+			ts->c->vector[0] = ts->a->vector[0] + ts->b->vector[0];
+			ts->c->vector[1] = ts->a->vector[1] + ts->b->vector[1];
+			ts->c->vector[2] = ts->a->vector[2] + ts->b->vector[2];
+			PR_NEXT ();
+
+			PR_CASE (SUB_F)
+			ts->c->_float = ts->a->_float - ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (SUB_V)
+			ts->c->vector[0] = ts->a->vector[0] - ts->b->vector[0];
+			ts->c->vector[1] = ts->a->vector[1] - ts->b->vector[1];
+			ts->c->vector[2] = ts->a->vector[2] - ts->b->vector[2];
+			PR_NEXT ();
+
+			PR_CASE (MUL_F)
+			ts->c->_float = ts->a->_float * ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (MUL_V)
+			ts->c->_float = ts->a->vector[0] * ts->b->vector[0] + ts->a->vector[1] * ts->b->vector[1] + ts->a->vector[2] * ts->b->vector[2];
+			PR_NEXT ();
+			PR_CASE (MUL_FV)
+			ts->c->vector[0] = ts->a->_float * ts->b->vector[0];
+			ts->c->vector[1] = ts->a->_float * ts->b->vector[1];
+			ts->c->vector[2] = ts->a->_float * ts->b->vector[2];
+			PR_NEXT ();
+			PR_CASE (MUL_VF)
+			ts->c->vector[0] = ts->b->_float * ts->a->vector[0];
+			ts->c->vector[1] = ts->b->_float * ts->a->vector[1];
+			ts->c->vector[2] = ts->b->_float * ts->a->vector[2];
+			PR_NEXT ();
+
+			PR_CASE (DIV_F)
+			ts->c->_float = ts->a->_float / ts->b->_float;
+			PR_NEXT ();
+
+			PR_CASE (BITAND)
+			ts->c->_float = (int)ts->a->_float & (int)ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (BITOR)
+			ts->c->_float = (int)ts->a->_float | (int)ts->b->_float;
+			PR_NEXT ();
+
+			PR_CASE (GE)
+			ts->c->_float = ts->a->_float >= ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (LE)
+			ts->c->_float = ts->a->_float <= ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (GT)
+			ts->c->_float = ts->a->_float > ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (LT)
+			ts->c->_float = ts->a->_float < ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (AND)
+			ts->c->_float = ts->a->_float && ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (OR)
+			ts->c->_float = ts->a->_float || ts->b->_float;
+			PR_NEXT ();
+
+			PR_CASE (NOT_F)
+			ts->c->_float = !ts->a->_float;
+			PR_NEXT ();
+			PR_CASE (NOT_V)
+			ts->c->_float = !ts->a->vector[0] && !ts->a->vector[1] && !ts->a->vector[2];
+			PR_NEXT ();
+			PR_CASE (NOT_S)
+			ts->c->_float = !ts->a->string || !*PR_GetString (ts->a->string);
+			PR_NEXT ();
+			PR_CASE (NOT_FNC)
+			ts->c->_float = !ts->a->function;
+			PR_NEXT ();
+			PR_CASE (NOT_ENT)
+			ts->c->_float = (PROG_TO_EDICT (ts->a->edict) == qcvm->edicts);
+			PR_NEXT ();
+
+			PR_CASE (EQ_F)
+			ts->c->_float = ts->a->_float == ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (EQ_V)
+			ts->c->_float = (ts->a->vector[0] == ts->b->vector[0]) && (ts->a->vector[1] == ts->b->vector[1]) && (ts->a->vector[2] == ts->b->vector[2]);
+			PR_NEXT ();
+			PR_CASE (EQ_S)
+			ts->c->_float = !strcmp (PR_GetString (ts->a->string), PR_GetString (ts->b->string));
+			PR_NEXT ();
+			PR_CASE (EQ_E)
+			ts->c->_float = ts->a->_int == ts->b->_int;
+			PR_NEXT ();
+			PR_CASE (EQ_FNC)
+			ts->c->_float = ts->a->function == ts->b->function;
+			PR_NEXT ();
+
+			PR_CASE (NE_F)
+			ts->c->_float = ts->a->_float != ts->b->_float;
+			PR_NEXT ();
+			PR_CASE (NE_V)
+			ts->c->_float = (ts->a->vector[0] != ts->b->vector[0]) || (ts->a->vector[1] != ts->b->vector[1]) || (ts->a->vector[2] != ts->b->vector[2]);
+			PR_NEXT ();
+			PR_CASE (NE_S)
+			ts->c->_float = strcmp (PR_GetString (ts->a->string), PR_GetString (ts->b->string));
+			PR_NEXT ();
+			PR_CASE (NE_E)
+			ts->c->_float = ts->a->_int != ts->b->_int;
+			PR_NEXT ();
+			PR_CASE (NE_FNC)
+			ts->c->_float = ts->a->function != ts->b->function;
+			PR_NEXT ();
+
+			PR_CASE (STORE)
+			ts->b->_int = ts->a->_int;
+			PR_NEXT ();
+			PR_CASE (STORE_V)
+			ts->b->vector[0] = ts->a->vector[0];
+			ts->b->vector[1] = ts->a->vector[1];
+			ts->b->vector[2] = ts->a->vector[2];
+			PR_NEXT ();
+
+			PR_CASE (STOREP)
+			ptr = (eval_t *)((byte *)qcvm->edicts + ts->b->_int);
+			ptr->_int = ts->a->_int;
+			PR_NEXT ();
+			PR_CASE (STOREP_V)
+			ptr = (eval_t *)((byte *)qcvm->edicts + ts->b->_int);
+			ptr->vector[0] = ts->a->vector[0];
+			ptr->vector[1] = ts->a->vector[1];
+			ptr->vector[2] = ts->a->vector[2];
+			PR_NEXT ();
+
+			PR_CASE (ADDRESS)
+			ed = PROG_TO_EDICT (ts->a->edict);
+#ifdef PARANOID
+			NUM_FOR_EDICT (ed); // Make sure it's in range
+#endif
+			if (ed == (edict_t *)qcvm->edicts && sv.state == ss_active)
+				goto worldassign;
+			if ((qcvm->findindex && ED_IndexedField (ts->b->_int)) || (qcvm->hot && ED_HotField (ts->b->_int)))
+				ED_FieldAddressed (ed, ts->b->_int);
+			ts->c->_int = (byte *)((int *)&ed->v + ts->b->_int) - (byte *)qcvm->edicts;
+			PR_NEXT ();
+
+			PR_CASE (LOAD)
+			ed = PROG_TO_EDICT (ts->a->edict);
+#ifdef PARANOID
+			NUM_FOR_EDICT (ed); // Make sure it's in range
+#endif
+			ts->c->_int = ((eval_t *)((int *)&ed->v + ts->b->_int))->_int;
+			PR_NEXT ();
+			PR_CASE (LOAD_V)
+			ed = PROG_TO_EDICT (ts->a->edict);
+#ifdef PARANOID
+			NUM_FOR_EDICT (ed); // Make sure it's in range
+#endif
+			ptr = (eval_t *)((int *)&ed->v + ts->b->_int);
+			ts->c->vector[0] = ptr->vector[0];
+			ts->c->vector[1] = ptr->vector[1];
+			ts->c->vector[2] = ptr->vector[2];
+			PR_NEXT ();
+
+			PR_CASE (IFNOT)
+			PR_JUMP (ts->a->_int ? 1 : ts->jump);
+			PR_CASE (IF)
+			PR_JUMP (ts->a->_int ? ts->jump : 1);
+			PR_CASE (GOTO)
+			PR_JUMP (ts->jump);
+
+			PR_CASE (CALL)
+			qcvm->xfunction->profile += profile - startprofile;
+			startprofile = profile;
+			qcvm->xstatement = ts - qcvm->tstatements;
+			qcvm->argc = ts->jump;
+			if (!ts->a->function)
+				PR_RunError ("NULL function");
+			newf = &qcvm->functions[ts->a->function];
+			if (newf->first_statement < 0)
+			{ // Built-in function
+				i = -newf->first_statement;
+				if (i >= qcvm->numbuiltins)
+					i = 0; // just invoke the fixme builtin.
+				PR_CallBuiltin (newf, i);
+				if (qcvm->trace) // traceon, the switch loop prints statements
+					return profile + PR_ExecuteSwitch (qcvm->xstatement, exitdepth);
+				PR_NEXT ();
+			}
+			if (PR_NATIVE (ts->a->function))
+			{
+				PR_ExecuteNative (newf);
+				PR_NEXT ();
+			}
+			// Normal function
+			ts = &qcvm->tstatements[PR_EnterFunction (newf)];
+			PR_JUMP (1);
+
+			PR_CASE (DONE)
+			qcvm->xfunction->profile += profile - startprofile;
+			startprofile = profile;
+			qcvm->xstatement = ts - qcvm->tstatements;
+			qcvm->globals[OFS_RETURN] = ts->a->vector[0];
+			qcvm->globals[OFS_RETURN + 1] = ts->a->vector[1];
+			qcvm->globals[OFS_RETURN + 2] = ts->a->vector[2];
+			ts = &qcvm->tstatements[PR_LeaveFunction ()];
+			if (qcvm->depth == exitdepth)
+			{ // Done
+				return profile;
+			}
+			PR_NEXT ();
+
+			PR_CASE (STATE)
+			ed = PROG_TO_EDICT (pr_global_struct->self);
+			ed->v.nextthink = pr_global_struct->time + 0.1;
+			ed->v.frame = ts->a->_float;
+			ed->v.think = ts->b->function;
+			if (qcvm->hot)
+				ED_HotStale (ed);
+			PR_NEXT ();
+
+			PR_CASE (LOAD_IFNOT)
+			ed = PROG_TO_EDICT (ts->a->edict);
+#ifdef PARANOID
+			NUM_FOR_EDICT (ed); // Make sure it's in range
+#endif
+			ts->c->_int = ((eval_t *)((int *)&ed->v + ts->b->_int))->_int;
+			++profile;
+			PR_JUMP (ts->c->_int ? 2 : ts->jump);
+			PR_CASE (LOAD_IF)
+			ed = PROG_TO_EDICT (ts->a->edict);
+#ifdef PARANOID
+			NUM_FOR_EDICT (ed); // Make sure it's in range
+#endif
+			ts->c->_int = ((eval_t *)((int *)&ed->v + ts->b->_int))->_int;
+			++profile;
+			PR_JUMP (ts->c->_int ? ts->jump : 2);
+
+			PR_CASE (ADDRESS_STOREP)
+			ed = PROG_TO_EDICT (ts->a->edict);
+#ifdef PARANOID
+			NUM_FOR_EDICT (ed); // Make sure it's in range
+#endif
+			if (ed == (edict_t *)qcvm->edicts && sv.state == ss_active)
+				goto worldassign;
+			if ((qcvm->findindex && ED_IndexedField (ts->b->_int)) || (qcvm->hot && ED_HotField (ts->b->_int)))
+				ED_FieldAddressed (ed, ts->b->_int);
+			ts->c->_int = (byte *)((int *)&ed->v + ts->b->_int) - (byte *)qcvm->edicts;
+			ptr = (eval_t *)((byte *)qcvm->edicts + ts->c->_int);
+			ptr->_int = ts->d->_int;
+			++profile;
+			ts += 2;
+			PR_DISPATCH ();
+			PR_CASE (ADDRESS_STOREP_V)
+			ed = PROG_TO_EDICT (ts->a->edict);
+#ifdef PARANOID
+			NUM_FOR_EDICT (ed); // Make sure it's in range
+#endif
+			if (ed == (edict_t *)qcvm->edicts && sv.state == ss_active)
+				goto worldassign;
+			if ((qcvm->findindex && ED_IndexedField (ts->b->_int)) || (qcvm->hot && ED_HotField (ts->b->_int)))
+				ED_FieldAddressed (ed, ts->b->_int);
+			ts->c->_int = (byte *)((int *)&ed->v + ts->b->_int) - (byte *)qcvm->edicts;
+			ptr = (eval_t *)((byte *)qcvm->edicts + ts->c->_int);
+			ptr->vector[0] = ts->d->vector[0];
+			ptr->vector[1] = ts->d->vector[1];
+			ptr->vector[2] = ts->d->vector[2];
+			++profile;
+			ts += 2;
+			PR_DISPATCH ();
+
+			PR_CASE (BADJUMP)
+			qcvm->xstatement = ts - qcvm->tstatements;
+			PR_RunError ("Bad jump target");
+			PR_NEXT ();
+
+			PR_CASE (BAD)
+			qcvm->xstatement = ts - qcvm->tstatements;
+			PR_RunError ("Bad opcode %i", qcvm->statements[qcvm->xstatement].op);
+			PR_NEXT ();
+		}
+	}
+
+runaway:
+	qcvm->xstatement = ts - qcvm->tstatements;
+	PR_RunError ("runaway loop error");
+	return profile;
+
+worldassign:
+	qcvm->xstatement = ts - qcvm->tstatements;
+	PR_RunError ("assignment to world entity");
+	return profile;
+}
+#undef PR_CASE
+#undef PR_DISPATCH
+#undef PR_JUMP
+#undef PR_NEXT
+
+/*
+===============================================================================
+
+NATIVE CODE CACHE
+
+With -qcnative on the command line, PR_TranslateProgs emits every server
+progs function whose reachable statements are all understood as C, runs
+PR_NATIVE_CC on it and loads the result. This is deliberately not a cvar:
+configs, paks and servers can set cvars, and the compiler command and the
+library it builds must not be theirs to choose. CSQC a server sent is never
+compiled. The library is kept in <userdir>/qcnative keyed by the progs crc,
+md4 and size and is only rebuilt when its signature doesn't match this
+engine's layout. Functions that can't be compiled and any load or compile
+failure leave the interpreter in charge.
+
+Native code calls back into the engine for builtins, other QC functions and
+errors, and goes through PR_EnterFunction / PR_LeaveFunction so locals, stack
+traces and xstatement behave as in the interpreter. Runaway loops are caught
+by counting backward jumps. traceon does not apply to native functions.
+
+===============================================================================
+*/
+
+#define PR_NATIVE_VERSION	 3
+#define PR_NATIVE_MAX_LENGTH 32768 // statements, larger functions are left to the interpreter
+#define PR_NATIVE_CC		 "cc -O2 -shared -fPIC -fno-strict-aliasing -ffp-contract=off" // output and source are appended
+
+cvar_t pr_native_check = {"pr_native_check", "0", CVAR_NONE};
+
+// must match the struct emitted by PR_WriteNative
+typedef struct prnativeapi_s
+{
+	void (*call) (int statement, int argc, int fnum);
+	const char *(*getstring) (int num);
+	void (*error) (int statement, const char *message);
+	int (*worldlocked) (void);
+	void (*addressed) (unsigned char *ed, int field);
+} prnativeapi_t;
+
+typedef const char *(*prnativebind_t) (prnative_t *natives, int numfunctions);
+
+static int PR_ExecuteFunction (dfunction_t *f);
+
+static void PR_NativeCall (int statement, int argc, int fnum)
+{
+	dfunction_t *newf;
+	int			 i;
+
+	qcvm->xstatement = statement;
+	qcvm->argc = argc;
+	if (!fnum)
+		PR_RunError ("NULL function");
+	newf = &qcvm->functions[fnum];
+	if (newf->first_statement < 0)
+	{ // Built-in function
+		i = -newf->first_statement;
+		if (i >= qcvm->numbuiltins)
+			i = 0; // just invoke the fixme builtin.
+		PR_CallBuiltin (newf, i);
+		return;
+	}
+	PR_ExecuteFunction (newf);
+}
+
+static void PR_NativeError (int statement, const char *message)
+{
+	qcvm->xstatement = statement;
+	PR_RunError ("%s", message);
+}
+
+static int PR_NativeWorldLocked (void)
+{
+	return sv.state == ss_active;
+}
+
+static void PR_NativeAddressed (unsigned char *ed, int field)
+{
+	if (qcvm->findindex || qcvm->hot)
+		ED_FieldAddressed ((edict_t *)ed, field);
+}
+
+static const prnativeapi_t pr_nativeapi = {PR_NativeCall, PR_GetString, PR_NativeError, PR_NativeWorldLocked, PR_NativeAddressed};
+
+/*
+====================
+PR_ExecuteNative
+====================
+*/
+static void PR_ExecuteNative (dfunction_t *f)
+{
+	prnative_t native = qcvm->natives[f - qcvm->functions];
+
+	PR_EnterFunction (f);
+	native (&pr_nativeapi, (eval_t *)qcvm->globals, (byte *)qcvm->edicts);
+	PR_LeaveFunction ();
+}
+
+/*
+====================
+PR_NativeSignature
+
+Everything the generated code bakes in, a cached library with another signature is rebuilt
+====================
+*/
+static void PR_NativeSignature (char *signature, size_t size)
+{
+	q_snprintf (
+		signature, size, "qcnative %i %04x %08x %u %i %i v%i self%i time%i nextthink%i frame%i think%i", PR_NATIVE_VERSION, qcvm->progscrc, qcvm->progshash,
+		qcvm->progssize, qcvm->progs->numfunctions, qcvm->progs->numstatements, (int)offsetof (edict_t, v), (int)offsetof (globalvars_t, self) / 4,
+		(int)offsetof (globalvars_t, time) / 4, (int)offsetof (entvars_t, nextthink), (int)offsetof (entvars_t, frame), (int)offsetof (entvars_t, think));
+}
+
+/*
+====================
+PR_NativeReachable
+
+Marks the statements function f can reach, returns false if any of them can't be compiled
+====================
+*/
+static qboolean PR_NativeReachable (dfunction_t *f, byte *reached, int *first, int *last)
+{
+	int	 numstatements = qcvm->progs->numstatements;
+	int *stack, depth, i, target, count;
+
+	if (f->first_statement <= 0 || f->first_statement >= numstatements)
+		return false;
+
+	stack = (int *)Mem_Alloc (numstatements * sizeof (int));
+	depth = 0;
+	count = 0;
+	stack[depth++] = f->first_statement;
+	reached[f->first_statement] = true;
+	*first = *last = f->first_statement;
+	while (depth)
+	{
+		i = stack[--depth];
+		*first = q_min (*first, i);
+		*last = q_max (*last, i);
+		if (qcvm->tstatements[i].op == TOP_BAD || qcvm->tstatements[i].op == TOP_BADJUMP || ++count > PR_NATIVE_MAX_LENGTH)
+		{
+			Mem_Free (stack);
+			return false;
+		}
+
+		target = PR_BranchTarget (&qcvm->statements[i], i);
+		if (target >= 0 && !reached[target])
+		{
+			reached[target] = true;
+			stack[depth++] = target;
+		}
+		switch (qcvm->statements[i].op)
+		{
+		case OP_DONE:
+		case OP_RETURN:
+		case OP_GOTO:
+			continue;
+		}
+		if (i + 1 >= numstatements)
+		{
+			Mem_Free (stack);
+			return false;
+		}
+		if (!reached[i + 1])
+		{
+			reached[i + 1] = true;
+			stack[depth++] = i + 1;
+		}
+	}
+
+	Mem_Free (stack);
+	return true;
+}
+
+/*
+====================
+PR_WriteNativeStatement
+====================
+*/
+static void PR_WriteNativeStatement (FILE *f, int i)
+{
+	const dstatement_t *st = &qcvm->statements[i];
+	int					a = (unsigned short)st->a, b = (unsigned short)st->b, c = (unsigned short)st->c;
+	int					k;
+
+	switch (st->op)
+	{
+	case OP_ADD_F:
+		fprintf (f, "\tg[%i].f = g[%i].f + g[%i].f;\n", c, a, b);
+		break;
+	case OP_SUB_F:
+		fprintf (f, "\tg[%i].f = g[%i].f - g[%i].f;\n", c, a, b);
+		break;
+	case OP_MUL_F:
+		fprintf (f, "\tg[%i].f = g[%i].f * g[%i].f;\n", c, a, b);
+		break;
+	case OP_DIV_F:
+		fprintf (f, "\tg[%i].f = g[%i].f / g[%i].f;\n", c, a, b);
+		break;
+	case OP_ADD_V:
+	case OP_SUB_V:
+		for (k = 0; k < 3; k++)
+			fprintf (f, "\tg[%i].f = g[%i].f %c g[%i].f;\n", c + k, a + k, st->op == OP_ADD_V ? '+' : '-', b + k);
+		break;
+	case OP_MUL_V:
+		fprintf (f, "\tg[%i].f = g[%i].f * g[%i].f + g[%i].f * g[%i].f + g[%i].f * g[%i].f;\n", c, a, b, a + 1, b + 1, a + 2, b + 2);
+		break;
+	case OP_MUL_FV:
+		for (k = 0; k < 3; k++)
+			fprintf (f, "\tg[%i].f = g[%i].f * g[%i].f;\n", c + k, a, b + k);
+		break;
+	case OP_MUL_VF:
+		for (k = 0; k < 3; k++)
+			fprintf (f, "\tg[%i].f = g[%i].f * g[%i].f;\n", c + k, b, a + k);
+		break;
+	case OP_BITAND:
+		fprintf (f, "\tg[%i].f = (int)g[%i].f & (int)g[%i].f;\n", c, a, b);
+		break;
+	case OP_BITOR:
+		fprintf (f, "\tg[%i].f = (int)g[%i].f | (int)g[%i].f;\n", c, a, b);
+		break;
+	case OP_GE:
+		fprintf (f, "\tg[%i].f = g[%i].f >= g[%i].f;\n", c, a, b);
+		break;
+	case OP_LE:
+		fprintf (f, "\tg[%i].f = g[%i].f <= g[%i].f;\n", c, a, b);
+		break;
+	case OP_GT:
+		fprintf (f, "\tg[%i].f = g[%i].f > g[%i].f;\n", c, a, b);
+		break;
+	case OP_LT:
+		fprintf (f, "\tg[%i].f = g[%i].f < g[%i].f;\n", c, a, b);
+		break;
+	case OP_AND:
+		fprintf (f, "\tg[%i].f = g[%i].f && g[%i].f;\n", c, a, b);
+		break;
+	case OP_OR:
+		fprintf (f, "\tg[%i].f = g[%i].f || g[%i].f;\n", c, a, b);
+		break;
+	case OP_NOT_F:
+		fprintf (f, "\tg[%i].f = !g[%i].f;\n", c, a);
+		break;
+	case OP_NOT_V:
+		fprintf (f, "\tg[%i].f = !g[%i].f && !g[%i].f && !g[%i].f;\n", c, a, a + 1, a + 2);
+		break;
+	case OP_NOT_S:
+		fprintf (f, "\tg[%i].f = !g[%i].i || !*api->getstring (g[%i].i);\n", c, a, a);
+		break;
+	case OP_NOT_FNC:
+	case OP_NOT_ENT:
+		fprintf (f, "\tg[%i].f = !g[%i].i;\n", c, a);
+		break;
+	case OP_EQ_F:
+		fprintf (f, "\tg[%i].f = g[%i].f == g[%i].f;\n", c, a, b);
+		break;
+	case OP_EQ_V:
+		fprintf (f, "\tg[%i].f = (g[%i].f == g[%i].f) && (g[%i].f == g[%i].f) && (g[%i].f == g[%i].f);\n", c, a, b, a + 1, b + 1, a + 2, b + 2);
+		break;
+	case OP_EQ_S:
+		fprintf (f, "\tg[%i].f = !strcmp (api->getstring (g[%i].i), api->getstring (g[%i].i));\n", c, a, b);
+		break;
+	case OP_EQ_E:
+	case OP_EQ_FNC:
+		fprintf (f, "\tg[%i].f = g[%i].i == g[%i].i;\n", c, a, b);
+		break;
+	case OP_NE_F:
+		fprintf (f, "\tg[%i].f = g[%i].f != g[%i].f;\n", c, a, b);
+		break;
+	case OP_NE_V:
+		fprintf (f, "\tg[%i].f = (g[%i].f != g[%i].f) || (g[%i].f != g[%i].f) || (g[%i].f != g[%i].f);\n", c, a, b, a + 1, b + 1, a + 2, b + 2);
+		break;
+	case OP_NE_S:
+		fprintf (f, "\tg[%i].f = strcmp (api->getstring (g[%i].i), api->getstring (g[%i].i));\n", c, a, b);
+		break;
+	case OP_NE_E:
+	case OP_NE_FNC:
+		fprintf (f, "\tg[%i].f = g[%i].i != g[%i].i;\n", c, a, b);
+		break;
+	case OP_STORE_F:
+	case OP_STORE_ENT:
+	case OP_STORE_FLD:
+	case OP_STORE_S:
+	case OP_STORE_FNC:
+		fprintf (f, "\tg[%i].i = g[%i].i;\n", b, a);
+		break;
+	case OP_STORE_V:
+		for (k = 0; k < 3; k++)
+			fprintf (f, "\tg[%i].i = g[%i].i;\n", b + k, a + k);
+		break;
+	case OP_STOREP_F:
+	case OP_STOREP_ENT:
+	case OP_STOREP_FLD:
+	case OP_STOREP_S:
+	case OP_STOREP_FNC:
+		fprintf (f, "\tp = (qcn_val_t *)(edicts + g[%i].i);\n\tp->i = g[%i].i;\n", b, a);
+		break;
+	case OP_STOREP_V:
+		fprintf (f, "\tp = (qcn_val_t *)(edicts + g[%i].i);\n", b);
+		for (k = 0; k < 3; k++)
+			fprintf (f, "\tp[%i].f = g[%i].f;\n", k, a + k);
+		break;
+	case OP_ADDRESS:
+		fprintf (f, "\ted = edicts + g[%i].i;\n", a);
+		fprintf (f, "\tif (ed == edicts && api->worldlocked ())\n\t\tapi->error (%i, \"assignment to world entity\");\n", i);
+		fprintf (f, "\tif (QCN_WATCHED (g[%i].i))\n\t\tapi->addressed (ed, g[%i].i);\n", b, b);
+		fprintf (f, "\tg[%i].i = (int)((unsigned char *)((int *)(ed + QCN_V) + g[%i].i) - edicts);\n", c, b);
+		break;
+	case OP_LOAD_F:
+	case OP_LOAD_FLD:
+	case OP_LOAD_ENT:
+	case OP_LOAD_S:
+	case OP_LOAD_FNC:
+		fprintf (f, "\tg[%i].i = QCN_FIELD (%i, %i)->i;\n", c, a, b);
+		break;
+	case OP_LOAD_V:
+		fprintf (f, "\tp = QCN_FIELD (%i, %i);\n", a, b);
+		for (k = 0; k < 3; k++)
+			fprintf (f, "\tg[%i].f = p[%i].f;\n", c + k, k);
+		break;
+	case OP_IFNOT:
+	case OP_IF:
+	case OP_GOTO:
+		k = PR_BranchTarget (st, i);
+		if (k <= i)
+			fprintf (f, "\tif (++loops > %i)\n\t\tapi->error (%i, \"runaway loop error\");\n", PR_RUNAWAY_LIMIT, i);
+		if (st->op == OP_GOTO)
+			fprintf (f, "\tgoto s%i;\n", k);
+		else
+			fprintf (f, "\tif (%sg[%i].i)\n\t\tgoto s%i;\n", st->op == OP_IFNOT ? "!" : "", a, k);
+		break;
+	case OP_CALL0:
+	case OP_CALL1:
+	case OP_CALL2:
+	case OP_CALL3:
+	case OP_CALL4:
+	case OP_CALL5:
+	case OP_CALL6:
+	case OP_CALL7:
+	case OP_CALL8:
+		fprintf (f, "\tapi->call (%i, %i, g[%i].i);\n", i, st->op - OP_CALL0, a);
+		break;
+	case OP_DONE:
+	case OP_RETURN:
+		for (k = 0; k < 3; k++)
+			fprintf (f, "\tg[%i].f = g[%i].f;\n", OFS_RETURN + k, a + k);
+		fprintf (f, "\treturn;\n");
+		break;
+	case OP_STATE:
+		fprintf (f, "\ted = edicts + g[QCN_SELF].i + QCN_V;\n");
+		fprintf (f, "\t*(float *)(ed + QCN_NEXTTHINK) = g[QCN_TIME].f + 0.1;\n");
+		fprintf (f, "\t*(float *)(ed + QCN_FRAME) = g[%i].f;\n\t*(int *)(ed + QCN_THINK) = g[%i].i;\n", a, b);
+		fprintf (f, "\tapi->addressed (ed - QCN_V, QCN_NEXTTHINK / 4);\n");
+		break;
+	default: // rejected by PR_NativeReachable
+		fprintf (f, "\tapi->error (%i, \"bad opcode\");\n", i);
+		break;
+	}
+}
+
+/*
+====================
+PR_WriteNative
+
+Writes the C source for every function that can be compiled, returns how many
+====================
+*/
+static int PR_WriteNative (const char *path, const char *signature)
+{
+	FILE		*f;
+	byte		*reached, *labels;
+	qboolean	*compiled;
+	dfunction_t *func;
+	int			 numstatements = qcvm->progs->numstatements;
+	int			 numfunctions = qcvm->progs->numfunctions;
+	int			 i, j, first, last, target, count;
+
+	f = fopen (path, "w");
+	if (!f)
+		return 0;
+
+	fprintf (f, "/* %s */\n\n", signature);
+	fprintf (f, "typedef union\n{\n\tfloat f;\n\tint i;\n} qcn_val_t;\n\n");
+	fprintf (f, "typedef struct\n{\n\tvoid (*call) (int statement, int argc, int fnum);\n\tconst char *(*getstring) (int num);\n");
+	fprintf (f, "\tvoid (*error) (int statement, const char *message);\n\tint (*worldlocked) (void);\n\tvoid (*addressed) (unsigned char *ed, int field);\n} qcn_api_t;\n\n");
+	fprintf (f, "typedef void (*qcn_func_t) (const qcn_api_t *api, qcn_val_t *g, unsigned char *edicts);\n\n");
+	fprintf (f, "int strcmp (const char *a, const char *b);\n\n");
+	fprintf (f, "#define QCN_V\t\t\t%i\n#define QCN_SELF\t\t%i\n#define QCN_TIME\t\t%i\n", (int)offsetof (edict_t, v), (int)offsetof (globalvars_t, self) / 4,
+			 (int)offsetof (globalvars_t, time) / 4);
+	fprintf (f, "#define QCN_NEXTTHINK\t%i\n#define QCN_FRAME\t\t%i\n#define QCN_THINK\t\t%i\n", (int)offsetof (entvars_t, nextthink),
+			 (int)offsetof (entvars_t, frame), (int)offsetof (entvars_t, think));
+	fprintf (f, "#define QCN_FIELD(e, o) ((qcn_val_t *)(edicts + g[e].i + QCN_V) + g[o].i)\n");
+	// ED_IndexedField and ED_HotField with the offsets baked in
+	fprintf (f, "#define QCN_INDEXED(o) ((unsigned)((o) - %i) < 5 || (unsigned)((o) - %i) < 8 || (unsigned)((o) - %i) < 3 || (unsigned)((o) - %i) < 3)\n",
+			 ED_FIELD (origin) - 2, ED_FIELD (mins) - 2, ED_FIELD (classname) - 2, ED_FIELD (targetname) - 2);
+	fprintf (f, "#define QCN_HOT(o) ((unsigned)((o) - %i) < 3 || (unsigned)((o) - %i) < 3 || (unsigned)((o) - %i) < 3 || (unsigned)((o) - %i) < 3 || (unsigned)((o) - %i) < 3)\n",
+			 ED_FIELD (modelindex) - 2, ED_FIELD (movetype) - 2, ED_FIELD (frame) - 2, ED_FIELD (nextthink) - 2, ED_FIELD (flags) - 2);
+	fprintf (f, "#define QCN_WATCHED(o) (QCN_INDEXED (o) || QCN_HOT (o))\n\n");
+	fprintf (f, "#ifdef _WIN32\n#define QCN_EXPORT __declspec (dllexport)\n#else\n#define QCN_EXPORT __attribute__ ((visibility (\"default\")))\n#endif\n\n");
+
+	reached = (byte *)Mem_Alloc (numstatements);
+	labels = (byte *)Mem_Alloc (numstatements);
+	compiled = (qboolean *)Mem_Alloc (numfunctions * sizeof (qboolean));
+	count = 0;
+	for (i = 1; i < numfunctions; i++)
+	{
+		func = &qcvm->functions[i];
+		memset (reached, 0, numstatements);
+		if (!PR_NativeReachable (func, reached, &first, &last))
+			continue;
+
+		memset (labels, 0, numstatements);
+		labels[func->first_statement] = true;
+		for (j = first; j <= last; j++)
+		{
+			target = PR_BranchTarget (&qcvm->statements[j], j);
+			if (reached[j] && target >= 0)
+				labels[target] = true;
+		}
+
+		if (!strstr (PR_GetString (func->s_name), "*/"))
+			fprintf (f, "/* %s */\n", PR_GetString (func->s_name));
+		fprintf (f, "static void f%i (const qcn_api_t *api, qcn_val_t *g, unsigned char *edicts)\n{\n", i);
+		fprintf (f, "\tqcn_val_t *p;\n\tunsigned char *ed;\n\tint loops = 0;\n\n");
+		fprintf (f, "\t(void)p;\n\t(void)ed;\n\t(void)loops;\n\tgoto s%i;\n", func->first_statement);
+		// only reachable statements are emitted, each one that falls through has a reachable successor
+		for (j = first; j <= last; j++)
+		{
+			if (!reached[j])
+				continue;
+			if (labels[j])
+				fprintf (f, "s%i:\n", j);
+			PR_WriteNativeStatement (f, j);
+		}
+		fprintf (f, "}\n\n");
+		compiled[i] = true;
+		count++;
+	}
+
+	fprintf (f, "QCN_EXPORT const char *qcn_bind (qcn_func_t *natives, int numfunctions)\n{\n");
+	fprintf (f, "\tif (numfunctions != %i)\n\t\treturn \"\";\n", numfunctions);
+	for (i = 0; i < numfunctions; i++)
+		if (compiled[i])
+			fprintf (f, "\tnatives[%i] = f%i;\n", i, i);
+	fprintf (f, "\treturn \"%s\";\n}\n", signature);
+
+	Mem_Free (compiled);
+	Mem_Free (labels);
+	Mem_Free (reached);
+	if (fclose (f) != 0)
+		return 0;
+	return count;
+}
+
+/*
+====================
+PR_BindNative
+
+Loads the library at path and binds its functions if its signature matches
+====================
+*/
+static qboolean PR_BindNative (const char *path, const char *signature)
+{
+	prnativebind_t bind;
+	const char	  *libsignature;
+	void		  *lib;
+	int			   i, count;
+
+	lib = SDL_LoadObject (path);
+	if (!lib)
+		return false;
+	bind = (prnativebind_t)SDL_LoadFunction (lib, "qcn_bind");
+	if (bind)
+	{
+		qcvm->natives = (prnative_t *)Mem_Alloc (qcvm->progs->numfunctions * sizeof (prnative_t));
+		libsignature = bind (qcvm->natives, qcvm->progs->numfunctions);
+		if (!strcmp (libsignature, signature))
+		{
+			for (i = count = 0; i < qcvm->progs->numfunctions; i++)
+				if (qcvm->natives[i])
+					count++;
+			Con_DPrintf ("PR_LoadNative: %i of %i functions from %s\n", count, qcvm->progs->numfunctions, path);
+			qcvm->nativelib = lib;
+			return true;
+		}
+		Mem_Free (qcvm->natives);
+		qcvm->natives = NULL;
+	}
+	SDL_UnloadObject (lib);
+	return false;
+}
+
+/*
+====================
+PR_LoadNative
+====================
+*/
+static void PR_LoadNative (void)
+{
+	char signature[256];
+	char path[MAX_OSPATH], source[MAX_OSPATH], command[MAX_OSPATH * 3];
+	int	 count;
+
+	PR_NativeSignature (signature, sizeof (signature));
+#ifdef _WIN32
+	q_snprintf (path, sizeof (path), "%s/qcnative/%04x_%08x_%u.dll", host_parms->userdir, qcvm->progscrc, qcvm->progshash, qcvm->progssize);
+#else
+	q_snprintf (path, sizeof (path), "%s/qcnative/%04x_%08x_%u.so", host_parms->userdir, qcvm->progscrc, qcvm->progshash, qcvm->progssize);
+#endif
+	if (PR_BindNative (path, signature))
+		return;
+
+	q_snprintf (source, sizeof (source), "%s/qcnative/%04x_%08x_%u.c", host_parms->userdir, qcvm->progscrc, qcvm->progshash, qcvm->progssize);
+	COM_CreatePath (source);
+	count = PR_WriteNative (source, signature);
+	if (!count)
+	{
+		Con_Warning ("PR_LoadNative: couldn't write %s\n", source);
+		return;
+	}
+
+	Con_Printf ("Compiling %i QC functions to native code...\n", count);
+	q_snprintf (command, sizeof (command), PR_NATIVE_CC " -o \"%s\" \"%s\"", path, source);
+	if (system (command) != 0 || !PR_BindNative (path, signature))
+	{
+		Con_Warning ("PR_LoadNative: \"%s\" failed, using the interpreter\n", command);
+		return;
+	}
+	remove (source);
+}
+
+/*
+====================
+PR_ExecuteFunction
+
+Runs f, which must not be a builtin, with whichever engine is selected
+====================
+*/
+static int PR_ExecuteFunction (dfunction_t *f)
+{
+	int exitdepth, s;
+
+	if (PR_NATIVE (f - qcvm->functions))
+	{
+		PR_ExecuteNative (f);
+		return 0;
+	}
+
+	// make a stack frame
+	exitdepth = qcvm->depth;
+	s = PR_EnterFunction (f);
+	if (pr_threaded.value && qcvm->tstatements)
+		return PR_ExecuteThreaded (s, exitdepth);
+	return PR_ExecuteSwitch (s, exitdepth);
+}
+
+/*
+====================
+PR_CheckNative
+
+pr_native_check: runs f natively, then again in the interpreter from the same
+state, and reports where the globals or edicts differ. Builtins run twice, so
+this is only meant for testing; temp strings may also differ between the runs.
+====================
+*/
+static void PR_CheckNative (dfunction_t *f)
+{
+	static byte		  *saved, *native;
+	static int		   savedsize;
+	static areanode_t *areanodes; // static so a run error can't leak them
+	int				   numglobals = qcvm->progs->numglobals;
+	int				   numedicts, savededicts, nativeedicts, size, i, j, seed;
+	edict_t			  *freehead, *freetail;
+	const byte		  *a, *b;
+
+	// edicts spawned by the call are covered up to a point
+	numedicts = q_min (qcvm->num_edicts + 64, qcvm->max_edicts);
+	size = numglobals * 4 + numedicts * qcvm->edict_size;
+	if (size > savedsize)
+	{
+		Mem_Free (saved);
+		Mem_Free (native);
+		savedsize = size;
+		saved = (byte *)Mem_Alloc (savedsize);
+		native = (byte *)Mem_Alloc (savedsize);
+	}
+	if (!areanodes)
+		areanodes = (areanode_t *)Mem_Alloc (sizeof (qcvm->areanodes));
+
+	memcpy (saved, qcvm->globals, numglobals * 4);
+	memcpy (saved + numglobals * 4, qcvm->edicts, numedicts * qcvm->edict_size);
+	memcpy (areanodes, qcvm->areanodes, sizeof (qcvm->areanodes));
+	savededicts = qcvm->num_edicts;
+	freehead = qcvm->free_edicts_head;
+	freetail = qcvm->free_edicts_tail;
+	seed = rand ();
+
+	srand (seed);
+	PR_ExecuteFunction (f);
+	nativeedicts = qcvm->num_edicts;
+	if (nativeedicts > numedicts)
+		return;
+	memcpy (native, qcvm->globals, numglobals * 4);
+	memcpy (native + numglobals * 4, qcvm->edicts, numedicts * qcvm->edict_size);
+
+	memcpy (qcvm->globals, saved, numglobals * 4);
+	memcpy (qcvm->edicts, saved + numglobals * 4, numedicts * qcvm->edict_size);
+	memcpy (qcvm->areanodes, areanodes, sizeof (qcvm->areanodes));
+	qcvm->num_edicts = savededicts;
+	qcvm->free_edicts_head = freehead;
+	qcvm->free_edicts_tail = freetail;
+	ED_ResetIndex ();
+
+	srand (seed);
+	pr_nonative = true;
+	PR_ExecuteFunction (f);
+	pr_nonative = false;
+
+	if (qcvm->num_edicts != nativeedicts)
+		Con_Warning ("pr_native_check: %s spawned %i edicts natively, %i interpreted\n", PR_GetString (f->s_name), nativeedicts, qcvm->num_edicts);
+	for (i = 0; i < numglobals; i++)
+		if (memcmp (native + i * 4, (byte *)qcvm->globals + i * 4, 4))
+		{
+			Con_Warning ("pr_native_check: %s differs at global %i (%s)\n", PR_GetString (f->s_name), i, PR_GlobalStringNoContents (i));
+			break;
+		}
+	for (i = 0; i < q_min (nativeedicts, qcvm->num_edicts); i++)
+	{
+		a = native + numglobals * 4 + i * qcvm->edict_size + offsetof (edict_t, v);
+		b = (byte *)EDICT_NUM (i) + offsetof (edict_t, v);
+		for (j = 0; j < qcvm->progs->entityfields; j++)
+			if (memcmp (a + j * 4, b + j * 4, 4))
+			{
+				Con_Warning ("pr_native_check: %s differs at edict %i field %i\n", PR_GetString (f->s_name), i, j);
+				break;
+			}
+	}
+}
+
+/*
+====================
+PR_ExecuteProgram
+====================
+*/
+void PR_ExecuteProgram (func_t fnum)
+{
+	dfunction_t *f;
+	int			 exitdepth, engine, statements;
+	double		 time;
+
+	if (!fnum || fnum >= (func_t)qcvm->progs->numfunctions)
+	{
+		if (pr_global_struct->self)
+			ED_Print (PROG_TO_EDICT (pr_global_struct->self));
+		Host_Error ("PR_ExecuteProgram: NULL function");
+	}
+
+	f = &qcvm->functions[fnum];
+
+	// FIXME: if this is a builtin, then we're going to crash.
+
+	qcvm->trace = false;
+
+	if (pr_profvm == qcvm && !qcvm->depth)
+	{
+		// frames left over from a run error are dropped
+		pr_profdepth = 0;
+		pr_profoverflow = 0;
+		if (qcvm->progshash != pr_profhash)
+		{
+			Con_Printf ("QC profiling stopped, progs changed\n");
+			pr_profvm = NULL;
+			PR_ProfileFree ();
+		}
+	}
+
+	if (!qcvm->depth)
+		ED_SettleIndex ();
+
+	if (pr_native_check.value && !qcvm->depth && PR_NATIVE (fnum))
+	{
+		PR_CheckNative (f);
+		return;
+	}
+
+	// nested calls from builtins are counted but only the outermost one is timed
+	exitdepth = qcvm->depth;
+	engine = (pr_threaded.value && qcvm->tstatements) ? 1 : 0;
+	time = exitdepth ? 0.0 : Sys_DoubleTime ();
+
+	statements = PR_ExecuteFunction (f);
+
+	qcvm->profilestatements[engine] += statements;
+	if (!exitdepth)
+		qcvm->profiletime[engine] += Sys_DoubleTime () - time;
+}
@@ -400,6 +400,27 @@ static void PF_ext_vectoangles (void)
 	G_VECTOR (OFS_RETURN)[PITCH] *= -1; // this builtin is for use with models. models have an inverted pitch. consistency with makevectors would never do!
 }
 
+/*
+=================
+PR_IsPureExtBuiltin
+
+The maths extensions above, for PR_IsPureBuiltin
+=================
+*/
+qboolean PR_IsPureExtBuiltin (builtin_t func)
+{
+	static const builtin_t pure[] = {
+		PF_Sin, PF_asin, PF_Cos, PF_acos, PF_tan, PF_atan, PF_atan2, PF_Sqrt, PF_pow, PF_Logarithm,
+		PF_min, PF_max, PF_bound, PF_anglemod, PF_bitshift, PF_crossproduct, PF_vectorvectors, PF_ext_vectoangles,
+	};
+	size_t i;
+
+	for (i = 0; i < countof (pure); i++)
+		if (func == pure[i])
+			return true;
+	return false;
+}
+
 // string stuff
 static void PF_strlen (void)
 { // FIXME: doesn't try to handle utf-8
@@ -489,7 +510,7 @@ static void PF_strzone (void)
 	}
 	len++; /*for the null*/
 
-	buf = Mem_Alloc (len);
+	buf = Mem_AllocTagged (len, MEMTAG_PROGS);
 	G_INT (OFS_RETURN) = PR_SetEngineString (buf);
 	id = -1 - G_INT (OFS_RETURN);
 	if (id >= qcvm->knownzonesize)
@@ -1603,7 +1624,7 @@ static void PF_tokenizebyseparator (void)
 			if (found)
 			{
 				tlen = qctoken[qctoken_count].end - qctoken[qctoken_count].start;
-				qctoken[qctoken_count].token = Mem_Alloc (tlen + 1);
+				qctoken[qctoken_count].token = Mem_AllocTagged (tlen + 1, MEMTAG_PROGS);
 				memcpy (qctoken[qctoken_count].token, start + qctoken[qctoken_count].start, tlen);
 				qctoken[qctoken_count].token[tlen] = 0;
 
@@ -2423,6 +2444,7 @@ static void PF_spawnclient (void)
 				ent->v.colormap = NUM_FOR_EDICT (ent);
 				ent->v.team = (svs.clients[i].colors & 15) + 1;
 				ent->v.netname = PR_SetEngineString (svs.clients[i].name);
+				ED_UpdateIndex (ent);
 				RETURN_EDICT (ent);
 				return;
 			}
@@ -3150,7 +3172,7 @@ static void PF_buf_copy (void)
 
 	// copy new data over.
 	strbuflist[bufto].used = strbuflist[bufto].allocated = strbuflist[buffrom].used;
-	strbuflist[bufto].strings = Mem_Alloc (strbuflist[buffrom].used * sizeof (char *));
+	strbuflist[bufto].strings = Mem_AllocTagged (strbuflist[buffrom].used * sizeof (char *), MEMTAG_PROGS);
 	for (i = 0; i < strbuflist[buffrom].used; i++)
 		strbuflist[bufto].strings[i] = strbuflist[buffrom].strings[i] ? q_strdup (strbuflist[buffrom].strings[i]) : NULL;
 }
@@ -3314,7 +3336,7 @@ static void PF_bufstr_set (void)
 	}
 	if (strbuflist[bufno].strings[index])
 		Mem_Free (strbuflist[bufno].strings[index]);
-	strbuflist[bufno].strings[index] = Mem_Alloc (strlen (string) + 1);
+	strbuflist[bufno].strings[index] = Mem_AllocTagged (strlen (string) + 1, MEMTAG_PROGS);
 	strcpy (strbuflist[bufno].strings[index], string);
 
 	if (index >= strbuflist[bufno].used)
@@ -3350,7 +3372,7 @@ static int PF_bufstr_add_internal (unsigned int bufno, const char *string, int a
 	// add in the new string.
 	if (strbuflist[bufno].strings[index])
 		Mem_Free (strbuflist[bufno].strings[index]);
-	strbuflist[bufno].strings[index] = Mem_Alloc (strlen (string) + 1);
+	strbuflist[bufno].strings[index] = Mem_AllocTagged (strlen (string) + 1, MEMTAG_PROGS);
 	strcpy (strbuflist[bufno].strings[index], string);
 
 	if (index >= strbuflist[bufno].used)
@@ -3459,7 +3481,7 @@ static void PF_findchain (void)
 {
 	edict_t	   *ent, *chain;
 	int			i, f;
-	const char *s, *t;
+	const char *s;
 	int			cfld;
 
 	chain = (edict_t *)qcvm->edicts;
@@ -3472,14 +3494,12 @@ static void PF_findchain (void)
 	else
 		cfld = &ent->v.chain - (int *)&ent->v;
 
-	for (i = 1; i < qcvm->num_edicts; i++, ent = NEXT_EDICT (ent))
+	for (i = ED_FindString (0, f, s); i; i = ED_FindString (i, f, s))
 	{
-		if (ent->free)
-			continue;
-		t = E_STRING (ent, f);
-		if (strcmp (s, t))
-			continue;
+		ent = EDICT_NUM (i);
 		((int *)&ent->v)[cfld] = EDICT_TO_PROG (chain);
+		if (ED_IndexedField (cfld))
+			ED_UpdateIndex (ent);
 		chain = ent;
 	}
 
@@ -3536,6 +3556,8 @@ static void PF_findchainfloat (void)
 		if (s != t)
 			continue;
 		((int *)&ent->v)[cfld] = EDICT_TO_PROG (chain);
+		if (ED_IndexedField (cfld))
+			ED_UpdateIndex (ent);
 		chain = ent;
 	}
 
@@ -3592,6 +3614,8 @@ static void PF_findchainflags (void)
 		if (!(s & t))
 			continue;
 		((int *)&ent->v)[cfld] = EDICT_TO_PROG (chain);
+		if (ED_IndexedField (cfld))
+			ED_UpdateIndex (ent);
 		chain = ent;
 	}
 
@@ -3653,7 +3677,10 @@ static void PF_putentfldstr (void)
 	edict_t		*ent = G_EDICT (OFS_PARM1);
 	const char	*value = G_STRING (OFS_PARM2);
 	if (fldidx < (unsigned int)qcvm->progs->numfielddefs)
+	{
 		G_FLOAT (OFS_RETURN) = ED_ParseEpair ((void *)&ent->v, qcvm->fielddefs + fldidx, value, true);
+		ED_UpdateIndex (ent);
+	}
 	else
 		G_FLOAT (OFS_RETURN) = false;
 }
@@ -5988,6 +6015,7 @@ void PR_DumpPlatform_f (void)
 		fprintf (f, "const float CONTENT_SKY = %i;\n", CONTENTS_SKY);
 
 		fprintf (f, "__used var float physics_mode = 2;\n");
+		fprintf (f, "__used var float parallel_thinks = 0; // 1 if thinks that fall due in the same frame don't depend on each other, see sv_parallelthinks\n");
 
 		fprintf (f, "const float TE_SPIKE = %i;\n", TE_SPIKE);
 		fprintf (f, "const float TE_SUPERSPIKE = %i;\n", TE_SUPERSPIKE);
@@ -6275,4 +6303,5 @@ void PR_DumpPlatform_f (void)
 	fprintf (f, "\n\n//Reset this back to normal.\n");
 	fprintf (f, "#pragma noref 0\n");
 	fclose (f);
+	COM_FlushDirectoryCache ();
 }
@@ -23,6 +23,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #ifndef _QUAKE_PROGS_H
 #define _QUAKE_PROGS_H
 
+#include <setjmp.h>
+
 #include "pr_comp.h"  /* defs shared with qcc */
 #include "progdefs.h" /* generated by program cdefs */
 
@@ -77,6 +79,8 @@ typedef struct qcvm_s qcvm_t;
 void PR_Init (void);
 
 void	 PR_ExecuteProgram (func_t fnum);
+void	 PR_TranslateProgs (void); // builds the threaded interpreter's statements and loads native code
+void	 PR_FreeTranslation (void);
 void	 PR_ClearProgs (qcvm_t *vm);
 qboolean PR_LoadProgs (const char *filename, qboolean fatal, unsigned int needcrc, const builtin_t *builtins, size_t numbuiltins);
 
@@ -108,10 +112,55 @@ void		PR_ClearEdictStrings ();
 void		PR_ClearEngineString (int num);
 
 void PR_Profile_f (void);
+void PR_ProfStart_f (void);
+void PR_ProfStop_f (void);
+#ifdef _DEBUG
+void TestEngineStrings_f (void);
+#endif
 
 edict_t *ED_Alloc (void);
 void	 ED_Free (edict_t *ed);
 
+// entvars_t fields the entity search index in pr_edict.c is built from
+#define ED_FIELD(name) ((int)(offsetof (entvars_t, name) / 4))
+static inline qboolean ED_IndexedField (int field)
+{
+	// STOREP_V through a pointer to field writes field + 2 as well
+	return (unsigned int)(field - ED_FIELD (origin) + 2) < 5 || (unsigned int)(field - ED_FIELD (mins) + 2) < 8 ||
+		   (unsigned int)(field - ED_FIELD (classname) + 2) < 3 || (unsigned int)(field - ED_FIELD (targetname) + 2) < 3;
+}
+
+// fields the hot field mirror in pr_edict.c copies or SV_Physics' skips depend on
+static inline qboolean ED_HotField (int field)
+{
+	return (unsigned int)(field - ED_FIELD (modelindex) + 2) < 3 || (unsigned int)(field - ED_FIELD (movetype) + 2) < 3 ||
+		   (unsigned int)(field - ED_FIELD (frame) + 2) < 3 || (unsigned int)(field - ED_FIELD (nextthink) + 2) < 3 ||
+		   (unsigned int)(field - ED_FIELD (flags) + 2) < 3;
+}
+
+// struct of arrays copy of what SV_Physics and the entity sweeps decide their skips on, one row per edict
+typedef struct edhot_s
+{
+	int	   max_edicts;
+	float *nextthink; // 0 for free edicts
+	float *modelindex;
+	byte  *still; // free, or movetype and flags leave SV_Physics nothing to do but think
+	byte  *stale; // the edict may have changed since its row was copied
+	byte  *idle;  // scratch for SV_Physics
+} edhot_t;
+
+void ED_UpdateIndex (edict_t *ed);
+void ED_FieldAddressed (edict_t *ed, int field);
+void ED_SettleIndex (void);
+void ED_ResetIndex (void);
+void ED_StringReleased (int num);
+int	 ED_FindString (int start, int field, const char *s);
+int	 ED_FindRadius (const float *org, float rad, int **candidates);
+
+void	 ED_HotStale (edict_t *ed);
+void	 ED_ResetHot (void);
+edhot_t *ED_GetHot (void);
+
 void		ED_Print (edict_t *ed);
 void		ED_Write (FILE *f, edict_t *ed);
 const char *ED_ParseEdict (const char *data, edict_t *ent);
@@ -159,6 +208,7 @@ int		 NUM_FOR_EDICT (edict_t *e);
 
 FUNC_NORETURN void PR_RunError (const char *error, ...) FUNC_PRINTF (1, 2);
 void			   PR_RunWarning (const char *error, ...) FUNC_PRINTF (1, 2);
+FUNC_NORETURN void PR_SandboxAbort (void);
 
 void ED_PrintEdicts (void);
 void ED_PrintNum (int ent);
@@ -178,6 +228,10 @@ char	  *PF_VarString (int first);
 #define STRINGTEMP_LENGTH  1024
 void PF_Fixme (void); // the 'unimplemented' builtin. woot.
 
+// builtins that only read their parms and write OFS_RETURN or the v_ vectors, a sandboxed vm may call them
+qboolean PR_IsPureBuiltin (builtin_t func);
+qboolean PR_IsPureExtBuiltin (builtin_t func);
+
 struct pr_extfuncs_s
 {
 /*all vms*/
@@ -211,6 +265,10 @@ struct pr_extfuncs_s
 #undef QCEXTFUNC
 };
 extern cvar_t pr_checkextension; // if 0, extensions are disabled (unless they'd be fatal, but they're still spammy)
+extern cvar_t pr_threaded;		 // if 0, the classic switch interpreter is used
+extern cvar_t pr_native_check;	 // if 1, every call runs natively and interpreted and the results are compared
+extern cvar_t pr_findindex;		 // if 0, find and findradius scan every edict, 2 checks the index on every search
+extern cvar_t pr_edictmirror;	 // if 1, the server sweeps skip idle edicts from the hot field mirror, 2 checks it every frame
 
 struct pr_extglobals_s
 {
@@ -230,6 +288,7 @@ struct pr_extglobals_s
 	QCEXTGLOBAL_VECTOR (input_cursor_trace_endpos) \
 	QCEXTGLOBAL_FLOAT (input_cursor_entitynumber)  \
 	QCEXTGLOBAL_FLOAT (physics_mode)               \
+	QCEXTGLOBAL_FLOAT (parallel_thinks)            \
 	// end
 #define QCEXTGLOBALS_CSQC                  \
 	QCEXTGLOBAL_FLOAT (cltime)             \
@@ -318,6 +377,10 @@ typedef struct areanode_s
 
 typedef struct hash_map_s hash_map_t;
 
+// natively compiled QC function, see PR_TranslateProgs
+struct prnativeapi_s;
+typedef void (*prnative_t) (const struct prnativeapi_s *api, eval_t *globals, byte *edicts);
+
 struct qcvm_s
 {
 	dprograms_t	 *progs;
@@ -339,6 +402,16 @@ struct qcvm_s
 	dfunction_t *xfunction;
 	int			 xstatement;
 
+	// statements pre-translated for the threaded interpreter, same indices as statements
+	struct prtstatement_s *tstatements;
+	// native code per function from the -qcnative cache, NULL where the interpreter runs
+	prnative_t			  *natives;
+	void				   *nativelib;
+
+	// statement throughput for the profile command, [0] switch and [1] threaded interpreter
+	uint64_t profilestatements[2];
+	double	 profiletime[2];
+
 	unsigned short progscrc;  // crc16 of the entire file
 	unsigned int   progshash; // folded file md4
 	unsigned int   progssize; // file size (bytes)
@@ -352,6 +425,7 @@ struct qcvm_s
 	int			 stringssize;
 	const char **knownstrings;
 	qboolean	*knownstringsowned;
+	hash_map_t	*knownstrings_map; // string pointer -> knownstrings index
 	int			 maxknownstrings;
 	int			 numknownstrings;
 	int			 progsstrings; // allocated by PR_MergeEngineFieldDefs (), not tied to edicts
@@ -386,10 +460,19 @@ struct qcvm_s
 	// originally from world.c
 	areanode_t areanodes[AREA_NODES];
 	int		   numareanodes;
+
+	// find and findradius acceleration, server progs only
+	struct edindex_s *findindex;
+	edhot_t			 *hot; // pr_edictmirror, server progs only
+
+	// sv_parallelthinks worker copies of the server progs
+	byte	*written; // edicts that OP_ADDRESS or OP_STATE gave the running code access to
+	jmp_buf *sandbox; // run errors and non-pure builtins longjmp here, see PR_SandboxAbort
 };
-extern globalvars_t *pr_global_struct;
+// thread local so sv_parallelthinks workers can run their own copies of the server progs
+extern THREAD_LOCAL globalvars_t *pr_global_struct;
 
-extern qcvm_t *qcvm;
+extern THREAD_LOCAL qcvm_t *qcvm;
 void		   PR_SwitchQCVM (qcvm_t *nvm);
 
 extern const builtin_t pr_ssqcbuiltins[];
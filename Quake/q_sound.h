@@ -182,8 +182,9 @@ extern cvar_t bgmvolume;
 
 void		S_LocalSound (const char *name);
 sfxcache_t *S_LoadSound (sfx_t *s);
+void		S_InsertSoundCache (const char *name, sfxcache_t *sc);
 
-wavinfo_t GetWavinfo (const char *name, byte *wav, int wavlength);
+wavinfo_t GetWavinfo (const char *name, const byte *wav, int wavlength);
 
 void SND_InitScaletable (void);
 
@@ -1161,7 +1161,7 @@ static void BuildSurfaceDisplayList (msurface_t *fa)
 	//
 	// draw texture
 	//
-	poly = (glpoly_t *)Mem_Alloc (sizeof (glpoly_t) + (lnumverts - 4) * VERTEXSIZE * sizeof (float));
+	poly = (glpoly_t *)Mem_LevelAlloc (sizeof (glpoly_t) + (lnumverts - 4) * VERTEXSIZE * sizeof (float), MEMTAG_MODEL);
 	poly->next = fa->polys;
 	fa->polys = poly;
 	poly->numverts = lnumverts;
@@ -2503,12 +2503,12 @@ GL_PrepareSIMDData
 */
 void GL_PrepareSIMDAndParallelData (void)
 {
-	cl.worldmodel->surfvis = Mem_Alloc (((cl.worldmodel->numsurfaces + 31) / 8));
+	cl.worldmodel->surfvis = Mem_LevelAlloc (((cl.worldmodel->numsurfaces + 31) / 8), MEMTAG_MODEL);
 #ifdef USE_SIMD
 	int i;
 
-	cl.worldmodel->soa_leafbounds = Mem_Alloc (6 * sizeof (float) * ((cl.worldmodel->numleafs + 31) & ~7));
-	cl.worldmodel->soa_surfplanes = Mem_Alloc (4 * sizeof (float) * ((cl.worldmodel->numsurfaces + 31) & ~7));
+	cl.worldmodel->soa_leafbounds = Mem_LevelAlloc (6 * sizeof (float) * ((cl.worldmodel->numleafs + 31) & ~7), MEMTAG_MODEL);
+	cl.worldmodel->soa_surfplanes = Mem_LevelAlloc (4 * sizeof (float) * ((cl.worldmodel->numsurfaces + 31) & ~7), MEMTAG_MODEL);
 
 	for (i = 0; i < cl.worldmodel->numleafs; ++i)
 	{
@@ -848,7 +848,7 @@ static void				   PScript_AssociateEffect_f (void)
 	}
 	if (!ae)
 	{
-		ae = Mem_Alloc (sizeof (*ae));
+		ae = Mem_AllocTagged (sizeof (*ae), MEMTAG_PARTICLES);
 		strcpy (ae->mname, modelname);
 		ae->next = associatedeffect;
 		associatedeffect = ae;
@@ -895,7 +895,7 @@ static void P_PartRedirect_f (void)
 	// create a new entry.
 	if (*to && q_strcasecmp (from, to))
 	{
-		l = Mem_Alloc (sizeof (*l) + strlen (from) + strlen (to) + 2);
+		l = Mem_AllocTagged (sizeof (*l) + strlen (from) + strlen (to) + 2, MEMTAG_PARTICLES);
 		l->from = (char *)(l + 1);
 		strcpy ((char *)l->from, from);
 		l->to = l->from + strlen (l->from) + 1;
@@ -1013,12 +1013,12 @@ static void PScript_RetintEffect (part_type_t *to, part_type_t *from, const char
 	// make sure 'to' has its own copy of any lists, so that we don't have issues when freeing this memory again.
 	if (to->sounds)
 	{
-		to->sounds = Mem_Alloc (to->numsounds * sizeof (*to->sounds));
+		to->sounds = Mem_AllocTagged (to->numsounds * sizeof (*to->sounds), MEMTAG_PARTICLES);
 		memcpy (to->sounds, from->sounds, to->numsounds * sizeof (*to->sounds));
 	}
 	if (to->ramp)
 	{
-		to->ramp = Mem_Alloc (to->rampindexes * sizeof (*to->ramp));
+		to->ramp = Mem_AllocTagged (to->rampindexes * sizeof (*to->ramp), MEMTAG_PARTICLES);
 		memcpy (to->ramp, from->ramp, to->rampindexes * sizeof (*to->ramp));
 	}
 
@@ -1628,7 +1628,7 @@ reparse:
 			if (*buf == '{')
 			{
 				int	  nest = 1;
-				char *str = Mem_Alloc (3);
+				char *str = Mem_AllocTagged (3, MEMTAG_PARTICLES);
 				int	  slen = 2;
 				str[0] = '{';
 				str[1] = '\n';
@@ -3388,13 +3388,13 @@ qboolean PScript_Startup (void)
 		r_numbeams = MAX_BEAMSEGS;
 		r_numtrailstates = MAX_TRAILSTATES;
 
-		particles = (particle_t *)Mem_Alloc (r_numparticles * sizeof (particle_t));
+		particles = (particle_t *)Mem_AllocTagged (r_numparticles * sizeof (particle_t), MEMTAG_PARTICLES);
 
-		beams = (beamseg_t *)Mem_Alloc (r_numbeams * sizeof (beamseg_t));
+		beams = (beamseg_t *)Mem_AllocTagged (r_numbeams * sizeof (beamseg_t), MEMTAG_PARTICLES);
 
-		decals = (clippeddecal_t *)Mem_Alloc (r_numdecals * sizeof (clippeddecal_t));
+		decals = (clippeddecal_t *)Mem_AllocTagged (r_numdecals * sizeof (clippeddecal_t), MEMTAG_PARTICLES);
 
-		trailstates = (trailstate_t *)Mem_Alloc (r_numtrailstates * sizeof (trailstate_t));
+		trailstates = (trailstate_t *)Mem_AllocTagged (r_numtrailstates * sizeof (trailstate_t), MEMTAG_PARTICLES);
 		memset (trailstates, 0, r_numtrailstates * sizeof (trailstate_t));
 		ts_cycle = 0;
 
@@ -3425,7 +3425,7 @@ void PScript_RecalculateSkyTris (void)
 			char		key[128];
 			const char *data = COM_Parse (m->entities);
 			int		   *remaps;
-			remaps = Mem_Alloc (sizeof (*remaps) * m->numtextures);
+			remaps = Mem_AllocTagged (sizeof (*remaps) * m->numtextures, MEMTAG_PARTICLES);
 			if (!remaps)
 				break;
 			for (t = 0; t < m->numtextures; t++)
@@ -3552,7 +3552,7 @@ static qboolean P_LoadParticleSet (char *name, qboolean implicit, qboolean showw
 		if (!strcmp (cfg->name, name))
 			return false;
 	}
-	cfg = Mem_Alloc (sizeof (*cfg) + strlen (name));
+	cfg = Mem_AllocTagged (sizeof (*cfg) + strlen (name), MEMTAG_PARTICLES);
 	if (!cfg)
 		return false;
 	strcpy (cfg->name, name);
@@ -3724,7 +3724,7 @@ static void R_Part_SkyTri (qmodel_t *mod, float *v1, float *v2, float *v3, msurf
 	skytriblock_t *mem = mod->skytrimem;
 	if (!mem || mem->count == countof (mem->tris))
 	{
-		mod->skytrimem = Mem_Alloc (sizeof (*mod->skytrimem));
+		mod->skytrimem = Mem_AllocTagged (sizeof (*mod->skytrimem), MEMTAG_PARTICLES);
 		mod->skytrimem->next = mem;
 		mod->skytrimem->count = 0;
 		mem = mod->skytrimem;
@@ -347,6 +347,9 @@ void SV_ClientPrintf (const char *fmt, ...) FUNC_PRINTF (1, 2);
 void SV_BroadcastPrintf (const char *fmt, ...) FUNC_PRINTF (1, 2);
 
 void SV_Physics (void);
+#ifdef _DEBUG
+void TestEdictMirror_f (void);
+#endif
 
 qboolean SV_CheckBottom (edict_t *ent);
 qboolean SV_movestep (edict_t *ent, vec3_t move, qboolean relink);
@@ -360,5 +363,9 @@ void SV_CheckForNewClients (void);
 void SV_RunClients (void);
 void SV_SaveSpawnparms ();
 void SV_SpawnServer (const char *server);
+void SV_PrefetchMap (const char *map);
+void SV_PrefetchNextMap (void);
+void SV_PrefetchFrame (void);
+void SV_CancelPrefetch (void);
 
 #endif /* _QUAKE_SERVER_H */
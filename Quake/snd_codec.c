@@ -306,7 +306,7 @@ snd_stream_t *S_CodecUtilOpen (const char *filename, snd_codec_t *codec, qboolea
 	}
 
 	/* Allocate a stream, Mem_Alloc zeroes its content */
-	stream = (snd_stream_t *)Mem_Alloc (sizeof (snd_stream_t));
+	stream = (snd_stream_t *)Mem_AllocTagged (sizeof (snd_stream_t), MEMTAG_SOUND);
 	stream->codec = codec;
 	stream->loop = loop;
 	stream->fh.file = handle;
@@ -214,7 +214,7 @@ void S_Init (void)
 
 	SND_InitScaletable ();
 	// allocate twice the max sounds to be able to cache enough...
-	known_sfx = (sfx_t *)Mem_Alloc ((MAX_SFX * 2) * sizeof (sfx_t));
+	known_sfx = (sfx_t *)Mem_AllocTagged ((MAX_SFX * 2) * sizeof (sfx_t), MEMTAG_SOUND);
 	num_sfx = 0;
 
 	snd_initialized = true;
@@ -350,6 +350,35 @@ sfx_t *S_PrecacheSound (const char *name)
 	return sfx;
 }
 
+/*
+==================
+S_InsertSoundCache
+
+Takes over a cache that S_LoadSound filled in for a
+private sfx_t, e.g. on a task worker, freeing it if
+the sound got loaded in the meantime
+==================
+*/
+void S_InsertSoundCache (const char *name, sfxcache_t *sc)
+{
+	sfx_t *sfx;
+
+	if (!sound_started || nosound.value)
+	{
+		Mem_Free (sc);
+		return;
+	}
+
+	sfx = S_FindName (name);
+
+	SDL_LockMutex (snd_mutex);
+	if (sfx->cache)
+		Mem_Free (sc);
+	else
+		sfx->cache = sc;
+	SDL_UnlockMutex (snd_mutex);
+}
+
 //=============================================================================
 
 /*
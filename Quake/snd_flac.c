@@ -139,7 +139,7 @@ flac_write_func (const FLAC__StreamDecoder *decoder, const FLAC__Frame *frame, c
 
 	if (!ff->buffer)
 	{
-		ff->buffer = (byte *)Mem_Alloc (ff->info->blocksize * ff->info->channels * ff->info->width);
+		ff->buffer = (byte *)Mem_AllocTagged (ff->info->blocksize * ff->info->channels * ff->info->width, MEMTAG_SOUND);
 		if (!ff->buffer)
 		{
 			ff->error = -1; /* needn't set this here, but... */
@@ -225,7 +225,7 @@ static qboolean S_FLAC_CodecOpenStream (snd_stream_t *stream)
 	flacfile_t *ff;
 	int			rc;
 
-	ff = (flacfile_t *)Mem_Alloc (sizeof (flacfile_t));
+	ff = (flacfile_t *)Mem_AllocTagged (sizeof (flacfile_t), MEMTAG_SOUND);
 
 	ff->decoder = FLAC__stream_decoder_new ();
 	if (ff->decoder == NULL)
@@ -29,14 +29,13 @@ extern SDL_mutex *snd_mutex;
 ResampleSfx
 ================
 */
-static void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
+static void ResampleSfx (sfxcache_t *sc, int inrate, int inwidth, const byte *data)
 {
-	int			outcount;
-	int			srcsample;
-	float		stepscale;
-	int			i;
-	int			sample, samplefrac, fracstep;
-	sfxcache_t *sc = sfx->cache;
+	int	  outcount;
+	int	  srcsample;
+	float stepscale;
+	int	  i;
+	int	  sample, samplefrac, fracstep;
 
 	stepscale = (float)inrate / shm->speed; // this is usually 0.5, 1, or 2
 
@@ -70,7 +69,7 @@ static void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 			srcsample = samplefrac >> 8;
 			samplefrac += fracstep;
 			if (inwidth == 2)
-				sample = LittleShort (((short *)data)[srcsample]);
+				sample = LittleShort (((const short *)data)[srcsample]);
 			else
 				sample = (unsigned int)((unsigned char)(data[srcsample]) - 128) << 8;
 			if (sc->width == 2)
@@ -86,25 +85,26 @@ static void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 /*
 ==============
 S_LoadSound
+
+The mutex is only held to check and publish s->cache,
+so task workers can load different sounds concurrently.
 ==============
 */
 sfxcache_t *S_LoadSound (sfx_t *s)
 {
 	char		namebuffer[256];
-	byte	   *data = NULL;
+	const byte *data = NULL;
 	wavinfo_t	info;
-	int			len;
+	int			len, filesize;
 	float		stepscale;
 	sfxcache_t *sc = NULL;
 
-	SDL_LockMutex (snd_mutex);
-
 	// see if still in memory
-	if (s->cache)
-	{
-		sc = s->cache;
-		goto unlock_mutex;
-	}
+	SDL_LockMutex (snd_mutex);
+	sc = s->cache;
+	SDL_UnlockMutex (snd_mutex);
+	if (sc)
+		return sc;
 
 	//	Con_Printf ("S_LoadSound: %x\n", (int)stackbuf);
 
@@ -114,25 +114,25 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 
 	//	Con_Printf ("loading %s\n",namebuffer);
 
-	data = COM_LoadFile (namebuffer, NULL);
+	data = COM_MapFile (namebuffer, &filesize, NULL);
 
 	if (!data)
 	{
 		Con_Printf ("Couldn't load %s\n", namebuffer);
-		goto unlock_mutex;
+		goto done;
 	}
 
-	info = GetWavinfo (s->name, data, com_filesize);
+	info = GetWavinfo (s->name, data, filesize);
 	if (info.channels != 1)
 	{
 		Con_Printf ("%s is a stereo sample\n", s->name);
-		goto unlock_mutex;
+		goto done;
 	}
 
 	if (info.width != 1 && info.width != 2)
 	{
 		Con_Printf ("%s is not 8 or 16 bit\n", s->name);
-		goto unlock_mutex;
+		goto done;
 	}
 
 	stepscale = (float)info.rate / shm->speed;
@@ -143,24 +143,33 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	if (info.samples == 0 || len == 0)
 	{
 		Con_Printf ("%s has zero samples\n", s->name);
-		goto unlock_mutex;
+		goto done;
 	}
 
-	sc = (sfxcache_t *)Mem_Alloc (len + sizeof (sfxcache_t));
+	sc = (sfxcache_t *)Mem_AllocTagged (len + sizeof (sfxcache_t), MEMTAG_SOUND);
 	if (!sc)
-		goto unlock_mutex;
+		goto done;
 	sc->length = info.samples;
 	sc->loopstart = info.loopstart;
 	sc->speed = info.rate;
 	sc->width = info.width;
 	sc->stereo = info.channels;
 
-	s->cache = sc;
-	ResampleSfx (s, sc->speed, sc->width, data + info.dataofs);
+	ResampleSfx (sc, sc->speed, sc->width, data + info.dataofs);
 
-unlock_mutex:
-	Mem_Free (data);
+	SDL_LockMutex (snd_mutex);
+	if (s->cache)
+	{
+		// another thread got there first
+		Mem_Free (sc);
+		sc = s->cache;
+	}
+	else
+		s->cache = sc;
 	SDL_UnlockMutex (snd_mutex);
+
+done:
+	COM_UnmapFile (data);
 	return sc;
 }
 
@@ -172,11 +181,12 @@ WAV loading
 ===============================================================================
 */
 
-static byte *data_p;
-static byte *iff_end;
-static byte *last_chunk;
-static byte *iff_data;
-static int	 iff_chunk_len;
+// thread local so sounds can be parsed on several task workers
+static THREAD_LOCAL const byte *data_p;
+static THREAD_LOCAL const byte *iff_end;
+static THREAD_LOCAL const byte *last_chunk;
+static THREAD_LOCAL const byte *iff_data;
+static THREAD_LOCAL int			iff_chunk_len;
 
 static short GetLittleShort (void)
 {
@@ -219,7 +229,7 @@ static void FindNextChunk (const char *name)
 		}
 		last_chunk = data_p + ((iff_chunk_len + 1) & ~1);
 		data_p -= 8;
-		if (!strncmp ((char *)data_p, name, 4))
+		if (!strncmp ((const char *)data_p, name, 4))
 			return;
 	}
 }
@@ -253,7 +263,7 @@ static void DumpChunks (void)
 GetWavinfo
 ============
 */
-wavinfo_t GetWavinfo (const char *name, byte *wav, int wavlength)
+wavinfo_t GetWavinfo (const char *name, const byte *wav, int wavlength)
 {
 	wavinfo_t info;
 	int		  i;
@@ -270,7 +280,7 @@ wavinfo_t GetWavinfo (const char *name, byte *wav, int wavlength)
 
 	// find "RIFF" chunk
 	FindChunk ("RIFF");
-	if (!(data_p && !strncmp ((char *)data_p + 8, "WAVE", 4)))
+	if (!(data_p && !strncmp ((const char *)data_p + 8, "WAVE", 4)))
 	{
 		Con_Printf ("%s missing RIFF/WAVE chunks\n", name);
 		return info;
@@ -316,7 +326,7 @@ wavinfo_t GetWavinfo (const char *name, byte *wav, int wavlength)
 		FindNextChunk ("LIST");
 		if (data_p)
 		{
-			if (!strncmp ((char *)data_p + 28, "mark", 4))
+			if (!strncmp ((const char *)data_p + 28, "mark", 4))
 			{ // this is not a proper parse, but it works with cooledit...
 				data_p += 24;
 				i = GetLittleLong (); // samples in loop
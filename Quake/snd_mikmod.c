@@ -134,7 +134,7 @@ static qboolean S_MIKMOD_CodecOpenStream (snd_stream_t *stream)
 {
 	mik_priv_t *priv;
 
-	stream->priv = Mem_Alloc (sizeof (mik_priv_t));
+	stream->priv = Mem_AllocTagged (sizeof (mik_priv_t), MEMTAG_SOUND);
 	priv = (mik_priv_t *)stream->priv;
 	priv->Seek = MIK_Seek;
 	priv->Tell = MIK_Tell;
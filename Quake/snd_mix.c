@@ -218,8 +218,8 @@ static void S_UpdateFilter (filter_t *filter, int M, float f_c)
 		filter->parity = 0;
 		// M + 1 rounded up to the next multiple of 16
 		filter->kernelsize = (M + 1) + 16 - ((M + 1) % 16);
-		filter->memory = (float *)Mem_Alloc (filter->kernelsize * sizeof (float));
-		filter->kernel = (float *)Mem_Alloc (filter->kernelsize * sizeof (float));
+		filter->memory = (float *)Mem_AllocTagged (filter->kernelsize * sizeof (float), MEMTAG_SOUND);
+		filter->kernel = (float *)Mem_AllocTagged (filter->kernelsize * sizeof (float), MEMTAG_SOUND);
 
 		S_MakeBlackmanWindowKernel (filter->kernel, M, f_c);
 	}
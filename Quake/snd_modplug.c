@@ -63,7 +63,7 @@ static qboolean S_MODPLUG_CodecOpenStream (snd_stream_t *stream)
 	long  len;
 
 	len = FS_filelength (&stream->fh);
-	moddata = (byte *)Mem_Alloc (len);
+	moddata = (byte *)Mem_AllocTagged (len, MEMTAG_SOUND);
 	FS_fread (moddata, 1, len, &stream->fh);
 
 	S_MODPLUG_SetSettings (stream);
@@ -384,7 +384,7 @@ static qboolean S_MP3_CodecOpenStream (snd_stream_t *stream)
 		return false;
 	}
 
-	stream->priv = Mem_Alloc (sizeof (mp3_priv_t));
+	stream->priv = Mem_AllocTagged (sizeof (mp3_priv_t), MEMTAG_SOUND);
 	if (!stream->priv)
 	{
 		Con_Printf ("Insufficient memory for MP3 audio\n");
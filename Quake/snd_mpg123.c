@@ -91,7 +91,7 @@ static qboolean S_MP3_CodecOpenStream (snd_stream_t *stream)
 		return false;
 	}
 
-	stream->priv = Mem_Alloc (sizeof (mp3_priv_t));
+	stream->priv = Mem_AllocTagged (sizeof (mp3_priv_t), MEMTAG_SOUND);
 	priv = (mp3_priv_t *)stream->priv;
 	priv->handle = mpg123_new (NULL, NULL);
 	if (priv->handle == NULL)
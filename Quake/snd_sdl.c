@@ -137,7 +137,7 @@ qboolean SNDDMA_Init (dma_t *dma)
 	buffersize = shm->samples * (shm->samplebits / 8);
 	Con_Printf ("SDL audio driver: %s, %d bytes buffer\n", drivername, buffersize);
 
-	shm->buffer = (unsigned char *)Mem_Alloc (buffersize);
+	shm->buffer = (unsigned char *)Mem_AllocTagged (buffersize, MEMTAG_SOUND);
 	if (!shm->buffer)
 	{
 		SDL_CloseAudio ();
@@ -75,7 +75,7 @@ static qboolean S_VORBIS_CodecOpenStream (snd_stream_t *stream)
 	long			numstreams;
 	int				res;
 
-	ovFile = (OggVorbis_File *)Mem_Alloc (sizeof (OggVorbis_File));
+	ovFile = (OggVorbis_File *)Mem_AllocTagged (sizeof (OggVorbis_File), MEMTAG_SOUND);
 	stream->priv = ovFile;
 	res = ov_open_callbacks (&stream->fh, ovFile, NULL, 0, ovc_qfs);
 	if (res != 0)
@@ -85,7 +85,7 @@ static qboolean S_XMP_CodecOpenStream (snd_stream_t *stream)
 	}
 #else
 	len = FS_filelength (&stream->fh);
-	moddata = (byte *)Mem_Alloc (len);
+	moddata = (byte *)Mem_AllocTagged (len, MEMTAG_SOUND);
 	FS_fread (moddata, 1, len, &stream->fh);
 	if (xmp_load_module_from_memory (c, moddata, len) < 0)
 	{
@@ -37,6 +37,9 @@ unsigned int sv_protocol_pext2 = PEXT2_SUPPORTED_SERVER; // spike
 
 static cvar_t sv_netsort = {"sv_netsort", "1", CVAR_NONE};
 static cvar_t sv_smoothplatformlerps = {"sv_smoothplatformlerps", "1", CVAR_NONE};
+static cvar_t sv_prefetch = {"sv_prefetch", "1", CVAR_ARCHIVE};
+
+static void SV_Prefetch_f (void);
 
 /*
 =============
@@ -882,6 +885,7 @@ static void SVFTE_BuildSnapshotForClient (client_t *client)
 	unsigned int  maxentities = client->limit_entities;
 	edict_t		 *clent = client->edict;
 	unsigned char eflags;
+	edhot_t		 *hot = qcvm->hot;
 
 	struct entity_num_state_s *ents = snapshot_entstate;
 	size_t					   numents = 0;
@@ -901,6 +905,10 @@ static void SVFTE_BuildSnapshotForClient (client_t *client)
 		eflags = 0;
 		if (ent != clent) // clent is ALLWAYS sent
 		{
+			// the mirror can tell there's no model without loading the edict
+			if (hot && !hot->stale[e] && !hot->modelindex[e])
+				continue;
+
 			// ignore ents without visible models
 			if ((!ent->v.modelindex || !PR_GetString (ent->v.model)[0]))
 			{
@@ -1134,6 +1142,7 @@ void SV_Init (void)
 	extern cvar_t sv_freezenonclients;
 	extern cvar_t sv_gameplayfix_spawnbeforethinks;
 	extern cvar_t sv_gameplayfix_bouncedownslopes;
+	extern cvar_t sv_parallelthinks;
 	extern cvar_t sv_friction;
 	extern cvar_t sv_edgefriction;
 	extern cvar_t sv_stopspeed;
@@ -1159,12 +1168,15 @@ void SV_Init (void)
 	Cvar_RegisterVariable (&sv_freezenonclients);
 	Cvar_RegisterVariable (&sv_gameplayfix_spawnbeforethinks);
 	Cvar_RegisterVariable (&sv_gameplayfix_bouncedownslopes);
+	Cvar_RegisterVariable (&sv_parallelthinks);
 	Cvar_RegisterVariable (&pr_checkextension);
 	Cvar_RegisterVariable (&sv_altnoclip); // johnfitz
 	Cvar_RegisterVariable (&sv_netsort);
 	Cvar_RegisterVariable (&sv_smoothplatformlerps);
+	Cvar_RegisterVariable (&sv_prefetch);
 
 	Cmd_AddCommand ("pext", SV_Pext_f);
+	Cmd_AddCommand ("prefetch", SV_Prefetch_f);
 	Cmd_AddCommand ("sv_protocol", &SV_Protocol_f); // johnfitz
 
 	for (i = 0; i < MAX_MODELS; i++)
@@ -2012,6 +2024,7 @@ void SV_WriteEntitiesToClient (client_t *client, sizebuf_t *msg, size_t overflow
 	qboolean	 sort = sv_netsort.value > 1;
 	float		 scale;
 	const char	*model;
+	edhot_t		*hot = qcvm->hot;
 
 	// with sv_netsort = 1, sort only if (any client) overflowed in the last 10 seconds
 	if (sv_netsort.value == 1 && dev_overflows.packetsize + 10 > realtime)
@@ -2049,6 +2062,10 @@ void SV_WriteEntitiesToClient (client_t *client, sizebuf_t *msg, size_t overflow
 	{
 		if (ent != clent) // clent already added before the loop
 		{
+			// the mirror can tell there's no model without loading the edict
+			if (hot && !hot->stale[e] && !hot->modelindex[e])
+				continue;
+
 			// ignore ents without visible models
 			if (!ent->v.modelindex || !(model = PR_GetString (ent->v.model))[0])
 				continue;
@@ -3180,6 +3197,354 @@ qmodel_t *SV_ModelForIndex (int index)
 	return sv.models[index];
 }
 
+/*
+=============================================================================
+
+NEXT MAP PREFETCH
+
+Once we know which map is likely to come next (intermission, level select
+menu) its files are read on background task workers so the OS page cache
+is warm when SV_SpawnServer gets there. Sounds are decoded into caches that
+are handed to the sound system after Host_ClearMemory, and alias models,
+which survive map changes, are loaded on the main thread one per frame.
+Model and sound names come from the last time the map was spawned.
+
+=============================================================================
+*/
+
+#define PREFETCH_CHUNK_SIZE (1024 * 1024)
+#define PREFETCH_PAGE_SIZE	4096
+
+typedef struct
+{
+	char		name[MAX_QPATH];
+	int			ofs, len;
+	qboolean	sound;
+	sfxcache_t *cache;
+} prefetch_item_t;
+
+typedef struct
+{
+	char			 map[MAX_QPATH];
+	prefetch_item_t *items;
+	char		   **models; // alias models, loaded by SV_PrefetchFrame
+	int				 next_model;
+	task_handle_t	 task;
+	atomic_uint32_t	 cancel;
+	atomic_uint32_t	 num_done;
+	atomic_uint64_t	 num_bytes;
+} prefetch_job_t;
+
+static prefetch_job_t *sv_prefetch_job;
+static hash_map_t	  *sv_prefetch_lists; // map name -> char ** of the files it precached
+
+/*
+================
+SV_PrefetchTask
+================
+*/
+static void SV_PrefetchTask (int index, prefetch_job_t **pjob)
+{
+	prefetch_job_t	*job = *pjob;
+	prefetch_item_t *item = &job->items[index];
+	com_file_t		 file;
+	sfx_t			 sfx;
+	byte			 buf[16384];
+	volatile byte	 sink = 0;
+	int				 ofs, end;
+
+	if (Atomic_LoadUInt32 (&job->cancel))
+		goto done;
+
+	if (item->sound)
+	{
+		// S_LoadSound on a private sfx_t, the cache is adopted by SV_FinishPrefetch
+		memset (&sfx, 0, sizeof (sfx));
+		q_strlcpy (sfx.name, item->name + 6, sizeof (sfx.name));
+		item->cache = S_LoadSound (&sfx);
+		if (item->cache)
+			Atomic_AddUInt64 (&job->num_bytes, item->cache->length * item->cache->width);
+	}
+	else if (COM_FileOpenRead (item->name, &file))
+	{
+		end = (int)q_min ((qfileofs_t)item->ofs + item->len, file.size);
+		if (file.data)
+		{
+			for (ofs = item->ofs; ofs < end; ofs += PREFETCH_PAGE_SIZE)
+				sink += file.data[ofs];
+		}
+		else
+		{
+			for (ofs = item->ofs; ofs < end; ofs += sizeof (buf))
+				COM_FileReadAt (&file, ofs, buf, q_min (end - ofs, (int)sizeof (buf)));
+		}
+		COM_FileClose (&file);
+		if (end > item->ofs)
+			Atomic_AddUInt64 (&job->num_bytes, end - item->ofs);
+	}
+
+done:
+	Atomic_IncrementUInt32 (&job->num_done);
+}
+
+/*
+================
+SV_PrefetchAddFile
+
+Splits large files so a cancelled job doesn't have to wait for them
+================
+*/
+static void SV_PrefetchAddFile (prefetch_job_t *job, const char *name)
+{
+	prefetch_item_t item;
+	int				ofs;
+
+	memset (&item, 0, sizeof (item));
+	if (q_strlcpy (item.name, name, sizeof (item.name)) >= sizeof (item.name))
+		return;
+
+	if (!strncmp (name, "sound/", 6))
+	{
+		if (!shm || !COM_FileExists (name, NULL))
+			return;
+		item.sound = true;
+		VEC_PUSH (job->items, item);
+		return;
+	}
+
+	// only looks the file up, pk3 entries are inflated on the workers
+	if (!COM_FileExists (name, NULL) || com_filesize <= 0)
+		return;
+
+	for (ofs = 0; ofs < com_filesize; ofs += PREFETCH_CHUNK_SIZE)
+	{
+		item.ofs = ofs;
+		item.len = (int)q_min ((qfileofs_t)PREFETCH_CHUNK_SIZE, com_filesize - ofs);
+		VEC_PUSH (job->items, item);
+	}
+
+	if (!q_strcasecmp (COM_FileGetExtension (name), "mdl"))
+		VEC_PUSH (job->models, q_strdup (name));
+}
+
+/*
+================
+SV_CancelPrefetch
+================
+*/
+void SV_CancelPrefetch (void)
+{
+	prefetch_job_t *job = sv_prefetch_job;
+	int				i;
+
+	if (!job)
+		return;
+	sv_prefetch_job = NULL;
+
+	Atomic_StoreUInt32 (&job->cancel, true);
+	if (job->task != INVALID_TASK_HANDLE)
+		Task_Join (job->task, SDL_MUTEX_MAXWAIT);
+
+	for (i = 0; i < (int)VEC_SIZE (job->items); i++)
+		Mem_Free (job->items[i].cache);
+	for (i = 0; i < (int)VEC_SIZE (job->models); i++)
+		Mem_Free (job->models[i]);
+	VEC_FREE (job->items);
+	VEC_FREE (job->models);
+	Mem_Free (job);
+}
+
+/*
+================
+SV_PrefetchMap
+
+Starts reading map on background workers, replacing any other prefetch
+================
+*/
+void SV_PrefetchMap (const char *map)
+{
+	prefetch_job_t *job;
+	char		 ***list;
+	int				i;
+
+	if (!sv_prefetch.value || !map[0])
+		return;
+	if (sv_prefetch_job && !strcmp (sv_prefetch_job->map, map))
+		return;
+	SV_CancelPrefetch ();
+
+	job = (prefetch_job_t *)Mem_Alloc (sizeof (prefetch_job_t));
+	q_strlcpy (job->map, map, sizeof (job->map));
+	job->task = INVALID_TASK_HANDLE;
+
+	SV_PrefetchAddFile (job, va ("maps/%s.bsp", map));
+	SV_PrefetchAddFile (job, va ("maps/%s.lit", map));
+	SV_PrefetchAddFile (job, va ("maps/%s.vis", map));
+	SV_PrefetchAddFile (job, va ("maps/%s.ent", map));
+
+	list = sv_prefetch_lists ? HashMap_Lookup (char **, sv_prefetch_lists, &map) : NULL;
+	if (list)
+		for (i = 0; i < (int)VEC_SIZE (*list); i++)
+			SV_PrefetchAddFile (job, (*list)[i]);
+
+	sv_prefetch_job = job;
+	if (!VEC_SIZE (job->items))
+		return;
+
+	Con_DPrintf ("Prefetching %s (%d items)\n", map, (int)VEC_SIZE (job->items));
+	job->task = Task_AllocateAndAssignIndexedFunc ((task_indexed_func_t)SV_PrefetchTask, VEC_SIZE (job->items), &job, sizeof (job));
+	Task_SetPriority (job->task, TASK_PRIORITY_BACKGROUND);
+	Task_Submit (job->task);
+}
+
+/*
+================
+SV_PrefetchNextMap
+
+Intermission hint, prefetches the "nextmap" global of the server progs
+if it names an unlocked level
+================
+*/
+void SV_PrefetchNextMap (void)
+{
+	qcvm_t			*old = qcvm;
+	ddef_t			*def;
+	char			 map[MAX_QPATH];
+	ap_level_index_t level_index;
+
+	if (!sv.active || !sv.qcvm.progs)
+		return;
+
+	map[0] = 0;
+	qcvm = NULL;
+	PR_SwitchQCVM (&sv.qcvm);
+	def = ED_FindGlobal ("nextmap");
+	if (def && (def->type & ~DEF_SAVEGLOBAL) == ev_string)
+		q_strlcpy (map, G_STRING (def->ofs), sizeof (map));
+	PR_SwitchQCVM (NULL);
+	PR_SwitchQCVM (old);
+
+	if (!map[0])
+		return;
+	if (!strcmp (map, "end") || (map[0] == 'e' && map[1] >= '0' && map[1] <= '9' && map[2] == 'm' && map[3] >= '0' && map[3] <= '9'))
+	{
+		level_index = get_level_for_map_name (map);
+		if (!ap_get_level_state (level_index)->unlocked)
+			return;
+	}
+	SV_PrefetchMap (map);
+}
+
+/*
+================
+SV_PrefetchFrame
+
+Loads the alias models of a finished prefetch, one per frame
+================
+*/
+void SV_PrefetchFrame (void)
+{
+	prefetch_job_t *job = sv_prefetch_job;
+
+	if (!job || job->next_model >= (int)VEC_SIZE (job->models))
+		return;
+	if (Atomic_LoadUInt32 (&job->num_done) < VEC_SIZE (job->items))
+		return;
+
+	Mod_ForName (job->models[job->next_model++], false);
+}
+
+/*
+================
+SV_FinishPrefetch
+
+Called by SV_SpawnServer once the old level is gone
+================
+*/
+static void SV_FinishPrefetch (const char *map)
+{
+	prefetch_job_t *job = sv_prefetch_job;
+	double			time;
+	int				i, num_done;
+
+	if (job && !strcmp (job->map, map))
+	{
+		time = Sys_DoubleTime ();
+		num_done = Atomic_LoadUInt32 (&job->num_done);
+		Atomic_StoreUInt32 (&job->cancel, true);
+		if (job->task != INVALID_TASK_HANDLE)
+			Task_Join (job->task, SDL_MUTEX_MAXWAIT);
+		job->task = INVALID_TASK_HANDLE;
+
+		for (i = 0; i < (int)VEC_SIZE (job->items); i++)
+		{
+			if (!job->items[i].cache)
+				continue;
+			S_InsertSoundCache (job->items[i].name + 6, job->items[i].cache);
+			job->items[i].cache = NULL;
+		}
+
+		Con_DPrintf (
+			"Prefetched %s: %d/%d items, %.1f KB, waited %.1f ms\n", map, num_done, (int)VEC_SIZE (job->items),
+			Atomic_LoadUInt64 (&job->num_bytes) / 1024.0, (Sys_DoubleTime () - time) * 1000.0);
+	}
+
+	SV_CancelPrefetch ();
+}
+
+/*
+================
+SV_RecordPrefetchList
+
+Remembers what the level precached for the next SV_PrefetchMap
+================
+*/
+static void SV_RecordPrefetchList (void)
+{
+	const char *name;
+	char	  **list = NULL;
+	char	 ***old;
+	int			i;
+
+	for (i = 2; i < MAX_MODELS && sv.model_precache[i]; i++)
+		if (sv.model_precache[i][0] != '*')
+			VEC_PUSH (list, q_strdup (sv.model_precache[i]));
+	for (i = 1; i < MAX_SOUNDS && sv.sound_precache[i]; i++)
+		VEC_PUSH (list, q_strdup (va ("sound/%s", sv.sound_precache[i])));
+
+	if (!sv_prefetch_lists)
+		sv_prefetch_lists = HashMap_Create (const char *, char **, &HashStr, &HashStrCmp);
+
+	name = sv.name;
+	old = HashMap_Lookup (char **, sv_prefetch_lists, &name);
+	if (old)
+	{
+		for (i = 0; i < (int)VEC_SIZE (*old); i++)
+			Mem_Free ((*old)[i]);
+		VEC_FREE (*old);
+		*old = list;
+		return;
+	}
+
+	name = q_strdup (sv.name);
+	HashMap_Insert (sv_prefetch_lists, &name, &list);
+}
+
+/*
+================
+SV_Prefetch_f
+================
+*/
+static void SV_Prefetch_f (void)
+{
+	if (Cmd_Argc () != 2)
+	{
+		Con_Printf ("prefetch <map> : read a map's files on background workers\n");
+		return;
+	}
+	SV_PrefetchMap (Cmd_Argv (1));
+}
+
 /*
 ================
 SV_SpawnServer
@@ -3234,6 +3599,7 @@ void SV_SpawnServer (const char *server)
 	//
 	// memset (&sv, 0, sizeof(sv));
 	Host_ClearMemory ();
+	SV_FinishPrefetch (server);
 
 	q_strlcpy (sv.name, server, sizeof (sv.name));
 
@@ -3370,6 +3736,8 @@ void SV_SpawnServer (const char *server)
 		Con_DWarning ("%i byte signon buffer exceeds standard limit of 7998 (max = %d).\n", sv.signon.cursize, sv.signon.maxsize);
 	// johnfitz
 
+	SV_RecordPrefetchList ();
+
 	// send serverinfo to all connected clients
 	for (i = 0, host_client = svs.clients; i < svs.maxclients; i++, host_client++)
 	{
@@ -3380,3 +3748,97 @@ void SV_SpawnServer (const char *server)
 
 	Con_DPrintf ("Server spawned.\n");
 }
+
+#ifdef _DEBUG
+/*
+================
+TestEdictMirror_f
+
+test_edict_mirror [edicts] [frames] fills the running server up to edicts (5000) with the
+kind of edict that makes up most of a big map, edicts that only wait, and times SV_Physics
+and SV_WriteEntitiesToClient for the first client without and with pr_edictmirror.
+The world keeps running while it does, then a frame with pr_edictmirror 2 checks the mirror.
+================
+*/
+void TestEdictMirror_f (void)
+{
+	int		  count = (Cmd_Argc () >= 2) ? atoi (Cmd_Argv (1)) : 5000;
+	int		  frames = (Cmd_Argc () >= 3) ? q_max (1, atoi (Cmd_Argv (2))) : 100;
+	float	  oldmirror = pr_edictmirror.value;
+	double	  physics_time[2], send_time[2], start;
+	client_t *client = NULL;
+	edict_t	 *ent;
+	sizebuf_t msg;
+	byte	  buf[MAX_DATAGRAM + 1000];
+	int		  i, pass, frame, numstress;
+
+	if (!sv.active)
+	{
+		Con_Printf ("test_edict_mirror needs a running server\n");
+		return;
+	}
+	for (i = 0; i < svs.maxclients && !client; i++)
+		if (svs.clients[i].active && svs.clients[i].spawned)
+			client = &svs.clients[i];
+
+	PR_SwitchQCVM (&sv.qcvm);
+	count = CLAMP (qcvm->num_edicts, count, qcvm->max_edicts);
+	numstress = count - qcvm->num_edicts;
+	TEMP_ALLOC (edict_t *, stress, q_max (numstress, 1));
+	for (i = 0; i < numstress; i++)
+	{
+		ent = stress[i] = ED_Alloc ();
+		switch (i % 4)
+		{
+		case 0: // items resting on the floor
+			ent->v.movetype = MOVETYPE_TOSS;
+			ent->v.flags = FL_ONGROUND;
+			break;
+		case 1: // monsters waiting for a long time
+			ent->v.movetype = MOVETYPE_NONE;
+			ent->v.nextthink = qcvm->time + 3600;
+			break;
+		default: // lights, info_ and trigger_ edicts
+			ent->v.movetype = MOVETYPE_NONE;
+			break;
+		}
+	}
+
+	for (pass = 0; pass < 2; pass++)
+	{
+		Cvar_SetValueQuick (&pr_edictmirror, pass);
+		SV_Physics (); // the mirror copies every row on its first frame
+		physics_time[pass] = send_time[pass] = 0;
+		for (frame = 0; frame < frames; frame++)
+		{
+			start = Sys_DoubleTime ();
+			SV_Physics ();
+			physics_time[pass] += Sys_DoubleTime () - start;
+			if (!client)
+				continue;
+			msg.allowoverflow = false;
+			msg.overflowed = false;
+			msg.data = buf;
+			msg.maxsize = q_min (MAX_DATAGRAM, client->limit_unreliable);
+			msg.cursize = 0;
+			start = Sys_DoubleTime ();
+			SV_WriteEntitiesToClient (client, &msg, sizeof (buf));
+			send_time[pass] += Sys_DoubleTime () - start;
+		}
+	}
+	Cvar_SetValueQuick (&pr_edictmirror, 2);
+	SV_Physics ();
+	Cvar_SetValueQuick (&pr_edictmirror, oldmirror);
+
+	for (i = 0; i < numstress; i++)
+		if (!stress[i]->free)
+			ED_Free (stress[i]);
+	TEMP_FREE (stress);
+	PR_SwitchQCVM (NULL);
+
+	Con_Printf ("%i edicts, %i frames\n", count, frames);
+	Con_Printf ("physics: %.3f ms/frame, %.3f with the mirror\n", physics_time[0] * 1000 / frames, physics_time[1] * 1000 / frames);
+	if (client)
+		Con_Printf ("send:    %.3f ms/frame, %.3f with the mirror\n", send_time[0] * 1000 / frames, send_time[1] * 1000 / frames);
+}
+#endif
@@ -182,6 +182,7 @@ qboolean SV_movestep (edict_t *ent, vec3_t move, qboolean relink)
 			if (relink)
 				SV_LinkEdict (ent, true);
 			ent->v.flags = (int)ent->v.flags & ~FL_ONGROUND;
+			ED_UpdateIndex (ent);
 			//	Con_Printf ("fall down\n");
 			return true;
 		}
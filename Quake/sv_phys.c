@@ -101,6 +101,7 @@ void SV_CheckVelocity (edict_t *ent)
 		{
 			Con_Printf ("Got a NaN origin on %s\n", PR_GetString (ent->v.classname));
 			ent->v.origin[i] = 0;
+			ED_UpdateIndex (ent);
 		}
 		if (ent->v.velocity[i] > sv_maxvelocity.value)
 			ent->v.velocity[i] = sv_maxvelocity.value;
@@ -136,6 +137,7 @@ qboolean SV_RunThink (edict_t *ent)
 	ent->oldframe = ent->v.frame; // johnfitz
 
 	ent->v.nextthink = 0;
+	ED_HotStale (ent);
 	pr_global_struct->time = thinktime;
 	pr_global_struct->self = EDICT_TO_PROG (ent);
 	pr_global_struct->other = EDICT_TO_PROG (qcvm->edicts);
@@ -551,6 +553,7 @@ void SV_PushMove (edict_t *pusher, float movetime)
 			{ // corpse
 				check->v.mins[0] = check->v.mins[1] = 0;
 				VectorCopy (check->v.mins, check->v.maxs);
+				ED_UpdateIndex (check);
 				continue;
 			}
 
@@ -678,6 +681,7 @@ void SV_CheckStuck (edict_t *ent)
 			}
 
 	VectorCopy (org, ent->v.origin);
+	ED_UpdateIndex (ent);
 	Con_DPrintf ("player is stuck.\n");
 }
 
@@ -927,6 +931,7 @@ void SV_WalkMove (edict_t *ent)
 		// cause the player to hop up higher on a slope too steep to climb
 		VectorCopy (nosteporg, ent->v.origin);
 		VectorCopy (nostepvel, ent->v.velocity);
+		ED_UpdateIndex (ent);
 	}
 }
 
@@ -1202,6 +1207,688 @@ void SV_Physics_Step (edict_t *ent)
 
 //============================================================================
 
+/*
+================
+SV_GatherHot
+
+Copies edict e into its mirror row, the edict has just been through SV_Physics
+================
+*/
+static void SV_GatherHot (edhot_t *hot, int e)
+{
+	edict_t *ent = EDICT_NUM (e);
+	float	 movetype = ent->v.movetype;
+	qboolean landed;
+
+	// SV_Physics_None, and SV_Physics_Toss once it has landed, do nothing but SV_RunThink
+	landed = ((int)ent->v.flags & FL_ONGROUND) && (movetype == MOVETYPE_TOSS || movetype == MOVETYPE_GIB || movetype == MOVETYPE_BOUNCE ||
+												   movetype == MOVETYPE_FLY || movetype == MOVETYPE_FLYMISSILE);
+	hot->still[e] = ent->free || ((e == 0 || e > svs.maxclients) && (movetype == MOVETYPE_NONE || landed));
+	hot->nextthink[e] = ent->free ? 0 : ent->v.nextthink;
+	hot->modelindex[e] = ent->v.modelindex;
+	hot->stale[e] = false;
+}
+
+/*
+================
+SV_CheckHot
+
+pr_edictmirror 2 runs this every frame
+================
+*/
+static void SV_CheckHot (edhot_t *hot, int count)
+{
+	float nextthink, modelindex;
+	byte  still;
+	int	  e;
+
+	for (e = 0; e < count; e++)
+	{
+		if (hot->stale[e])
+			continue;
+		nextthink = hot->nextthink[e];
+		modelindex = hot->modelindex[e];
+		still = hot->still[e];
+		SV_GatherHot (hot, e);
+		if (memcmp (&nextthink, &hot->nextthink[e], sizeof (float)) || memcmp (&modelindex, &hot->modelindex[e], sizeof (float)) || still != hot->still[e])
+			Con_Warning ("SV_CheckHot: edict %i is stale\n", e);
+	}
+}
+
+/*
+================
+SV_MarkIdle
+
+Flags the edicts whose rows say SV_Physics would have nothing to do for them this frame.
+Branch free over the mirror's arrays so the compiler can vectorize it.
+================
+*/
+static void SV_MarkIdle (edhot_t *hot, int count)
+{
+	const double limit = qcvm->time + host_frametime; // SV_RunThink's test
+	const float *nextthink = hot->nextthink;
+	const byte	*still = hot->still;
+	byte		*idle = hot->idle;
+	int			 e;
+
+	for (e = 0; e < count; e++)
+		idle[e] = still[e] & ((nextthink[e] <= 0) | (nextthink[e] > limit));
+}
+
+/*
+===============================================================================
+
+PARALLEL THINKS
+
+With sv_parallelthinks, and progs that set parallel_thinks to promise that the
+thinks falling due in a frame don't depend on each other, one run of edicts a
+frame has its thinks done on the task workers. A run is a stretch of edict
+numbers where SV_Physics would do nothing but thinks with no physics around
+them, so running them all when the serial loop reaches the first one sees the
+world exactly as the serial loop would: everything before has moved, nothing
+after has. The thinks are grouped by the areanode their box sits under,
+VANILLA_AREA_DEPTH levels down, and each group runs in edict order on one
+worker's copy of the server progs: its own globals, edicts and stacks, the
+switch interpreter and only the builtins PR_IsPureBuiltin allows. What a group
+wrote is diffed against sv.qcvm's edicts and applied in group order once the
+workers are done, so creation, removal and every other write stays deferred.
+Whatever a copy can't do (spawn, remove, traces, setorigin, random, temp
+strings, run errors...) abandons the group, which the serial loop then runs as
+it always has, and the think function that did it is never sent to the workers
+again for these progs. Globals left behind by the workers are dropped, the
+progs promised not to rely on them.
+
+===============================================================================
+*/
+
+cvar_t sv_parallelthinks = {"sv_parallelthinks", "0", CVAR_NONE}; // 2 also reruns the frame serially and compares
+
+typedef struct
+{
+	int ofs; // in ints from qcvm->edicts
+	int value;
+} thinkwrite_t;
+
+typedef struct
+{
+	int			 *ents; // ascending
+	thinkwrite_t *writes;
+	qboolean	  aborted;
+	func_t		  aborter; // think that was running when it aborted
+} thinkregion_t;
+
+typedef struct
+{
+	qcvm_t		 vm;
+	jmp_buf		 abort;
+	int			 frame; // think_frame its edicts were copied in
+	dprograms_t *progs;
+	unsigned int progshash;
+	int			 max_edicts;
+	int			 edict_size;
+	dfunction_t *functions; // own copy, the interpreter adds to the profile counters
+	float		*globals;
+	byte		*edicts;
+	byte		*written;
+} thinkworker_t;
+
+static thinkworker_t *think_workers[TASKS_MAX_WORKERS + 1]; // the main thread helps as num_workers
+static thinkregion_t  think_regions[AREA_NODES];
+static int			  think_nodes[AREA_NODES]; // areanode -> think_regions index
+static builtin_t	  think_builtins[countof (sv.qcvm.builtins)];
+static builtin_t	  think_sources[countof (sv.qcvm.builtins)]; // what think_builtins was made from
+static int			  think_frame;
+static byte			 *think_aborted; // by function, thinks that abandoned a region stay serial
+static dprograms_t	 *think_abortedprogs;
+static unsigned int	  think_abortedhash;
+
+/*
+================
+SV_CaptureSendInterval
+
+johnfitz -- PROTOCOL_FITZQUAKE
+capture interval to nextthink here and send it to client for better
+lerp timing, but only if interval is not 0.1 (which client assumes)
+================
+*/
+static void SV_CaptureSendInterval (edict_t *ent)
+{
+	ent->sendinterval = false;
+	if (!ent->free && ent->v.nextthink > qcvm->time &&
+		(ent->v.movetype == MOVETYPE_STEP || ent->v.movetype == MOVETYPE_WALK || ent->v.frame != ent->oldframe))
+	{
+		int j = Q_rint ((ent->v.nextthink - ent->oldthinktime) * 255);
+		if (j >= 0 && j < 256 && j != 25 && j != 26) // 25 and 26 are close enough to 0.1 to not send
+			ent->sendinterval = true;
+	}
+}
+
+/*
+================
+SV_ThinkOnly
+
+True if SV_Physics has nothing to do for ent this frame but its think, and
+SV_CheckWaterTransition after it for MOVETYPE_STEP
+================
+*/
+static qboolean SV_ThinkOnly (edict_t *ent)
+{
+	float thinktime = ent->v.nextthink;
+	int	  flags = (int)ent->v.flags;
+
+	if (ent->free || thinktime <= 0 || thinktime > qcvm->time + host_frametime)
+		return false;
+	if (!ent->v.think || ent->v.think >= (func_t)qcvm->progs->numfunctions)
+		return false; // PR_ExecuteProgram's Host_Error
+	if (think_aborted[ent->v.think])
+		return false;
+
+	switch ((int)ent->v.movetype)
+	{
+	case MOVETYPE_NONE:
+		return true;
+	case MOVETYPE_STEP:
+		return (flags & (FL_ONGROUND | FL_FLY | FL_SWIM)) != 0;
+	case MOVETYPE_TOSS:
+	case MOVETYPE_GIB:
+	case MOVETYPE_BOUNCE:
+	case MOVETYPE_FLY:
+	case MOVETYPE_FLYMISSILE:
+		return (flags & FL_ONGROUND) != 0; // SV_ThinkRegionTask checks it's still there after the think
+	default:
+		return false;
+	}
+}
+
+/*
+================
+SV_Passive
+
+True if SV_Physics changes nothing the progs can see for ent this frame
+================
+*/
+static qboolean SV_Passive (edict_t *ent, int e)
+{
+	float thinktime = ent->v.nextthink;
+	int	  flags = (int)ent->v.flags;
+	int	  cont;
+
+	if (ent->free)
+		return true;
+	if (e <= svs.maxclients || (thinktime > 0 && thinktime <= qcvm->time + host_frametime))
+		return false;
+
+	switch ((int)ent->v.movetype)
+	{
+	case MOVETYPE_NONE:
+		return true;
+	case MOVETYPE_STEP:
+		if (!(flags & (FL_ONGROUND | FL_FLY | FL_SWIM)) || !ent->v.watertype)
+			return false;
+		// SV_CheckWaterTransition rewrites what is already there unless the edict moved
+		cont = SV_PointContents (ent->v.origin);
+		if (cont <= CONTENTS_WATER)
+			return ent->v.watertype == cont && ent->v.waterlevel == 1;
+		return ent->v.watertype == CONTENTS_EMPTY && ent->v.waterlevel == cont;
+	case MOVETYPE_TOSS:
+	case MOVETYPE_GIB:
+	case MOVETYPE_BOUNCE:
+	case MOVETYPE_FLY:
+	case MOVETYPE_FLYMISSILE:
+		return (flags & FL_ONGROUND) != 0;
+	default:
+		return false;
+	}
+}
+
+/*
+================
+SV_ThinkRegion
+
+The areanode ent's think can run under on a worker, or NULL if it has to stay serial
+================
+*/
+static areanode_t *SV_ThinkRegion (edict_t *ent)
+{
+	return SV_ThinkOnly (ent) ? SV_AreaRegion (ent, VANILLA_AREA_DEPTH) : NULL;
+}
+
+/*
+================
+SV_PrepareThinkWorkers
+
+Sizes each worker's copies for the current progs and refreshes the builtins they may call
+================
+*/
+static void SV_PrepareThinkWorkers (void)
+{
+	thinkworker_t *worker;
+	int			   i;
+
+	for (i = 0; i < (int)countof (think_builtins); i++)
+	{
+		if (think_sources[i] == qcvm->builtins[i] && think_builtins[i])
+			continue;
+		think_sources[i] = qcvm->builtins[i];
+		think_builtins[i] = PR_IsPureBuiltin (qcvm->builtins[i]) ? qcvm->builtins[i] : PR_SandboxAbort;
+	}
+
+	for (i = 0; i <= Tasks_NumWorkers (); i++)
+	{
+		if (!think_workers[i])
+			think_workers[i] = (thinkworker_t *)Mem_Alloc (sizeof (thinkworker_t));
+		worker = think_workers[i];
+		if (worker->progs == qcvm->progs && worker->progshash == qcvm->progshash && worker->max_edicts == qcvm->max_edicts &&
+			worker->edict_size == qcvm->edict_size)
+			continue;
+		Mem_Free (worker->functions);
+		Mem_Free (worker->globals);
+		Mem_Free (worker->edicts);
+		Mem_Free (worker->written);
+		worker->functions = (dfunction_t *)Mem_Alloc (qcvm->progs->numfunctions * sizeof (dfunction_t));
+		memcpy (worker->functions, qcvm->functions, qcvm->progs->numfunctions * sizeof (dfunction_t));
+		worker->globals = (float *)Mem_Alloc (qcvm->progs->numglobals * 4);
+		worker->edicts = (byte *)Mem_Alloc (qcvm->max_edicts * qcvm->edict_size);
+		worker->written = (byte *)Mem_Alloc (qcvm->max_edicts);
+		worker->progs = qcvm->progs;
+		worker->progshash = qcvm->progshash;
+		worker->max_edicts = qcvm->max_edicts;
+		worker->edict_size = qcvm->edict_size;
+		worker->frame = think_frame - 1;
+	}
+}
+
+/*
+================
+SV_ThinkWorker
+
+The calling worker's copy of the server progs, brought up to date with sv.qcvm the
+first time it is needed in a frame
+================
+*/
+static thinkworker_t *SV_ThinkWorker (void)
+{
+	const qcvm_t  *src = &sv.qcvm;
+	thinkworker_t *worker = think_workers[Tasks_GetWorkerIndex ()];
+	qcvm_t		  *vm = &worker->vm;
+
+	if (worker->frame == think_frame)
+		return worker;
+
+	memcpy (vm, src, offsetof (qcvm_t, stack)); // progs, strings and the rest it only reads
+	vm->functions = worker->functions;
+	vm->globals = worker->globals;
+	memcpy (vm->builtins, think_builtins, sizeof (vm->builtins));
+	vm->trace = false;
+	vm->tstatements = NULL; // the threaded statements point into sv.qcvm's globals
+	vm->natives = NULL;
+	vm->nativelib = NULL;
+	memset (&vm->extglobals, 0, sizeof (vm->extglobals)); // so do these, and nothing a sandbox can reach reads them
+	vm->depth = 0;
+	vm->localstack_used = 0;
+	vm->time = src->time;
+	vm->num_edicts = src->num_edicts;
+	vm->reserved_edicts = src->reserved_edicts;
+	vm->max_edicts = src->max_edicts;
+	vm->edicts = (edict_t *)worker->edicts;
+	vm->free_edicts_head = NULL;
+	vm->free_edicts_tail = NULL;
+	vm->worldmodel = src->worldmodel;
+	vm->GetModel = src->GetModel;
+	vm->numareanodes = 0;
+	vm->findindex = NULL;
+	vm->hot = NULL;
+	vm->written = worker->written;
+	vm->sandbox = &worker->abort;
+	memcpy (worker->edicts, src->edicts, src->num_edicts * src->edict_size);
+	worker->frame = think_frame;
+	return worker;
+}
+
+/*
+================
+SV_ThinkRegionTask
+
+Runs one region's thinks on the worker's copy and keeps what they wrote. The copy's
+edicts are put back the way sv.qcvm has them for the next region.
+================
+*/
+static void SV_ThinkRegionTask (int index, void *unused)
+{
+	thinkregion_t *region = &think_regions[index];
+	thinkworker_t *worker = SV_ThinkWorker ();
+	qcvm_t		  *oldvm = qcvm; // sv.qcvm if the main thread helps out while it joins
+	globalvars_t  *oldglobals = pr_global_struct;
+	thinkwrite_t   write;
+	const int	  *shared;
+	int			  *own;
+	int			   i, e;
+
+	qcvm = &worker->vm;
+	pr_global_struct = (globalvars_t *)qcvm->globals;
+	memcpy (qcvm->globals, sv.qcvm.globals, sv.qcvm.progs->numglobals * 4);
+
+	if (!setjmp (worker->abort))
+	{
+		for (i = 0; i < (int)VEC_SIZE (region->ents); i++)
+		{
+			edict_t *ent = EDICT_NUM (region->ents[i]);
+
+			qcvm->written[region->ents[i]] = true;
+			region->aborter = ent->v.think;
+			SV_RunThink (ent);
+			if (ent->v.movetype != MOVETYPE_NONE && ent->v.movetype != MOVETYPE_STEP && !((int)ent->v.flags & FL_ONGROUND))
+				PR_SandboxAbort (); // SV_Physics_Toss would move it right away
+			SV_CaptureSendInterval (ent);
+		}
+	}
+	else
+		region->aborted = true;
+
+	for (e = 0; e < qcvm->num_edicts; e++)
+	{
+		if (!qcvm->written[e])
+			continue;
+		qcvm->written[e] = false;
+		shared = (const int *)((byte *)sv.qcvm.edicts + e * qcvm->edict_size);
+		own = (int *)EDICT_NUM (e);
+		for (i = 0; !region->aborted && i < qcvm->edict_size / 4; i++)
+		{
+			if (own[i] == shared[i])
+				continue;
+			write.ofs = e * (qcvm->edict_size / 4) + i;
+			write.value = own[i];
+			VEC_PUSH (region->writes, write);
+		}
+		memcpy (own, shared, qcvm->edict_size);
+	}
+
+	qcvm = oldvm;
+	pr_global_struct = oldglobals;
+}
+
+/*
+================
+SV_ParallelStart
+
+Where SV_PhysicsLoop should stop to hand the longest run of thinks to the workers,
+or entity_cap if it shouldn't
+================
+*/
+static int SV_ParallelStart (int entity_cap)
+{
+	edict_t *ent;
+	int		 best = entity_cap, bestcount = 1, start = -1, count = 0, e;
+
+	if (!sv_parallelthinks.value || !qcvm->extglobals.parallel_thinks || !*qcvm->extglobals.parallel_thinks || Tasks_NumWorkers () < 2 ||
+		pr_global_struct->force_retouch)
+		return entity_cap;
+
+	if (think_abortedprogs != qcvm->progs || think_abortedhash != qcvm->progshash)
+	{
+		Mem_Free (think_aborted);
+		think_aborted = (byte *)Mem_Alloc (qcvm->progs->numfunctions);
+		think_abortedprogs = qcvm->progs;
+		think_abortedhash = qcvm->progshash;
+	}
+
+	for (e = svs.maxclients + 1; e < entity_cap; e++)
+	{
+		ent = EDICT_NUM (e);
+		if (SV_ThinkRegion (ent))
+		{
+			if (start < 0)
+			{
+				start = e;
+				count = 0;
+			}
+			if (++count > bestcount)
+			{
+				best = start;
+				bestcount = count;
+			}
+		}
+		else if (!SV_Passive (ent, e))
+			start = -1;
+	}
+	return best;
+}
+
+/*
+================
+SV_ParallelThinks
+
+SV_PhysicsLoop has reached start. Runs what it can of the thinks from there to the
+end of the run on the task workers, and returns the edicts the loop has to skip, or
+NULL if everything is left to it.
+================
+*/
+static byte *SV_ParallelThinks (int start, int entity_cap)
+{
+	static byte	  *done;
+	static int	  *owner; // think_regions index that last wrote each edict while merging, or -1
+	static int	  *touched;
+	static int	   doneedicts;
+	thinkregion_t *region;
+	areanode_t	  *node;
+	edict_t		  *ent;
+	int			   numregions, end, r, i, e;
+
+	// group the run's thinks, in edict order within each region
+	memset (think_nodes, -1, sizeof (think_nodes));
+	numregions = 0;
+	for (end = start; end < entity_cap; end++)
+	{
+		ent = EDICT_NUM (end);
+		if (!(node = SV_ThinkRegion (ent)))
+		{
+			if (SV_Passive (ent, end))
+				continue;
+			break; // the serial loop has to get to it first
+		}
+		r = think_nodes[node - qcvm->areanodes];
+		if (r < 0)
+		{
+			r = think_nodes[node - qcvm->areanodes] = numregions++;
+			VEC_CLEAR (think_regions[r].ents);
+			VEC_CLEAR (think_regions[r].writes);
+			think_regions[r].aborted = false;
+		}
+		VEC_PUSH (think_regions[r].ents, end);
+	}
+	if (numregions < 2)
+		return NULL;
+
+	if (doneedicts != qcvm->max_edicts)
+	{
+		Mem_Free (done);
+		Mem_Free (owner);
+		doneedicts = qcvm->max_edicts;
+		done = (byte *)Mem_Alloc (doneedicts);
+		owner = (int *)Mem_Alloc (doneedicts * sizeof (int));
+		memset (owner, -1, doneedicts * sizeof (int));
+	}
+
+	++think_frame;
+	SV_PrepareThinkWorkers ();
+	Task_Join (Task_AllocateAssignIndexedFuncAndSubmit (SV_ThinkRegionTask, numregions, NULL, 0), SDL_MUTEX_MAXWAIT);
+
+	// merge in region order, the outcome doesn't depend on which worker finished first
+	memset (done, 0, entity_cap);
+	VEC_CLEAR (touched);
+	for (r = 0; r < numregions; r++)
+	{
+		region = &think_regions[r];
+		if (region->aborted)
+		{
+			think_aborted[region->aborter] = true;
+			continue;
+		}
+		for (i = 0; i < (int)VEC_SIZE (region->writes); i++)
+		{
+			e = region->writes[i].ofs / (qcvm->edict_size / 4);
+			if (owner[e] < 0)
+				VEC_PUSH (touched, e);
+			else if (owner[e] != r && sv_parallelthinks.value >= 2)
+				Con_Warning ("sv_parallelthinks: edict %i written from two regions\n", e);
+			owner[e] = r;
+			((int *)qcvm->edicts)[region->writes[i].ofs] = region->writes[i].value;
+		}
+		for (i = 0; i < (int)VEC_SIZE (region->ents); i++)
+			done[region->ents[i]] = true;
+	}
+	for (i = 0; i < (int)VEC_SIZE (touched); i++)
+	{
+		ED_UpdateIndex (EDICT_NUM (touched[i]));
+		owner[touched[i]] = -1;
+	}
+
+	// the rest of SV_Physics_Step, in edict order for the sounds
+	for (e = start; e < end; e++)
+	{
+		ent = EDICT_NUM (e);
+		if (done[e] && !ent->free && ent->v.movetype == MOVETYPE_STEP)
+			SV_CheckWaterTransition (ent);
+	}
+
+	return done;
+}
+
+/*
+================
+SV_PhysicsLoop
+
+Treats each object in turn, handing a run of them to SV_ParallelThinks if parallel
+================
+*/
+static void SV_PhysicsLoop (int entity_cap, edhot_t *hot, qboolean parallel)
+{
+	edict_t *ent = qcvm->edicts;
+	byte	*done = NULL; // by SV_ParallelThinks
+	int		 start = parallel ? SV_ParallelStart (entity_cap) : entity_cap;
+	int		 i;
+
+	// for (i=0 ; i<sv.num_edicts ; i++, ent = NEXT_EDICT(ent))
+	for (i = 0; i < entity_cap; i++, ent = NEXT_EDICT (ent))
+	{
+		if (i == start)
+			done = SV_ParallelThinks (start, entity_cap);
+
+		// sendinterval is left as it is, it would come out the same
+		if (hot && hot->idle[i] && !hot->stale[i])
+			continue;
+
+		if (ent->free || (done && done[i]))
+		{
+			if (hot)
+				SV_GatherHot (hot, i);
+			continue;
+		}
+
+		if (pr_global_struct->force_retouch)
+		{
+			SV_LinkEdict (ent, true); // force retouch even for stationary
+		}
+
+		if (i > 0 && i <= svs.maxclients && qcvm == &sv.qcvm)
+			SV_Physics_Client (ent, i);
+		else if (ent->v.movetype == MOVETYPE_PUSH)
+			SV_Physics_Pusher (ent);
+		else if (ent->v.movetype == MOVETYPE_NONE)
+			SV_Physics_None (ent);
+		else if (ent->v.movetype == MOVETYPE_NOCLIP)
+			SV_Physics_Noclip (ent);
+		else if (ent->v.movetype == MOVETYPE_STEP)
+			SV_Physics_Step (ent);
+		else if (
+			ent->v.movetype == MOVETYPE_TOSS || ent->v.movetype == MOVETYPE_GIB || ent->v.movetype == MOVETYPE_BOUNCE || ent->v.movetype == MOVETYPE_FLY ||
+			ent->v.movetype == MOVETYPE_FLYMISSILE)
+			SV_Physics_Toss (ent);
+		else
+			Host_EndGame ("SV_Physics: bad movetype %i", (int)ent->v.movetype);
+
+		SV_CaptureSendInterval (ent);
+
+		if (hot)
+			SV_GatherHot (hot, i);
+	}
+}
+
+/*
+================
+SV_CheckParallelPhysics
+
+sv_parallelthinks 2: runs the frame's physics with the workers, then again from the
+same state with the unmodified serial loop, and warns where the edicts differ. The
+serial results are kept. Builtins run twice, so this is only meant for testing, and
+the globals aren't compared since the workers drop theirs.
+================
+*/
+static void SV_CheckParallelPhysics (int entity_cap, edhot_t *hot)
+{
+	static byte		  *saved, *parallel;
+	static int		   savedsize;
+	static areanode_t *areanodes;
+	int				   numglobals = qcvm->progs->numglobals;
+	int				   numedicts, savededicts, paralleledicts, size, i, e, seed;
+	edict_t			  *freehead, *freetail;
+	const byte		  *a, *b;
+
+	// edicts spawned during the frame are covered up to a point
+	numedicts = q_min (qcvm->num_edicts + 64, qcvm->max_edicts);
+	size = numglobals * 4 + numedicts * qcvm->edict_size;
+	if (size > savedsize)
+	{
+		Mem_Free (saved);
+		Mem_Free (parallel);
+		savedsize = size;
+		saved = (byte *)Mem_Alloc (savedsize);
+		parallel = (byte *)Mem_Alloc (savedsize);
+	}
+	if (!areanodes)
+		areanodes = (areanode_t *)Mem_Alloc (sizeof (qcvm->areanodes));
+
+	memcpy (saved, qcvm->globals, numglobals * 4);
+	memcpy (saved + numglobals * 4, qcvm->edicts, numedicts * qcvm->edict_size);
+	memcpy (areanodes, qcvm->areanodes, sizeof (qcvm->areanodes));
+	savededicts = qcvm->num_edicts;
+	freehead = qcvm->free_edicts_head;
+	freetail = qcvm->free_edicts_tail;
+	seed = rand ();
+
+	srand (seed);
+	SV_PhysicsLoop (entity_cap, hot, true);
+	paralleledicts = qcvm->num_edicts;
+	if (paralleledicts > numedicts)
+		return;
+	memcpy (parallel, qcvm->edicts, numedicts * qcvm->edict_size);
+
+	memcpy (qcvm->globals, saved, numglobals * 4);
+	memcpy (qcvm->edicts, saved + numglobals * 4, numedicts * qcvm->edict_size);
+	memcpy (qcvm->areanodes, areanodes, sizeof (qcvm->areanodes));
+	qcvm->num_edicts = savededicts;
+	qcvm->free_edicts_head = freehead;
+	qcvm->free_edicts_tail = freetail;
+	ED_ResetIndex (); // and the mirror, hot goes with it
+
+	srand (seed);
+	SV_PhysicsLoop (entity_cap, NULL, false);
+
+	if (qcvm->num_edicts != paralleledicts)
+		Con_Warning ("sv_parallelthinks: %i edicts in parallel, %i serially\n", paralleledicts, qcvm->num_edicts);
+	for (e = 0; e < q_min (paralleledicts, qcvm->num_edicts); e++)
+	{
+		a = parallel + e * qcvm->edict_size + offsetof (edict_t, v);
+		b = (byte *)EDICT_NUM (e) + offsetof (edict_t, v);
+		for (i = 0; i < qcvm->progs->entityfields; i++)
+			if (memcmp (a + i * 4, b + i * 4, 4))
+			{
+				Con_Warning ("sv_parallelthinks: edict %i field %i differs from the serial run\n", e, i);
+				break;
+			}
+	}
+}
+
 /*
 ================
 SV_Physics
@@ -1213,6 +1900,7 @@ void SV_Physics (void)
 	int		 i;
 	int		 entity_cap; // For sv_freezenonclients
 	edict_t *ent;
+	edhot_t *hot = NULL;
 
 	int physics_mode;
 	if (qcvm->extglobals.physics_mode)
@@ -1249,58 +1937,27 @@ void SV_Physics (void)
 
 	// SV_CheckAllEnts ();
 
-	//
-	// treat each object in turn
-	//
-	ent = qcvm->edicts;
-
 	if (sv_freezenonclients.value && qcvm == &sv.qcvm)
 		entity_cap = svs.maxclients + 1; // Only run physics on clients and the world
 	else
 		entity_cap = qcvm->num_edicts;
 
-	// for (i=0 ; i<sv.num_edicts ; i++, ent = NEXT_EDICT(ent))
-	for (i = 0; i < entity_cap; i++, ent = NEXT_EDICT (ent))
+	// force_retouch links every edict, so there is nothing to skip
+	if (qcvm == &sv.qcvm && !pr_global_struct->force_retouch && (hot = ED_GetHot ()))
 	{
-		if (ent->free)
-			continue;
-
-		if (pr_global_struct->force_retouch)
-		{
-			SV_LinkEdict (ent, true); // force retouch even for stationary
-		}
-
-		if (i > 0 && i <= svs.maxclients && qcvm == &sv.qcvm)
-			SV_Physics_Client (ent, i);
-		else if (ent->v.movetype == MOVETYPE_PUSH)
-			SV_Physics_Pusher (ent);
-		else if (ent->v.movetype == MOVETYPE_NONE)
-			SV_Physics_None (ent);
-		else if (ent->v.movetype == MOVETYPE_NOCLIP)
-			SV_Physics_Noclip (ent);
-		else if (ent->v.movetype == MOVETYPE_STEP)
-			SV_Physics_Step (ent);
-		else if (
-			ent->v.movetype == MOVETYPE_TOSS || ent->v.movetype == MOVETYPE_GIB || ent->v.movetype == MOVETYPE_BOUNCE || ent->v.movetype == MOVETYPE_FLY ||
-			ent->v.movetype == MOVETYPE_FLYMISSILE)
-			SV_Physics_Toss (ent);
-		else
-			Host_EndGame ("SV_Physics: bad movetype %i", (int)ent->v.movetype);
-
-		// johnfitz -- PROTOCOL_FITZQUAKE
-		// capture interval to nextthink here and send it to client for better
-		// lerp timing, but only if interval is not 0.1 (which client assumes)
-		ent->sendinterval = false;
-		if (!ent->free && ent->v.nextthink > qcvm->time &&
-			(ent->v.movetype == MOVETYPE_STEP || ent->v.movetype == MOVETYPE_WALK || ent->v.frame != ent->oldframe))
-		{
-			int j = Q_rint ((ent->v.nextthink - ent->oldthinktime) * 255);
-			if (j >= 0 && j < 256 && j != 25 && j != 26) // 25 and 26 are close enough to 0.1 to not send
-				ent->sendinterval = true;
-		}
-		// johnfitz
+		if (pr_edictmirror.value >= 2)
+			SV_CheckHot (hot, entity_cap);
+		SV_MarkIdle (hot, entity_cap);
 	}
 
+	//
+	// treat each object in turn
+	//
+	if (qcvm == &sv.qcvm && sv_parallelthinks.value >= 2 && SV_ParallelStart (entity_cap) < entity_cap)
+		SV_CheckParallelPhysics (entity_cap, hot);
+	else
+		SV_PhysicsLoop (entity_cap, hot, qcvm == &sv.qcvm);
+
 	if (pr_global_struct->force_retouch)
 		pr_global_struct->force_retouch--;
 
@@ -35,6 +35,8 @@ typedef long long qfileofs_t;
 int		   Sys_fseek (FILE *file, qfileofs_t ofs, int origin);
 qfileofs_t Sys_ftell (FILE *file);
 qfileofs_t Sys_filelength (FILE *f);
+int		   Sys_pread (FILE *file, void *dest, int count, qfileofs_t ofs);
+// reads at ofs without using or moving the stream position, returns the number of bytes read
 
 // returns the file size or -1 if file is not present.
 // the file should be in BINARY mode for stupid OSs that care
@@ -48,6 +50,7 @@ int Sys_FileOpenWrite (const char *path);
 void Sys_FileClose (int handle);
 void Sys_FileSeek (int handle, int position);
 int	 Sys_FileRead (int handle, void *dest, int count);
+int	 Sys_FileReadAt (int handle, qfileofs_t ofs, void *dest, int count); // positional, safe to call from several threads
 int	 Sys_FileWrite (int handle, const void *data, int count);
 void Sys_mkdir (const char *path);
 
@@ -55,6 +58,15 @@ int Sys_FileType (const char *path);
 /* returns an FS entity type, i.e. FS_ENT_FILE or FS_ENT_DIRECTORY.
  * returns FS_ENT_NONE (0) if no such file or directory is present. */
 
+qboolean Sys_ListDirectory (const char *path, void (*callback) (const char *name, int type, void *userdata), void *userdata);
+/* calls callback with the name and FS entity type of every entry in the
+ * directory except . and .., returns false if it can't be opened. */
+
+const byte *Sys_MapFile (const char *path, qfileofs_t *size);
+void		Sys_UnmapFile (const byte *data, qfileofs_t size);
+/* maps the whole file read-only into memory and sets size.
+ * returns NULL if the file can't be opened, is empty or mapping fails. */
+
 //
 // system IO
 //
@@ -141,6 +141,20 @@ int Sys_FileRead (int handle, void *dest, int count)
 	}
 }
 
+int Sys_FileReadAt (int handle, qfileofs_t ofs, void *dest, int count)
+{
+	if (sys_handles[handle].file)
+		return Sys_pread (sys_handles[handle].file, dest, count, ofs);
+	else
+	{
+		if (ofs >= sys_handles[handle].size)
+			return 0;
+		count = (int)q_min ((qfileofs_t)count, sys_handles[handle].size - ofs);
+		memcpy (dest, sys_handles[handle].memory + ofs, count);
+		return count;
+	}
+}
+
 int Sys_FileWrite (int handle, const void *data, int count)
 {
 	assert (sys_handles[handle].file);
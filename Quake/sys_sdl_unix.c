@@ -33,6 +33,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <fcntl.h>
+#include <dirent.h>
+#include <sys/mman.h>
 #ifdef DO_USERDIRS
 #include <pwd.h>
 #endif
@@ -59,6 +61,24 @@ qfileofs_t Sys_ftell (FILE *file)
 	return ftello (file);
 }
 
+int Sys_pread (FILE *file, void *dest, int count, qfileofs_t ofs)
+{
+	int		total = 0;
+	ssize_t num_read;
+
+	while (total < count)
+	{
+		num_read = pread (fileno (file), (byte *)dest + total, count - total, ofs + total);
+		if (num_read < 0 && errno == EINTR)
+			continue;
+		if (num_read <= 0)
+			break;
+		total += num_read;
+	}
+
+	return total;
+}
+
 int Sys_FileType (const char *path)
 {
 	/*
@@ -77,6 +97,66 @@ int Sys_FileType (const char *path)
 	return FS_ENT_NONE;
 }
 
+qboolean Sys_ListDirectory (const char *path, void (*callback) (const char *name, int type, void *userdata), void *userdata)
+{
+	DIR			  *dir_p;
+	struct dirent *dir_t;
+	char		   entry_path[MAX_OSPATH];
+	int			   type;
+
+	dir_p = opendir (path);
+	if (dir_p == NULL)
+		return false;
+
+	while ((dir_t = readdir (dir_p)) != NULL)
+	{
+		if (!strcmp (dir_t->d_name, ".") || !strcmp (dir_t->d_name, ".."))
+			continue;
+#ifdef DT_REG
+		if (dir_t->d_type == DT_REG)
+			type = FS_ENT_FILE;
+		else if (dir_t->d_type == DT_DIR)
+			type = FS_ENT_DIRECTORY;
+		else
+#endif
+		{ // symlinks or file systems that don't report the type
+			q_snprintf (entry_path, sizeof (entry_path), "%s/%s", path, dir_t->d_name);
+			type = Sys_FileType (entry_path);
+		}
+		callback (dir_t->d_name, type, userdata);
+	}
+
+	closedir (dir_p);
+	return true;
+}
+
+const byte *Sys_MapFile (const char *path, qfileofs_t *size)
+{
+	struct stat st;
+	void	   *data;
+	int			fd;
+
+	fd = open (path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+
+	data = MAP_FAILED;
+	if (fstat (fd, &st) == 0 && st.st_size > 0)
+		data = mmap (NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close (fd); // the mapping keeps its own reference
+
+	if (data == MAP_FAILED)
+		return NULL;
+
+	*size = st.st_size;
+	return (const byte *)data;
+}
+
+void Sys_UnmapFile (const byte *data, qfileofs_t size)
+{
+	munmap ((void *)data, (size_t)size);
+}
+
 static char cwd[MAX_OSPATH];
 #ifdef DO_USERDIRS
 static char userdir[MAX_OSPATH];
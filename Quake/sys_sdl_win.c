@@ -51,6 +51,61 @@ int Sys_FileType (const char *path)
 	return FS_ENT_FILE;
 }
 
+qboolean Sys_ListDirectory (const char *path, void (*callback) (const char *name, int type, void *userdata), void *userdata)
+{
+	WIN32_FIND_DATA fdat;
+	HANDLE			fhnd;
+	char			pattern[MAX_OSPATH];
+
+	q_snprintf (pattern, sizeof (pattern), "%s/*", path);
+	fhnd = FindFirstFile (pattern, &fdat);
+	if (fhnd == INVALID_HANDLE_VALUE)
+		return false;
+
+	do
+	{
+		if (!strcmp (fdat.cFileName, ".") || !strcmp (fdat.cFileName, ".."))
+			continue;
+		callback (fdat.cFileName, (fdat.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ? FS_ENT_DIRECTORY : FS_ENT_FILE, userdata);
+	} while (FindNextFile (fhnd, &fdat));
+
+	FindClose (fhnd);
+	return true;
+}
+
+const byte *Sys_MapFile (const char *path, qfileofs_t *size)
+{
+	HANDLE		  file, mapping;
+	LARGE_INTEGER file_size;
+	void		 *data = NULL;
+
+	file = CreateFile (path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	if (GetFileSizeEx (file, &file_size) && file_size.QuadPart > 0)
+	{
+		mapping = CreateFileMapping (file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping)
+		{
+			data = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+			CloseHandle (mapping); // the view keeps the mapping alive
+		}
+	}
+	CloseHandle (file);
+
+	if (!data)
+		return NULL;
+
+	*size = file_size.QuadPart;
+	return (const byte *)data;
+}
+
+void Sys_UnmapFile (const byte *data, qfileofs_t size)
+{
+	UnmapViewOfFile (data);
+}
+
 static HANDLE hinput, houtput;
 static char	  cwd[1024];
 static double counter_freq;
@@ -65,6 +120,29 @@ qfileofs_t Sys_ftell (FILE *file)
 	return _ftelli64 (file);
 }
 
+int Sys_pread (FILE *file, void *dest, int count, qfileofs_t ofs)
+{
+	HANDLE	   handle;
+	OVERLAPPED overlapped;
+	DWORD	   num_read = 0;
+	BOOL	   ok;
+
+	// ReadFile on a synchronous handle moves the file pointer even with an explicit offset,
+	// which would desync the CRT buffer of whoever is using the stream, so read through a
+	// handle of our own. It has its own file object and position.
+	handle = ReOpenFile ((HANDLE)_get_osfhandle (_fileno (file)), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 0);
+	if (handle == INVALID_HANDLE_VALUE)
+		return 0;
+
+	memset (&overlapped, 0, sizeof (overlapped));
+	overlapped.Offset = (DWORD)ofs;
+	overlapped.OffsetHigh = (DWORD)(ofs >> 32);
+	ok = ReadFile (handle, dest, count, &num_read, &overlapped);
+	CloseHandle (handle);
+
+	return ok ? (int)num_read : 0;
+}
+
 static void Sys_GetBasedir (char *argv0, char *dst, size_t dstsize)
 {
 	char  *tmp;
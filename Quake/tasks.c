@@ -40,24 +40,46 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 	} while (false)
 #endif
 
-#define NUM_INDEX_BITS		 8
-#define MAX_PENDING_TASKS	 (1u << NUM_INDEX_BITS)
-#define MAX_EXECUTABLE_TASKS 256
-#define MAX_DEPENDENT_TASKS	 16
-#define MAX_PAYLOAD_SIZE	 128
+#define NUM_INDEX_BITS			   16
+#define MAX_PENDING_TASKS		   (1u << NUM_INDEX_BITS)
+#define NUM_SEGMENT_INDEX_BITS	   8
+#define TASKS_PER_SEGMENT		   (1u << NUM_SEGMENT_INDEX_BITS)
+#define MAX_TASK_SEGMENTS		   (MAX_PENDING_TASKS / TASKS_PER_SEGMENT)
+#define MAX_EXECUTABLE_TASKS	   MAX_PENDING_TASKS
+#define MAX_INLINE_DEPENDENT_TASKS 16
+#define DEPENDENT_CHUNK_SIZE	   31
+#define MAX_PAYLOAD_SIZE		   128
 #define WORKER_HUNK_SIZE	 (1 * 1024 * 1024)
 #define WAIT_SPIN_COUNT		 100
+#define WORKER_DEQUE_SIZE	 256
+#define JOIN_MAX_HELPED_TASKS 64
+#define JOIN_HELP_POLL_MS	 1
+#define TRACE_EVENTS_PER_WORKER 8192
+#define TRACE_MAX_FRAMES	 256
+#define RANGE_CHUNK_DIVISOR	 4
+#define NUM_ARENA_FRAMES	 2
+#define ARENA_ALIGNMENT		 16
 
 COMPILE_TIME_ASSERT (tasks, MAX_EXECUTABLE_TASKS >= 256);
 COMPILE_TIME_ASSERT (tasks, MAX_PENDING_TASKS >= MAX_EXECUTABLE_TASKS);
+COMPILE_TIME_ASSERT (tasks, TASKS_PER_SEGMENT >= 256);
+COMPILE_TIME_ASSERT (tasks, (WORKER_DEQUE_SIZE & (WORKER_DEQUE_SIZE - 1)) == 0);
 
 typedef enum
 {
 	TASK_TYPE_NONE,
 	TASK_TYPE_SCALAR,
 	TASK_TYPE_INDEXED,
+	TASK_TYPE_RANGE,
 } task_type_t;
 
+// Overflow dependents are chained per task slot and kept when the slot is recycled
+typedef struct task_dependents_s
+{
+	task_handle_t			  handles[DEPENDENT_CHUNK_SIZE];
+	struct task_dependents_s *next;
+} task_dependents_t;
+
 typedef struct
 {
 	task_type_t		task_type;
@@ -67,10 +89,13 @@ typedef struct
 	atomic_uint32_t remaining_dependencies;
 	uint64_t		epoch;
 	void		   *func;
+	task_priority_t priority;
+	const char	   *name;
 	SDL_mutex	   *epoch_mutex;
 	SDL_cond	   *epoch_condition;
 	uint8_t			payload[MAX_PAYLOAD_SIZE];
-	task_handle_t	dependent_task_handles[MAX_DEPENDENT_TASKS];
+	task_handle_t	   dependent_task_handles[MAX_INLINE_DEPENDENT_TASKS];
+	task_dependents_t *overflow_dependents;
 } task_t;
 
 typedef struct
@@ -91,24 +116,122 @@ typedef struct
 	uint32_t		limit;
 } task_counter_t;
 
+// Task slots are allocated in segments on demand, the handle index
+// selects the segment in the upper and the slot in the lower bits
+typedef struct
+{
+	task_t		   tasks[TASKS_PER_SEGMENT];
+	task_counter_t indexed_task_counters[1]; // num_workers * TASKS_PER_SEGMENT
+} task_segment_t;
+
+// Chase-Lev deque, only the owning worker pushes/pops at the bottom, other workers steal from the top
+typedef struct
+{
+	atomic_uint32_t top;
+	uint32_t		top_padding[15]; // Pad to 64 byte cache line size
+	atomic_uint32_t bottom;
+	uint32_t		bottom_padding[15];
+	atomic_uint32_t task_indices[WORKER_DEQUE_SIZE];
+} task_deque_t;
+
+typedef struct
+{
+	atomic_uint64_t num_executed;
+	atomic_uint64_t num_stolen;
+	uint64_t		padding[6]; // Pad to 64 byte cache line size
+} worker_stats_t;
+
+// sequence is 0 while an event is being written, dumps skip those
+typedef struct
+{
+	atomic_uint32_t sequence;
+	task_type_t		task_type;
+	const char	   *name;
+	uint64_t		begin_ticks;
+	uint64_t		end_ticks;
+} trace_event_t;
+
+typedef struct
+{
+	uint32_t	  num_written;
+	trace_event_t events[TRACE_EVENTS_PER_WORKER];
+} trace_buffer_t;
+
+typedef struct
+{
+	atomic_uint64_t num_joins;
+	atomic_uint64_t join_ticks;
+	atomic_uint64_t num_helped;
+	atomic_uint64_t helped_ticks;
+} join_stats_t;
+
+// Frame arena allocations that didn't fit into the worker hunk, header is padded to ARENA_ALIGNMENT
+typedef struct arena_block_s
+{
+	struct arena_block_s *next;
+} arena_block_t;
+
+COMPILE_TIME_ASSERT (arena_block, sizeof (arena_block_t) <= ARENA_ALIGNMENT);
+
+// used/overflow_used/overflow_blocks are only touched by the owning thread
+// and by Arena_EndFrame once every task of that frame has finished
+typedef struct
+{
+	byte		   *base;
+	size_t			used;
+	size_t			overflow_used;
+	arena_block_t  *overflow_blocks;
+	atomic_uint64_t high_water;
+	atomic_uint64_t overflow_bytes;
+	uint64_t		padding[2]; // Pad to 64 byte cache line size
+} frame_arena_t;
+
 static int					 num_workers = 0;
 static SDL_Thread		   **worker_threads;
-static task_t				 tasks[MAX_PENDING_TASKS];
+static task_segment_t		*task_segments[MAX_TASK_SEGMENTS];
+static atomic_uint32_t		 num_task_segments;
+static atomic_uint32_t		 growing_task_pool;
 static task_queue_t			*free_task_queue;
-static task_queue_t			*executable_task_queue;
-static task_counter_t		*indexed_task_counters;
+static task_queue_t			*executable_task_queues[NUM_TASK_PRIORITIES];
 static uint8_t				 steal_worker_indices[TASKS_MAX_WORKERS * 2];
+static qboolean				 work_stealing = false;
+static task_deque_t			*worker_deques;
+static worker_stats_t		*worker_stats;
+static SDL_sem				*work_semaphore;
+static atomic_uint32_t		 join_helper_busy;
+static join_stats_t			 join_stats;
+static atomic_uint32_t		 trace_enabled;
+static trace_buffer_t		*trace_buffers;
+static uint64_t				 trace_frame_ticks[TRACE_MAX_FRAMES];
+static uint32_t				 trace_num_frames;
+static frame_arena_t		*frame_arenas;
+static atomic_uint32_t		 arena_frame;
+
+static void Tasks_TraceCallback (cvar_t *var);
+cvar_t		tasks_trace = {"tasks_trace", "0", CVAR_NONE};
 static THREAD_LOCAL qboolean is_worker = false;
 static THREAD_LOCAL int		 tl_worker_index;
+static THREAD_LOCAL uint32_t tl_steal_seed = 0x9E3779B9u;
+
+/*
+====================
+GetTask
+====================
+*/
+static inline task_t *GetTask (uint32_t task_index)
+{
+	return &task_segments[task_index >> NUM_SEGMENT_INDEX_BITS]->tasks[task_index & (TASKS_PER_SEGMENT - 1)];
+}
 
 /*
 ====================
-IndexedTaskCounterIndex
+GetIndexedTaskCounter
 ====================
 */
-static inline int IndexedTaskCounterIndex (int task_index, int worker_index)
+static inline task_counter_t *GetIndexedTaskCounter (uint32_t task_index, int worker_index)
 {
-	return (MAX_PENDING_TASKS * worker_index) + task_index;
+	task_segment_t *segment = task_segments[task_index >> NUM_SEGMENT_INDEX_BITS];
+	return &segment->indexed_task_counters[(TASKS_PER_SEGMENT * worker_index) + (task_index & (TASKS_PER_SEGMENT - 1))];
 }
 
 /*
@@ -136,7 +259,7 @@ static inline uint64_t EpochFromTaskHandle (task_handle_t handle)
 CreateTaskHandle
 ====================
 */
-static inline task_handle_t CreateTaskHandle (uint32_t index, int epoch)
+static inline task_handle_t CreateTaskHandle (uint32_t index, uint64_t epoch)
 {
 	return (task_handle_t)index | ((task_handle_t)epoch << NUM_INDEX_BITS);
 }
@@ -197,7 +320,7 @@ static task_queue_t *CreateTaskQueue (int capacity)
 {
 	assert (capacity > 0);
 	assert ((capacity & (capacity - 1)) == 0); // Needs to be power of 2
-	task_queue_t *queue = Mem_Alloc (sizeof (task_queue_t) + (sizeof (atomic_uint32_t) * (capacity - 1)));
+	task_queue_t *queue = Mem_AllocTagged (sizeof (task_queue_t) + (sizeof (atomic_uint32_t) * (capacity - 1)), MEMTAG_TASKS);
 	queue->capacity_mask = capacity - 1;
 	queue->push_semaphore = SDL_CreateSemaphore (capacity - 1);
 	queue->pop_semaphore = SDL_CreateSemaphore (0);
@@ -231,12 +354,11 @@ static inline void TaskQueuePush (task_queue_t *queue, uint32_t task_index)
 
 /*
 ====================
-TaskQueuePop
-====================a
+TaskQueuePopReserved
+====================
 */
-static inline uint32_t TaskQueuePop (task_queue_t *queue)
+static inline uint32_t TaskQueuePopReserved (task_queue_t *queue)
 {
-	SpinWaitSemaphore (queue->pop_semaphore);
 	uint32_t tail = Atomic_LoadUInt32 (&queue->tail);
 	qboolean cas_successful = false;
 	do
@@ -259,320 +381,1107 @@ static inline uint32_t TaskQueuePop (task_queue_t *queue)
 
 /*
 ====================
-Task_ExecuteIndexed
+TaskQueuePop
 ====================
 */
-static inline void Task_ExecuteIndexed (int worker_index, task_t *task, uint32_t task_index)
+static inline uint32_t TaskQueuePop (task_queue_t *queue)
 {
-	for (int i = 0; i < num_workers; ++i)
-	{
-		const int		steal_worker_index = steal_worker_indices[worker_index + i];
-		int				counter_index = IndexedTaskCounterIndex (task_index, steal_worker_index);
-		task_counter_t *counter = &indexed_task_counters[counter_index];
-		uint32_t		index = 0;
-		while ((index = Atomic_IncrementUInt32 (&counter->index)) < counter->limit)
-		{
-			((task_indexed_func_t)task->func) (index, task->payload);
-		}
-	}
+	SpinWaitSemaphore (queue->pop_semaphore);
+	return TaskQueuePopReserved (queue);
 }
 
 /*
 ====================
-Task_Worker
+TaskQueueTryPop
 ====================
 */
-static int Task_Worker (void *data)
+static inline qboolean TaskQueueTryPop (task_queue_t *queue, uint32_t *task_index)
 {
-	is_worker = true;
-
-	const int worker_index = (intptr_t)data;
-	tl_worker_index = worker_index;
-	while (true)
-	{
-		uint32_t task_index = TaskQueuePop (executable_task_queue);
-		task_t	*task = &tasks[task_index];
-		ANNOTATE_HAPPENS_AFTER (task);
-
-		if (task->task_type == TASK_TYPE_SCALAR)
-		{
-			((task_func_t)task->func) (task->payload);
-		}
-		else if (task->task_type == TASK_TYPE_INDEXED)
-		{
-			Task_ExecuteIndexed (worker_index, task, task_index);
-		}
-
-#if defined(USE_HELGRIND)
-		ANNOTATE_HAPPENS_BEFORE (task);
-		qboolean indexed_task = task->task_type == TASK_TYPE_INDEXED;
-		if (indexed_task)
-		{
-			// Helgrind needs to know about all threads
-			// that participated in an indexed execution
-			SDL_LockMutex (task->epoch_mutex);
-			for (int i = 0; i < task->num_dependents; ++i)
-			{
-				const int task_index = IndexFromTaskHandle (task->dependent_task_handles[i]);
-				task_t	 *dep_task = &tasks[task_index];
-				ANNOTATE_HAPPENS_BEFORE (dep_task);
-			}
-		}
-#endif
+	if (SDL_SemTryWait (queue->pop_semaphore) != 0)
+		return false;
+	*task_index = TaskQueuePopReserved (queue);
+	return true;
+}
 
-		if (Atomic_DecrementUInt32 (&task->remaining_workers) == 1)
-		{
-			SDL_LockMutex (task->epoch_mutex);
-			for (int i = 0; i < task->num_dependents; ++i)
-				Task_Submit (task->dependent_task_handles[i]);
-			task->epoch += 1;
-			SDL_CondBroadcast (task->epoch_condition);
-			SDL_UnlockMutex (task->epoch_mutex);
-			TaskQueuePush (free_task_queue, task_index);
-		}
+/*
+====================
+TaskDequePush
 
-#if defined(USE_HELGRIND)
-		if (indexed_task)
-			SDL_UnlockMutex (task->epoch_mutex);
-#endif
-	}
-	return 0;
+Only called by the owning worker, fails if the deque is full
+====================
+*/
+static inline qboolean TaskDequePush (task_deque_t *deque, uint32_t task_index)
+{
+	const uint32_t bottom = Atomic_LoadUInt32 (&deque->bottom);
+	const uint32_t top = Atomic_LoadUInt32 (&deque->top);
+	if ((bottom - top) >= WORKER_DEQUE_SIZE)
+		return false;
+	ANNOTATE_HAPPENS_BEFORE (&deque->task_indices[bottom & (WORKER_DEQUE_SIZE - 1)]);
+	Atomic_StoreUInt32 (&deque->task_indices[bottom & (WORKER_DEQUE_SIZE - 1)], task_index);
+	Atomic_StoreUInt32 (&deque->bottom, bottom + 1);
+	return true;
 }
 
 /*
 ====================
-Tasks_Init
+TaskDequePop
+
+Only called by the owning worker, returns the most recently pushed task
 ====================
 */
-void Tasks_Init (void)
+static inline qboolean TaskDequePop (task_deque_t *deque, uint32_t *task_index)
 {
-	free_task_queue = CreateTaskQueue (MAX_PENDING_TASKS);
-	executable_task_queue = CreateTaskQueue (MAX_EXECUTABLE_TASKS);
-
-	for (uint32_t task_index = 0; task_index < (MAX_PENDING_TASKS - 1); ++task_index)
+	const uint32_t bottom = Atomic_LoadUInt32 (&deque->bottom) - 1;
+	Atomic_StoreUInt32 (&deque->bottom, bottom);
+	// the store to bottom must be visible before top is read, or the owner and a thief can both take the last task
+	Atomic_ThreadFence ();
+	uint32_t top = Atomic_LoadUInt32 (&deque->top);
+	if ((int32_t)(bottom - top) < 0)
 	{
-		TaskQueuePush (free_task_queue, task_index);
+		Atomic_StoreUInt32 (&deque->bottom, bottom + 1);
+		return false;
 	}
 
-	for (uint32_t task_index = 0; task_index < MAX_PENDING_TASKS; ++task_index)
+	*task_index = Atomic_LoadUInt32 (&deque->task_indices[bottom & (WORKER_DEQUE_SIZE - 1)]);
+	qboolean success = true;
+	if (bottom == top)
 	{
-		tasks[task_index].epoch_mutex = SDL_CreateMutex ();
-		tasks[task_index].epoch_condition = SDL_CreateCond ();
+		// Last entry, race against stealers
+		success = Atomic_CompareExchangeUInt32 (&deque->top, &top, top + 1);
+		Atomic_StoreUInt32 (&deque->bottom, bottom + 1);
 	}
+	if (success)
+		ANNOTATE_HAPPENS_AFTER (&deque->task_indices[bottom & (WORKER_DEQUE_SIZE - 1)]);
+	return success;
+}
 
-	num_workers = CLAMP (1, SDL_GetCPUCount (), TASKS_MAX_WORKERS);
+/*
+====================
+TaskDequeSteal
 
-	// Fill lookup table to avoid modulo in Task_ExecuteIndexed
-	for (int i = 0; i < num_workers; ++i)
-	{
-		steal_worker_indices[i] = i;
-		steal_worker_indices[i + num_workers] = i;
-	}
+Called by other workers, returns the oldest task
+====================
+*/
+static inline qboolean TaskDequeSteal (task_deque_t *deque, uint32_t *task_index)
+{
+	uint32_t top = Atomic_LoadUInt32 (&deque->top);
+	Atomic_ThreadFence (); // pairs with the fence in TaskDequePop
+	const uint32_t bottom = Atomic_LoadUInt32 (&deque->bottom);
+	if ((int32_t)(bottom - top) <= 0)
+		return false;
 
-	indexed_task_counters = Mem_Alloc (sizeof (task_counter_t) * num_workers * MAX_PENDING_TASKS);
-	worker_threads = (SDL_Thread **)Mem_Alloc (sizeof (SDL_Thread *) * num_workers);
-	for (int i = 0; i < num_workers; ++i)
-	{
-		worker_threads[i] = SDL_CreateThread (Task_Worker, "Task_Worker", (void *)(intptr_t)i);
-	}
+	*task_index = Atomic_LoadUInt32 (&deque->task_indices[top & (WORKER_DEQUE_SIZE - 1)]);
+	if (!Atomic_CompareExchangeUInt32 (&deque->top, &top, top + 1))
+		return false;
+	ANNOTATE_HAPPENS_AFTER (&deque->task_indices[top & (WORKER_DEQUE_SIZE - 1)]);
+	return true;
 }
 
 /*
 ====================
-Tasks_NumWorkers
+StealRandom
 ====================
 */
-int Tasks_NumWorkers (void)
+static inline uint32_t StealRandom (void)
 {
-	return num_workers;
+	// xorshift32
+	uint32_t x = tl_steal_seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	tl_steal_seed = x;
+	return x;
 }
 
 /*
 ====================
-Tasks_IsWorker
+GetWorkerDeque
 ====================
 */
-qboolean Tasks_IsWorker (void)
+static inline task_deque_t *GetWorkerDeque (int worker_index, task_priority_t priority)
 {
-	return is_worker;
+	return &worker_deques[(worker_index * NUM_TASK_PRIORITIES) + priority];
 }
+
 /*
 ====================
-Tasks_GetWorkerIndex
+PushExecutableTask
 ====================
 */
-int Tasks_GetWorkerIndex (void)
+static void PushExecutableTask (uint32_t task_index, task_priority_t priority)
 {
-	return tl_worker_index;
+	// Tasks released by a worker stay on that worker unless they get stolen
+	if (!work_stealing || !is_worker || (tl_worker_index >= num_workers) || !TaskDequePush (GetWorkerDeque (tl_worker_index, priority), task_index))
+		TaskQueuePush (executable_task_queues[priority], task_index);
+	SDL_SemPost (work_semaphore);
 }
 
 /*
 ====================
-Task_Allocate
+TryFindExecutableTask
+
+Does a single pass over all lanes up to max_priority, critical lane first.
+The caller needs to have acquired work_semaphore.
 ====================
 */
-task_handle_t Task_Allocate (void)
+static qboolean TryFindExecutableTask (int worker_index, task_priority_t max_priority, uint32_t *task_index)
 {
-	uint32_t task_index = TaskQueuePop (free_task_queue);
-	task_t	*task = &tasks[task_index];
-	Atomic_StoreUInt32 (&task->remaining_dependencies, 1);
-	task->task_type = TASK_TYPE_NONE;
-	task->num_dependents = 0;
-	task->indexed_limit = 0;
-	task->func = NULL;
-	return CreateTaskHandle (task_index, task->epoch);
+	for (int priority = TASK_PRIORITY_CRITICAL; priority <= max_priority; ++priority)
+	{
+		if (work_stealing && (worker_index < num_workers) && TaskDequePop (GetWorkerDeque (worker_index, priority), task_index))
+			return true;
+		if (TaskQueueTryPop (executable_task_queues[priority], task_index))
+			return true;
+		if (!work_stealing)
+			continue;
+		const uint32_t first_victim = StealRandom () % num_workers;
+		for (int i = 0; i < num_workers; ++i)
+		{
+			const int victim_index = steal_worker_indices[first_victim + i];
+			if ((victim_index != worker_index) && TaskDequeSteal (GetWorkerDeque (victim_index, priority), task_index))
+			{
+				Atomic_IncrementUInt64 (&worker_stats[worker_index].num_stolen);
+				return true;
+			}
+		}
+	}
+	return false;
 }
 
 /*
 ====================
-Task_AssignFunc
+PopExecutableTask
 ====================
 */
-void Task_AssignFunc (task_handle_t handle, task_func_t func, void *payload, size_t payload_size)
+static uint32_t PopExecutableTask (int worker_index)
 {
-	assert (payload_size <= MAX_PAYLOAD_SIZE);
-	task_t *task = &tasks[IndexFromTaskHandle (handle)];
-	task->task_type = TASK_TYPE_SCALAR;
-	task->func = (void *)func;
-	if (payload)
-		memcpy (&task->payload, payload, payload_size);
+	// Every post to work_semaphore is matched by exactly one pushed task,
+	// so after a successful wait there is guaranteed to be a task somewhere
+	SpinWaitSemaphore (work_semaphore);
+	uint32_t task_index;
+	while (!TryFindExecutableTask (worker_index, NUM_TASK_PRIORITIES - 1, &task_index))
+		CPUPause ();
+	return task_index;
 }
 
 /*
 ====================
-Task_AssignIndexedFunc
+TryPopExecutableTask
 ====================
 */
-void Task_AssignIndexedFunc (task_handle_t handle, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
+static qboolean TryPopExecutableTask (int worker_index, task_priority_t max_priority, uint32_t *task_index)
 {
-	assert (payload_size <= MAX_PAYLOAD_SIZE);
-	uint32_t task_index = IndexFromTaskHandle (handle);
-	task_t	*task = &tasks[task_index];
-	task->task_type = TASK_TYPE_INDEXED;
-	task->func = (void *)func;
-	task->indexed_limit = limit;
-	uint32_t index = 0;
-	uint32_t count_per_worker = (limit + num_workers - 1) / num_workers;
-	for (int worker_index = 0; worker_index < num_workers; ++worker_index)
-	{
-		const int		task_counter_index = IndexedTaskCounterIndex (task_index, worker_index);
-		task_counter_t *counter = &indexed_task_counters[task_counter_index];
-		Atomic_StoreUInt32 (&counter->index, index);
-		counter->limit = q_min (index + count_per_worker, limit);
-		index += count_per_worker;
-	}
-	if (payload)
-		memcpy (&task->payload, payload, payload_size);
+	if (SDL_SemTryWait (work_semaphore) != 0)
+		return false;
+	if (TryFindExecutableTask (worker_index, max_priority, task_index))
+		return true;
+	// Only lower priority work is queued, hand the token back to the workers
+	SDL_SemPost (work_semaphore);
+	return false;
 }
 
 /*
 ====================
-Task_Submit
+GetDependentHandle
 ====================
 */
-void Task_Submit (task_handle_t handle)
+static inline task_handle_t GetDependentHandle (task_t *task, int dependent_index)
 {
-	uint32_t task_index = IndexFromTaskHandle (handle);
-	task_t	*task = &tasks[task_index];
-	assert (task->epoch == EpochFromTaskHandle (handle));
-	ANNOTATE_HAPPENS_BEFORE (task);
-	if (Atomic_DecrementUInt32 (&task->remaining_dependencies) == 1)
+	if (dependent_index < MAX_INLINE_DEPENDENT_TASKS)
+		return task->dependent_task_handles[dependent_index];
+	dependent_index -= MAX_INLINE_DEPENDENT_TASKS;
+	task_dependents_t *chunk = task->overflow_dependents;
+	for (; dependent_index >= DEPENDENT_CHUNK_SIZE; dependent_index -= DEPENDENT_CHUNK_SIZE)
+		chunk = chunk->next;
+	return chunk->handles[dependent_index];
+}
+
+/*
+====================
+AddDependentHandle
+
+Needs to be called with the task's epoch_mutex locked
+====================
+*/
+static void AddDependentHandle (task_t *task, task_handle_t handle)
+{
+	int dependent_index = task->num_dependents++;
+	if (dependent_index < MAX_INLINE_DEPENDENT_TASKS)
 	{
-		const int num_task_workers = (task->task_type == TASK_TYPE_INDEXED) ? q_min (task->indexed_limit, num_workers) : 1;
-		Atomic_StoreUInt32 (&task->remaining_workers, num_task_workers);
-		for (int i = 0; i < num_task_workers; ++i)
-		{
-			TaskQueuePush (executable_task_queue, task_index);
-		}
+		task->dependent_task_handles[dependent_index] = handle;
+		return;
+	}
+	dependent_index -= MAX_INLINE_DEPENDENT_TASKS;
+	task_dependents_t **chunk = &task->overflow_dependents;
+	while (true)
+	{
+		if (!*chunk)
+			*chunk = (task_dependents_t *)Mem_AllocTagged (sizeof (task_dependents_t), MEMTAG_TASKS);
+		if (dependent_index < DEPENDENT_CHUNK_SIZE)
+			break;
+		dependent_index -= DEPENDENT_CHUNK_SIZE;
+		chunk = &(*chunk)->next;
 	}
+	(*chunk)->handles[dependent_index] = handle;
 }
+
 /*
 ====================
-Tasks_Submit
+SubmitDependents
 ====================
 */
-
-void Tasks_Submit (int num_handles, task_handle_t *handles)
+static void SubmitDependents (task_t *task)
 {
-	for (int i = 0; i < num_handles; ++i)
+	const int num_inline = q_min (task->num_dependents, MAX_INLINE_DEPENDENT_TASKS);
+	for (int i = 0; i < num_inline; ++i)
+		Task_Submit (task->dependent_task_handles[i]);
+	int remaining = task->num_dependents - num_inline;
+	for (task_dependents_t *chunk = task->overflow_dependents; remaining > 0; chunk = chunk->next)
 	{
-		Task_Submit (handles[i]);
+		const int num_chunk = q_min (remaining, DEPENDENT_CHUNK_SIZE);
+		for (int i = 0; i < num_chunk; ++i)
+			Task_Submit (chunk->handles[i]);
+		remaining -= num_chunk;
 	}
 }
 
 /*
 ====================
-Task_AddDependency
+GrowTaskPool
+
+Adds a segment of task slots to the free queue. Returns false
+if the pool is at its limit or another thread is already growing it.
 ====================
 */
-void Task_AddDependency (task_handle_t before, task_handle_t after)
+static qboolean GrowTaskPool (void)
 {
-	uint32_t  before_task_index = IndexFromTaskHandle (before);
-	task_t	 *before_task = &tasks[before_task_index];
-	const int before_handle_task_epoch = EpochFromTaskHandle (before);
-	SDL_LockMutex (before_task->epoch_mutex);
-	if (before_task->epoch != before_handle_task_epoch)
+	uint32_t not_growing = 0;
+	if (!Atomic_CompareExchangeUInt32 (&growing_task_pool, &not_growing, 1))
+		return false;
+
+	const uint32_t segment_index = Atomic_LoadUInt32 (&num_task_segments);
+	if (segment_index >= MAX_TASK_SEGMENTS)
 	{
-		ANNOTATE_HAPPENS_AFTER (before_task);
-		SDL_UnlockMutex (before_task->epoch_mutex);
-		return;
+		Atomic_StoreUInt32 (&growing_task_pool, 0);
+		return false;
 	}
-	uint32_t after_task_index = IndexFromTaskHandle (after);
-	task_t	*after_task = &tasks[after_task_index];
-	assert (before_task->num_dependents < MAX_DEPENDENT_TASKS);
-	before_task->dependent_task_handles[before_task->num_dependents] = after;
-	before_task->num_dependents += 1;
-	Atomic_IncrementUInt32 (&after_task->remaining_dependencies);
-	SDL_UnlockMutex (before_task->epoch_mutex);
+
+	task_segment_t *segment =
+		(task_segment_t *)Mem_AllocTagged (sizeof (task_segment_t) + (sizeof (task_counter_t) * ((num_workers * TASKS_PER_SEGMENT) - 1)), MEMTAG_TASKS);
+	for (uint32_t i = 0; i < TASKS_PER_SEGMENT; ++i)
+	{
+		segment->tasks[i].epoch_mutex = SDL_CreateMutex ();
+		segment->tasks[i].epoch_condition = SDL_CreateCond ();
+	}
+	task_segments[segment_index] = segment;
+	Atomic_StoreUInt32 (&num_task_segments, segment_index + 1);
+
+	const uint32_t first_task_index = segment_index * TASKS_PER_SEGMENT;
+	for (uint32_t i = 0; i < TASKS_PER_SEGMENT; ++i)
+		TaskQueuePush (free_task_queue, first_task_index + i);
+
+	Atomic_StoreUInt32 (&growing_task_pool, 0);
+	return true;
 }
 
 /*
 ====================
-Task_Join
+Task_ExecuteIndexed
 ====================
 */
-qboolean Task_Join (task_handle_t handle, uint32_t timeout)
+static inline void Task_ExecuteIndexed (int worker_index, task_t *task, uint32_t task_index)
 {
-	task_t	 *task = &tasks[IndexFromTaskHandle (handle)];
-	const int handle_task_epoch = EpochFromTaskHandle (handle);
-	SDL_LockMutex (task->epoch_mutex);
-	while (task->epoch == handle_task_epoch)
+	for (int i = 0; i < num_workers; ++i)
 	{
-		if (SDL_CondWaitTimeout (task->epoch_condition, task->epoch_mutex, timeout) == SDL_MUTEX_TIMEDOUT)
+		const int		steal_worker_index = steal_worker_indices[worker_index + i];
+		task_counter_t *counter = GetIndexedTaskCounter (task_index, steal_worker_index);
+		uint32_t		index = 0;
+		while ((index = Atomic_IncrementUInt32 (&counter->index)) < counter->limit)
 		{
-			SDL_UnlockMutex (task->epoch_mutex);
-			return false;
+			((task_indexed_func_t)task->func) (index, task->payload);
 		}
 	}
-	SDL_UnlockMutex (task->epoch_mutex);
-	ANNOTATE_HAPPENS_AFTER (task);
-	return true;
 }
 
-#ifdef _DEBUG
 /*
-=================
-TASKS_TEST_ASSERT
-=================
+====================
+Task_ExecuteRange
+
+Guided scheduling: every claim takes a fraction of what is left in a
+worker's share, so big loops start with big chunks and only the tail
+is split finely for load balancing.
+====================
 */
-#define TASKS_TEST_ASSERT(cond, what) \
-	if (!(cond))                      \
-	{                                 \
-		Con_Printf ("%s\n", what);    \
-		abort ();                     \
+static inline void Task_ExecuteRange (int worker_index, task_t *task, uint32_t task_index)
+{
+	for (int i = 0; i < num_workers; ++i)
+	{
+		const int		steal_worker_index = steal_worker_indices[worker_index + i];
+		task_counter_t *counter = GetIndexedTaskCounter (task_index, steal_worker_index);
+		const uint32_t	limit = counter->limit;
+		while (true)
+		{
+			const uint32_t current = Atomic_LoadUInt32 (&counter->index);
+			if (current >= limit)
+				break;
+			const uint32_t chunk = q_max (1u, (limit - current) / RANGE_CHUNK_DIVISOR);
+			const uint32_t begin = Atomic_AddUInt32 (&counter->index, chunk);
+			if (begin >= limit)
+				break;
+			((task_range_func_t)task->func) (begin, q_min (begin + chunk, limit), task->payload);
+		}
 	}
+}
 
 /*
-=================
-LotsOfTasks
-=================
+====================
+TraceTask
+
+Only called by the thread that owns worker_index
+====================
 */
-static void LotsOfTasksTestTask (void *counters_ptr)
+static void TraceTask (int worker_index, task_t *task, uint64_t begin_ticks)
 {
-	uint32_t *counters = *((uint32_t **)counters_ptr);
-	++counters[Tasks_GetWorkerIndex ()];
+	trace_buffer_t *buffer = &trace_buffers[worker_index];
+	const uint32_t	sequence = ++buffer->num_written;
+	trace_event_t  *event = &buffer->events[sequence & (TRACE_EVENTS_PER_WORKER - 1)];
+	Atomic_StoreUInt32 (&event->sequence, 0);
+	event->task_type = task->task_type;
+	event->name = task->name;
+	event->begin_ticks = begin_ticks;
+	event->end_ticks = SDL_GetPerformanceCounter ();
+	Atomic_StoreUInt32 (&event->sequence, sequence);
 }
-static void LotsOfTasks (void)
+
+/*
+====================
+Task_Execute
+====================
+*/
+static void Task_Execute (int worker_index, uint32_t task_index)
+{
+	task_t *task = GetTask (task_index);
+	Atomic_IncrementUInt64 (&worker_stats[worker_index].num_executed);
+	ANNOTATE_HAPPENS_AFTER (task);
+
+	const qboolean tracing = Atomic_LoadUInt32 (&trace_enabled) != 0;
+	const uint64_t begin_ticks = tracing ? SDL_GetPerformanceCounter () : 0;
+
+	if (task->task_type == TASK_TYPE_SCALAR)
+	{
+		((task_func_t)task->func) (task->payload);
+	}
+	else if (task->task_type == TASK_TYPE_INDEXED)
+	{
+		Task_ExecuteIndexed (worker_index, task, task_index);
+	}
+	else if (task->task_type == TASK_TYPE_RANGE)
+	{
+		Task_ExecuteRange (worker_index, task, task_index);
+	}
+
+	if (tracing)
+		TraceTask (worker_index, task, begin_ticks);
+
+#if defined(USE_HELGRIND)
+	ANNOTATE_HAPPENS_BEFORE (task);
+	qboolean indexed_task = task->task_type != TASK_TYPE_SCALAR;
+	if (indexed_task)
+	{
+		// Helgrind needs to know about all threads
+		// that participated in an indexed execution
+		SDL_LockMutex (task->epoch_mutex);
+		for (int i = 0; i < task->num_dependents; ++i)
+		{
+			task_t *dep_task = GetTask (IndexFromTaskHandle (GetDependentHandle (task, i)));
+			ANNOTATE_HAPPENS_BEFORE (dep_task);
+		}
+	}
+#endif
+
+	if (Atomic_DecrementUInt32 (&task->remaining_workers) == 1)
+	{
+		SDL_LockMutex (task->epoch_mutex);
+		SubmitDependents (task);
+		task->epoch += 1;
+		SDL_CondBroadcast (task->epoch_condition);
+		SDL_UnlockMutex (task->epoch_mutex);
+		TaskQueuePush (free_task_queue, task_index);
+	}
+
+#if defined(USE_HELGRIND)
+	if (indexed_task)
+		SDL_UnlockMutex (task->epoch_mutex);
+#endif
+}
+
+/*
+====================
+Task_Worker
+====================
+*/
+static int Task_Worker (void *data)
+{
+	is_worker = true;
+
+	const int worker_index = (intptr_t)data;
+	tl_worker_index = worker_index;
+	tl_steal_seed = (worker_index + 1) * 0x9E3779B9u;
+	while (true)
+		Task_Execute (worker_index, PopExecutableTask (worker_index));
+	return 0;
+}
+
+/*
+====================
+Tasks_TraceCallback
+====================
+*/
+static void Tasks_TraceCallback (cvar_t *var)
+{
+	if (var->value && !trace_buffers)
+		trace_buffers = (trace_buffer_t *)Mem_AllocTagged (sizeof (trace_buffer_t) * (num_workers + 1), MEMTAG_TASKS);
+	Atomic_StoreUInt32 (&trace_enabled, var->value != 0);
+}
+
+/*
+====================
+Tasks_TraceFrame
+
+Marks the start of a frame for trace_frames
+====================
+*/
+void Tasks_TraceFrame (void)
+{
+	if (!Atomic_LoadUInt32 (&trace_enabled))
+		return;
+	trace_frame_ticks[trace_num_frames % TRACE_MAX_FRAMES] = SDL_GetPerformanceCounter ();
+	++trace_num_frames;
+}
+
+/*
+====================
+TraceTaskName
+
+Names are the stringified function argument, strip casts like "(task_func_t)"
+====================
+*/
+static const char *trace_categories[] = {"none", "scalar", "indexed", "range"};
+static const char *TraceTaskName (const char *name)
+{
+	if (!name)
+		return "unknown";
+	const char *cast_end = strrchr (name, ')');
+	if (cast_end && (name[0] == '('))
+		name = cast_end + 1;
+	while (*name == ' ')
+		++name;
+	return name;
+}
+
+/*
+====================
+Tasks_TraceFrames_f
+
+Writes the last N frames of task events as Chrome trace JSON,
+can be loaded in chrome://tracing or ui.perfetto.dev
+====================
+*/
+static void Tasks_TraceFrames_f (void)
+{
+	if (Cmd_Argc () < 2)
+	{
+		Con_Printf ("trace_frames <numframes> [filename] : write task timeline of the last frames\n");
+		return;
+	}
+	if (!Atomic_LoadUInt32 (&trace_enabled) || (trace_num_frames < 2))
+	{
+		Con_Printf ("no frames traced, set tasks_trace 1 first\n");
+		return;
+	}
+
+	// The current frame is still in flight, only dump completed ones
+	const uint32_t num_completed = q_min (trace_num_frames - 1, (uint32_t)TRACE_MAX_FRAMES - 1);
+	const uint32_t num_frames = CLAMP (1u, (uint32_t)atoi (Cmd_Argv (1)), num_completed);
+	const uint32_t first_frame = trace_num_frames - 1 - num_frames;
+	const uint64_t start_ticks = trace_frame_ticks[first_frame % TRACE_MAX_FRAMES];
+	const uint64_t end_ticks = trace_frame_ticks[(trace_num_frames - 1) % TRACE_MAX_FRAMES];
+	const double   ticks_to_us = 1000000.0 / (double)SDL_GetPerformanceFrequency ();
+
+	char name[MAX_OSPATH];
+	q_snprintf (name, sizeof (name), "%s/%s", com_gamedir, (Cmd_Argc () >= 3) ? Cmd_Argv (2) : "trace.json");
+	COM_CreatePath (name);
+	FILE *f = fopen (name, "w");
+	if (!f)
+	{
+		Con_Printf ("ERROR: couldn't open file %s.\n", name);
+		return;
+	}
+
+	fprintf (f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	fprintf (f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"tasks\"}}");
+	for (int i = 0; i <= num_workers; ++i)
+		fprintf (
+			f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}}", i,
+			(i < num_workers) ? "worker" : "joiner", i);
+	for (uint32_t frame = first_frame; frame < trace_num_frames - 1; ++frame)
+		fprintf (
+			f, ",\n{\"name\":\"frame %u\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}", frame,
+			(trace_frame_ticks[frame % TRACE_MAX_FRAMES] - start_ticks) * ticks_to_us);
+
+	int num_events = 0;
+	for (int i = 0; i <= num_workers; ++i)
+	{
+		trace_buffer_t *buffer = &trace_buffers[i];
+		for (int j = 0; j < TRACE_EVENTS_PER_WORKER; ++j)
+		{
+			trace_event_t *event = &buffer->events[j];
+			const uint32_t sequence = Atomic_LoadUInt32 (&event->sequence);
+			if (sequence == 0)
+				continue;
+			const trace_event_t copy = *event;
+			if ((Atomic_LoadUInt32 (&event->sequence) != sequence) || (copy.begin_ticks < start_ticks) || (copy.begin_ticks >= end_ticks))
+				continue;
+			fprintf (
+				f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", TraceTaskName (copy.name),
+				trace_categories[copy.task_type], i, (copy.begin_ticks - start_ticks) * ticks_to_us, (copy.end_ticks - copy.begin_ticks) * ticks_to_us);
+			++num_events;
+		}
+	}
+	fprintf (f, "\n]}\n");
+	fclose (f);
+	COM_FlushDirectoryCache ();
+	Con_Printf ("wrote %d task events of %u frames to %s\n", num_events, num_frames, name);
+}
+
+/*
+====================
+GetFrameArena
+
+Workers use their own slot, the Task_Join helper uses num_workers and the
+main thread num_workers + 1. Arenas alternate between frames because the
+tasks of the next frame can start before GL_EndRenderingTask has finished.
+====================
+*/
+static inline frame_arena_t *GetFrameArena (int slot, uint32_t frame)
+{
+	return &frame_arenas[(slot * NUM_ARENA_FRAMES) + (frame % NUM_ARENA_FRAMES)];
+}
+
+/*
+====================
+Arena_BeginFrame
+====================
+*/
+void Arena_BeginFrame (void)
+{
+	Atomic_IncrementUInt32 (&arena_frame);
+}
+
+/*
+====================
+Arena_CurrentFrame
+====================
+*/
+uint32_t Arena_CurrentFrame (void)
+{
+	return Atomic_LoadUInt32 (&arena_frame);
+}
+
+/*
+====================
+Arena_FrameAlloc
+
+Memory is not cleared and stays valid until Arena_EndFrame of the current frame
+====================
+*/
+void *Arena_FrameAlloc (size_t size)
+{
+	const int	   slot = is_worker ? tl_worker_index : (num_workers + 1);
+	frame_arena_t *arena = GetFrameArena (slot, Atomic_LoadUInt32 (&arena_frame));
+
+	size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+	if (!arena->base)
+		arena->base = (byte *)Mem_AllocNonZeroTagged (WORKER_HUNK_SIZE, MEMTAG_TASKS);
+	if (size <= (WORKER_HUNK_SIZE - arena->used))
+	{
+		void *ptr = arena->base + arena->used;
+		arena->used += size;
+		return ptr;
+	}
+
+	arena_block_t *block = (arena_block_t *)Mem_AllocNonZeroTagged (ARENA_ALIGNMENT + size, MEMTAG_TASKS);
+	block->next = arena->overflow_blocks;
+	arena->overflow_blocks = block;
+	arena->overflow_used += size;
+	Atomic_AddUInt64 (&arena->overflow_bytes, size);
+	return (byte *)block + ARENA_ALIGNMENT;
+}
+
+/*
+====================
+Arena_EndFrame
+
+Must only be called once every task that allocated during the frame has finished
+====================
+*/
+void Arena_EndFrame (uint32_t frame)
+{
+	for (int slot = 0; slot < (num_workers + 2); ++slot)
+	{
+		frame_arena_t *arena = GetFrameArena (slot, frame);
+		const uint64_t frame_used = arena->used + arena->overflow_used;
+		if (frame_used > Atomic_LoadUInt64 (&arena->high_water))
+			Atomic_StoreUInt64 (&arena->high_water, frame_used);
+		while (arena->overflow_blocks)
+		{
+			arena_block_t *next = arena->overflow_blocks->next;
+			Mem_Free (arena->overflow_blocks);
+			arena->overflow_blocks = next;
+		}
+		arena->used = 0;
+		arena->overflow_used = 0;
+	}
+}
+
+/*
+====================
+Tasks_Init
+====================
+*/
+void Tasks_Init (void)
+{
+	// Free queue needs to be able to hold every slot, push_semaphore is initialized to capacity - 1
+	free_task_queue = CreateTaskQueue (MAX_PENDING_TASKS * 2);
+	for (int i = 0; i < NUM_TASK_PRIORITIES; ++i)
+		executable_task_queues[i] = CreateTaskQueue (MAX_EXECUTABLE_TASKS);
+	work_semaphore = SDL_CreateSemaphore (0);
+
+	num_workers = CLAMP (1, SDL_GetCPUCount (), TASKS_MAX_WORKERS);
+	GrowTaskPool ();
+
+	work_stealing = COM_CheckParm ("-worksteal") != 0;
+	// One extra slot for the thread that helps out in Task_Join
+	worker_stats = (worker_stats_t *)Mem_AllocTagged (sizeof (worker_stats_t) * (num_workers + 1), MEMTAG_TASKS);
+	// Plus one more for the main thread, hunks are allocated on first use
+	frame_arenas = (frame_arena_t *)Mem_AllocTagged (sizeof (frame_arena_t) * (num_workers + 2) * NUM_ARENA_FRAMES, MEMTAG_TASKS);
+	if (work_stealing)
+	{
+		worker_deques = (task_deque_t *)Mem_AllocTagged (sizeof (task_deque_t) * num_workers * NUM_TASK_PRIORITIES, MEMTAG_TASKS);
+	}
+
+	// Fill lookup table to avoid modulo in Task_ExecuteIndexed
+	for (int i = 0; i < num_workers; ++i)
+	{
+		steal_worker_indices[i] = i;
+		steal_worker_indices[i + num_workers] = i;
+	}
+
+	worker_threads = (SDL_Thread **)Mem_AllocTagged (sizeof (SDL_Thread *) * num_workers, MEMTAG_TASKS);
+	for (int i = 0; i < num_workers; ++i)
+	{
+		worker_threads[i] = SDL_CreateThread (Task_Worker, "Task_Worker", (void *)(intptr_t)i);
+	}
+}
+
+/*
+====================
+Tasks_InitCommands
+====================
+*/
+void Tasks_InitCommands (void)
+{
+	Cvar_RegisterVariable (&tasks_trace);
+	Cvar_SetCallback (&tasks_trace, Tasks_TraceCallback);
+	Cmd_AddCommand ("tasks_stats", Tasks_Stats_f);
+	Cmd_AddCommand ("trace_frames", Tasks_TraceFrames_f);
+}
+
+/*
+====================
+Tasks_NumWorkers
+====================
+*/
+int Tasks_NumWorkers (void)
+{
+	return num_workers;
+}
+
+/*
+====================
+Tasks_IsWorker
+====================
+*/
+qboolean Tasks_IsWorker (void)
+{
+	return is_worker;
+}
+/*
+====================
+Tasks_GetWorkerIndex
+====================
+*/
+int Tasks_GetWorkerIndex (void)
+{
+	return tl_worker_index;
+}
+
+/*
+====================
+Task_Allocate
+====================
+*/
+task_handle_t Task_Allocate (void)
+{
+	uint32_t task_index;
+	while (!TaskQueueTryPop (free_task_queue, &task_index))
+	{
+		if (!GrowTaskPool ())
+		{
+			// Either at the limit or another thread is adding slots right now
+			task_index = TaskQueuePop (free_task_queue);
+			break;
+		}
+	}
+	task_t *task = GetTask (task_index);
+	Atomic_StoreUInt32 (&task->remaining_dependencies, 1);
+	task->task_type = TASK_TYPE_NONE;
+	task->num_dependents = 0;
+	task->indexed_limit = 0;
+	task->func = NULL;
+	task->name = NULL;
+	task->priority = TASK_PRIORITY_CRITICAL;
+	return CreateTaskHandle (task_index, task->epoch);
+}
+
+/*
+====================
+Task_AssignFunc
+====================
+*/
+void Task_AssignFuncNamed (task_handle_t handle, task_func_t func, void *payload, size_t payload_size, const char *name)
+{
+	assert (payload_size <= MAX_PAYLOAD_SIZE);
+	task_t *task = GetTask (IndexFromTaskHandle (handle));
+	task->task_type = TASK_TYPE_SCALAR;
+	task->func = (void *)func;
+	task->name = name;
+	if (payload)
+		memcpy (&task->payload, payload, payload_size);
+}
+
+/*
+====================
+InitIndexedTaskCounters
+====================
+*/
+static void InitIndexedTaskCounters (uint32_t task_index, uint32_t limit)
+{
+	uint32_t index = 0;
+	uint32_t count_per_worker = (limit + num_workers - 1) / num_workers;
+	for (int worker_index = 0; worker_index < num_workers; ++worker_index)
+	{
+		task_counter_t *counter = GetIndexedTaskCounter (task_index, worker_index);
+		Atomic_StoreUInt32 (&counter->index, index);
+		counter->limit = q_min (index + count_per_worker, limit);
+		index += count_per_worker;
+	}
+}
+
+/*
+====================
+Task_AssignIndexedFunc
+====================
+*/
+void Task_AssignIndexedFuncNamed (task_handle_t handle, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size, const char *name)
+{
+	assert (payload_size <= MAX_PAYLOAD_SIZE);
+	uint32_t task_index = IndexFromTaskHandle (handle);
+	task_t	*task = GetTask (task_index);
+	task->task_type = TASK_TYPE_INDEXED;
+	task->func = (void *)func;
+	task->name = name;
+	task->indexed_limit = limit;
+	InitIndexedTaskCounters (task_index, limit);
+	if (payload)
+		memcpy (&task->payload, payload, payload_size);
+}
+
+/*
+====================
+Task_AssignRangeFunc
+====================
+*/
+void Task_AssignRangeFuncNamed (task_handle_t handle, task_range_func_t func, uint32_t limit, void *payload, size_t payload_size, const char *name)
+{
+	assert (payload_size <= MAX_PAYLOAD_SIZE);
+	uint32_t task_index = IndexFromTaskHandle (handle);
+	task_t	*task = GetTask (task_index);
+	task->task_type = TASK_TYPE_RANGE;
+	task->func = (void *)func;
+	task->name = name;
+	task->indexed_limit = limit;
+	InitIndexedTaskCounters (task_index, limit);
+	if (payload)
+		memcpy (&task->payload, payload, payload_size);
+}
+
+/*
+====================
+Task_SetPriority
+====================
+*/
+void Task_SetPriority (task_handle_t handle, task_priority_t priority)
+{
+	assert ((priority >= TASK_PRIORITY_CRITICAL) && (priority < NUM_TASK_PRIORITIES));
+	task_t *task = GetTask (IndexFromTaskHandle (handle));
+	assert (task->epoch == EpochFromTaskHandle (handle));
+	task->priority = priority;
+}
+
+/*
+====================
+Task_Submit
+====================
+*/
+void Task_Submit (task_handle_t handle)
+{
+	uint32_t task_index = IndexFromTaskHandle (handle);
+	task_t	*task = GetTask (task_index);
+	assert (task->epoch == EpochFromTaskHandle (handle));
+	ANNOTATE_HAPPENS_BEFORE (task);
+	if (Atomic_DecrementUInt32 (&task->remaining_dependencies) == 1)
+	{
+		const int num_task_workers = (task->task_type != TASK_TYPE_SCALAR) ? q_min (task->indexed_limit, num_workers) : 1;
+		Atomic_StoreUInt32 (&task->remaining_workers, num_task_workers);
+		for (int i = 0; i < num_task_workers; ++i)
+		{
+			PushExecutableTask (task_index, task->priority);
+		}
+	}
+}
+/*
+====================
+Tasks_Submit
+====================
+*/
+
+void Tasks_Submit (int num_handles, task_handle_t *handles)
+{
+	for (int i = 0; i < num_handles; ++i)
+	{
+		Task_Submit (handles[i]);
+	}
+}
+
+/*
+====================
+Task_AddDependency
+====================
+*/
+void Task_AddDependency (task_handle_t before, task_handle_t after)
+{
+	uint32_t	   before_task_index = IndexFromTaskHandle (before);
+	task_t		  *before_task = GetTask (before_task_index);
+	const uint64_t before_handle_task_epoch = EpochFromTaskHandle (before);
+	SDL_LockMutex (before_task->epoch_mutex);
+	if (before_task->epoch != before_handle_task_epoch)
+	{
+		ANNOTATE_HAPPENS_AFTER (before_task);
+		SDL_UnlockMutex (before_task->epoch_mutex);
+		return;
+	}
+	uint32_t after_task_index = IndexFromTaskHandle (after);
+	task_t	*after_task = GetTask (after_task_index);
+	AddDependentHandle (before_task, after);
+	Atomic_IncrementUInt32 (&after_task->remaining_dependencies);
+	SDL_UnlockMutex (before_task->epoch_mutex);
+}
+
+/*
+====================
+Task_JoinHelping
+
+Executes queued tasks on the calling thread while waiting. Helped tasks
+run with the spare worker index num_workers, so per-worker data indexed
+by Tasks_GetWorkerIndex is never shared with a real worker. Because the
+thread counts as a worker while helping, nested joins just block.
+Only tasks of the same or higher priority than the joined one are taken.
+====================
+*/
+static qboolean Task_JoinHelping (task_t *task, uint64_t handle_task_epoch, uint32_t timeout)
+{
+	const uint32_t start_ms = SDL_GetTicks ();
+	int			   num_helped = 0;
+	SDL_LockMutex (task->epoch_mutex);
+	// Only valid while the epoch matches, slot can be reused afterwards
+	const task_priority_t max_priority = task->priority;
+	while (task->epoch == handle_task_epoch)
+	{
+		const uint32_t elapsed_ms = SDL_GetTicks () - start_ms;
+		if ((timeout != SDL_MUTEX_MAXWAIT) && (elapsed_ms >= timeout))
+		{
+			SDL_UnlockMutex (task->epoch_mutex);
+			return false;
+		}
+
+		uint32_t task_index;
+		if ((num_helped < JOIN_MAX_HELPED_TASKS) && TryPopExecutableTask (num_workers, max_priority, &task_index))
+		{
+			SDL_UnlockMutex (task->epoch_mutex);
+			const uint64_t help_start = SDL_GetPerformanceCounter ();
+			is_worker = true;
+			tl_worker_index = num_workers;
+			Task_Execute (num_workers, task_index);
+			is_worker = false;
+			tl_worker_index = 0;
+			Atomic_AddUInt64 (&join_stats.helped_ticks, SDL_GetPerformanceCounter () - help_start);
+			Atomic_IncrementUInt64 (&join_stats.num_helped);
+			++num_helped;
+			SDL_LockMutex (task->epoch_mutex);
+			continue;
+		}
+
+		// Completion wakes us up right away, the short timeout only polls for new work
+		uint32_t wait_ms = (timeout != SDL_MUTEX_MAXWAIT) ? (timeout - elapsed_ms) : SDL_MUTEX_MAXWAIT;
+		if (num_helped < JOIN_MAX_HELPED_TASKS)
+			wait_ms = q_min (wait_ms, (uint32_t)JOIN_HELP_POLL_MS);
+		SDL_CondWaitTimeout (task->epoch_condition, task->epoch_mutex, wait_ms);
+	}
+	SDL_UnlockMutex (task->epoch_mutex);
+	return true;
+}
+
+/*
+====================
+Task_JoinWaiting
+====================
+*/
+static qboolean Task_JoinWaiting (task_t *task, uint64_t handle_task_epoch, uint32_t timeout)
+{
+	SDL_LockMutex (task->epoch_mutex);
+	while (task->epoch == handle_task_epoch)
+	{
+		if (SDL_CondWaitTimeout (task->epoch_condition, task->epoch_mutex, timeout) == SDL_MUTEX_TIMEDOUT)
+		{
+			SDL_UnlockMutex (task->epoch_mutex);
+			return false;
+		}
+	}
+	SDL_UnlockMutex (task->epoch_mutex);
+	return true;
+}
+
+/*
+====================
+Task_Join
+====================
+*/
+qboolean Task_Join (task_handle_t handle, uint32_t timeout)
+{
+	task_t		  *task = GetTask (IndexFromTaskHandle (handle));
+	const uint64_t handle_task_epoch = EpochFromTaskHandle (handle);
+	const uint64_t join_start = SDL_GetPerformanceCounter ();
+	qboolean	   joined;
+
+	// Only one non-worker thread at a time can use the spare worker index
+	uint32_t helper_free = 0;
+	if (!is_worker && (num_workers < TASKS_MAX_WORKERS) && Atomic_CompareExchangeUInt32 (&join_helper_busy, &helper_free, 1))
+	{
+		joined = Task_JoinHelping (task, handle_task_epoch, timeout);
+		Atomic_StoreUInt32 (&join_helper_busy, 0);
+	}
+	else
+		joined = Task_JoinWaiting (task, handle_task_epoch, timeout);
+
+	Atomic_IncrementUInt64 (&join_stats.num_joins);
+	Atomic_AddUInt64 (&join_stats.join_ticks, SDL_GetPerformanceCounter () - join_start);
+	if (joined)
+		ANNOTATE_HAPPENS_AFTER (task);
+	return joined;
+}
+
+/*
+====================
+Tasks_Stats_f
+====================
+*/
+void Tasks_Stats_f (void)
+{
+	if ((Cmd_Argc () >= 2) && !strcmp (Cmd_Argv (1), "reset"))
+	{
+		Atomic_StoreUInt64 (&join_stats.num_joins, 0);
+		Atomic_StoreUInt64 (&join_stats.join_ticks, 0);
+		Atomic_StoreUInt64 (&join_stats.num_helped, 0);
+		Atomic_StoreUInt64 (&join_stats.helped_ticks, 0);
+		for (int i = 0; i <= num_workers; ++i)
+		{
+			Atomic_StoreUInt64 (&worker_stats[i].num_executed, 0);
+			Atomic_StoreUInt64 (&worker_stats[i].num_stolen, 0);
+		}
+		for (int i = 0; i < ((num_workers + 2) * NUM_ARENA_FRAMES); ++i)
+		{
+			Atomic_StoreUInt64 (&frame_arenas[i].high_water, 0);
+			Atomic_StoreUInt64 (&frame_arenas[i].overflow_bytes, 0);
+		}
+		return;
+	}
+
+	const double   ticks_to_ms = 1000.0 / (double)SDL_GetPerformanceFrequency ();
+	const uint64_t num_joins = Atomic_LoadUInt64 (&join_stats.num_joins);
+	const double   join_ms = Atomic_LoadUInt64 (&join_stats.join_ticks) * ticks_to_ms;
+	const double   helped_ms = Atomic_LoadUInt64 (&join_stats.helped_ticks) * ticks_to_ms;
+
+	Con_Printf ("%d workers, %s scheduler, %u task slots\n", num_workers, work_stealing ? "work stealing" : "shared queue",
+		Atomic_LoadUInt32 (&num_task_segments) * TASKS_PER_SEGMENT);
+	Con_Printf ("joins: %" SDL_PRIu64 ", %.1f ms\n", num_joins, join_ms);
+	Con_Printf ("helped: %" SDL_PRIu64 " tasks, %.1f ms (%.1f%% of join time)\n", Atomic_LoadUInt64 (&join_stats.num_helped), helped_ms,
+		(join_ms > 0.0) ? (100.0 * helped_ms / join_ms) : 0.0);
+	for (int i = 0; i <= num_workers; ++i)
+		Con_Printf (
+			"%s %2d: executed %" SDL_PRIu64 ", stolen %" SDL_PRIu64 "\n", (i < num_workers) ? "worker" : "joiner", i,
+			Atomic_LoadUInt64 (&worker_stats[i].num_executed), Atomic_LoadUInt64 (&worker_stats[i].num_stolen));
+
+	Con_Printf ("frame arenas: %d KB per thread and frame\n", WORKER_HUNK_SIZE / 1024);
+	for (int slot = 0; slot < (num_workers + 2); ++slot)
+	{
+		uint64_t high_water = 0;
+		uint64_t overflow_bytes = 0;
+		for (uint32_t frame = 0; frame < NUM_ARENA_FRAMES; ++frame)
+		{
+			frame_arena_t *arena = GetFrameArena (slot, frame);
+			high_water = q_max (high_water, Atomic_LoadUInt64 (&arena->high_water));
+			overflow_bytes += Atomic_LoadUInt64 (&arena->overflow_bytes);
+		}
+		const char *owner = (slot < num_workers) ? "worker" : ((slot == num_workers) ? "joiner" : "main");
+		Con_Printf ("%s %2d: high water %.1f KB, overflow %.1f KB\n", owner, slot, high_water / 1024.0, overflow_bytes / 1024.0);
+	}
+}
+
+#ifdef _DEBUG
+/*
+=================
+TASKS_TEST_ASSERT
+=================
+*/
+#define TASKS_TEST_ASSERT(cond, what) \
+	if (!(cond))                      \
+	{                                 \
+		Con_Printf ("%s\n", what);    \
+		abort ();                     \
+	}
+
+/*
+=================
+LotsOfTasks
+=================
+*/
+static void LotsOfTasksTestTask (void *counters_ptr)
+{
+	uint32_t *counters = *((uint32_t **)counters_ptr);
+	++counters[Tasks_GetWorkerIndex ()];
+}
+static void LotsOfTasks (void)
 {
 	static const int NUM_TASKS = 100000;
 	TEMP_ALLOC_ZEROED (uint32_t, counters, TASKS_MAX_WORKERS);
@@ -612,6 +1521,229 @@ static void IndexedTasks ()
 	TEMP_FREE (counters);
 }
 
+/*
+=================
+RangeTasks
+=================
+*/
+static void RangeTestTask (int begin, int end, void *visited_ptr)
+{
+	atomic_uint32_t *visited = *((atomic_uint32_t **)visited_ptr);
+	for (int i = begin; i < end; ++i)
+		Atomic_IncrementUInt32 (&visited[i]);
+}
+static void RangeTasks (void)
+{
+	static const int LIMIT = 100000;
+	TEMP_ALLOC_ZEROED (atomic_uint32_t, visited, LIMIT);
+	task_handle_t task = Task_AllocateAssignRangeFuncAndSubmit (RangeTestTask, LIMIT, (void *)&visited, sizeof (atomic_uint32_t *));
+	Task_Join (task, SDL_MUTEX_MAXWAIT);
+	for (int i = 0; i < LIMIT; ++i)
+		TASKS_TEST_ASSERT (Atomic_LoadUInt32 (&visited[i]) == 1, "Range index not visited exactly once");
+	TEMP_FREE (visited);
+}
+
+/*
+=================
+ManyDependents
+=================
+*/
+static void ManyDependentsTestTask (void *counter_ptr)
+{
+	atomic_uint32_t *counter = *((atomic_uint32_t **)counter_ptr);
+	Atomic_IncrementUInt32 (counter);
+}
+static void ManyDependents (void)
+{
+	static const int NUM_DEPENDENTS = 5000;
+	atomic_uint32_t	 counter;
+	atomic_uint32_t *counter_ptr = &counter;
+	Atomic_StoreUInt32 (&counter, 0);
+	TEMP_ALLOC (task_handle_t, handles, NUM_DEPENDENTS);
+	task_handle_t root = Task_AllocateAndAssignFunc (ManyDependentsTestTask, &counter_ptr, sizeof (atomic_uint32_t *));
+	for (int i = 0; i < NUM_DEPENDENTS; ++i)
+	{
+		handles[i] = Task_AllocateAndAssignFunc (ManyDependentsTestTask, &counter_ptr, sizeof (atomic_uint32_t *));
+		Task_AddDependency (root, handles[i]);
+		Task_Submit (handles[i]);
+	}
+	TASKS_TEST_ASSERT (Atomic_LoadUInt32 (&counter) == 0, "Dependents executed before root");
+	Task_Submit (root);
+	for (int i = 0; i < NUM_DEPENDENTS; ++i)
+		Task_Join (handles[i], SDL_MUTEX_MAXWAIT);
+	TASKS_TEST_ASSERT (Atomic_LoadUInt32 (&counter) == NUM_DEPENDENTS + 1, "Wrong counter");
+	TEMP_FREE (handles);
+}
+
+/*
+=================
+FrameArenas
+=================
+*/
+static size_t FrameArenaTestSize (int index)
+{
+	// Every 1000th allocation is larger than the worker hunk and has to overflow
+	return ((index % 1000) == 999) ? (WORKER_HUNK_SIZE + 1) : ((index % 61) + 1);
+}
+static void FrameArenaTestTask (int index, void *allocations_ptr)
+{
+	byte		**allocations = *((byte ***)allocations_ptr);
+	const size_t size = FrameArenaTestSize (index);
+	allocations[index] = (byte *)Arena_FrameAlloc (size);
+	memset (allocations[index], index & 0xFF, size);
+}
+static void FrameArenas (void)
+{
+	static const int LIMIT = 10000;
+	TEMP_ALLOC (byte *, allocations, LIMIT);
+	// Render tasks allocate from whatever frame is current, so wait until the last
+	// rendered frame has ended and nothing is in flight before using a frame of our own
+	if (!isDedicated)
+		GL_SynchronizeEndRenderingTask ();
+	Arena_BeginFrame ();
+	byte *main_allocation = (byte *)Arena_FrameAlloc (1);
+	task_handle_t task = Task_AllocateAssignIndexedFuncAndSubmit (FrameArenaTestTask, LIMIT, (void *)&allocations, sizeof (byte **));
+	Task_Join (task, SDL_MUTEX_MAXWAIT);
+	TASKS_TEST_ASSERT (((uintptr_t)main_allocation % ARENA_ALIGNMENT) == 0, "Misaligned arena allocation");
+	for (int i = 0; i < LIMIT; ++i)
+	{
+		TASKS_TEST_ASSERT (((uintptr_t)allocations[i] % ARENA_ALIGNMENT) == 0, "Misaligned arena allocation");
+		TASKS_TEST_ASSERT (allocations[i][0] == (i & 0xFF), "Arena allocations overlap");
+		TASKS_TEST_ASSERT (allocations[i][FrameArenaTestSize (i) - 1] == (i & 0xFF), "Arena allocations overlap");
+	}
+	Arena_EndFrame (Arena_CurrentFrame ());
+	TEMP_FREE (allocations);
+}
+
+/*
+=================
+MixedPriorities
+=================
+*/
+static void MixedPriorities (void)
+{
+	static const int NUM_TASKS = 10000;
+	atomic_uint32_t	 counter;
+	atomic_uint32_t *counter_ptr = &counter;
+	Atomic_StoreUInt32 (&counter, 0);
+	TEMP_ALLOC (task_handle_t, handles, NUM_TASKS);
+	for (int i = 0; i < NUM_TASKS; ++i)
+	{
+		handles[i] = Task_AllocateAndAssignFunc (ManyDependentsTestTask, &counter_ptr, sizeof (atomic_uint32_t *));
+		if (i & 1)
+			Task_SetPriority (handles[i], TASK_PRIORITY_BACKGROUND);
+		if (i > 0)
+			Task_AddDependency (handles[i - 1], handles[i]);
+	}
+	Tasks_Submit (NUM_TASKS, handles);
+	Task_Join (handles[NUM_TASKS - 1], SDL_MUTEX_MAXWAIT);
+	TASKS_TEST_ASSERT (Atomic_LoadUInt32 (&counter) == NUM_TASKS, "Wrong counter");
+	TEMP_FREE (handles);
+}
+
+/*
+=================
+BenchmarkTasks
+=================
+*/
+static void BenchmarkTestTask (void *iterations_ptr)
+{
+	const int	 iterations = *((int *)iterations_ptr);
+	volatile int sink = 0;
+	for (int i = 0; i < iterations; ++i)
+		sink += i;
+}
+static void BenchmarkIndexedTask (int index, void *unused)
+{
+	volatile int sink = index;
+	(void)sink;
+}
+static void BenchmarkRangeTask (int begin, int end, void *unused)
+{
+	for (int i = begin; i < end; ++i)
+		BenchmarkIndexedTask (i, unused);
+}
+static void BenchmarkTasks (int work_iterations)
+{
+	static const int NUM_INDEPENDENT_TASKS = 100000;
+	static const int NUM_GRAPHS = 1000;
+	static const int NUM_CHILDREN = 16;
+	static const int NUM_GRANDCHILDREN = 8;
+
+	uint64_t executed_before = 0;
+	uint64_t stolen_before = 0;
+	for (int i = 0; i <= num_workers; ++i)
+	{
+		executed_before += Atomic_LoadUInt64 (&worker_stats[i].num_executed);
+		stolen_before += Atomic_LoadUInt64 (&worker_stats[i].num_stolen);
+	}
+
+	// Independent tasks submitted from the main thread
+	TEMP_ALLOC (task_handle_t, handles, NUM_INDEPENDENT_TASKS);
+	double start_time = Sys_DoubleTime ();
+	for (int i = 0; i < NUM_INDEPENDENT_TASKS; ++i)
+		handles[i] = Task_AllocateAssignFuncAndSubmit (BenchmarkTestTask, &work_iterations, sizeof (int));
+	for (int i = 0; i < NUM_INDEPENDENT_TASKS; ++i)
+		Task_Join (handles[i], SDL_MUTEX_MAXWAIT);
+	const double independent_time = Sys_DoubleTime () - start_time;
+	TEMP_FREE (handles);
+
+	// Fan-out graphs, dependents get released by the workers
+	const int num_graph_tasks = 1 + NUM_CHILDREN + (NUM_CHILDREN * NUM_GRANDCHILDREN);
+	TEMP_ALLOC (task_handle_t, graph_handles, num_graph_tasks);
+	start_time = Sys_DoubleTime ();
+	for (int graph = 0; graph < NUM_GRAPHS; ++graph)
+	{
+		int num_handles = 0;
+		const task_handle_t root = Task_AllocateAndAssignFunc (BenchmarkTestTask, &work_iterations, sizeof (int));
+		graph_handles[num_handles++] = root;
+		for (int i = 0; i < NUM_CHILDREN; ++i)
+		{
+			const task_handle_t child = Task_AllocateAndAssignFunc (BenchmarkTestTask, &work_iterations, sizeof (int));
+			Task_AddDependency (root, child);
+			graph_handles[num_handles++] = child;
+			for (int j = 0; j < NUM_GRANDCHILDREN; ++j)
+			{
+				const task_handle_t grandchild = Task_AllocateAndAssignFunc (BenchmarkTestTask, &work_iterations, sizeof (int));
+				Task_AddDependency (child, grandchild);
+				graph_handles[num_handles++] = grandchild;
+			}
+		}
+		Tasks_Submit (num_handles, graph_handles);
+		Task_Join (graph_handles[num_handles - 1], SDL_MUTEX_MAXWAIT);
+		for (int i = 0; i < num_handles - 1; ++i)
+			Task_Join (graph_handles[i], SDL_MUTEX_MAXWAIT);
+	}
+	const double graph_time = Sys_DoubleTime () - start_time;
+	TEMP_FREE (graph_handles);
+
+	// Same loop as one index per claim and as guided ranges
+	static const int NUM_ELEMENTS = 1000000;
+	start_time = Sys_DoubleTime ();
+	Task_Join (Task_AllocateAssignIndexedFuncAndSubmit (BenchmarkIndexedTask, NUM_ELEMENTS, NULL, 0), SDL_MUTEX_MAXWAIT);
+	const double indexed_time = Sys_DoubleTime () - start_time;
+	start_time = Sys_DoubleTime ();
+	Task_Join (Task_AllocateAssignRangeFuncAndSubmit (BenchmarkRangeTask, NUM_ELEMENTS, NULL, 0), SDL_MUTEX_MAXWAIT);
+	const double range_time = Sys_DoubleTime () - start_time;
+
+	uint64_t executed = 0;
+	uint64_t stolen = 0;
+	for (int i = 0; i <= num_workers; ++i)
+	{
+		executed += Atomic_LoadUInt64 (&worker_stats[i].num_executed);
+		stolen += Atomic_LoadUInt64 (&worker_stats[i].num_stolen);
+	}
+	executed -= executed_before;
+	stolen -= stolen_before;
+
+	Con_Printf ("%d workers, %s scheduler, %d iterations per task\n", num_workers, work_stealing ? "work stealing" : "shared queue", work_iterations);
+	Con_Printf ("independent: %.0f tasks/sec\n", NUM_INDEPENDENT_TASKS / q_max (independent_time, 1e-6));
+	Con_Printf ("graph:       %.0f tasks/sec\n", (NUM_GRAPHS * num_graph_tasks) / q_max (graph_time, 1e-6));
+	Con_Printf ("indexed:     %.0f elements/sec\n", NUM_ELEMENTS / q_max (indexed_time, 1e-6));
+	Con_Printf ("range:       %.0f elements/sec\n", NUM_ELEMENTS / q_max (range_time, 1e-6));
+	Con_Printf ("executed %" SDL_PRIu64 ", stolen %" SDL_PRIu64 " (%.1f%%)\n", executed, stolen, executed ? (100.0 * stolen / executed) : 0.0);
+}
+
 /*
 =================
 TestTasks_f
@@ -619,7 +1751,16 @@ TestTasks_f
 */
 void TestTasks_f (void)
 {
+	if (Cmd_Argc () >= 2 && !strcmp (Cmd_Argv (1), "bench"))
+	{
+		BenchmarkTasks ((Cmd_Argc () >= 3) ? q_max (0, atoi (Cmd_Argv (2))) : 100);
+		return;
+	}
 	LotsOfTasks ();
 	IndexedTasks ();
+	RangeTasks ();
+	ManyDependents ();
+	MixedPriorities ();
+	FrameArenas ();
 }
 #endif
@@ -30,51 +30,106 @@
 #define TASKS_MAX_WORKERS	32
 
 typedef uint64_t task_handle_t;
+
+typedef enum
+{
+	TASK_PRIORITY_CRITICAL, // Frame critical work, always drained first
+	TASK_PRIORITY_BACKGROUND,
+	NUM_TASK_PRIORITIES,
+} task_priority_t;
+
 typedef void (*task_func_t) (void *);
 typedef void (*task_indexed_func_t) (int, void *);
+typedef void (*task_range_func_t) (int, int, void *); // [begin, end)
 
 void		  Tasks_Init (void);
+void		  Tasks_InitCommands (void);
 int			  Tasks_NumWorkers (void);
 qboolean	  Tasks_IsWorker (void);
 int			  Tasks_GetWorkerIndex (void);
 task_handle_t Task_Allocate (void);
-void		  Task_AssignFunc (task_handle_t handle, task_func_t func, void *payload, size_t payload_size);
-void		  Task_AssignIndexedFunc (task_handle_t handle, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size);
+void		  Task_AssignFuncNamed (task_handle_t handle, task_func_t func, void *payload, size_t payload_size, const char *name);
+void		  Task_AssignIndexedFuncNamed (
+	task_handle_t handle, task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size, const char *name);
+void		  Task_AssignRangeFuncNamed (task_handle_t handle, task_range_func_t func, uint32_t limit, void *payload, size_t payload_size, const char *name);
+void		  Task_SetPriority (task_handle_t handle, task_priority_t priority);
 void		  Task_Submit (task_handle_t handle);
 void		  Tasks_Submit (int num_handles, task_handle_t *handles);
 void		  Task_AddDependency (task_handle_t before, task_handle_t after);
 qboolean	  Task_Join (task_handle_t handle, uint32_t timeout);
+void		  Tasks_Stats_f (void);
+void		  Tasks_TraceFrame (void);
+void		  Arena_BeginFrame (void);
+uint32_t	  Arena_CurrentFrame (void);
+void		 *Arena_FrameAlloc (size_t size);
+void		  Arena_EndFrame (uint32_t frame);
+
+// The stringified function is only used to label tasks in trace_frames dumps
+#define Task_AssignFunc(handle, func, payload, payload_size) Task_AssignFuncNamed (handle, func, payload, payload_size, #func)
+#define Task_AssignIndexedFunc(handle, func, limit, payload, payload_size) \
+	Task_AssignIndexedFuncNamed (handle, func, limit, payload, payload_size, #func)
+#define Task_AssignRangeFunc(handle, func, limit, payload, payload_size) Task_AssignRangeFuncNamed (handle, func, limit, payload, payload_size, #func)
+
+static inline task_handle_t Task_AllocateAndAssignFuncNamed (task_func_t func, void *payload, size_t payload_size, const char *name)
+{
+	task_handle_t handle = Task_Allocate ();
+	Task_AssignFuncNamed (handle, func, payload, payload_size, name);
+	return handle;
+}
 
-static inline task_handle_t Task_AllocateAndAssignFunc (task_func_t func, void *payload, size_t payload_size)
+static inline task_handle_t
+Task_AllocateAndAssignIndexedFuncNamed (task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size, const char *name)
 {
 	task_handle_t handle = Task_Allocate ();
-	Task_AssignFunc (handle, func, payload, payload_size);
+	Task_AssignIndexedFuncNamed (handle, func, limit, payload, payload_size, name);
 	return handle;
 }
 
-static inline task_handle_t Task_AllocateAndAssignIndexedFunc (task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
+static inline task_handle_t Task_AllocateAssignFuncAndSubmitNamed (task_func_t func, void *payload, size_t payload_size, const char *name)
 {
 	task_handle_t handle = Task_Allocate ();
-	Task_AssignIndexedFunc (handle, func, limit, payload, payload_size);
+	Task_AssignFuncNamed (handle, func, payload, payload_size, name);
+	Task_Submit (handle);
 	return handle;
 }
 
-static inline task_handle_t Task_AllocateAssignFuncAndSubmit (task_func_t func, void *payload, size_t payload_size)
+static inline task_handle_t
+Task_AllocateAssignIndexedFuncAndSubmitNamed (task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size, const char *name)
 {
 	task_handle_t handle = Task_Allocate ();
-	Task_AssignFunc (handle, func, payload, payload_size);
+	Task_AssignIndexedFuncNamed (handle, func, limit, payload, payload_size, name);
 	Task_Submit (handle);
 	return handle;
 }
 
-static inline task_handle_t Task_AllocateAssignIndexedFuncAndSubmit (task_indexed_func_t func, uint32_t limit, void *payload, size_t payload_size)
+static inline task_handle_t
+Task_AllocateAndAssignRangeFuncNamed (task_range_func_t func, uint32_t limit, void *payload, size_t payload_size, const char *name)
+{
+	task_handle_t handle = Task_Allocate ();
+	Task_AssignRangeFuncNamed (handle, func, limit, payload, payload_size, name);
+	return handle;
+}
+
+static inline task_handle_t
+Task_AllocateAssignRangeFuncAndSubmitNamed (task_range_func_t func, uint32_t limit, void *payload, size_t payload_size, const char *name)
 {
 	task_handle_t handle = Task_Allocate ();
-	Task_AssignIndexedFunc (handle, func, limit, payload, payload_size);
+	Task_AssignRangeFuncNamed (handle, func, limit, payload, payload_size, name);
 	Task_Submit (handle);
 	return handle;
 }
 
+#define Task_AllocateAndAssignFunc(func, payload, payload_size) Task_AllocateAndAssignFuncNamed (func, payload, payload_size, #func)
+#define Task_AllocateAndAssignIndexedFunc(func, limit, payload, payload_size) \
+	Task_AllocateAndAssignIndexedFuncNamed (func, limit, payload, payload_size, #func)
+#define Task_AllocateAssignFuncAndSubmit(func, payload, payload_size) Task_AllocateAssignFuncAndSubmitNamed (func, payload, payload_size, #func)
+#define Task_AllocateAssignIndexedFuncAndSubmit(func, limit, payload, payload_size) \
+	Task_AllocateAssignIndexedFuncAndSubmitNamed (func, limit, payload, payload_size, #func)
+#define Task_AllocateAndAssignRangeFunc(func, limit, payload, payload_size) \
+	Task_AllocateAndAssignRangeFuncNamed (func, limit, payload, payload_size, #func)
+#define Task_AllocateAssignRangeFuncAndSubmit(func, limit, payload, payload_size) \
+	Task_AllocateAssignRangeFuncAndSubmitNamed (func, limit, payload, payload_size, #func)
+
 #ifdef _DEBUG
 void TestTasks_f (void);
 #endif
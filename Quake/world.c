@@ -407,6 +407,8 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 	if (ent->free)
 		return;
 
+	ED_UpdateIndex (ent);
+
 	// set the abs box
 	if (ent->v.solid == SOLID_BSP && pr_checkextension.value && IsOriginWithinMinMax (ent->v.origin, ent->v.mins, ent->v.maxs) &&
 		!IsAxisAlignedDeg (ent->v.angles))
@@ -490,6 +492,29 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 		SV_TouchLinks (ent);
 }
 
+/*
+===============
+SV_AreaRegion
+
+The descent SV_LinkEdict does, cut off at depth
+===============
+*/
+areanode_t *SV_AreaRegion (edict_t *ent, int depth)
+{
+	areanode_t *node = qcvm->areanodes;
+
+	for (; depth > 0 && node->axis != -1; depth--)
+	{
+		if (ent->v.absmin[node->axis] > node->dist)
+			node = node->children[0];
+		else if (ent->v.absmax[node->axis] < node->dist)
+			node = node->children[1];
+		else
+			return NULL; // crosses the node
+	}
+	return node;
+}
+
 /*
 ===============================================================================
 
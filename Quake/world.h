@@ -62,6 +62,10 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers);
 // sets ent->v.absmin and ent->v.absmax
 // if touchtriggers, calls prog functions for the intersected triggers
 
+areanode_t *SV_AreaRegion (edict_t *ent, int depth);
+// returns the areanode at most depth levels down that holds ent's absmin/absmax box,
+// or NULL if the box crosses a node above it
+
 int SV_PointContentsAllBsps (vec3_t p, edict_t *forent); // check all SOLID_BSP ents
 int SV_PointContents (vec3_t p);
 int SV_TruePointContents (vec3_t p);